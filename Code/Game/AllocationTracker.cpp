@@ -0,0 +1,236 @@
+#include "Game/AllocationTracker.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every global operator new in the game lands here. The counts are relaxed atomics, since the simulation
+// thread allocates too, and each frame's are swapped out by BeginAllocationFrame().
+//
+constexpr int SUBSYSTEM_COUNT = static_cast<int>( AllocationSubsystem::COUNT );
+
+static std::atomic<unsigned long long>	s_frameAllocationCounts[SUBSYSTEM_COUNT];
+static std::atomic<unsigned long long>	s_frameByteCounts[SUBSYSTEM_COUNT];
+static std::atomic<unsigned long long>	s_totalAllocationCounts[SUBSYSTEM_COUNT];
+static std::atomic<unsigned long long>	s_totalByteCounts[SUBSYSTEM_COUNT];
+static AllocationCounts					s_lastFrameCounts[SUBSYSTEM_COUNT];		// Main thread only
+
+static thread_local AllocationSubsystem	t_currentSubsystem		= AllocationSubsystem::OTHER;
+static thread_local char const*			t_banScopeName			= nullptr;
+static thread_local unsigned int		t_banLiftCount			= 0;
+
+
+//----------------------------------------------------------------------------------------------------------
+static void CountAllocation( size_t byteCount )
+{
+#if defined( _DEBUG )
+	if ( t_banScopeName != nullptr )
+	{
+		// Lifted first, since dying allocates too
+		char const* scopeName = t_banScopeName;
+		t_banScopeName = nullptr;
+		ERROR_AND_DIE( Stringf( "Heap allocation of %u bytes inside %s", static_cast<unsigned int>( byteCount ), scopeName ) );
+	}
+#endif
+
+	int subsystemIndex = static_cast<int>( t_currentSubsystem );
+	s_frameAllocationCounts[subsystemIndex].fetch_add( 1, std::memory_order_relaxed );
+	s_frameByteCounts[subsystemIndex].fetch_add( byteCount, std::memory_order_relaxed );
+	s_totalAllocationCounts[subsystemIndex].fetch_add( 1, std::memory_order_relaxed );
+	s_totalByteCounts[subsystemIndex].fetch_add( byteCount, std::memory_order_relaxed );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void* TrackedAllocate( size_t byteCount )
+{
+	CountAllocation( byteCount );
+	void* memory = malloc( byteCount > 0 ? byteCount : 1 );
+	if ( memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void* operator new( size_t byteCount )
+{
+	return TrackedAllocate( byteCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void* operator new[]( size_t byteCount )
+{
+	return TrackedAllocate( byteCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void* operator new( size_t byteCount, std::nothrow_t const& ) noexcept
+{
+	CountAllocation( byteCount );
+	return malloc( byteCount > 0 ? byteCount : 1 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void* operator new[]( size_t byteCount, std::nothrow_t const& ) noexcept
+{
+	CountAllocation( byteCount );
+	return malloc( byteCount > 0 ? byteCount : 1 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete( void* memory ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete[]( void* memory ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete( void* memory, std::nothrow_t const& ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void operator delete[]( void* memory, std::nothrow_t const& ) noexcept
+{
+	free( memory );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ScopedAllocationSubsystem::ScopedAllocationSubsystem( AllocationSubsystem subsystem )
+	: m_previousSubsystem( t_currentSubsystem )
+{
+	t_currentSubsystem = subsystem;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ScopedAllocationSubsystem::~ScopedAllocationSubsystem()
+{
+	t_currentSubsystem = m_previousSubsystem;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ScopedAllocationBan::ScopedAllocationBan( char const* scopeName, bool isActive )
+	: m_isActive( isActive )
+{
+	if ( !m_isActive )
+		return;
+
+	m_previousScopeName = t_banScopeName;
+	m_liftCountAtStart = t_banLiftCount;
+	t_banScopeName = scopeName;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A lift inside this scope lifts the bans around it as well, so they stay lifted once it closes
+//
+ScopedAllocationBan::~ScopedAllocationBan()
+{
+	if ( !m_isActive )
+		return;
+
+	t_banScopeName = ( t_banLiftCount == m_liftCountAtStart ) ? m_previousScopeName : nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void LiftAllocationBan()
+{
+	t_banScopeName = nullptr;
+	t_banLiftCount++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void BeginAllocationFrame()
+{
+	for ( int subsystemIndex = 0; subsystemIndex < SUBSYSTEM_COUNT; subsystemIndex++ )
+	{
+		s_lastFrameCounts[subsystemIndex].m_allocationCount = s_frameAllocationCounts[subsystemIndex].exchange( 0, std::memory_order_relaxed );
+		s_lastFrameCounts[subsystemIndex].m_byteCount = s_frameByteCounts[subsystemIndex].exchange( 0, std::memory_order_relaxed );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AllocationCounts GetLastFrameAllocations( AllocationSubsystem subsystem )
+{
+	return s_lastFrameCounts[static_cast<int>( subsystem )];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+AllocationCounts GetTotalAllocations( AllocationSubsystem subsystem )
+{
+	AllocationCounts counts;
+	counts.m_allocationCount = s_totalAllocationCounts[static_cast<int>( subsystem )].load( std::memory_order_relaxed );
+	counts.m_byteCount = s_totalByteCounts[static_cast<int>( subsystem )].load( std::memory_order_relaxed );
+	return counts;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+char const* GetAllocationSubsystemName( AllocationSubsystem subsystem )
+{
+	switch ( subsystem )
+	{
+		case AllocationSubsystem::OTHER:		return "Other";
+		case AllocationSubsystem::LEVEL:		return "Level";
+		case AllocationSubsystem::PATH:			return "Path";
+		case AllocationSubsystem::PROP:			return "Prop";
+		case AllocationSubsystem::TAP_MANAGER:	return "TapManager";
+		case AllocationSubsystem::HUD:			return "HUD";
+		case AllocationSubsystem::MENU:			return "Menu";
+		default:								return "Unknown";
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string GetLastFrameAllocationsAsString()
+{
+	std::string statsText;
+	for ( int subsystemIndex = 0; subsystemIndex < SUBSYSTEM_COUNT; subsystemIndex++ )
+	{
+		AllocationCounts const& counts = s_lastFrameCounts[subsystemIndex];
+		statsText += Stringf( "%s%s %llu (%.1f KB)", subsystemIndex > 0 ? ", " : "", GetAllocationSubsystemName( static_cast<AllocationSubsystem>( subsystemIndex ) ),
+			counts.m_allocationCount, static_cast<double>( counts.m_byteCount ) / 1024.0 );
+	}
+	return statsText;
+}
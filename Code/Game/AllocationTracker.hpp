@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+// What a heap allocation is charged to; see ScopedAllocationSubsystem. Anything outside every scope is OTHER.
+//
+enum class AllocationSubsystem
+{
+	OTHER,
+	LEVEL,
+	PATH,
+	PROP,
+	TAP_MANAGER,
+	HUD,
+	MENU,
+
+	COUNT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AllocationCounts
+{
+	unsigned long long m_allocationCount	= 0;
+	unsigned long long m_byteCount			= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Charges every heap allocation this thread makes while in scope to one subsystem. Scopes nest, and the
+// innermost one wins.
+//
+class ScopedAllocationSubsystem
+{
+public:
+	explicit ScopedAllocationSubsystem( AllocationSubsystem subsystem );
+	~ScopedAllocationSubsystem();
+
+private:
+	AllocationSubsystem m_previousSubsystem;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// In debug builds, a heap allocation on this thread while an active ban is in scope dies with the ban's
+// name, so the debugger stops right on the call that allocated. Release builds only count.
+//
+class ScopedAllocationBan
+{
+public:
+	explicit ScopedAllocationBan( char const* scopeName, bool isActive = true );
+	~ScopedAllocationBan();
+
+private:
+	char const*		m_previousScopeName	= nullptr;
+	unsigned int	m_liftCountAtStart	= 0;
+	bool			m_isActive			= false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+void LiftAllocationBan();		// Until every ban scope on this thread has closed; see Level::GoToState()
+
+void BeginAllocationFrame();	// Main thread, once a frame
+AllocationCounts GetLastFrameAllocations( AllocationSubsystem subsystem );
+AllocationCounts GetTotalAllocations( AllocationSubsystem subsystem );
+char const* GetAllocationSubsystemName( AllocationSubsystem subsystem );
+std::string GetLastFrameAllocationsAsString();
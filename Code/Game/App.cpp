@@ -1,5 +1,20 @@
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/ReplayExporter.hpp"
+#include "Game/RenderTest.hpp"
+#include "Game/RecordingRenderBackend.hpp"
+#include "Game/RenderQueue.hpp"
+#include "Game/LatencyCalibrator.hpp"
+#include "Game/Level.hpp"
+#include "Game/Path.hpp"
+#include "Game/RunLog.hpp"
+#include "Game/ScoreDatabase.hpp"
+#include "Game/ContentHash.hpp"
+#include "Game/SimulationThread.hpp"
+#include "Game/FramePacer.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/AllocationTracker.hpp"
 
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/Time.hpp"
@@ -17,6 +32,11 @@
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Audio/AudioSystem_Wwise.hpp"
 #include "Engine/Core/Clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 
 
 App*				g_theApp = nullptr;
@@ -26,6 +46,9 @@ InputSystem*		g_theInput = nullptr;
 AudioSystem_Wwise*	g_theAudio = nullptr;
 Window*				g_theWindow = nullptr;
 BitmapFont*			g_defaultFont = nullptr;
+RenderBackend*		g_theRenderBackend = nullptr;
+ScoreDatabase*		g_theScoreDatabase = nullptr;
+FrameArena*			g_theFrameArena = nullptr;
 
 extern Clock* g_systemClock;
 
@@ -105,6 +128,7 @@ bool App::Command_Delay( EventArgs& args )
 		if ( inputDelayAsFloat >= 0.f )
 		{
 			g_gameConfigBlackboard.SetValue( "inputDelaySeconds", inputDelayString );
+			g_gameConfigBlackboard.SetValue( "calibratedInputDelaySeconds", inputDelayString );
 			double currentInputDelay = g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 );
 			std::string message = Stringf( "Set the input delay is %1.3f seconds.", currentInputDelay );
 			g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, message );
@@ -119,6 +143,340 @@ bool App::Command_Delay( EventArgs& args )
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RenderTest( EventArgs& args )
+{
+	RenderTestSettings settings;
+	settings.m_updateGoldens	= args.GetValue( "update", settings.m_updateGoldens );
+	settings.m_channelTolerance	= args.GetValue( "tolerance", g_gameConfigBlackboard.GetValue( "renderTestTolerance", settings.m_channelTolerance ) );
+	settings.m_maxBadPixels		= args.GetValue( "maxBadPixels", g_gameConfigBlackboard.GetValue( "renderTestMaxBadPixels", settings.m_maxBadPixels ) );
+	settings.m_dimensions.x		= args.GetValue( "width", settings.m_dimensions.x );
+	settings.m_dimensions.y		= args.GetValue( "height", settings.m_dimensions.y );
+
+	int failureCount = RunRenderGoldenTests( settings );
+	if ( g_theApp && failureCount > 0 )
+	{
+		g_theApp->m_exitCode = 1;
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RenderBench( EventArgs& args )
+{
+	IntVec2 dimensions;
+	dimensions.x = args.GetValue( "width", 1600 );
+	dimensions.y = args.GetValue( "height", 800 );
+	int frameCount = args.GetValue( "frames", 100 );
+
+	RunRenderBenchmark( dimensions, frameCount );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RenderStats( EventArgs& args )
+{
+	UNUSED( args );
+	if ( g_theApp == nullptr )
+		return false;
+
+	g_theApp->m_showRenderStats = !g_theApp->m_showRenderStats;
+	if ( g_theApp->m_showRenderStats )
+	{
+		g_theApp->InstallRenderRecorder();
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Render stats <tint=green>ON<!tint>" );
+		return true;
+	}
+
+	RecordingRenderBackend const* recorder = g_theApp->m_renderRecorder;
+	int frameCount = recorder->GetRecordedFrameCount();
+	if ( frameCount > 0 )
+	{
+		RenderFrameStats const& totals = recorder->GetTotalStats();
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Render stats over %i frames, per frame: draws=%.1f states=%.1f redundant=%.1f uploads=%.1f",
+			frameCount, static_cast<float>( totals.m_drawCalls ) / frameCount, static_cast<float>( totals.m_stateChanges ) / frameCount,
+			static_cast<float>( totals.m_redundantStateChanges ) / frameCount, static_cast<float>( totals.m_bufferUploads ) / frameCount ) );
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Render stats <tint=red>OFF<!tint>" );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RenderTrace( EventArgs& args )
+{
+	if ( g_theApp == nullptr )
+		return false;
+
+	int frameCount = args.GetValue( "frames", 1 );
+	std::string traceFilePath = args.GetValue( "file", "Saved/RenderTrace.txt" );
+
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( traceFilePath ).parent_path(), error );
+
+	g_theApp->InstallRenderRecorder();
+	g_theApp->m_renderRecorder->StartTrace( frameCount, traceFilePath );
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Tracing the next %i frames to \"%s\"", frameCount, traceFilePath.c_str() ) );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RenderQueue( EventArgs& args )
+{
+	UNUSED( args );
+	if ( g_theApp == nullptr )
+		return false;
+
+	if ( g_theApp->m_renderQueue )
+	{
+		g_theApp->RemoveRenderQueue();
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Render queue <tint=red>OFF<!tint>" );
+	}
+	else
+	{
+		g_theApp->InstallRenderQueue();
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Render queue <tint=green>ON<!tint>" );
+	}
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_FramePacing( EventArgs& args )
+{
+	if ( g_theApp == nullptr )
+		return false;
+
+	double requestedHz = args.GetValue( "hz", 0.0 );
+	if ( g_theApp->m_framePacer && requestedHz <= 0.0 )
+	{
+		delete g_theApp->m_framePacer;
+		g_theApp->m_framePacer = nullptr;
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Low latency frame pacing <tint=red>OFF<!tint>" );
+		return true;
+	}
+
+	double targetHz = requestedHz > 0.0 ? requestedHz : g_gameConfigBlackboard.GetValue( "framePacingHz", 60.0 );
+	g_gameConfigBlackboard.SetValue( "framePacingHz", Stringf( "%g", targetHz ) );
+	if ( g_theApp->m_framePacer )
+	{
+		g_theApp->m_framePacer->SetTargetHz( targetHz );
+	}
+	else
+	{
+		g_theApp->m_framePacer = new FramePacer( targetHz, g_gameConfigBlackboard.GetValue( "framePacingMarginSeconds", 0.002 ) );
+	}
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Low latency frame pacing <tint=green>ON<!tint> at %g Hz", targetHz ) );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_LatencyProfile( EventArgs& args )
+{
+	std::string profileName = args.GetValue( "name", "" );
+	if ( profileName.empty() )
+	{
+		profileName = g_gameConfigBlackboard.GetValue( "latencyProfile", "default" );
+		double currentInputDelay = g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 );
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "The current latency profile is \"%s\" (%1.3f seconds).", profileName.c_str(), currentInputDelay ) );
+		return true;
+	}
+
+	g_gameConfigBlackboard.SetValue( "latencyProfile", profileName );
+
+	LatencyProfile profile;
+	if ( LoadLatencyProfile( profileName, profile ) )
+	{
+		ApplyLatencyProfile( profile );
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Switched to latency profile \"%s\" (%1.3f seconds).", profileName.c_str(), profile.m_inputDelaySeconds ) );
+	}
+	else
+	{
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Latency profile \"%s\" is new; calibrate from the main menu to measure it.", profileName.c_str() ) );
+	}
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_RunStats( EventArgs& args )
+{
+	Level* level = g_theApp->m_theGame->FindLevel( args.GetValue( "level", "" ) );
+	if ( level == nullptr )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "No level matches \"%s\"", args.GetValue( "level", "" ).c_str() ) );
+		return false;
+	}
+
+	if ( args.GetValue( "clear", false ) )
+	{
+		level->ClearDifficultyOverlay();
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Difficulty overlay <tint=red>OFF<!tint>" );
+		return true;
+	}
+
+	std::string levelFilePath = level->GetFilePath();
+	std::string runLogFolder = args.GetValue( "folder", g_gameConfigBlackboard.GetValue( "runLogFolder", "Saved/RunLogs" ) );
+	unsigned int nodeCount = level->GetPath()->GetNodeCount();
+
+	RunLogAggregate aggregate;
+	if ( !AggregateRunLogs( runLogFolder, levelFilePath, level->GetChartHash(), nodeCount, aggregate ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Could not read run logs from \"%s\"", runLogFolder.c_str() ) );
+		return false;
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Aggregated %u runs (%llu taps, %u skipped) of \"%s\" in %.3f seconds on %i threads",
+		aggregate.m_runCount, aggregate.m_tapCount, aggregate.m_skippedFileCount, levelFilePath.c_str(), aggregate.m_elapsedSeconds, aggregate.m_threadCount ) );
+	if ( aggregate.m_runCount == 0 )
+		return true;
+
+	// The few nodes that end the most runs are what charters look at first
+	std::vector<unsigned int> deadliestNodes;
+	for ( unsigned int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		if ( aggregate.m_nodes[nodeIndex].m_deathRate > 0.f )
+		{
+			deadliestNodes.push_back( nodeIndex );
+		}
+	}
+	std::sort( deadliestNodes.begin(), deadliestNodes.end(), [&]( unsigned int a, unsigned int b )
+		{ return aggregate.m_nodes[a].m_deathRate > aggregate.m_nodes[b].m_deathRate; } );
+	deadliestNodes.resize( std::min( deadliestNodes.size(), static_cast<size_t>( 5 ) ) );
+	for ( unsigned int nodeIndex : deadliestNodes )
+	{
+		NodeDifficulty const& node = aggregate.m_nodes[nodeIndex];
+		g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Node %4u: %5.1f%% death, %5.1f%% miss, %+6.1f ms mean error over %u runs",
+			nodeIndex, node.m_deathRate * 100.f, node.m_missRate * 100.f, node.m_meanErrorMs, node.m_reachCount ) );
+	}
+
+	std::string metricsFolder = g_gameConfigBlackboard.GetValue( "metricsFolder", "Saved/Metrics" );
+	std::error_code error;
+	std::filesystem::create_directories( metricsFolder, error );
+	std::string levelName = std::filesystem::path( levelFilePath ).stem().string();
+	std::string csvFilePath = Stringf( "%s/%s_nodes.csv", metricsFolder.c_str(), levelName.c_str() );
+	if ( !SaveNodeDifficultyToCSV( aggregate.m_nodes, csvFilePath ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save node difficulty to \"%s\"", csvFilePath.c_str() ) );
+	}
+
+	level->SetDifficultyOverlay( aggregate.m_nodes );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_ChartStats( EventArgs& args )
+{
+	UNUSED( args );
+	Game* game = g_theApp->m_theGame;
+	game->AnalyzeCharts();
+
+	std::string metricsFolder = g_gameConfigBlackboard.GetValue( "metricsFolder", "Saved/Metrics" );
+	std::error_code error;
+	std::filesystem::create_directories( metricsFolder, error );
+	std::string csvFilePath = metricsFolder + "/charts.csv";
+	std::ofstream csvFile( csvFilePath, std::ios::out | std::ios::trunc );
+	csvFile << "level,chart,authored,rating,notesPerSecond,peakNotesPerSecond,irregularity,spinsPerNote,speedChangesPerNote,turnSharpness\n";
+
+	for ( unsigned int levelIndex = 0; levelIndex < game->GetLevelCount(); levelIndex++ )
+	{
+		Level const& level = game->GetLevel( levelIndex );
+		LevelInfo const& info = level.GetInfo();
+		ChartDifficulty const& chart = info.m_chart;
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "%-28s %4.1f (authored %4.1f): %.2f n/s, peak %.2f, irregularity %.2f, spins %.2f, speed %.2f, turns %.2f",
+			info.m_name.c_str(), info.m_difficulty, info.m_authoredDifficulty, chart.m_notesPerSecond, chart.m_peakNotesPerSecond,
+			chart.m_irregularity, chart.m_spinsPerNote, chart.m_speedChangesPerNote, chart.m_turnSharpness ) );
+		csvFile << Stringf( "%s,%s,%.2f,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f\n", level.GetFilePath().c_str(), GetContentHashString( level.GetChartHash() ).c_str(), info.m_authoredDifficulty, info.m_difficulty,
+			chart.m_notesPerSecond, chart.m_peakNotesPerSecond, chart.m_irregularity, chart.m_spinsPerNote, chart.m_speedChangesPerNote, chart.m_turnSharpness );
+	}
+
+	if ( !csvFile.good() )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save chart stats to \"%s\"", csvFilePath.c_str() ) );
+	}
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void AddPathMeshStatsLine( std::string const& name, PathMeshStats const& stats )
+{
+	double unindexedToCompact = stats.m_compactByteSize > 0 ? static_cast<double>( stats.m_unindexedByteSize ) / static_cast<double>( stats.m_compactByteSize ) : 0.0;
+	double unindexedToGpu = stats.m_gpuByteSize > 0 ? static_cast<double>( stats.m_unindexedByteSize ) / static_cast<double>( stats.m_gpuByteSize ) : 0.0;
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "%-28s %7u nodes, %9llu verts, %9llu indexes: %9.1f KB stored (%.1fx smaller), %9.1f KB on the GPU (%.1fx), %9.1f KB unindexed, max error %.2g",
+		name.c_str(), stats.m_nodeCount, stats.m_vertexCount, stats.m_indexCount, static_cast<double>( stats.m_compactByteSize ) / 1024.0, unindexedToCompact,
+		static_cast<double>( stats.m_gpuByteSize ) / 1024.0, unindexedToGpu, static_cast<double>( stats.m_unindexedByteSize ) / 1024.0,
+		static_cast<double>( stats.m_maxQuantizationError ) ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The synthetic chart cycles through every kind of node (every turn, U-turns, spins, speed changes and
+// checkpoints), so its size per node is typical of a busy chart rather than of a straight line
+//
+bool App::Command_PathStats( EventArgs& args )
+{
+	Game* game = g_theApp->m_theGame;
+	for ( unsigned int levelIndex = 0; levelIndex < game->GetLevelCount(); levelIndex++ )
+	{
+		Level const& level = game->GetLevel( levelIndex );
+		Path const* path = level.GetPath();
+		if ( path == nullptr )
+			continue;
+
+		AddPathMeshStatsLine( level.GetInfo().m_name, path->GetMeshStats() );
+	}
+
+	int nodeCount = args.GetValue( "nodes", 100'000 );
+	static char const* const SYNTHETIC_BEATS[] = { "1", ".5", ".75", ".25", "1.5", "2", "1", ".5" };
+	constexpr int SYNTHETIC_BEAT_COUNT = sizeof( SYNTHETIC_BEATS ) / sizeof( SYNTHETIC_BEATS[0] );
+	std::string xmlText = "<Path name=\"Synthetic\" scale=\"1\" width=\".6\">\n";
+	xmlText.reserve( static_cast<size_t>( nodeCount ) * 32 );
+	for ( int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		xmlText += Stringf( "<Node beat=\"%s\"", SYNTHETIC_BEATS[nodeIndex % SYNTHETIC_BEAT_COUNT] );
+		if ( nodeIndex % 61 == 60 )		xmlText += Stringf( " speed=\"%s\"", ( nodeIndex / 61 ) % 2 == 0 ? "1.5" : "1" );
+		if ( nodeIndex % 37 == 36 )		xmlText += " spin=\"true\"";
+		if ( nodeIndex % 500 == 499 )	xmlText += " checkpoint=\"true\"";
+		xmlText += " />\n";
+	}
+	xmlText += "</Path>\n";
+
+	Path syntheticPath;
+	if ( !syntheticPath.LoadFromXmlText( xmlText, "Synthetic" ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, "Failed to build the synthetic path" );
+		return false;
+	}
+	AddPathMeshStatsLine( Stringf( "Synthetic (%i nodes)", nodeCount ), syntheticPath.GetMeshStats() );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool App::Command_AllocStats( EventArgs& args )
+{
+	UNUSED( args );
+	for ( int subsystemIndex = 0; subsystemIndex < static_cast<int>( AllocationSubsystem::COUNT ); subsystemIndex++ )
+	{
+		AllocationSubsystem subsystem = static_cast<AllocationSubsystem>( subsystemIndex );
+		AllocationCounts totals = GetTotalAllocations( subsystem );
+		AllocationCounts lastFrame = GetLastFrameAllocations( subsystem );
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "%-10s %10llu allocations, %10.1f KB total; last frame %llu, %.1f KB",
+			GetAllocationSubsystemName( subsystem ), totals.m_allocationCount, static_cast<double>( totals.m_byteCount ) / 1024.0,
+			lastFrame.m_allocationCount, static_cast<double>( lastFrame.m_byteCount ) / 1024.0 ) );
+	}
+	return true;
+}
+
+
 //--------------------------------------------------------------------------------------------------------------
 App::App()
 {
@@ -132,7 +490,7 @@ App::~App()
 
 
 //--------------------------------------------------------------------------------------------------------------
-void App::Startup()
+void App::Startup( char const* commandLine )
 {
 	// Create and startup all Engine subsystems.
 	EventSystemConfig eventSystemConfig;
@@ -202,7 +560,62 @@ void App::Startup()
 	g_theEventSystem->GetEventMetadata( "delay" ).m_isCommmand = true;
 	g_theEventSystem->DefineAlias( "d", "delay" );
 
+	g_theEventSystem->SubscribeEventCallbackFunction( "latencyprofile", Command_LatencyProfile );
+	g_theEventSystem->GetEventMetadata( "latencyprofile" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "latencyprofile" ).m_shortDescription = "Shows or switches the calibrated input delay profile.";
+	g_theEventSystem->GetEventMetadata( "latencyprofile" ).m_longDescription = "Args: name=<profile>. One profile per audio/input setup, measured with Calibrate on the main menu.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "runstats", Command_RunStats );
+	g_theEventSystem->GetEventMetadata( "runstats" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "runstats" ).m_shortDescription = "Aggregates saved run logs into a per-node difficulty overlay on the path.";
+	g_theEventSystem->GetEventMetadata( "runstats" ).m_longDescription = "Args: level=<name or path>, folder=<run log folder>, clear=true hides the overlay. Also writes <level>_nodes.csv to the metrics folder.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "chartstats", Command_ChartStats );
+	g_theEventSystem->GetEventMetadata( "chartstats" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "chartstats" ).m_shortDescription = "Re-analyzes every chart's difficulty and lists the breakdown.";
+	g_theEventSystem->GetEventMetadata( "chartstats" ).m_longDescription = "Also writes charts.csv to the metrics folder, with the authored difficulty next to the analyzed one.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "allocstats", Command_AllocStats );
+	g_theEventSystem->GetEventMetadata( "allocstats" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "allocstats" ).m_shortDescription = "Lists heap allocations per subsystem since startup and in the last frame.";
+	g_theEventSystem->GetEventMetadata( "allocstats" ).m_longDescription = "Renderstats shows the per-frame counts live.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "pathstats", Command_PathStats );
+	g_theEventSystem->GetEventMetadata( "pathstats" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "pathstats" ).m_shortDescription = "Lists the track geometry size of every chart and of a synthetic one.";
+	g_theEventSystem->GetEventMetadata( "pathstats" ).m_longDescription = "Args: nodes=<count> sizes the synthetic chart, 100000 by default. Compares against unindexed Vertex_PCU triangles.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "rendertest", Command_RenderTest );
+	g_theEventSystem->GetEventMetadata( "rendertest" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "rendertest" ).m_shortDescription = "Compares software-rendered scenes against the golden images.";
+	g_theEventSystem->GetEventMetadata( "rendertest" ).m_longDescription = "Args: update=true rewrites the goldens, tolerance=<per-channel>, maxBadPixels=<count> (defaults from GameConfig). A missing golden fails until update=true writes it.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "renderstats", Command_RenderStats );
+	g_theEventSystem->GetEventMetadata( "renderstats" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "renderstats" ).m_shortDescription = "Toggles per-frame draw call and state change counts.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "rendertrace", Command_RenderTrace );
+	g_theEventSystem->GetEventMetadata( "rendertrace" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "rendertrace" ).m_shortDescription = "Writes every render call of the next frames to a text file.";
+	g_theEventSystem->GetEventMetadata( "rendertrace" ).m_longDescription = "Args: frames=<count>, file=<path>. Traces from two builds can be diffed directly.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "renderqueue", Command_RenderQueue );
+	g_theEventSystem->GetEventMetadata( "renderqueue" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "renderqueue" ).m_shortDescription = "Toggles sorting draws by render state and dropping redundant state changes.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "framepacing", Command_FramePacing );
+	g_theEventSystem->GetEventMetadata( "framepacing" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "framepacing" ).m_shortDescription = "Toggles starting each frame just in time for the next present.";
+	g_theEventSystem->GetEventMetadata( "framepacing" ).m_longDescription = "Args: hz=<refresh rate> turns pacing on at that rate. Renderstats shows its timings.";
+
+	g_theEventSystem->SubscribeEventCallbackFunction( "renderbench", Command_RenderBench );
+	g_theEventSystem->GetEventMetadata( "renderbench" ).m_isCommmand = true;
+	g_theEventSystem->GetEventMetadata( "renderbench" ).m_shortDescription = "Times software rendering of a gameplay frame.";
+	g_theEventSystem->GetEventMetadata( "renderbench" ).m_longDescription = "Args: frames=<count>, width=<pixels>, height=<pixels>.";
+
 	g_defaultFont = g_theRenderer->CreateOrGetBitmapFont( "Data/Images/RobotoMonoSemiBold128" );
+	g_theRenderBackend = new GpuRenderBackend();
+	g_theFrameArena = new FrameArena();
 
 	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "App Startup" );
 	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "Press ESC to return to the previous screen." );
@@ -216,7 +629,76 @@ void App::Startup()
 
 	// Initialize Game & Game Constants
 	LoadGameConfig( "Data/GameConfig.xml" );
+	ParseCommandLine( commandLine );
+
+	// Export mode renders a replay offline; the exporter has to own the backend before any level loads
+	std::string exportReplayPath = g_gameConfigBlackboard.GetValue( "export", "" );
+	if ( !exportReplayPath.empty() )
+	{
+		g_gameConfigBlackboard.SetValue( "bakedCamera", "true" );
+		g_gameConfigBlackboard.SetValue( "recordReplays", "false" );
+		g_gameConfigBlackboard.SetValue( "hotReload", "false" );
+
+		ReplayExportConfig exportConfig;
+		exportConfig.m_replayFilePath	= exportReplayPath;
+		exportConfig.m_outputFolder		= g_gameConfigBlackboard.GetValue( "exportOut", exportConfig.m_outputFolder );
+		exportConfig.m_format			= g_gameConfigBlackboard.GetValue( "exportFormat", exportConfig.m_format );
+		exportConfig.m_dimensions.x		= g_gameConfigBlackboard.GetValue( "exportWidth", exportConfig.m_dimensions.x );
+		exportConfig.m_dimensions.y		= g_gameConfigBlackboard.GetValue( "exportHeight", exportConfig.m_dimensions.y );
+		exportConfig.m_framesPerSecond	= g_gameConfigBlackboard.GetValue( "exportFps", exportConfig.m_framesPerSecond );
+		exportConfig.m_tailSeconds		= g_gameConfigBlackboard.GetValue( "exportTail", exportConfig.m_tailSeconds );
+		exportConfig.m_firstFrame		= g_gameConfigBlackboard.GetValue( "exportStart", exportConfig.m_firstFrame );
+		exportConfig.m_endFrame			= g_gameConfigBlackboard.GetValue( "exportEnd", exportConfig.m_endFrame );
+		exportConfig.m_workerCount		= g_gameConfigBlackboard.GetValue( "exportWorkers", exportConfig.m_workerCount );
+		m_exporter = new ReplayExporter( exportConfig );
+	}
+	else
+	{
+		// Exports replay the delay stored in the replay, so the local calibration only applies to play
+		LatencyProfile latencyProfile;
+		if ( LoadLatencyProfile( g_gameConfigBlackboard.GetValue( "latencyProfile", "default" ), latencyProfile ) )
+		{
+			ApplyLatencyProfile( latencyProfile );
+		}
+		else
+		{
+			// Without a profile, adaptive nudges stay near the delay the session started with
+			double inputDelaySeconds = g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 );
+			g_gameConfigBlackboard.SetValue( "calibratedInputDelaySeconds", Stringf( "%.17g", inputDelaySeconds ) );
+		}
+
+		if ( g_gameConfigBlackboard.GetValue( "renderQueue", true ) )
+		{
+			InstallRenderQueue();
+		}
+
+		// Exports render offline as fast as they can, so only live play is paced
+		if ( g_gameConfigBlackboard.GetValue( "framePacing", false ) )
+		{
+			m_framePacer = new FramePacer( g_gameConfigBlackboard.GetValue( "framePacingHz", 60.0 ),
+				g_gameConfigBlackboard.GetValue( "framePacingMarginSeconds", 0.002 ) );
+		}
+
+		g_theScoreDatabase = new ScoreDatabase();
+		g_theScoreDatabase->Startup();
+	}
+
 	m_theGame = new Game();
+
+	if ( m_exporter )
+	{
+		m_exporter->Startup();
+	}
+
+	// Test runs execute once and quit, reporting failures through the exit code. They still open the
+	// window and start the renderer and audio, which the game loads its assets through.
+	if ( g_gameConfigBlackboard.GetValue( "rendertest", false ) )
+	{
+		EventArgs renderTestArgs;
+		renderTestArgs.SetValue( "update", g_gameConfigBlackboard.GetValue( "updateGoldens", "false" ) );
+		Command_RenderTest( renderTestArgs );
+		HandleQuitRequested();
+	}
 }
 
 
@@ -235,8 +717,35 @@ void App::Shutdown()
 {
 	g_defaultFont = nullptr;
 
+	// The game's buffers belong to whichever backend created them, so it goes before the exporter
+	// hands the GPU backend back
 	delete m_theGame;
 	m_theGame = nullptr;
+
+	if ( m_exporter )
+	{
+		m_exporter->Shutdown();
+		delete m_exporter;
+		m_exporter = nullptr;
+	}
+
+	delete m_framePacer;
+	m_framePacer = nullptr;
+
+	if ( g_theScoreDatabase )
+	{
+		g_theScoreDatabase->Shutdown();
+		delete g_theScoreDatabase;
+		g_theScoreDatabase = nullptr;
+	}
+
+	RemoveRenderQueue();
+	RemoveRenderRecorder();
+	delete g_theRenderBackend;
+	g_theRenderBackend = nullptr;
+
+	delete g_theFrameArena;
+	g_theFrameArena = nullptr;
 	
 	g_theEventSystem->UnsubscribeEventCallbackFunction( "quit", RecieveWM_CLOSE );
 	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, "App Shutdown" );
@@ -274,12 +783,58 @@ void App::Shutdown()
 
 
 //--------------------------------------------------------------------------------------------------------------
+// Everything that can change game state runs under the simulation thread's lock, so its ticks only ever
+// fall between frames' updates. Rendering draws from snapshots and runs unlocked, alongside the ticks.
+//
 void App::RunFrame()
 {
+	if ( m_framePacer )
+	{
+		m_framePacer->WaitForFrameStart();
+	}
+
+	bool isRenderingFrame = true;
+	std::unique_lock<std::mutex> sharedStateLock( SimulationThread::GetSharedStateMutex() );
 	BeginFrame();
-	Update();
-	Render();
+	if ( m_exporter )
+	{
+		// Each exported frame advances the simulation by exactly one fixed step, however long it took
+		m_exporter->RunFrame();
+		if ( m_exporter->IsFinished() )
+		{
+			HandleQuitRequested();
+		}
+		sharedStateLock.unlock();
+	}
+	else
+	{
+		Update();
+		isRenderingFrame = m_theGame->ShouldRenderFrame();
+		sharedStateLock.unlock();
+		if ( isRenderingFrame )
+		{
+			Render();
+		}
+	}
+
+	if ( !isRenderingFrame )
+	{
+		// Nothing is presented to block on, so wait out the poll interval instead of spinning
+		EndFrame( false );
+		double idlePollSeconds = g_gameConfigBlackboard.GetValue( "idlePollSeconds", 0.004 );
+		std::this_thread::sleep_for( std::chrono::duration<double>( idlePollSeconds ) );
+		return;
+	}
+
+	if ( m_framePacer )
+	{
+		m_framePacer->MarkFrameSubmitted();
+	}
 	EndFrame();
+	if ( m_framePacer )
+	{
+		m_framePacer->MarkFramePresented();
+	}
 }
 
 
@@ -294,6 +849,11 @@ void App::LoadGameConfig( char const* gameConfigXMLFilePath )
 		if ( rootElement )
 		{
 			g_gameConfigBlackboard.PopulateFromXmlElementAttributes( *rootElement );
+			m_gameConfigFileValues.clear();
+			for ( XmlAttribute const* attribute = rootElement->FirstAttribute(); attribute != nullptr; attribute = attribute->Next() )
+			{
+				m_gameConfigFileValues[attribute->Name()] = attribute->Value();
+			}
 			g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Successfully loaded game config from \"%s\".", gameConfigXMLFilePath ) );
 		}
 		else
@@ -308,6 +868,73 @@ void App::LoadGameConfig( char const* gameConfigXMLFilePath )
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// Applies only the settings whose value in the file changed since it was last read. Everything else on
+// the blackboard may have been overridden since (command line, calibration, console commands) and keeps
+// its current value.
+//
+void App::ReloadGameConfig( char const* gameConfigXMLFilePath )
+{
+	XmlDocument gameConfig;
+	XmlResult result = gameConfig.LoadFile( gameConfigXMLFilePath );
+	XmlElement const* rootElement = result == tinyxml2::XML_SUCCESS ? gameConfig.RootElement() : nullptr;
+	if ( rootElement == nullptr )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to reload game config from \"%s\"; keeping the current settings", gameConfigXMLFilePath ) );
+		return;
+	}
+
+	int changedCount = 0;
+	for ( XmlAttribute const* attribute = rootElement->FirstAttribute(); attribute != nullptr; attribute = attribute->Next() )
+	{
+		std::string& fileValue = m_gameConfigFileValues[attribute->Name()];
+		if ( fileValue == attribute->Value() )
+			continue;
+
+		fileValue = attribute->Value();
+		g_gameConfigBlackboard.SetValue( attribute->Name(), fileValue );
+		g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "%s = \"%s\"", attribute->Name(), fileValue.c_str() ) );
+		changedCount++;
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Reloaded game config from \"%s\": %i settings changed", gameConfigXMLFilePath, changedCount ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void App::ParseCommandLine( char const* commandLine )
+{
+	// Accepts key=value pairs separated by spaces; values may be wrapped in quotes to contain spaces
+	std::string token;
+	bool isInQuotes = false;
+	for ( char const* cursor = commandLine; ; cursor++ )
+	{
+		char c = *cursor;
+		if ( c == '"' )
+		{
+			isInQuotes = !isInQuotes;
+			continue;
+		}
+
+		if ( c != '\0' && ( isInQuotes || c != ' ' ) )
+		{
+			token += c;
+			continue;
+		}
+
+		size_t equalsIndex = token.find( '=' );
+		if ( equalsIndex != std::string::npos && equalsIndex > 0 )
+		{
+			g_gameConfigBlackboard.SetValue( token.substr( 0, equalsIndex ), token.substr( equalsIndex + 1 ) );
+		}
+		token.clear();
+
+		if ( c == '\0' )
+			break;
+	}
+}
+
+
 //--------------------------------------------------------------------------------------------------------------
 bool App::HandleQuitRequested() 
 {
@@ -328,6 +955,9 @@ void App::BeginFrame()
 	g_theInput->BeginFrame();
 	g_theWindow->BeginFrame();
 	g_theRenderer->BeginFrame();
+	g_theRenderBackend->BeginFrame();
+	g_theFrameArena->BeginFrame();
+	BeginAllocationFrame();
 	DebugRenderBeginFrame();
 	g_theDevConsole->BeginFrame();
 	g_theAudio->BeginFrame();
@@ -350,6 +980,29 @@ void App::Update()
 	}
 
 	m_theGame->Update();
+
+	if ( m_showRenderStats && m_renderRecorder )
+	{
+		std::string statsText = Stringf( "Render: %s", m_renderRecorder->GetLastFrameStats().GetAsString().c_str() );
+		DebugAddMessage( statsText, 0.f, Rgba8::WHITE, Rgba8::WHITE );
+	}
+
+	if ( m_showRenderStats && m_theGame->IsIdleState() )
+	{
+		RedrawThrottle const& throttle = m_theGame->GetRedrawThrottle();
+		DebugAddMessage( Stringf( "Idle: skipped %u of %u frames", throttle.GetSkippedFrameCount(), throttle.GetFrameCount() ), 0.f, Rgba8::WHITE, Rgba8::WHITE );
+	}
+
+	if ( m_showRenderStats && m_framePacer )
+	{
+		DebugAddMessage( Stringf( "Pacing: %s", m_framePacer->GetStatsAsString().c_str() ), 0.f, Rgba8::WHITE, Rgba8::WHITE );
+	}
+
+	if ( m_showRenderStats )
+	{
+		DebugAddMessage( Stringf( "Arena: %s", g_theFrameArena->GetStatsAsString().c_str() ), 0.f, Rgba8::WHITE, Rgba8::WHITE );
+		DebugAddMessage( Stringf( "Allocs: %s", GetLastFrameAllocationsAsString().c_str() ), 0.f, Rgba8::WHITE, Rgba8::WHITE );
+	}
 }
 
 
@@ -366,15 +1019,91 @@ void App::Render() const
 
 
 //--------------------------------------------------------------------------------------------------------------
-void App::EndFrame()
+// A frame that drew nothing isn't presented, so the last one drawn stays on screen
+//
+void App::EndFrame( bool isPresenting )
 {
 	g_theEventSystem->EndFrame();
 	g_theInput->EndFrame();
 	g_theWindow->EndFrame();
-	g_theRenderer->EndFrame();
+	g_theRenderBackend->EndFrame();
+	if ( isPresenting )
+	{
+		g_theRenderer->EndFrame();
+	}
 	DebugRenderEndFrame();
 	g_theDevConsole->EndFrame();
 	g_theAudio->EndFrame();
+
+	if ( m_renderRecorder && !m_showRenderStats && !m_renderRecorder->IsTracing() )
+	{
+		RemoveRenderRecorder();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void App::InstallRenderRecorder()
+{
+	if ( m_renderRecorder )
+		return;
+
+	// Record beneath the queue, so the counts are what actually reaches the renderer
+	if ( m_renderQueue )
+	{
+		m_renderRecorder = new RecordingRenderBackend( m_renderQueue->GetWrappedBackend() );
+		m_renderQueue->SetWrappedBackend( m_renderRecorder );
+		return;
+	}
+
+	m_renderRecorder = new RecordingRenderBackend( g_theRenderBackend );
+	g_theRenderBackend = m_renderRecorder;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void App::RemoveRenderRecorder()
+{
+	if ( m_renderRecorder == nullptr )
+		return;
+
+	if ( m_renderQueue && m_renderQueue->GetWrappedBackend() == m_renderRecorder )
+	{
+		m_renderQueue->SetWrappedBackend( m_renderRecorder->GetWrappedBackend() );
+	}
+	else
+	{
+		g_theRenderBackend = m_renderRecorder->GetWrappedBackend();
+	}
+
+	delete m_renderRecorder;
+	m_renderRecorder = nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The queue always sits on top of the backend chain; a recorder installed earlier ends up beneath it.
+//
+void App::InstallRenderQueue()
+{
+	if ( m_renderQueue )
+		return;
+
+	m_renderQueue = new RenderQueue( g_theRenderBackend );
+	g_theRenderBackend = m_renderQueue;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void App::RemoveRenderQueue()
+{
+	if ( m_renderQueue == nullptr )
+		return;
+
+	m_renderQueue->Flush();
+	g_theRenderBackend = m_renderQueue->GetWrappedBackend();
+	delete m_renderQueue;
+	m_renderQueue = nullptr;
 }
 
 
@@ -383,3 +1112,10 @@ bool App::IsQuitting() const
 { 
 	return m_isQuitting; 
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+int App::GetExitCode() const
+{
+	return m_exitCode;
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "Engine/Core/Rgba8.hpp"
+#include <map>
+#include <string>
 
 //----------------------------------------------------------------------------------------------------------
 class Renderer;
@@ -7,6 +9,10 @@ class Game;
 class Camera;
 class NamedStrings;
 class EventArgs;
+class ReplayExporter;
+class RecordingRenderBackend;
+class RenderQueue;
+class FramePacer;
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -17,29 +23,55 @@ public:
 	static bool Command_Autoplay( EventArgs& args );
 	static bool Command_Nofail( EventArgs& args );
 	static bool Command_Delay( EventArgs& args );
+	static bool Command_RenderTest( EventArgs& args );
+	static bool Command_RenderBench( EventArgs& args );
+	static bool Command_RenderStats( EventArgs& args );
+	static bool Command_RenderTrace( EventArgs& args );
+	static bool Command_RenderQueue( EventArgs& args );
+	static bool Command_FramePacing( EventArgs& args );
+	static bool Command_LatencyProfile( EventArgs& args );
+	static bool Command_RunStats( EventArgs& args );
+	static bool Command_ChartStats( EventArgs& args );
+	static bool Command_AllocStats( EventArgs& args );
+	static bool Command_PathStats( EventArgs& args );
 
 public:
 	App();
 	~App();
-	void Startup();
+	void Startup( char const* commandLine = "" );
 	void RunMainLoop();
 	void Shutdown();
 	void RunFrame();
 
 	void LoadGameConfig( char const* gameConfigXMLFilePath );
+	void ReloadGameConfig( char const* gameConfigXMLFilePath );
+	void ParseCommandLine( char const* commandLine );
 	bool HandleQuitRequested();
 	bool IsQuitting() const;
+	int GetExitCode() const;
 
 private:
 	void BeginFrame();
 	void Update();
 	void Render() const;
-	void EndFrame();
+	void EndFrame( bool isPresenting = true );
+
+	void InstallRenderRecorder();
+	void RemoveRenderRecorder();
+	void InstallRenderQueue();
+	void RemoveRenderQueue();
 
 private:
 	bool m_isQuitting = false;
+	int m_exitCode = 0;
 	bool m_doDebugRendering = false;
 	Camera* m_appCamera;
+	ReplayExporter* m_exporter = nullptr;
+	RecordingRenderBackend* m_renderRecorder = nullptr;
+	bool m_showRenderStats = false;
+	RenderQueue* m_renderQueue = nullptr;
+	FramePacer* m_framePacer = nullptr;		// Only in low latency pacing mode
+	std::map<std::string, std::string> m_gameConfigFileValues;	// As last read from GameConfig.xml
 
 public:
 	Game*	m_theGame;
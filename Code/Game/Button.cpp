@@ -1,10 +1,12 @@
 #include "Game/Button.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/RenderBackend.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Core/Clock.hpp"
 #include "Engine/Renderer/Renderer.hpp"
+#include "Engine/Renderer/BitmapFont.hpp"
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -28,6 +30,8 @@ Button::Button( AABB2 const& bounds, std::string const& eventName, std::string c
 	, m_eventName( eventName )
 	, m_label( label )
 {
+	RebuildQuadVerts();
+	RebuildLabelVerts();
 }
 
 
@@ -53,6 +57,17 @@ void Button::Reset()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+void Button::SetLabel( std::string const& label )
+{
+	if ( label == m_label )
+		return;
+
+	m_label = label;
+	RebuildLabelVerts();
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Button::Update( Vec2 const& cursorPosition )
 {
@@ -62,33 +77,22 @@ void Button::Update( Vec2 const& cursorPosition )
 
 
 //----------------------------------------------------------------------------------------------------------
-void Button::Render() const
+void Button::AddQuadVerts( Mesh& out_verts ) const
 {
-	Mesh verts;
-	Rgba8 color;
-	if		( m_pressed )	color = m_pressedColor;
-	else if ( m_hovered )	color = m_hoveredColor;
-	else if ( m_selected )	color = m_selectedColor;
-	else					color = m_defaultColor;
-
-	AddVertsForAABB2D( verts, m_bounds, color );
+	Mesh const& quadVerts = m_quadVerts[(int)GetVisualState()];
+	out_verts.insert( out_verts.end(), quadVerts.begin(), quadVerts.end() );
+}
 
-	g_theRenderer->BindTexture( nullptr );
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetModelConstants();
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawVertexArray( verts );
 
-	IndexedMesh labelMesh;
-	AABB2 textBoxBounds = m_bounds;
-	textBoxBounds.PadAllSides( -10.f );
-	float const& height = m_bounds.GetDimensions().y;
-	g_defaultFont->AddVertsForTextInBox2D( labelMesh, m_label, textBoxBounds, height, Rgba8::BLACK, .66f );
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->DrawIndexedMesh( labelMesh );
+//----------------------------------------------------------------------------------------------------------
+void Button::AddLabelVerts( IndexedMesh& out_verts ) const
+{
+	unsigned int indexOffset = static_cast<unsigned int>( out_verts.m_vertexes.size() );
+	out_verts.m_vertexes.insert( out_verts.m_vertexes.end(), m_labelVerts.m_vertexes.begin(), m_labelVerts.m_vertexes.end() );
+	for ( unsigned int index : m_labelVerts.m_indexes )
+	{
+		out_verts.m_indexes.push_back( index + indexOffset );
+	}
 }
 
 
@@ -113,6 +117,30 @@ void Button::OnPress()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+bool Button::IsPressed() const
+{
+	return m_pressed;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ButtonVisualState Button::GetVisualState() const
+{
+	if		( m_pressed )	return ButtonVisualState::PRESSED;
+	else if ( m_hovered )	return ButtonVisualState::HOVERED;
+	else if ( m_selected )	return ButtonVisualState::SELECTED;
+	else					return ButtonVisualState::DEFAULT;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int Button::GetLabelRevision() const
+{
+	return m_labelRevision;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 bool Button::CheckCursorOverlap( Vec2 const& cursorPosition )
 {
@@ -134,3 +162,27 @@ void Button::UpdatePressedState()
 		g_theEventSystem->FireEvent( BUTTON_PRESS_EVENT_NAME, arguments );
 	}
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+void Button::RebuildQuadVerts()
+{
+	Rgba8 const stateColors[(int)ButtonVisualState::COUNT] = { m_defaultColor, m_hoveredColor, m_selectedColor, m_pressedColor };
+	for ( int stateIndex = 0; stateIndex < (int)ButtonVisualState::COUNT; stateIndex++ )
+	{
+		m_quadVerts[stateIndex].clear();
+		AddVertsForAABB2D( m_quadVerts[stateIndex], m_bounds, stateColors[stateIndex] );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Button::RebuildLabelVerts()
+{
+	m_labelVerts = IndexedMesh();
+	AABB2 textBoxBounds = m_bounds;
+	textBoxBounds.PadAllSides( -10.f );
+	float const& height = m_bounds.GetDimensions().y;
+	g_defaultFont->AddVertsForTextInBox2D( m_labelVerts, m_label, textBoxBounds, height, Rgba8::BLACK, .66f );
+	m_labelRevision++;
+}
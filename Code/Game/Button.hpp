@@ -1,6 +1,7 @@
 #pragma once
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Core/Rgba8.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
 #include <string>
 
 
@@ -24,6 +25,21 @@ enum CardinalDirection : int
 
 
 //----------------------------------------------------------------------------------------------------------
+enum class ButtonVisualState
+{
+	DEFAULT,
+	HOVERED,
+	SELECTED,
+	PRESSED,
+
+	COUNT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Keeps its tessellated quad for every visual state and its label, rebuilt only when the label changes,
+// so a menu can batch its buttons without tessellating anything per frame
+//
 class Button
 {
 public:
@@ -31,16 +47,23 @@ public:
 
 	void LinkTo( Button& otherButton, CardinalDirection direction, bool oneWay = false );
 	void Reset();
+	void SetLabel( std::string const& label );
 
 	void Update( Vec2 const& cursorPosition );
-	void Render() const;
+	void AddQuadVerts( Mesh& out_verts ) const;				// In its current visual state
+	void AddLabelVerts( IndexedMesh& out_verts ) const;
 
 	bool TryClick();
 	void OnPress();
+	bool IsPressed() const;
+	ButtonVisualState GetVisualState() const;
+	unsigned int GetLabelRevision() const;
 
 private:
 	bool CheckCursorOverlap( Vec2 const& cursorPosition );
 	void UpdatePressedState();
+	void RebuildQuadVerts();
+	void RebuildLabelVerts();
 
 public:
 	Button* m_neighbors[NUM_CARDINAL_DIRECTIONS] = { nullptr };
@@ -57,6 +80,10 @@ private:
 	bool m_pressed = false;
 	bool m_hovered = false;
 
+	Mesh m_quadVerts[(int)ButtonVisualState::COUNT];
+	IndexedMesh m_labelVerts;
+	unsigned int m_labelRevision = 0;
+
 public:
 	bool m_selected = false;
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "Game/CameraTrack.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Path.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <algorithm>
+
+
+//----------------------------------------------------------------------------------------------------------
+static Vec2 EvaluateCatmullRom( Vec2 const& p0, Vec2 const& p1, Vec2 const& p2, Vec2 const& p3, float t )
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+
+	Vec2 a = 2.f * p1;
+	Vec2 b = p2 - p0;
+	Vec2 c = 2.f * p0 - 5.f * p1 + 4.f * p2 - p3;
+	Vec2 d = 3.f * p1 - p0 - 3.f * p2 + p3;
+
+	return .5f * ( a + ( b * t ) + ( c * t2 ) + ( d * t3 ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CameraTrack::Bake( Path const& path, int nodeLookahead, int smoothingRadius )
+{
+	Clear();
+
+	int nodeCount = static_cast<int>( path.GetNodeCount() );
+	if ( nodeCount == 0 )
+		return;
+
+	// Same target the live camera chases: the node a few tiles ahead of the player
+	std::vector<Vec2> targets;
+	targets.reserve( nodeCount );
+	for ( int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		int targetIndex = nodeIndex + nodeLookahead;
+		if ( targetIndex >= nodeCount )
+		{
+			targetIndex = nodeCount - 1;
+		}
+
+		targets.push_back( path.GetNode( targetIndex )->GetPosition() );
+	}
+
+	// Box filter over neighboring targets takes the corners out of sharp turns and spins
+	m_keys.reserve( nodeCount );
+	for ( int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		Vec2 sum = Vec2::ZERO;
+		int sampleCount = 0;
+		for ( int offset = -smoothingRadius; offset <= smoothingRadius; offset++ )
+		{
+			int sampleIndex = nodeIndex + offset;
+			if ( sampleIndex < 0 || sampleIndex >= nodeCount )
+				continue;
+
+			sum += targets[sampleIndex];
+			sampleCount++;
+		}
+
+		double timeInBeats = path.GetNode( nodeIndex )->m_timeInBeats;
+		if ( !m_keys.empty() && timeInBeats <= m_keys.back().m_timeInBeats )
+			continue;	// Keys must be strictly increasing in time for the lookup
+
+		CameraTrackKey& key = m_keys.emplace_back();
+		key.m_timeInBeats = timeInBeats;
+		key.m_position = sum / static_cast<float>( sampleCount );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CameraTrack::Clear()
+{
+	m_keys.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool CameraTrack::IsBaked() const
+{
+	return !m_keys.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec2 CameraTrack::GetPositionAtBeat( double timeInBeats ) const
+{
+	if ( m_keys.empty() )
+		return Vec2::ZERO;
+
+	if ( timeInBeats <= m_keys.front().m_timeInBeats )
+		return m_keys.front().m_position;
+
+	if ( timeInBeats >= m_keys.back().m_timeInBeats )
+		return m_keys.back().m_position;
+
+	// First key strictly after the requested time; the segment starts one before it
+	auto nextKey = std::upper_bound( m_keys.begin(), m_keys.end(), timeInBeats,
+		[]( double time, CameraTrackKey const& key ) { return time < key.m_timeInBeats; } );
+
+	int lastIndex = static_cast<int>( m_keys.size() ) - 1;
+	int index2 = static_cast<int>( nextKey - m_keys.begin() );
+	int index1 = index2 - 1;
+	int index0 = index1 > 0 ? index1 - 1 : 0;
+	int index3 = index2 < lastIndex ? index2 + 1 : lastIndex;
+
+	CameraTrackKey const& key1 = m_keys[index1];
+	CameraTrackKey const& key2 = m_keys[index2];
+	double fraction = GetFractionWithinRange( timeInBeats, key1.m_timeInBeats, key2.m_timeInBeats );
+
+	return EvaluateCatmullRom( m_keys[index0].m_position, key1.m_position, key2.m_position, m_keys[index3].m_position,
+		static_cast<float>( fraction ) );
+}
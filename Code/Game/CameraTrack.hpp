@@ -0,0 +1,33 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+class Path;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CameraTrackKey
+{
+	double m_timeInBeats = 0.0;
+	Vec2 m_position = Vec2::ZERO;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// A camera path precomputed from a fully loaded Path. Keys are placed at every node's input time and
+// evaluated as a Catmull-Rom spline, so the camera is a pure function of the conductor's beat.
+//
+class CameraTrack
+{
+public:
+	void Bake( Path const& path, int nodeLookahead = 4, int smoothingRadius = 2 );
+	void Clear();
+
+	bool IsBaked() const;
+	Vec2 GetPositionAtBeat( double timeInBeats ) const;
+
+private:
+	std::vector<CameraTrackKey> m_keys;
+};
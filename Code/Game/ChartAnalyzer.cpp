@@ -0,0 +1,158 @@
+#include "Game/ChartAnalyzer.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/Level.hpp"
+#include "Game/Path.hpp"
+#include "Game/TempoMap.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr double CHART_PEAK_WINDOW_SECONDS = 5.0;
+
+// Rating weights, fitted so the charts that shipped with hand-typed difficulties land close to them
+constexpr float RATING_SCALE					= .65f;
+constexpr float PEAK_DENSITY_WEIGHT				= .8f;
+constexpr float AVERAGE_DENSITY_WEIGHT			= .4f;
+constexpr float IRREGULARITY_WEIGHT				= 2.f;
+constexpr float SPIN_WEIGHT						= 8.f;
+constexpr float SPEED_CHANGE_WEIGHT				= 10.f;
+constexpr float TURN_SHARPNESS_WEIGHT			= 2.f;
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetTurnDegrees( float fromAngle, float toAngle )
+{
+	float turn = fmodf( toAngle - fromAngle, 360.f );
+	if ( turn > 180.f )		turn -= 360.f;
+	if ( turn < -180.f )	turn += 360.f;
+	return fabsf( turn );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Node 0 is where the player starts, so the taps are nodes 1 onward and their times come straight from
+// m_timeInTicks, which already has every speed change folded in.
+//
+ChartDifficulty AnalyzeChart( Path const& path, TempoMap const& tempoMap )
+{
+	ChartDifficulty difficulty;
+	int nodeCount = static_cast<int>( path.GetNodeCount() );
+	int tapCount = nodeCount - 1;
+	if ( tapCount < 2 )
+		return difficulty;
+
+	std::vector<double> tapTimesSeconds( tapCount );
+	for ( int tapIndex = 0; tapIndex < tapCount; tapIndex++ )
+	{
+		tapTimesSeconds[tapIndex] = tempoMap.TicksToSeconds( path.GetNode( tapIndex + 1 )->m_timeInTicks );
+	}
+
+	double chartSeconds = tapTimesSeconds.back() - tapTimesSeconds.front();
+	if ( chartSeconds > 0.0 )
+	{
+		difficulty.m_notesPerSecond = static_cast<float>( tapCount / chartSeconds );
+	}
+
+	int windowStartIndex = 0;
+	int peakTapsInWindow = 0;
+	for ( int tapIndex = 0; tapIndex < tapCount; tapIndex++ )
+	{
+		while ( tapTimesSeconds[tapIndex] - tapTimesSeconds[windowStartIndex] > CHART_PEAK_WINDOW_SECONDS )
+		{
+			windowStartIndex++;
+		}
+		peakTapsInWindow = std::max( peakTapsInWindow, tapIndex - windowStartIndex + 1 );
+	}
+	difficulty.m_peakNotesPerSecond = static_cast<float>( peakTapsInWindow / CHART_PEAK_WINDOW_SECONDS );
+
+	double irregularitySum = 0.0;
+	int intervalPairCount = 0;
+	for ( int tapIndex = 2; tapIndex < tapCount; tapIndex++ )
+	{
+		double prevInterval = tapTimesSeconds[tapIndex - 1] - tapTimesSeconds[tapIndex - 2];
+		double interval = tapTimesSeconds[tapIndex] - tapTimesSeconds[tapIndex - 1];
+		if ( prevInterval <= 0.0 || interval <= 0.0 )
+			continue;
+
+		irregularitySum += fabs( log2( interval / prevInterval ) );
+		intervalPairCount++;
+	}
+	if ( intervalPairCount > 0 )
+	{
+		difficulty.m_irregularity = static_cast<float>( irregularitySum / intervalPairCount );
+	}
+
+	int spinCount = 0;
+	int speedChangeCount = 0;
+	float turnSum = 0.f;
+	for ( int nodeIndex = 1; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		PathNode const& prevNode = *path.GetNode( nodeIndex - 1 );
+		PathNode const& node = *path.GetNode( nodeIndex );
+		if ( node.m_clockwise != prevNode.m_clockwise )
+		{
+			spinCount++;
+		}
+		if ( node.m_speed != prevNode.m_speed )
+		{
+			speedChangeCount++;
+		}
+		turnSum += GetTurnDegrees( prevNode.m_angle, node.m_angle ) / 180.f;
+	}
+	difficulty.m_spinsPerNote = static_cast<float>( spinCount ) / static_cast<float>( tapCount );
+	difficulty.m_speedChangesPerNote = static_cast<float>( speedChangeCount ) / static_cast<float>( tapCount );
+	difficulty.m_turnSharpness = turnSum / static_cast<float>( tapCount );
+
+	difficulty.m_rating = RATING_SCALE * (
+		PEAK_DENSITY_WEIGHT		* difficulty.m_peakNotesPerSecond +
+		AVERAGE_DENSITY_WEIGHT	* difficulty.m_notesPerSecond +
+		IRREGULARITY_WEIGHT		* difficulty.m_irregularity +
+		SPIN_WEIGHT				* difficulty.m_spinsPerNote +
+		SPEED_CHANGE_WEIGHT		* difficulty.m_speedChangesPerNote +
+		TURN_SHARPNESS_WEIGHT	* difficulty.m_turnSharpness );
+	return difficulty;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Levels are independent and analysis only reads their paths, so each thread claims whole levels through
+// an atomic cursor and writes only to the levels it claimed.
+//
+void AnalyzeLevelLibrary( Level* levels, unsigned int levelCount )
+{
+	if ( levelCount == 0 )
+		return;
+
+	int threadCount = static_cast<int>( std::thread::hardware_concurrency() );
+	threadCount = std::clamp( threadCount, 1, static_cast<int>( levelCount ) );
+
+	std::atomic<unsigned int> nextLevelIndex = 0;
+	auto analyzeWork = [&]()
+	{
+		for ( ;; )
+		{
+			unsigned int levelIndex = nextLevelIndex.fetch_add( 1, std::memory_order_relaxed );
+			if ( levelIndex >= levelCount )
+				break;
+
+			levels[levelIndex].AnalyzeChart();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve( threadCount - 1 );
+	for ( int threadIndex = 1; threadIndex < threadCount; threadIndex++ )
+	{
+		threads.emplace_back( analyzeWork );
+	}
+	analyzeWork();
+	for ( std::thread& thread : threads )
+	{
+		thread.join();
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+
+//----------------------------------------------------------------------------------------------------------
+class Path;
+class Level;
+class TempoMap;
+
+
+//----------------------------------------------------------------------------------------------------------
+// What makes a chart hard to play, measured from the compiled path in real time so the level's tempo and
+// the nodes' speed changes are already accounted for. m_rating folds them into one number on roughly the
+// same scale charters used to type by hand.
+//
+struct ChartDifficulty
+{
+	float	m_notesPerSecond		= 0.f;	// Averaged over the whole chart
+	float	m_peakNotesPerSecond	= 0.f;	// Densest CHART_PEAK_WINDOW_SECONDS stretch
+	float	m_irregularity			= 0.f;	// Mean |log2| ratio between consecutive tap intervals; 0 is a straight rhythm
+	float	m_spinsPerNote			= 0.f;
+	float	m_speedChangesPerNote	= 0.f;
+	float	m_turnSharpness			= 0.f;	// Mean change of direction per node, 1 is a full reversal
+	float	m_rating				= 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+ChartDifficulty AnalyzeChart( Path const& path, TempoMap const& tempoMap );
+void AnalyzeLevelLibrary( Level* levels, unsigned int levelCount );
@@ -0,0 +1,479 @@
+#include "Game/ChartEditor.hpp"
+#include "Game/CameraTrack.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/Conductor.hpp"
+#include "Game/Path.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/TaggedString.hpp"
+#include "Engine/Core/VertexUtils.hpp"
+#include "Engine/Input/InputSystem.hpp"
+#include "Engine/Audio/AudioSystem_Wwise.hpp"
+#include "Engine/Math/AABB2.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Renderer/BitmapFont.hpp"
+#include "Engine/Window/Window.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr float EDITOR_MIN_NODE_BEATS = 0.0625f;	// A sixteenth; anything shorter can't be tapped anyway
+constexpr float EDITOR_MAX_NODE_BEATS = 4.f;
+constexpr float EDITOR_SPEED_STEP = 0.25f;
+
+
+//----------------------------------------------------------------------------------------------------------
+ChartEditor::ChartEditor()
+{
+	float aspect = g_theWindow->GetAspect();
+	float gameSize = g_gameConfigBlackboard.GetValue( "gameSize", 10.f );
+	Vec2 gameCameraDimensions;
+	gameCameraDimensions.y = gameSize;
+	gameCameraDimensions.x = gameSize * aspect;
+	AABB2 gameCameraBounds = AABB2( Vec2::ZERO, gameCameraDimensions );
+	gameCameraBounds.SetCenter( Vec2::ZERO );
+	m_camera.SetOrthoView( gameCameraBounds );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ChartEditor::~ChartEditor()
+{
+	Close();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Compiles a private copy of the chart rather than borrowing the level's, so nothing the level holds on
+// to (its player, its checkpoints, a pending hot reload) ever sees a half-edited path.
+//
+bool ChartEditor::Open( std::string const& levelFilePath )
+{
+	Close();
+	m_chart.Reset();
+
+	ChartCompileSettings settings = ChartCompileSettings::FromGameConfig();
+	settings.m_bakeCamera = false;
+	if ( !Level::CompileChart( levelFilePath, settings, m_chart ) || m_chart.m_path->GetNodeCount() == 0 )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Can't edit \"%s\": %s", levelFilePath.c_str(), m_chart.m_errorMessage.c_str() ) );
+		Close();
+		return false;
+	}
+
+	m_chart.m_path->UploadVertexBuffers();
+	SoundEventID musicPlayEvent = g_theAudio->GetEventID( m_chart.m_musicPlayEvent );
+	SoundEventID musicStopEvent = g_theAudio->GetEventID( m_chart.m_musicStopEvent );
+	m_conductor = new Conductor( m_chart.m_tempoMap, musicPlayEvent, musicStopEvent, m_chart.m_countdownLength );
+
+	m_loopStartNodeIndex = 0;
+	m_loopEndNodeIndex = -1;
+	m_isPlaying = false;
+	m_hasUnsavedEdits = false;
+	m_hasSavedChanges = false;
+	m_statusText = Stringf( "Editing %s", m_chart.m_pathFilePath.c_str() );
+	Select( 0 );
+	m_camera.SnapTo( m_chart.m_path->GetNode( 0 )->GetPosition() );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::Close()
+{
+	if ( m_hasUnsavedEdits )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Discarded unsaved edits to \"%s\"", m_chart.m_pathFilePath.c_str() ) );
+		m_hasUnsavedEdits = false;
+	}
+
+	delete m_conductor;
+	m_conductor = nullptr;
+
+	delete m_chart.m_path;
+	m_chart.m_path = nullptr;
+
+	delete m_chart.m_cameraTrack;
+	m_chart.m_cameraTrack = nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::Update()
+{
+	if ( m_chart.m_path == nullptr )
+		return;
+
+	UpdateTransport();
+	UpdateEdits();
+
+	if ( m_isPlaying )
+	{
+		m_conductor->RefreshInputDelay();
+		m_conductor->Update( llround( GetGameClock()->GetDeltaSeconds() * 1'000'000.0 ) );
+		double currentTimeInBeats = GetCurrentTimeInBeats();
+		PlayDueClicks( m_lastTimeInBeats, currentTimeInBeats );
+		m_lastTimeInBeats = currentTimeInBeats;
+
+		if ( currentTimeInBeats >= GetLoopEndTimeInBeats() )
+		{
+			ScrubTo( m_chart.m_path->GetNode( m_loopStartNodeIndex )->m_timeInBeats );
+		}
+	}
+
+	Vec2 pivotPosition;
+	Vec2 orbitPosition;
+	GetPreviewPlanetPositions( GetCurrentTimeInBeats(), pivotPosition, orbitPosition );
+	m_camera.m_targetPosition = pivotPosition;
+	m_camera.Update();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::Render() const
+{
+	if ( m_chart.m_path == nullptr )
+		return;
+
+	Path const& path = *m_chart.m_path;
+	g_theRenderBackend->BeginCamera( m_camera );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::WORLD );
+	path.Render();
+
+	// Loop markers and the selection under the planets, planets on top
+	float planetRadius = path.GetWidth() * .4f;
+	Mesh& verts = g_theFrameArena->AllocateMesh();
+	PathNode const* loopStartNode = path.GetNode( m_loopStartNodeIndex );
+	PathNode const* loopEndNode = m_loopEndNodeIndex >= 0 ? path.GetNode( m_loopEndNodeIndex ) : path.GetLastNode();
+	AddVertsForDisc2D( verts, loopStartNode->GetPosition(), planetRadius * 1.6f, Rgba8( 0, 200, 0, 120 ), 24 );
+	AddVertsForDisc2D( verts, loopEndNode->GetPosition(), planetRadius * 1.6f, Rgba8( 200, 0, 0, 120 ), 24 );
+
+	PathNode const* selectedNode = path.GetNode( m_selectedNodeIndex );
+	AddVertsForDisc2D( verts, selectedNode->GetPosition(), planetRadius * 1.3f, Rgba8( 255, 220, 0, 160 ), 24 );
+
+	Vec2 pivotPosition;
+	Vec2 orbitPosition;
+	GetPreviewPlanetPositions( GetCurrentTimeInBeats(), pivotPosition, orbitPosition );
+	AddVertsForDisc2D( verts, pivotPosition, planetRadius, Rgba8::RED, 32 );
+	AddVertsForDisc2D( verts, orbitPosition, planetRadius, Rgba8::BLUE, 32 );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::ACTORS );
+	g_theRenderBackend->BindTexture( nullptr );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawVertexArray( verts );
+
+	g_theRenderBackend->EndCamera( m_camera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::RenderHUD( AABB2 const& screenBounds ) const
+{
+	if ( m_chart.m_path == nullptr )
+		return;
+
+	Path const& path = *m_chart.m_path;
+	PathNodeDef const& def = path.GetNodeDef( m_selectedNodeIndex );
+	PathNode const* node = path.GetNode( m_selectedNodeIndex );
+	double currentTimeInBeats = GetCurrentTimeInBeats();
+
+	TempoMap const& tempoMap = m_chart.m_tempoMap;
+	int measure = 0;
+	double beatInMeasure = 0.0;
+	tempoMap.GetMeasureAndBeat( node->m_timeInBeats, measure, beatInMeasure );
+	std::string nodeText = Stringf( "Node %i / %u%s\nbeat %g  speed %g%s%s%s\nat beat %.3f (bar %i beat %.3f, %.3f s, %g bpm)",
+		m_selectedNodeIndex, path.GetNodeCount(), m_hasUnsavedEdits ? "  (unsaved)" : "",
+		def.m_beats, node->m_speed, def.m_speed > 0.f ? "" : " (inherited)", def.m_spin ? "  spin" : "", def.m_checkpoint ? "  checkpoint" : "",
+		node->m_timeInBeats, measure + 1, beatInMeasure + 1.0, tempoMap.BeatsToSeconds( node->m_timeInBeats ), tempoMap.GetBpm( node->m_timeInBeats ) );
+
+	std::string transportText = Stringf( "%s  beat %.3f / %.3f\n%s",
+		m_isPlaying ? "Playing" : "Paused", currentTimeInBeats, path.GetTotalTimeInBeats(), m_statusText.c_str() );
+
+	std::string helpText =
+		"LEFT/RIGHT select  F/G scrub a beat  SPACE play/pause  J/K loop start/end\n"
+		"UP/DOWN beat +-1/4  A/D beat +-1/16  Q/W speed  E inherit speed  S spin  C checkpoint\n"
+		"N insert  X delete  ENTER save  ESC exit";
+
+	AABB2 textBounds = screenBounds;
+	textBounds.PadAllSides( -25.f );
+	AABB2 helpBounds = textBounds.ChopOffBottom( .15f );
+
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, TaggedString( nodeText ), textBounds, 30.f, Rgba8::WHITE, .6f, Vec2( 0.f, 1.f ) );
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, TaggedString( transportText ), textBounds, 30.f, Rgba8::PASTEL_BLUE, .6f, Vec2( 1.f, 1.f ) );
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, TaggedString( helpText ), helpBounds, 20.f, Rgba8::PASTEL_GREEN, .6f, Vec2( .5f, 0.f ) );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Writes the path file only; the level file is never touched. With hot reload on, the watcher picks the
+// save up like any other edit, and the game queues the level's reload itself when the editor exits.
+//
+bool ChartEditor::Save()
+{
+	if ( m_chart.m_path == nullptr )
+		return false;
+
+	if ( !m_chart.m_path->SaveToXmlFile( m_chart.m_pathFilePath ) )
+	{
+		m_statusText = Stringf( "Failed to save %s", m_chart.m_pathFilePath.c_str() );
+		g_theDevConsole->AddLine( DevConsole::WARNING, m_statusText );
+		return false;
+	}
+
+	m_statusText = Stringf( "Saved %s", m_chart.m_pathFilePath.c_str() );
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, m_statusText );
+	m_hasUnsavedEdits = false;
+	m_hasSavedChanges = true;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool ChartEditor::HasSavedChanges() const
+{
+	return m_hasSavedChanges;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Each key press is one edit to the selected node, applied through the path's incremental recompile
+//
+void ChartEditor::UpdateEdits()
+{
+	Path& path = *m_chart.m_path;
+	PathNodeDef def = path.GetNodeDef( m_selectedNodeIndex );
+	float currentSpeed = path.GetNode( m_selectedNodeIndex )->m_speed;
+	bool isDefChanged = true;
+
+	if		( g_theInput->GetKeyDown( KEYCODE_UP ) )	def.m_beats += .25f;
+	else if ( g_theInput->GetKeyDown( KEYCODE_DOWN ) )	def.m_beats -= .25f;
+	else if ( g_theInput->GetKeyDown( 'D' ) )			def.m_beats += .0625f;
+	else if ( g_theInput->GetKeyDown( 'A' ) )			def.m_beats -= .0625f;
+	else if ( g_theInput->GetKeyDown( 'W' ) )			def.m_speed = currentSpeed + EDITOR_SPEED_STEP;
+	else if ( g_theInput->GetKeyDown( 'Q' ) )			def.m_speed = std::max( currentSpeed - EDITOR_SPEED_STEP, EDITOR_SPEED_STEP );
+	else if ( g_theInput->GetKeyDown( 'E' ) )			def.m_speed = 0.f;
+	else if ( g_theInput->GetKeyDown( 'S' ) )			def.m_spin = !def.m_spin;
+	else if ( g_theInput->GetKeyDown( 'C' ) )			def.m_checkpoint = !def.m_checkpoint;
+	else												isDefChanged = false;
+
+	if ( isDefChanged )
+	{
+		def.m_beats = std::clamp( def.m_beats, EDITOR_MIN_NODE_BEATS, EDITOR_MAX_NODE_BEATS );
+		path.SetNodeDef( m_selectedNodeIndex, def );
+		m_hasUnsavedEdits = true;
+	}
+	else if ( g_theInput->GetKeyDown( 'N' ) )
+	{
+		PathNodeDef newDef;
+		newDef.m_beats = def.m_beats;
+		path.InsertNode( m_selectedNodeIndex + 1, newDef );
+		m_selectedNodeIndex++;
+		m_hasUnsavedEdits = true;
+	}
+	else if ( g_theInput->GetKeyDown( 'X' ) && path.GetNodeCount() > 1 )
+	{
+		path.RemoveNode( m_selectedNodeIndex );
+		m_hasUnsavedEdits = true;
+	}
+	else if ( g_theInput->GetKeyDown( KEYCODE_ENTER ) )
+	{
+		Save();
+		return;
+	}
+	else
+	{
+		return;
+	}
+
+	// Node indexes and times may have moved; keep everything pointing at a real node
+	int lastNodeIndex = static_cast<int>( path.GetNodeCount() ) - 1;
+	m_loopStartNodeIndex = std::min( m_loopStartNodeIndex, lastNodeIndex );
+	m_loopEndNodeIndex = std::min( m_loopEndNodeIndex, lastNodeIndex );
+	if ( !m_isPlaying )
+	{
+		Select( std::min( m_selectedNodeIndex, lastNodeIndex ) );
+	}
+	else
+	{
+		m_selectedNodeIndex = std::min( m_selectedNodeIndex, lastNodeIndex );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::UpdateTransport()
+{
+	Path const& path = *m_chart.m_path;
+	int lastNodeIndex = static_cast<int>( path.GetNodeCount() ) - 1;
+
+	if ( g_theInput->GetKeyDown( KEYCODE_SPACE ) )
+	{
+		SetPlaying( !m_isPlaying );
+	}
+
+	if ( g_theInput->GetKeyDown( KEYCODE_RIGHT ) )
+	{
+		Select( std::min( m_selectedNodeIndex + 1, lastNodeIndex ) );
+	}
+	if ( g_theInput->GetKeyDown( KEYCODE_LEFT ) )
+	{
+		Select( std::max( m_selectedNodeIndex - 1, 0 ) );
+	}
+
+	// Scrubbing snaps to the beat grid, and selects whatever node is pivoting there
+	double scrubBeats = 0.0;
+	if ( g_theInput->GetKeyDown( 'G' ) )	scrubBeats = 1.0;
+	if ( g_theInput->GetKeyDown( 'F' ) )	scrubBeats = -1.0;
+	if ( scrubBeats != 0.0 )
+	{
+		double scrubTimeInBeats = floor( GetCurrentTimeInBeats() + 0.5 ) + scrubBeats;
+		ScrubTo( scrubTimeInBeats );
+		m_selectedNodeIndex = path.GetNodeIndexAtTime( m_cursorTimeInBeats );
+	}
+
+	if ( g_theInput->GetKeyDown( 'J' ) )
+	{
+		m_loopStartNodeIndex = m_selectedNodeIndex;
+	}
+	if ( g_theInput->GetKeyDown( 'K' ) )
+	{
+		m_loopEndNodeIndex = ( m_loopEndNodeIndex == m_selectedNodeIndex ) ? -1 : m_selectedNodeIndex;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The same click the calibrator plays, on every node the preview passed this frame, so the chart can be
+// checked by ear against the song
+//
+void ChartEditor::PlayDueClicks( double prevTimeInBeats, double currentTimeInBeats )
+{
+	Path const& path = *m_chart.m_path;
+	int nodeIndex = path.GetNodeIndexAtTime( prevTimeInBeats ) + 1;
+	PathNode const* node = path.GetNode( nodeIndex );
+	while ( node != nullptr && node->m_timeInBeats <= currentTimeInBeats )
+	{
+		if ( node->m_timeInBeats > prevTimeInBeats )
+		{
+			g_theAudio->PlayEvent( AK::EVENTS::PLAY_TESTCLICK );
+			break;	// Several nodes in one frame are one click
+		}
+		node = path.GetNode( ++nodeIndex );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::Select( int nodeIndex )
+{
+	PathNode const* node = m_chart.m_path->GetNode( nodeIndex );
+	if ( node == nullptr )
+		return;
+
+	m_selectedNodeIndex = nodeIndex;
+	ScrubTo( node->m_timeInBeats );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Seeking the music is all it takes to scrub: the conductor counts beats from wherever it starts
+//
+void ChartEditor::ScrubTo( double timeInBeats )
+{
+	m_cursorTimeInBeats = std::clamp( timeInBeats, 0.0, m_chart.m_path->GetTotalTimeInBeats() );
+	m_lastTimeInBeats = m_cursorTimeInBeats;
+	if ( m_isPlaying )
+	{
+		m_conductor->PlayAt( m_cursorTimeInBeats );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ChartEditor::SetPlaying( bool isPlaying )
+{
+	if ( isPlaying == m_isPlaying )
+		return;
+
+	if ( isPlaying )
+	{
+		if ( m_cursorTimeInBeats >= GetLoopEndTimeInBeats() )
+		{
+			m_cursorTimeInBeats = m_chart.m_path->GetNode( m_loopStartNodeIndex )->m_timeInBeats;
+		}
+		m_isPlaying = true;
+		ScrubTo( m_cursorTimeInBeats );
+		return;
+	}
+
+	m_cursorTimeInBeats = GetCurrentTimeInBeats();
+	m_isPlaying = false;
+	m_conductor->Stop();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double ChartEditor::GetCurrentTimeInBeats() const
+{
+	if ( m_isPlaying )
+		return m_conductor->GetCurrentTimeInBeats();
+
+	return m_cursorTimeInBeats;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double ChartEditor::GetLoopEndTimeInBeats() const
+{
+	Path const& path = *m_chart.m_path;
+	double loopStartTimeInBeats = path.GetNode( m_loopStartNodeIndex )->m_timeInBeats;
+	PathNode const* loopEndNode = path.GetNode( m_loopEndNodeIndex );
+	if ( loopEndNode == nullptr || loopEndNode->m_timeInBeats <= loopStartTimeInBeats )
+		return path.GetTotalTimeInBeats();
+
+	return loopEndNode->m_timeInBeats;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Where the planets are at this time during play, worked out exactly as PlayerPlanets does from the node
+// that is pivoting, so what the editor shows is what the player will see
+//
+void ChartEditor::GetPreviewPlanetPositions( double timeInBeats, Vec2& out_pivotPosition, Vec2& out_orbitPosition ) const
+{
+	Path const& path = *m_chart.m_path;
+	int nodeIndex = path.GetNodeIndexAtTime( timeInBeats );
+	PathNode const* node = path.GetNode( nodeIndex );
+	PathNode const* prevNode = path.GetNode( nodeIndex - 1 );
+
+	float turnDirection = node->m_clockwise ? -1.f : 1.f;
+	double fractionUntilOneBeatAway = GetFractionWithinRange( timeInBeats, node->m_timeInBeats, node->m_timeInBeats + 1.f / node->m_speed );
+	float angleDispFromPrevAngle = Interpolate( 0, turnDirection * 180.f, static_cast<float>( fractionUntilOneBeatAway ) );
+	float inAngle = prevNode != nullptr ? prevNode->m_angle : 0.f;
+	float angle = GetNormalizedAngle( 180.f + inAngle + angleDispFromPrevAngle );
+
+	out_pivotPosition = node->GetPosition();
+	out_orbitPosition = out_pivotPosition + Vec2::MakeFromPolarDegrees( angle, node->m_radius * 2.f );
+}
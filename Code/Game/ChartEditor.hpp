@@ -0,0 +1,61 @@
+#pragma once
+#include "Game/GameCamera.hpp"
+#include "Game/Level.hpp"
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+class Conductor;
+class Path;
+struct AABB2;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Edits one level's path in place while its song loops. The editor compiles its own copy of the chart,
+// so the level itself is untouched until the edits are saved and hot reload picks the file up. Every
+// edit goes through Path's incremental recompile, so only the chunk that changed is rebuilt and
+// re-uploaded, and node times stay exactly what a fresh load of the saved file would give.
+//
+class ChartEditor
+{
+public:
+	ChartEditor();
+	~ChartEditor();
+
+	bool Open( std::string const& levelFilePath );
+	void Close();
+
+	void Update();
+	void Render() const;
+	void RenderHUD( AABB2 const& screenBounds ) const;
+
+	bool Save();
+	bool HasSavedChanges() const;
+
+private:
+	void UpdateEdits();
+	void UpdateTransport();
+	void PlayDueClicks( double prevTimeInBeats, double currentTimeInBeats );
+
+	void Select( int nodeIndex );
+	void ScrubTo( double timeInBeats );
+	void SetPlaying( bool isPlaying );
+	double GetCurrentTimeInBeats() const;
+	double GetLoopEndTimeInBeats() const;
+	void GetPreviewPlanetPositions( double timeInBeats, Vec2& out_pivotPosition, Vec2& out_orbitPosition ) const;
+
+private:
+	CompiledChart	m_chart;
+	Conductor*		m_conductor			= nullptr;
+	GameCamera		m_camera;
+
+	int				m_selectedNodeIndex	= 0;
+	int				m_loopStartNodeIndex = 0;
+	int				m_loopEndNodeIndex	= -1;		// Negative loops to the end of the path
+	double			m_cursorTimeInBeats	= 0.0;		// Where playback starts from, and the preview while paused
+	double			m_lastTimeInBeats	= 0.0;		// Clicks are played for nodes passed since this
+	bool			m_isPlaying			= false;
+	bool			m_hasUnsavedEdits	= false;
+	bool			m_hasSavedChanges	= false;
+	std::string		m_statusText;
+};
@@ -1,9 +1,8 @@
 #include "Game/Conductor.hpp"
 #include "Game/GameCommon.hpp"
 #include "Engine/Core/NamedStrings.hpp"
-#include "Engine/Core/Clock.hpp"
-#include "Engine/Renderer/DebugRender.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include <cmath>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -18,13 +17,15 @@
 
 
 //----------------------------------------------------------------------------------------------------------
-Conductor::Conductor( float bpm, SoundEventID musicEventID, SoundEventID slowEventID, int countInBeats )
+Conductor::Conductor( TempoMap const& tempoMap, SoundEventID musicEventID, SoundEventID slowEventID, int countInBeats )
 	: m_musicEventID( musicEventID )
-	, m_elapsedBeats( -countInBeats )
+	, m_tempoMap( tempoMap )
 	, m_countInBeats( countInBeats )
-	, m_beatDurationSeconds( 60.f / bpm )
 	, m_slowEventID( slowEventID )
 {
+	m_songStartMicroseconds = m_tempoMap.TicksToMicroseconds( -static_cast<long long>( countInBeats ) * TICKS_PER_BEAT );
+	StartBeat( -countInBeats );
+	RefreshInputDelay();
 }
 
 
@@ -39,58 +40,62 @@ Conductor::~Conductor()
 void Conductor::Play()
 {
 	Stop();
-	m_music = g_theAudio->PlayMusicEvent( m_musicEventID, (void*)this, OnBeat );
+	if ( !m_isSimulated )
+	{
+		m_music = g_theAudio->PlayMusicEvent( m_musicEventID, (void*)this, OnBeat );
+	}
 
-	m_timeSinceLastBeat = 0.0;
-	m_timeUntilNextBeat = m_beatDurationSeconds;
+	StartBeat( m_elapsedBeats );
+	RefreshInputDelay();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Conductor::Play( double startTimeBeats )
 {
-	Stop();
-	m_elapsedBeats = FloorToInt( startTimeBeats - m_countInBeats );
+	PlayAt( startTimeBeats - m_countInBeats );
+}
 
-	double seekTimeSeconds = startTimeBeats * m_beatDurationSeconds;
-	unsigned int seekTimeMS = FloorToInt( seekTimeSeconds * 1000 );
-	m_music = g_theAudio->PlayMusicEventAt( m_musicEventID, seekTimeMS, (void*)this, OnBeat );
 
-	double beatFraction = startTimeBeats - floor( startTimeBeats );
-	if ( beatFraction >= 0.999 )
+//----------------------------------------------------------------------------------------------------------
+// The start is rounded to a tick, and the music is seeked to that tick's song time, which the tempo map
+// gives directly however many tempo changes come before it
+//
+void Conductor::PlayAt( double timeInBeats )
+{
+	Stop();
+	long long timeInTicks = TempoMap::BeatsToTicks( timeInBeats );
+	StartBeat( static_cast<int>( floor( TempoMap::TicksToBeats( timeInTicks ) ) ) );
+	m_songTimeMicroseconds = m_tempoMap.TicksToMicroseconds( timeInTicks );
+
+	if ( !m_isSimulated )
 	{
-		beatFraction = 0.0;
-		m_elapsedBeats++;
+		unsigned int seekTimeMS = static_cast<unsigned int>( ( m_songTimeMicroseconds - m_songStartMicroseconds ) / 1000 );
+		m_music = g_theAudio->PlayMusicEventAt( m_musicEventID, seekTimeMS, (void*)this, OnBeat );
 	}
-
-	m_timeSinceLastBeat = static_cast<float>( beatFraction ) * m_beatDurationSeconds;
-	m_timeUntilNextBeat = static_cast<float>( 1 - beatFraction ) * m_beatDurationSeconds;
+	RefreshInputDelay();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void Conductor::Update()
+// Called once per simulation tick with the tick's length, which is a whole number of microseconds, so the
+// song clock only ever moves in exact steps
+//
+void Conductor::Update( long long deltaMicroseconds )
 {
-	if ( m_incrementBeat )
+	if ( m_incrementBeat.exchange( false ) )
 	{
-		m_elapsedBeats++;
-		m_timeSinceLastBeat = 0.f;
-		m_timeUntilNextBeat = m_beatDurationSeconds;
-		m_incrementBeat = false;
-
-		if ( m_showDebugMessages )
-		{
-			DebugAddMessage( Stringf( "Beat #%i\n", m_elapsedBeats + 1 ), 0.8f, Rgba8::DARK_GRAY, Rgba8::CYAN );
-		}
+		StartBeat( m_elapsedBeats + 1 );
 	}
 
-	float deltaSeconds = static_cast<float>( GetGameClock()->GetDeltaSeconds() );
-	m_timeSinceLastBeat += deltaSeconds;
-	m_timeUntilNextBeat -= deltaSeconds;
-
-	if ( m_showDebugMessages )
+	m_songTimeMicroseconds += deltaMicroseconds;
+	if ( m_isSimulated )
 	{
-		DebugAddMessage( Stringf( "Conductor: %f", GetCurrentTimeInBeats() ), 0.f, Rgba8::PASTEL_RED, Rgba8::PASTEL_RED );
+		// Simulated playback has no music to call back on beats, so count them off the song time instead
+		while ( m_tempoMap.TicksToMicroseconds( static_cast<long long>( m_elapsedBeats + 1 ) * TICKS_PER_BEAT ) <= m_songTimeMicroseconds )
+		{
+			m_elapsedBeats++;
+		}
 	}
 }
 
@@ -111,6 +116,38 @@ void Conductor::Slow()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+void Conductor::SetSimulated( bool isSimulated )
+{
+	m_isSimulated = isSimulated;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The blackboard stores strings, so the delay is parsed here once per frame rather than on every time
+// query. Changes from the delay command or a calibration apply from the next frame. Main thread only.
+//
+void Conductor::RefreshInputDelay()
+{
+	SetInputDelaySeconds( g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Conductor::SetInputDelaySeconds( double inputDelaySeconds )
+{
+	m_inputDelaySeconds = inputDelaySeconds;
+	m_inputDelayMicroseconds = llround( inputDelaySeconds * 1'000'000.0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double Conductor::GetInputDelaySeconds() const
+{
+	return m_inputDelaySeconds;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 int Conductor::GetCurrentBeat() const
 {
@@ -119,35 +156,45 @@ int Conductor::GetCurrentBeat() const
 
 
 //----------------------------------------------------------------------------------------------------------
-double Conductor::GetCurrentTimeInBeats() const
+// The input delay is in song time, so it is taken off before converting to ticks: across a tempo change
+// the same delay is a different number of ticks on either side.
+//
+long long Conductor::GetCurrentTimeInMicroseconds() const
 {
-	if ( GetBeatDuration() == 0.f )
-		return 0.0;
+	return m_songTimeMicroseconds - m_inputDelayMicroseconds;
+}
 
-	double beatInteger = static_cast<double>( m_elapsedBeats );
-	double beatFraction = static_cast<double>( GetBeatFraction() );
 
-	const double inputDelaySeconds = g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 );
-	double inputDelayBeats = inputDelaySeconds / m_beatDurationSeconds;
+//----------------------------------------------------------------------------------------------------------
+long long Conductor::GetCurrentTimeInTicks() const
+{
+	return m_tempoMap.MicrosecondsToTicks( GetCurrentTimeInMicroseconds() );
+}
 
-	return beatInteger + beatFraction - inputDelayBeats;
+
+//----------------------------------------------------------------------------------------------------------
+double Conductor::GetCurrentTimeInBeats() const
+{
+	return TempoMap::TicksToBeats( GetCurrentTimeInTicks() );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 float Conductor::GetBeatFraction() const
 {
-	if ( m_beatDurationSeconds == 0.f )
+	long long beatStartMicroseconds = m_tempoMap.TicksToMicroseconds( static_cast<long long>( m_elapsedBeats ) * TICKS_PER_BEAT );
+	long long beatEndMicroseconds = m_tempoMap.TicksToMicroseconds( static_cast<long long>( m_elapsedBeats + 1 ) * TICKS_PER_BEAT );
+	if ( beatEndMicroseconds <= beatStartMicroseconds )
 		return 0.f;
 
-	return m_timeSinceLastBeat / m_beatDurationSeconds;
+	return static_cast<float>( m_songTimeMicroseconds - beatStartMicroseconds ) / static_cast<float>( beatEndMicroseconds - beatStartMicroseconds );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-float Conductor::GetBeatDuration() const
+TempoMap const& Conductor::GetTempoMap() const
 {
-	return m_beatDurationSeconds;
+	return m_tempoMap;
 }
 
 
@@ -161,3 +208,11 @@ void Conductor::OnBeat( MusicCallbackInfo const& info )
 
 	m_incrementBeat = true;
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+void Conductor::StartBeat( int beat )
+{
+	m_elapsedBeats = beat;
+	m_songTimeMicroseconds = m_tempoMap.TicksToMicroseconds( static_cast<long long>( beat ) * TICKS_PER_BEAT );
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include "Game/TempoMap.hpp"
 #include "Engine/Audio/AudioSystem_Wwise.hpp"
+#include <atomic>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -9,22 +11,30 @@ public:
 	static void OnBeat( void* conductor, MusicCallbackInfo info );
 
 public:
-	Conductor( float bpm, SoundEventID musicEventID, SoundEventID slowEventID, int countInBeats = 4 );
+	Conductor( TempoMap const& tempoMap, SoundEventID musicEventID, SoundEventID slowEventID, int countInBeats = 4 );
 	~Conductor();
 
 	void Play();
-	void Play( double startTimeBeats );
-	void Update();
+	void Play( double startTimeBeats );		// Counts in to startTimeBeats
+	void PlayAt( double timeInBeats );		// No count-in: the song is at timeInBeats right away
+	void Update( long long deltaMicroseconds );
 	void Stop();
 	void Slow();
+	void SetSimulated( bool isSimulated );
+	void RefreshInputDelay();
+	void SetInputDelaySeconds( double inputDelaySeconds );
 
+	double GetInputDelaySeconds() const;
 	int GetCurrentBeat() const;
+	long long GetCurrentTimeInMicroseconds() const;
+	long long GetCurrentTimeInTicks() const;
 	double GetCurrentTimeInBeats() const;
 	float GetBeatFraction() const;
-	float GetBeatDuration() const;
+	TempoMap const& GetTempoMap() const;
 
 private:
 	void OnBeat( MusicCallbackInfo const& info );
+	void StartBeat( int beat );
 
 private:
 	SoundPlaybackID m_music;
@@ -32,11 +42,13 @@ private:
 	SoundEventID m_musicEventID;
 	SoundEventID m_slowEventID;
 
-	float	m_beatDurationSeconds	= 0.f;
-	float	m_timeSinceLastBeat		= 0.f;
-	float	m_timeUntilNextBeat		= 0.f;
-	int		m_countInBeats			= 4;
-	int		m_elapsedBeats			= -4;
-	bool	m_showDebugMessages		= true;
-	bool	m_incrementBeat			= false;
+	TempoMap m_tempoMap;
+	long long	m_songTimeMicroseconds		= 0;	// Tempo map time, so beat 0 is 0; the audio clock only ever snaps it to beats
+	long long	m_songStartMicroseconds		= 0;	// Where the music file starts: the count-in before beat 0
+	double		m_inputDelaySeconds			= 0.0;	// Cached from "inputDelaySeconds" by RefreshInputDelay()
+	long long	m_inputDelayMicroseconds	= 0;
+	int			m_countInBeats				= 4;
+	int			m_elapsedBeats				= -4;
+	bool		m_isSimulated				= false;	// No audio, so no beat callbacks: beats are counted off song time
+	std::atomic<bool>	m_incrementBeat		= false;	// Set from the audio thread
 };
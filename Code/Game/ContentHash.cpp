@@ -0,0 +1,137 @@
+#include "Game/ContentHash.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <cstring>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr unsigned long long XXH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+constexpr unsigned long long XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr unsigned long long XXH_PRIME64_3 = 0x165667B19E3779F9ull;
+constexpr unsigned long long XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr unsigned long long XXH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Little-endian reads through memcpy, so unaligned input is fine and compiles to a plain load on x86
+//
+static unsigned long long ReadU64( unsigned char const* bytes )
+{
+	unsigned long long value;
+	memcpy( &value, bytes, sizeof( value ) );
+	return value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned long long ReadU32( unsigned char const* bytes )
+{
+	unsigned int value;
+	memcpy( &value, bytes, sizeof( value ) );
+	return value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned long long RotateLeft( unsigned long long value, int bits )
+{
+	return ( value << bits ) | ( value >> ( 64 - bits ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned long long Round( unsigned long long accumulator, unsigned long long input )
+{
+	accumulator += input * XXH_PRIME64_2;
+	accumulator = RotateLeft( accumulator, 31 );
+	return accumulator * XXH_PRIME64_1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned long long MergeRound( unsigned long long accumulator, unsigned long long lane )
+{
+	accumulator ^= Round( 0, lane );
+	return accumulator * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned long long HashXXH64( void const* data, size_t byteCount, unsigned long long seed )
+{
+	unsigned char const* bytes = static_cast<unsigned char const*>( data );
+	unsigned char const* end = bytes + byteCount;
+	unsigned long long hash;
+
+	if ( byteCount >= 32 )
+	{
+		// Four independent lanes over 32 byte stripes
+		unsigned long long lane1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		unsigned long long lane2 = seed + XXH_PRIME64_2;
+		unsigned long long lane3 = seed;
+		unsigned long long lane4 = seed - XXH_PRIME64_1;
+		unsigned char const* lastStripe = end - 32;
+		do
+		{
+			lane1 = Round( lane1, ReadU64( bytes ) );
+			lane2 = Round( lane2, ReadU64( bytes + 8 ) );
+			lane3 = Round( lane3, ReadU64( bytes + 16 ) );
+			lane4 = Round( lane4, ReadU64( bytes + 24 ) );
+			bytes += 32;
+		}
+		while ( bytes <= lastStripe );
+
+		hash = RotateLeft( lane1, 1 ) + RotateLeft( lane2, 7 ) + RotateLeft( lane3, 12 ) + RotateLeft( lane4, 18 );
+		hash = MergeRound( hash, lane1 );
+		hash = MergeRound( hash, lane2 );
+		hash = MergeRound( hash, lane3 );
+		hash = MergeRound( hash, lane4 );
+	}
+	else
+	{
+		hash = seed + XXH_PRIME64_5;
+	}
+
+	hash += static_cast<unsigned long long>( byteCount );
+
+	// Tail: whatever is left after the stripes, 8, then 4, then 1 byte at a time
+	while ( bytes + 8 <= end )
+	{
+		hash ^= Round( 0, ReadU64( bytes ) );
+		hash = RotateLeft( hash, 27 ) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		bytes += 8;
+	}
+	if ( bytes + 4 <= end )
+	{
+		hash ^= ReadU32( bytes ) * XXH_PRIME64_1;
+		hash = RotateLeft( hash, 23 ) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		bytes += 4;
+	}
+	while ( bytes < end )
+	{
+		hash ^= ( *bytes ) * XXH_PRIME64_5;
+		hash = RotateLeft( hash, 11 ) * XXH_PRIME64_1;
+		bytes++;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned long long HashXXH64( std::string const& text, unsigned long long seed )
+{
+	return HashXXH64( text.data(), text.size(), seed );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string GetContentHashString( unsigned long long hash )
+{
+	return Stringf( "%016llx", hash );
+}
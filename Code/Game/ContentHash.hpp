@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+// XXH64 of a block of memory; matches the reference xxHash implementation bit for bit, so hashes can be
+// checked with the stock xxhsum tool. Fast enough (several GB/s) to hash every chart on every load.
+//
+unsigned long long HashXXH64( void const* data, size_t byteCount, unsigned long long seed = 0 );
+unsigned long long HashXXH64( std::string const& text, unsigned long long seed = 0 );
+
+std::string GetContentHashString( unsigned long long hash );
@@ -0,0 +1,150 @@
+#define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
+#include <windows.h>			// Only needed here for the directory change notifications
+
+#include "Game/FileWatcher.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr DWORD FILE_WATCHER_BUFFER_BYTES = 16 * 1024;
+
+
+//----------------------------------------------------------------------------------------------------------
+FileWatcher::~FileWatcher()
+{
+	Shutdown();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool FileWatcher::Startup( std::string const& folder, double settleSeconds )
+{
+	Shutdown();
+
+	HANDLE directory = CreateFileA( folder.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+	if ( directory == INVALID_HANDLE_VALUE )
+		return false;
+
+	m_folder = folder;
+	m_settleSeconds = settleSeconds;
+	m_directory = directory;
+	m_stopEvent = CreateEventA( nullptr, TRUE, FALSE, nullptr );
+	m_watchThread = std::thread( &FileWatcher::WatchThreadMain, this );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void FileWatcher::Shutdown()
+{
+	if ( m_directory == nullptr )
+		return;
+
+	SetEvent( m_stopEvent );
+	if ( m_watchThread.joinable() )
+	{
+		m_watchThread.join();
+	}
+
+	CloseHandle( m_stopEvent );
+	m_stopEvent = nullptr;
+	CloseHandle( m_directory );
+	m_directory = nullptr;
+
+	std::scoped_lock lock( m_changedFilesMutex );
+	m_changedFiles.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void FileWatcher::PopChangedFiles( std::vector<std::string>& out_filepaths )
+{
+	out_filepaths.clear();
+	double nowSeconds = GetCurrentTimeSeconds();
+
+	std::scoped_lock lock( m_changedFilesMutex );
+	for ( auto fileIter = m_changedFiles.begin(); fileIter != m_changedFiles.end(); )
+	{
+		if ( nowSeconds - fileIter->second < m_settleSeconds )
+		{
+			++fileIter;
+			continue;
+		}
+
+		out_filepaths.push_back( fileIter->first );
+		fileIter = m_changedFiles.erase( fileIter );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Keeps one overlapped read of the folder's changes outstanding and sleeps on it and the stop event
+// together, so Shutdown() can wake the thread no matter where it is.
+//
+void FileWatcher::WatchThreadMain()
+{
+	DWORD notifyBuffer[FILE_WATCHER_BUFFER_BYTES / sizeof( DWORD )];	// The notifications must be DWORD aligned
+	DWORD const notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA( nullptr, TRUE, FALSE, nullptr );
+	HANDLE const waitHandles[2] = { m_stopEvent, overlapped.hEvent };
+
+	for ( ;; )
+	{
+		BOOL isReading = ReadDirectoryChangesW( m_directory, notifyBuffer, sizeof( notifyBuffer ), TRUE, notifyFilter, nullptr, &overlapped, nullptr );
+		if ( !isReading )
+			break;	// The folder went away
+
+		DWORD waitResult = WaitForMultipleObjects( 2, waitHandles, FALSE, INFINITE );
+		if ( waitResult != WAIT_OBJECT_0 + 1 )
+		{
+			// Stopping; the read still owns the buffer until the cancel completes
+			CancelIoEx( m_directory, &overlapped );
+			DWORD ignoredBytes = 0;
+			GetOverlappedResult( m_directory, &overlapped, &ignoredBytes, TRUE );
+			break;
+		}
+
+		DWORD bytesReturned = 0;
+		if ( !GetOverlappedResult( m_directory, &overlapped, &bytesReturned, FALSE ) )
+			break;
+
+		if ( bytesReturned == 0 )
+		{
+			// More changes than fit in the buffer; the details are lost
+			NoteChangedFile( m_folder );
+			continue;
+		}
+
+		unsigned char const* notifyBytes = reinterpret_cast<unsigned char const*>( notifyBuffer );
+		for ( ;; )
+		{
+			FILE_NOTIFY_INFORMATION const* notification = reinterpret_cast<FILE_NOTIFY_INFORMATION const*>( notifyBytes );
+			int nameLength = static_cast<int>( notification->FileNameLength / sizeof( WCHAR ) );
+			int utf8Length = WideCharToMultiByte( CP_UTF8, 0, notification->FileName, nameLength, nullptr, 0, nullptr, nullptr );
+			std::string relativePath( utf8Length, '\0' );
+			WideCharToMultiByte( CP_UTF8, 0, notification->FileName, nameLength, relativePath.data(), utf8Length, nullptr, nullptr );
+			std::replace( relativePath.begin(), relativePath.end(), '\\', '/' );
+			NoteChangedFile( m_folder + "/" + relativePath );
+
+			if ( notification->NextEntryOffset == 0 )
+				break;
+
+			notifyBytes += notification->NextEntryOffset;
+		}
+	}
+
+	CloseHandle( overlapped.hEvent );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void FileWatcher::NoteChangedFile( std::string const& filepath )
+{
+	double nowSeconds = GetCurrentTimeSeconds();
+	std::scoped_lock lock( m_changedFilesMutex );
+	m_changedFiles[filepath] = nowSeconds;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Reports files that changed anywhere under one folder. A background thread blocks on the OS change
+// notifications (ReadDirectoryChangesW, the Windows counterpart of inotify) and notes each file with the
+// time it last changed; PopChangedFiles() hands out only files that have been quiet for the settle time,
+// so an editor that saves in several writes triggers one reload of the finished file.
+//
+class FileWatcher
+{
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	bool Startup( std::string const& folder, double settleSeconds );
+	void Shutdown();
+
+	// Paths are "<folder>/<relative path>" with forward slashes. The folder itself is reported when the OS
+	// dropped notifications, meaning anything under it may have changed.
+	void PopChangedFiles( std::vector<std::string>& out_filepaths );
+
+private:
+	void WatchThreadMain();
+	void NoteChangedFile( std::string const& filepath );
+
+private:
+	std::string			m_folder;
+	double				m_settleSeconds = 0.25;
+	void*				m_directory = nullptr;		// HANDLE
+	void*				m_stopEvent = nullptr;		// HANDLE; signaled by Shutdown()
+	std::thread			m_watchThread;
+
+	std::mutex			m_changedFilesMutex;
+	std::unordered_map<std::string, double>	m_changedFiles;		// Path to when it last changed
+};
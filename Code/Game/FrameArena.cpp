@@ -0,0 +1,104 @@
+#include "Game/FrameArena.hpp"
+#include "Engine/Core/StringUtils.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+// Measures the frame just finished before rewinding. Capacity only ever grows, so any growth since the
+// last rewind means that frame went to the heap.
+//
+void FrameArena::BeginFrame()
+{
+	size_t bytesUsed = 0;
+	for ( size_t meshIndex = 0; meshIndex < m_meshesUsed; meshIndex++ )
+	{
+		bytesUsed += m_meshes[meshIndex].size() * sizeof( Vertex_PCU );
+		m_meshes[meshIndex].clear();
+	}
+	for ( size_t meshIndex = 0; meshIndex < m_indexedMeshesUsed; meshIndex++ )
+	{
+		IndexedMesh& indexedMesh = m_indexedMeshes[meshIndex];
+		bytesUsed += indexedMesh.m_vertexes.size() * sizeof( Vertex_PCU ) + indexedMesh.m_indexes.size() * sizeof( unsigned int );
+		indexedMesh.m_vertexes.clear();
+		indexedMesh.m_indexes.clear();
+	}
+
+	size_t bytesReserved = GetBytesReserved();
+	if ( bytesReserved > m_bytesReserved )
+	{
+		m_growthFrameCount++;
+	}
+
+	m_bytesReserved = bytesReserved;
+	m_lastFrameBytesUsed = bytesUsed;
+	m_peakBytesUsed = bytesUsed > m_peakBytesUsed ? bytesUsed : m_peakBytesUsed;
+	size_t meshesUsed = m_meshesUsed + m_indexedMeshesUsed;
+	m_peakMeshesUsed = meshesUsed > m_peakMeshesUsed ? meshesUsed : m_peakMeshesUsed;
+	m_meshesUsed = 0;
+	m_indexedMeshesUsed = 0;
+	m_frameCount++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Mesh& FrameArena::AllocateMesh()
+{
+	if ( m_meshesUsed == m_meshes.size() )
+	{
+		m_meshes.emplace_back();
+	}
+
+	return m_meshes[m_meshesUsed++];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IndexedMesh& FrameArena::AllocateIndexedMesh()
+{
+	if ( m_indexedMeshesUsed == m_indexedMeshes.size() )
+	{
+		m_indexedMeshes.emplace_back();
+	}
+
+	return m_indexedMeshes[m_indexedMeshesUsed++];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+size_t FrameArena::GetPeakBytesUsed() const
+{
+	return m_peakBytesUsed;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int FrameArena::GetGrowthFrameCount() const
+{
+	return m_growthFrameCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string FrameArena::GetStatsAsString() const
+{
+	return Stringf( "%.1f KB last frame, %.1f KB peak in %u meshes, %.1f KB reserved, grew on %u of %u frames",
+		m_lastFrameBytesUsed / 1024.0, m_peakBytesUsed / 1024.0, static_cast<unsigned int>( m_peakMeshesUsed ),
+		m_bytesReserved / 1024.0, m_growthFrameCount, m_frameCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Slots count too: a new mesh is a heap allocation even before it holds anything
+//
+size_t FrameArena::GetBytesReserved() const
+{
+	size_t bytesReserved = m_meshes.size() * sizeof( Mesh ) + m_indexedMeshes.size() * sizeof( IndexedMesh );
+	for ( Mesh const& mesh : m_meshes )
+	{
+		bytesReserved += mesh.capacity() * sizeof( Vertex_PCU );
+	}
+	for ( IndexedMesh const& indexedMesh : m_indexedMeshes )
+	{
+		bytesReserved += indexedMesh.m_vertexes.capacity() * sizeof( Vertex_PCU ) + indexedMesh.m_indexes.capacity() * sizeof( unsigned int );
+	}
+	return bytesReserved;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Engine/Core/Vertex_PCU.hpp"
+#include <deque>
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+// A linear allocator for the vertex arrays a frame builds and throws away. Handing one out only bumps a
+// count, and BeginFrame() rewinds it, so an array is reused every frame with the capacity it grew to.
+// Once a frame's meshes have grown to fit, steady-state frames never touch the heap for them.
+//
+// The engine fills Mesh and IndexedMesh, which are std::vectors, so the arena bumps through pooled
+// vectors rather than raw bytes. A mesh is only valid until the next BeginFrame(); main thread only.
+//
+class FrameArena
+{
+public:
+	void BeginFrame();
+
+	Mesh& AllocateMesh();				// Empty; valid until the next BeginFrame()
+	IndexedMesh& AllocateIndexedMesh();
+
+	size_t GetPeakBytesUsed() const;
+	unsigned int GetGrowthFrameCount() const;
+	std::string GetStatsAsString() const;
+
+private:
+	size_t GetBytesReserved() const;
+
+private:
+	std::deque<Mesh>			m_meshes;					// A deque, so growing never moves a mesh in use
+	std::deque<IndexedMesh>		m_indexedMeshes;
+	size_t						m_meshesUsed			= 0;
+	size_t						m_indexedMeshesUsed		= 0;
+
+	size_t						m_lastFrameBytesUsed	= 0;
+	size_t						m_peakBytesUsed			= 0;
+	size_t						m_bytesReserved			= 0;
+	size_t						m_peakMeshesUsed		= 0;
+	unsigned int				m_frameCount			= 0;
+	unsigned int				m_growthFrameCount		= 0;	// Frames that had to allocate
+};
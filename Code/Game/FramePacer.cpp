@@ -0,0 +1,156 @@
+#include "Game/FramePacer.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+
+//----------------------------------------------------------------------------------------------------------
+// The OS sleep can overshoot by a whole scheduler quantum, so it stops this far short and yields the rest
+//
+constexpr double SPIN_SECONDS = 0.002;
+
+
+//----------------------------------------------------------------------------------------------------------
+FramePacer::FramePacer( double targetHz, double marginSeconds )
+	: m_marginSeconds( marginSeconds )
+{
+	SetTargetHz( targetHz );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void FramePacer::SetTargetHz( double targetHz )
+{
+	if ( targetHz <= 0.0 )
+	{
+		ERROR_RECOVERABLE( Stringf( "Frame pacing needs a positive rate, not %g; pacing at 60 Hz", targetHz ) );
+		targetHz = 60.0;
+	}
+	m_targetFrameSeconds = 1.0 / targetHz;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A frame that already missed its deadline starts right away instead of sleeping through the next one
+//
+void FramePacer::WaitForFrameStart()
+{
+	double sleepStartTime = GetCurrentTimeSeconds();
+	double nextPresentTime = m_lastPresentTime + m_targetFrameSeconds;
+	double wakeTime = nextPresentTime - GetPredictedFrameSeconds() - m_marginSeconds;
+
+	double sleepSeconds = wakeTime - sleepStartTime - SPIN_SECONDS;
+	if ( sleepSeconds > 0.0 )
+	{
+		std::this_thread::sleep_for( std::chrono::duration<double>( sleepSeconds ) );
+	}
+	while ( GetCurrentTimeSeconds() < wakeTime )
+	{
+		std::this_thread::yield();
+	}
+
+	m_frameStartTime = GetCurrentTimeSeconds();
+	m_lastSleepSeconds = m_frameStartTime - sleepStartTime;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void FramePacer::MarkFrameSubmitted()
+{
+	m_costHistorySeconds[m_costHistoryIndex] = GetCurrentTimeSeconds() - m_frameStartTime;
+	m_costHistoryIndex = ( m_costHistoryIndex + 1 ) % COST_HISTORY_SIZE;
+	m_costHistoryCount = std::min( m_costHistoryCount + 1, COST_HISTORY_SIZE );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// With vsync on, presenting blocks until the flip, so the next deadline is a whole refresh after it. How
+// well that holds shows in the measured present interval and its jitter.
+//
+void FramePacer::MarkFramePresented()
+{
+	double presentTime = GetCurrentTimeSeconds();
+	if ( m_lastPresentTime > 0.0 )
+	{
+		m_presentIntervalSeconds[m_presentIntervalIndex] = presentTime - m_lastPresentTime;
+		m_presentIntervalIndex = ( m_presentIntervalIndex + 1 ) % COST_HISTORY_SIZE;
+		m_presentIntervalCount = std::min( m_presentIntervalCount + 1, COST_HISTORY_SIZE );
+	}
+
+	m_lastPresentTime = presentTime;
+	m_lastInputAgeSeconds = m_lastPresentTime - m_frameStartTime;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double FramePacer::GetTargetHz() const
+{
+	return 1.0 / m_targetFrameSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The 90th percentile of recent frames, so one hitch doesn't pull every following frame earlier, but a
+// run of slow frames does
+//
+double FramePacer::GetPredictedFrameSeconds() const
+{
+	if ( m_costHistoryCount == 0 )
+		return m_targetFrameSeconds;
+
+	double sortedCosts[COST_HISTORY_SIZE];
+	std::copy( m_costHistorySeconds, m_costHistorySeconds + m_costHistoryCount, sortedCosts );
+	int percentileIndex = ( m_costHistoryCount * 9 ) / 10;
+	std::nth_element( sortedCosts, sortedCosts + percentileIndex, sortedCosts + m_costHistoryCount );
+	return std::min( sortedCosts[percentileIndex], m_targetFrameSeconds );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The median, so a missed refresh now and then doesn't hide what the display is actually running at
+//
+double FramePacer::GetMeasuredPresentSeconds() const
+{
+	if ( m_presentIntervalCount == 0 )
+		return m_targetFrameSeconds;
+
+	double sortedIntervals[COST_HISTORY_SIZE];
+	std::copy( m_presentIntervalSeconds, m_presentIntervalSeconds + m_presentIntervalCount, sortedIntervals );
+	int medianIndex = m_presentIntervalCount / 2;
+	std::nth_element( sortedIntervals, sortedIntervals + medianIndex, sortedIntervals + m_presentIntervalCount );
+	return sortedIntervals[medianIndex];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The 90th percentile distance of a present interval from the median; how far a single Present() return
+// can be from the refresh it is assumed to mark
+//
+double FramePacer::GetPresentJitterSeconds() const
+{
+	if ( m_presentIntervalCount == 0 )
+		return 0.0;
+
+	double medianSeconds = GetMeasuredPresentSeconds();
+	double deviations[COST_HISTORY_SIZE];
+	for ( int intervalIndex = 0; intervalIndex < m_presentIntervalCount; intervalIndex++ )
+	{
+		deviations[intervalIndex] = std::abs( m_presentIntervalSeconds[intervalIndex] - medianSeconds );
+	}
+	int percentileIndex = ( m_presentIntervalCount * 9 ) / 10;
+	std::nth_element( deviations, deviations + percentileIndex, deviations + m_presentIntervalCount );
+	return deviations[percentileIndex];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string FramePacer::GetStatsAsString() const
+{
+	return Stringf( "%.0f Hz, predicted %.2f ms, slept %.2f ms, input to present %.2f ms, presents every %.2f ms (jitter %.2f ms)", GetTargetHz(),
+		GetPredictedFrameSeconds() * 1000.0, m_lastSleepSeconds * 1000.0, m_lastInputAgeSeconds * 1000.0,
+		GetMeasuredPresentSeconds() * 1000.0, GetPresentJitterSeconds() * 1000.0 );
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Starts each frame as late as it can and still make the next present. The recent cost of a frame,
+// from polling input to submitting it, predicts this one's, so the pacer sleeps until that long before
+// the deadline. Taps polled after waking are then as fresh as they can be when the frame is shown, and
+// the CPU and GPU idle rather than draw frames that never reach the screen.
+//
+// The renderer gives no access to the swap chain, so the pacer has no vblank timestamps. It assumes
+// that with vsync on, Present() returns right after the flip and takes that moment as the refresh. The
+// interval between presents is measured so the assumption can be checked. If the median is not the
+// target period, or the jitter is more than a fraction of the margin, the schedule is drifting against
+// the real refresh. "Input to present" likewise ends when Present() returns, not when the frame is
+// scanned out, so it leaves out scanout and any compositor delay.
+//
+class FramePacer
+{
+public:
+	FramePacer( double targetHz, double marginSeconds );
+
+	void SetTargetHz( double targetHz );
+
+	void WaitForFrameStart();		// Just before input is polled
+	void MarkFrameSubmitted();		// Once the frame is drawn, before it is presented
+	void MarkFramePresented();
+
+	double GetTargetHz() const;
+	double GetPredictedFrameSeconds() const;
+	double GetMeasuredPresentSeconds() const;
+	double GetPresentJitterSeconds() const;
+	std::string GetStatsAsString() const;
+
+private:
+	static constexpr int COST_HISTORY_SIZE = 32;
+
+	double	m_targetFrameSeconds	= 1.0 / 60.0;
+	double	m_marginSeconds			= 0.002;	// Covers GPU time and sleep jitter the CPU cost doesn't show
+	double	m_costHistorySeconds[COST_HISTORY_SIZE] = {};
+	int		m_costHistoryIndex		= 0;
+	int		m_costHistoryCount		= 0;
+	double	m_presentIntervalSeconds[COST_HISTORY_SIZE] = {};	// Between consecutive presents
+	int		m_presentIntervalIndex	= 0;
+	int		m_presentIntervalCount	= 0;
+
+	double	m_frameStartTime		= 0.0;
+	double	m_lastPresentTime		= 0.0;
+	double	m_lastSleepSeconds		= 0.0;
+	double	m_lastInputAgeSeconds	= 0.0;		// From polling input to Present() returning
+};
@@ -1,11 +1,18 @@
 #include "Game/Game.hpp"
 
 #include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
 #include "Game/App.hpp"
 #include "Game/Path.hpp"
 #include "Game/PlayerPlanets.hpp"
 #include "Game/Conductor.hpp"
 #include "Game/Menu.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/LatencyCalibrator.hpp"
+#include "Game/ChartEditor.hpp"
+#include "Game/ChartAnalyzer.hpp"
+#include "Game/ContentHash.hpp"
+#include "Game/FileWatcher.hpp"
 
 #include "Engine/Core/FileUtils.hpp"
 #include "Engine/Core/EngineCommon.hpp"
@@ -19,6 +26,9 @@
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Audio/AudioSystem_Wwise.hpp"
 #include "Engine/Window/Window.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <filesystem>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -56,6 +66,18 @@
 		return true;
 	}
 
+	if ( buttonEventName == "GOTO_CALIBRATION" )
+	{
+		theGame->GoToState( GameState::CALIBRATION );
+		return true;
+	}
+
+	if ( buttonEventName == "GOTO_EDITOR" )
+	{
+		theGame->GoToState( GameState::EDITOR );
+		return true;
+	}
+
 	if ( buttonEventName == "SELECT_NEXT_LEVEL" )
 	{
 		theGame->SelectNextLevel();
@@ -64,7 +86,19 @@
 
 	if ( buttonEventName == "SELECT_PREV_LEVEL" )
 	{
-		theGame->SelectNextLevel();
+		theGame->SelectPrevLevel();
+		return true;
+	}
+
+	if ( buttonEventName == "CYCLE_LEVEL_SORT" )
+	{
+		theGame->CycleLevelSort();
+		return true;
+	}
+
+	if ( buttonEventName == "CYCLE_LEVEL_FILTER" )
+	{
+		theGame->CycleLevelFilter();
 		return true;
 	}
 
@@ -93,12 +127,20 @@ Game::Game()
 
 	LoadLevelData();
 	InitializeMenus();
+	AnalyzeCharts();
+	m_calibrator = new LatencyCalibrator();
+	m_editor = new ChartEditor();
+	m_redrawThrottle.Configure( g_gameConfigBlackboard.GetValue( "idleRedrawMaxHz", 30.0 ),
+		g_gameConfigBlackboard.GetValue( "idleRedrawRefreshSeconds", 1.0 ) );
+	StartHotReload();
 	OnEnter_Attract();
 }
 
 //--------------------------------------------------------------------------------------------------------------
 Game::~Game()
 {
+	StopHotReload();
+
 	delete[] m_levels;
 	m_levels = nullptr;
 
@@ -107,8 +149,16 @@ Game::~Game()
 		case GameState::ATTRACT:		OnExit_Attract();		break;
 		case GameState::LEVEL_SELECT:	OnExit_LevelSelect();	break;
 		case GameState::GAMEPLAY:		OnExit_Gameplay();		break;
+		case GameState::CALIBRATION:	OnExit_Calibration();	break;
+		case GameState::EDITOR:			OnExit_Editor();		break;
 	}
 
+	delete m_editor;
+	m_editor = nullptr;
+
+	delete m_calibrator;
+	m_calibrator = nullptr;
+
 	delete m_levelSelectMenu;
 	m_levelSelectMenu = nullptr;
 
@@ -128,7 +178,13 @@ Game::~Game()
 //--------------------------------------------------------------------------------------------------------------
 void Game::Update()
 {
+	if ( m_fixedDeltaSeconds > 0.0 )
+	{
+		m_fixedTimeSeconds += m_fixedDeltaSeconds;
+	}
+
 	UpdateDevCheats();
+	UpdateHotReload();
 
 	switch ( m_currentState )
 	{
@@ -136,7 +192,16 @@ void Game::Update()
 		case GameState::LEVEL_SELECT:	Update_LevelSelect();	break;
 		case GameState::GAMEPLAY:		Update_Gameplay();		break;
 		case GameState::CREDITS:		Update_Credits();		break;
+		case GameState::CALIBRATION:	Update_Calibration();	break;
+		case GameState::EDITOR:			Update_Editor();		break;
 	}
+
+	// After the switch, so labels retyped and states entered this frame are uploaded before they render
+	AABB2 const& screenBounds = m_screenCamera.GetBoundingBox();
+	if		( m_currentState == GameState::ATTRACT )		m_attractMenu->UploadVertexBuffers( screenBounds );
+	else if ( m_currentState == GameState::LEVEL_SELECT )	m_levelSelectMenu->UploadVertexBuffers( screenBounds );
+
+	UpdateRedrawRequests();
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -148,12 +213,27 @@ void Game::Render() const
 		case GameState::LEVEL_SELECT:	Render_LevelSelect();	break; 
 		case GameState::GAMEPLAY:		Render_Gameplay();		break;
 		case GameState::CREDITS:		Render_Credits();		break;
+		case GameState::CALIBRATION:	Render_Calibration();	break;
+		case GameState::EDITOR:			Render_Editor();		break;
 	}
 
 	DebugRenderScreen( m_screenCamera );
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// Gameplay, calibration and the editor draw every frame. The menus and credits are mostly static, so a
+// frame there is only drawn for input, animation or the refresh timer, capped by "idleRedrawMaxHz".
+//
+bool Game::ShouldRenderFrame()
+{
+	if ( !IsIdleState() || !g_gameConfigBlackboard.GetValue( "idleRedraw", true ) )
+		return true;
+
+	return m_redrawThrottle.ShouldDrawFrame( GetCurrentTimeSeconds() );
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 Clock* Game::GetClock()
 {
@@ -161,12 +241,24 @@ Clock* Game::GetClock()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+double Game::GetTimeSeconds() const
+{
+	if ( m_fixedDeltaSeconds > 0.0 )
+		return m_fixedTimeSeconds;
+
+	return m_gameClock->GetTotalSeconds();
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Game::GoToState( GameState state )
 {
 	if ( state == m_currentState )
 		return;
 
+	m_redrawThrottle.RequestRedraw();
+	m_redrawThrottle.ResetFrameCounts();
 	g_theAudio->PlayEvent( AK::EVENTS::PLAY_TESTCLICK );
 	switch ( m_currentState )
 	{
@@ -174,6 +266,8 @@ void Game::GoToState( GameState state )
 		case GameState::LEVEL_SELECT:	OnExit_LevelSelect();	break;
 		case GameState::GAMEPLAY:		OnExit_Gameplay();		break;
 		case GameState::CREDITS:		OnExit_Credits();		break;
+		case GameState::CALIBRATION:	OnExit_Calibration();	break;
+		case GameState::EDITOR:			OnExit_Editor();		break;
 	}
 
 	m_currentState = state;
@@ -183,10 +277,126 @@ void Game::GoToState( GameState state )
 		case GameState::LEVEL_SELECT:	OnEnter_LevelSelect();	break;
 		case GameState::GAMEPLAY:		OnEnter_Gameplay();		break;
 		case GameState::CREDITS:		OnEnter_Credits();		break;
+		case GameState::CALIBRATION:	OnEnter_Calibration();	break;
+		case GameState::EDITOR:			OnEnter_Editor();		break;
 	}
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+bool Game::BeginReplayPlayback( Replay const& replay, double fixedDeltaSeconds )
+{
+	for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+	{
+		if ( m_levels[levelIndex].GetFilePath() != replay.m_levelFilePath )
+			continue;
+
+		unsigned long long chartHash = m_levels[levelIndex].GetChartHash();
+		if ( replay.m_chartHash != 0 && replay.m_chartHash != chartHash )
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Replay was recorded against chart %s but \"%s\" is now %s; judgements may differ",
+				GetContentHashString( replay.m_chartHash ).c_str(), replay.m_levelFilePath.c_str(), GetContentHashString( chartHash ).c_str() ) );
+		}
+
+		GoToState( GameState::LEVEL_SELECT );
+		m_currentLevelIndex = levelIndex;
+		m_fixedDeltaSeconds = fixedDeltaSeconds;
+		m_fixedTimeSeconds = 0.0;
+
+		GetCurrentLevel().StartReplayPlayback( replay, fixedDeltaSeconds );
+		GoToState( GameState::GAMEPLAY );
+		return true;
+	}
+
+	g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "No level matches replay level \"%s\"", replay.m_levelFilePath.c_str() ) );
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Game::IsReplayPlaybackFinished() const
+{
+	if ( m_currentState != GameState::GAMEPLAY )
+		return true;
+
+	LevelState levelState = GetCurrentLevel().GetState();
+	return levelState == LevelState::WIN || levelState == LevelState::FAIL;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int Game::GetLevelCount() const
+{
+	return m_levelCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string const& Game::GetLevelFilePath( unsigned int levelIndex ) const
+{
+	return m_levels[levelIndex].GetFilePath();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Matches either the level's full file path or just its file name without the extension. An empty name
+// finds the level last selected.
+//
+Level* Game::FindLevel( std::string const& levelName )
+{
+	if ( levelName.empty() )
+		return &GetCurrentLevel();
+
+	for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+	{
+		std::string const& levelFilePath = m_levels[levelIndex].GetFilePath();
+		if ( levelFilePath == levelName || std::filesystem::path( levelFilePath ).stem().string() == levelName )
+			return &m_levels[levelIndex];
+	}
+
+	return nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Level const& Game::GetLevel( unsigned int levelIndex ) const
+{
+	return m_levels[levelIndex];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Game::IsIdleState() const
+{
+	return m_currentState == GameState::ATTRACT || m_currentState == GameState::LEVEL_SELECT || m_currentState == GameState::CREDITS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RedrawThrottle const& Game::GetRedrawThrottle() const
+{
+	return m_redrawThrottle;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Replaces every level's authored difficulty with the one analyzed from its path. Off through
+// "analyzeCharts" only keeps the authored numbers for sorting; the library is still listed either way.
+//
+void Game::AnalyzeCharts()
+{
+	if ( g_gameConfigBlackboard.GetValue( "analyzeCharts", true ) )
+	{
+		double startTimeSeconds = GetCurrentTimeSeconds();
+		AnalyzeLevelLibrary( m_levels, m_levelCount );
+		double elapsedMs = ( GetCurrentTimeSeconds() - startTimeSeconds ) * 1000.0;
+		g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Analyzed %u charts in %.2f ms", m_levelCount, elapsedMs ) );
+	}
+
+	RebuildLevelOrder();
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 Level& Game::GetCurrentLevel()
 {
@@ -223,6 +433,7 @@ void Game::LoadLevelData()
 		ERROR_AND_DIE( "LevelConfig.xml doesn't have any levels in it!" );
 	}
 
+	double startTimeSeconds = GetCurrentTimeSeconds();
 	m_levels = new Level[m_levelCount];
 	unsigned int levelIndex = 0;
 	XmlElement* levelElement = rootElement->FirstChildElement( "Level" );
@@ -236,6 +447,210 @@ void Game::LoadLevelData()
 		levelElement = levelElement->NextSiblingElement( "Level" );
 		levelIndex++;
 	}
+
+	double elapsedMs = ( GetCurrentTimeSeconds() - startTimeSeconds ) * 1000.0;
+	g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Loaded %u levels in %.2f ms", m_levelCount, elapsedMs ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::StartHotReload()
+{
+	if ( !g_gameConfigBlackboard.GetValue( "hotReload", true ) )
+		return;
+
+	m_dataWatcher = new FileWatcher();
+	double settleSeconds = g_gameConfigBlackboard.GetValue( "hotReloadSettleSeconds", 0.25 );
+	if ( !m_dataWatcher->Startup( "Data", settleSeconds ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, "Could not watch \"Data\" for changes; hot reload is off" );
+		delete m_dataWatcher;
+		m_dataWatcher = nullptr;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::StopHotReload()
+{
+	if ( m_dataWatcher != nullptr )
+	{
+		m_dataWatcher->Shutdown();
+		delete m_dataWatcher;
+		m_dataWatcher = nullptr;
+	}
+
+	if ( m_chartCompileThread.joinable() )
+	{
+		m_chartCompileThread.join();
+	}
+
+	for ( CompiledChart* chart : m_compilingCharts )
+	{
+		delete chart;
+	}
+	m_compilingCharts.clear();
+	m_compilingLevelIndexes.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Runs every frame but only does real work when something changed: picks up settled file changes, starts
+// or collects the background compile, and swaps finished charts in where that is safe.
+//
+void Game::UpdateHotReload()
+{
+	std::vector<std::string> changedFiles;
+	if ( m_dataWatcher != nullptr )
+	{
+		m_dataWatcher->PopChangedFiles( changedFiles );
+	}
+
+	for ( std::string const& changedFile : changedFiles )
+	{
+		std::string changedPath = std::filesystem::path( changedFile ).lexically_normal().generic_string();
+		bool isEverythingChanged = changedPath == "Data";
+		if ( isEverythingChanged || changedPath == "Data/GameConfig.xml" )
+		{
+			g_theApp->ReloadGameConfig( "Data/GameConfig.xml" );
+		}
+		if ( changedPath == "Data/LevelConfig.xml" )
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, "LevelConfig.xml changed; restart to add or remove levels" );
+		}
+
+		for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+		{
+			Level const& level = m_levels[levelIndex];
+			std::string levelPath = std::filesystem::path( level.GetFilePath() ).lexically_normal().generic_string();
+			std::string pathPath = std::filesystem::path( level.GetPathFilePath() ).lexically_normal().generic_string();
+			if ( isEverythingChanged || changedPath == levelPath || changedPath == pathPath )
+			{
+				QueueChartReload( levelIndex );
+			}
+		}
+	}
+
+	if ( m_chartCompileThread.joinable() && m_isChartCompileFinished.load( std::memory_order_acquire ) )
+	{
+		FinishChartCompile();
+	}
+	if ( !m_chartCompileThread.joinable() && !m_queuedReloads.empty() )
+	{
+		StartChartCompile();
+	}
+
+	ApplyPendingCharts();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::QueueChartReload( unsigned int levelIndex )
+{
+	if ( std::find( m_queuedReloads.begin(), m_queuedReloads.end(), levelIndex ) == m_queuedReloads.end() )
+	{
+		m_queuedReloads.push_back( levelIndex );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// One worker per batch of changed charts. Everything it touches is handed over here and not looked at
+// by the main thread again until the worker has flagged that it is done.
+//
+void Game::StartChartCompile()
+{
+	ChartCompileSettings settings = ChartCompileSettings::FromGameConfig();
+	settings.m_analyzeChart = g_gameConfigBlackboard.GetValue( "analyzeCharts", true );
+
+	m_compilingLevelIndexes.swap( m_queuedReloads );
+	m_queuedReloads.clear();
+	for ( unsigned int levelIndex : m_compilingLevelIndexes )
+	{
+		CompiledChart* chart = new CompiledChart();
+		chart->m_levelFilePath = m_levels[levelIndex].GetFilePath();
+		m_compilingCharts.push_back( chart );
+	}
+
+	m_isChartCompileFinished.store( false, std::memory_order_relaxed );
+	m_chartCompileThread = std::thread( [this, settings]()
+		{
+			for ( CompiledChart* chart : m_compilingCharts )
+			{
+				std::string levelFilePath = chart->m_levelFilePath;
+				Level::CompileChart( levelFilePath, settings, *chart );
+			}
+			m_isChartCompileFinished.store( true, std::memory_order_release );
+		} );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::FinishChartCompile()
+{
+	m_chartCompileThread.join();
+
+	for ( size_t chartIndex = 0; chartIndex < m_compilingCharts.size(); chartIndex++ )
+	{
+		CompiledChart* chart = m_compilingCharts[chartIndex];
+		Level& level = m_levels[m_compilingLevelIndexes[chartIndex]];
+		if ( !chart->m_errorMessage.empty() )
+		{
+			// A half-saved or broken file; keep playing the last good chart until it is fixed
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Hot reload failed: %s", chart->m_errorMessage.c_str() ) );
+			delete chart;
+			continue;
+		}
+
+		if ( chart->m_chartHash == level.GetChartHash() && !level.HasPendingChart() )
+		{
+			delete chart;	// Saved without changes
+			continue;
+		}
+
+		level.SetPendingChart( chart );
+		m_hasPendingCharts = true;
+	}
+
+	m_compilingCharts.clear();
+	m_compilingLevelIndexes.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The level being played takes its new chart in its own countdown; every other level isn't in use and
+// swaps right away. Either way the chart is applied sooner or later, so both count toward rebuilding the
+// level select order. That waits until gameplay is exited, since re-sorting and re-filtering mid-play
+// would only rebuild labels nobody sees.
+//
+void Game::ApplyPendingCharts()
+{
+	if ( m_hasPendingCharts )
+	{
+		m_hasPendingCharts = false;
+		for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+		{
+			Level& level = m_levels[levelIndex];
+			if ( !level.HasPendingChart() )
+				continue;
+
+			m_needsLevelOrderRebuild = true;
+			if ( m_currentState == GameState::GAMEPLAY && levelIndex == m_currentLevelIndex )
+			{
+				m_hasPendingCharts = true;
+				continue;
+			}
+
+			level.ApplyPendingChart();
+		}
+	}
+
+	if ( !m_needsLevelOrderRebuild || m_currentState == GameState::GAMEPLAY )
+		return;
+
+	m_needsLevelOrderRebuild = false;
+	RebuildLevelOrder();
+	m_redrawThrottle.RequestRedraw();
 }
 
 
@@ -277,7 +692,7 @@ void Game::InitializeAttractMenu()
 	AABB2 settingsButtonBounds = buttonRowBounds;
 	Vec2 secondaryButtonDimensions = Vec2( startButtonDimensions.x * .75f, startButtonDimensions.y * .9f );
 	settingsButtonBounds.SetDimensions( secondaryButtonDimensions, Vec2( 0.f, .5f ) );
-	Button& settingsButton = m_attractMenu->m_buttons.emplace_back( settingsButtonBounds, "GOTO_SETTINGS", "Settings" );
+	Button& settingsButton = m_attractMenu->m_buttons.emplace_back( settingsButtonBounds, "GOTO_CALIBRATION", "Calibrate" );
 
 	AABB2 creditsButtonBounds = buttonRowBounds;
 	creditsButtonBounds.SetDimensions( secondaryButtonDimensions, Vec2( 1.f, .5f ) );
@@ -297,7 +712,7 @@ void Game::InitalizeLevelSelectMenu()
 	// Level Select Menu
 	std::string levelBackgroundFilepath = g_gameConfigBlackboard.GetValue( "levelSelectBackground", "" );
 	m_levelSelectMenu = new Menu( "Level Select", levelBackgroundFilepath );
-	m_levelSelectMenu->m_buttons.reserve( 4 );
+	m_levelSelectMenu->m_buttons.reserve( 7 );	// Buttons link to each other by pointer; never reallocate
 
 	AABB2 buttonRowBounds = screenBounds;
 	buttonRowBounds.ChopOffTop( .6667f );
@@ -329,27 +744,181 @@ void Game::InitalizeLevelSelectMenu()
 
 	resetCheckpointButton.LinkTo( rightButton, EAST, true );
 	resetCheckpointButton.LinkTo( leftButton, WEST, true );
+
+	AABB2 optionsRowBounds = screenBounds;
+	optionsRowBounds.ChopOffBottom( .9f );
+	optionsRowBounds.ScaleDimensions( .95f );
+	Vec2 optionButtonDimensions = Vec2( optionsRowBounds.GetDimensions().x * .2f, optionsRowBounds.GetDimensions().y );
+
+	AABB2 sortButtonBounds = optionsRowBounds;
+	sortButtonBounds.SetDimensions( optionButtonDimensions, Vec2( 0.f, .5f ) );
+	Button& sortButton = m_levelSelectMenu->m_buttons.emplace_back( sortButtonBounds, "CYCLE_LEVEL_SORT" );
+	m_levelSortButton = &sortButton;
+
+	AABB2 filterButtonBounds = optionsRowBounds;
+	filterButtonBounds.SetDimensions( optionButtonDimensions, Vec2( 1.f, .5f ) );
+	Button& filterButton = m_levelSelectMenu->m_buttons.emplace_back( filterButtonBounds, "CYCLE_LEVEL_FILTER" );
+	m_levelFilterButton = &filterButton;
+
+	AABB2 editButtonBounds = optionsRowBounds;
+	editButtonBounds.SetDimensions( optionButtonDimensions );
+	Button& editButton = m_levelSelectMenu->m_buttons.emplace_back( editButtonBounds, "GOTO_EDITOR", "Edit Chart" );
+
+	sortButton.LinkTo( editButton, EAST );
+	editButton.LinkTo( filterButton, EAST );
+	leftButton.LinkTo( sortButton, NORTH );
+	rightButton.LinkTo( filterButton, NORTH );
+	playButton.LinkTo( editButton, NORTH );
+	UpdateLevelSelectLabels();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Game::SelectNextLevel()
 {
-	m_currentLevelIndex++;
-	m_currentLevelIndex %= m_levelCount;
+	auto currentLevel = std::find( m_levelOrder.begin(), m_levelOrder.end(), m_currentLevelIndex );
+	if ( currentLevel == m_levelOrder.end() || ++currentLevel == m_levelOrder.end() )
+	{
+		currentLevel = m_levelOrder.begin();
+	}
+	m_currentLevelIndex = *currentLevel;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Game::SelectPrevLevel()
 {
-	if ( m_currentLevelIndex == 0 )
+	auto currentLevel = std::find( m_levelOrder.begin(), m_levelOrder.end(), m_currentLevelIndex );
+	if ( currentLevel == m_levelOrder.begin() || currentLevel == m_levelOrder.end() )
 	{
-		m_currentLevelIndex = m_levelCount - 1;
+		currentLevel = m_levelOrder.end();
 	}
-	else
+	m_currentLevelIndex = *( --currentLevel );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::CycleLevelSort()
+{
+	int nextSortMode = ( static_cast<int>( m_levelSortMode ) + 1 ) % static_cast<int>( LevelSortMode::COUNT );
+	m_levelSortMode = static_cast<LevelSortMode>( nextSortMode );
+	RebuildLevelOrder();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Skips difficulty bands with no levels in them, so the list is never empty
+//
+void Game::CycleLevelFilter()
+{
+	int filterCount = static_cast<int>( LevelFilter::COUNT );
+	for ( int step = 1; step < filterCount; step++ )
+	{
+		LevelFilter filter = static_cast<LevelFilter>( ( static_cast<int>( m_levelFilter ) + step ) % filterCount );
+		for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+		{
+			if ( DoesLevelPassFilter( levelIndex, filter ) )
+			{
+				m_levelFilter = filter;
+				RebuildLevelOrder();
+				return;
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::RebuildLevelOrder()
+{
+	m_levelOrder.clear();
+	for ( unsigned int levelIndex = 0; levelIndex < m_levelCount; levelIndex++ )
+	{
+		if ( DoesLevelPassFilter( levelIndex, m_levelFilter ) )
+		{
+			m_levelOrder.push_back( levelIndex );
+		}
+	}
+
+	if ( m_levelOrder.empty() )
+	{
+		m_levelFilter = LevelFilter::ALL;
+		RebuildLevelOrder();
+		return;
+	}
+
+	// Stable, so equally rated levels keep their library order
+	if ( m_levelSortMode != LevelSortMode::LIBRARY )
+	{
+		bool easiestFirst = m_levelSortMode == LevelSortMode::EASIEST_FIRST;
+		std::stable_sort( m_levelOrder.begin(), m_levelOrder.end(), [&]( unsigned int a, unsigned int b )
+			{
+				float difficultyA = m_levels[a].GetInfo().m_difficulty;
+				float difficultyB = m_levels[b].GetInfo().m_difficulty;
+				return easiestFirst ? difficultyA < difficultyB : difficultyA > difficultyB;
+			} );
+	}
+
+	KeepSelectedLevelVisible();
+	UpdateLevelSelectLabels();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Only on level select, since everywhere else the current level is the one being played or edited
+//
+void Game::KeepSelectedLevelVisible()
+{
+	if ( m_currentState != GameState::LEVEL_SELECT )
+		return;
+
+	if ( std::find( m_levelOrder.begin(), m_levelOrder.end(), m_currentLevelIndex ) == m_levelOrder.end() )
 	{
-		m_currentLevelIndex--;
+		m_currentLevelIndex = m_levelOrder.front();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Game::DoesLevelPassFilter( unsigned int levelIndex, LevelFilter filter ) const
+{
+	float difficulty = m_levels[levelIndex].GetInfo().m_difficulty;
+	float easyMaxDifficulty = g_gameConfigBlackboard.GetValue( "difficultyEasyMax", 3.5f );
+	float hardMinDifficulty = g_gameConfigBlackboard.GetValue( "difficultyHardMin", 5.f );
+	switch ( filter )
+	{
+		case LevelFilter::EASY:		return difficulty < easyMaxDifficulty;
+		case LevelFilter::NORMAL:	return difficulty >= easyMaxDifficulty && difficulty < hardMinDifficulty;
+		case LevelFilter::HARD:		return difficulty >= hardMinDifficulty;
+		default:					return true;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::UpdateLevelSelectLabels()
+{
+	if ( m_levelSortButton != nullptr )
+	{
+		switch ( m_levelSortMode )
+		{
+			case LevelSortMode::EASIEST_FIRST:	m_levelSortButton->SetLabel( "Sort: Easiest" );	break;
+			case LevelSortMode::HARDEST_FIRST:	m_levelSortButton->SetLabel( "Sort: Hardest" );	break;
+			default:							m_levelSortButton->SetLabel( "Sort: Library" );	break;
+		}
+	}
+
+	if ( m_levelFilterButton != nullptr )
+	{
+		char const* filterName = "All";
+		switch ( m_levelFilter )
+		{
+			case LevelFilter::EASY:		filterName = "Easy";	break;
+			case LevelFilter::NORMAL:	filterName = "Normal";	break;
+			case LevelFilter::HARD:		filterName = "Hard";	break;
+			default:					filterName = "All";		break;
+		}
+		m_levelFilterButton->SetLabel( Stringf( "Show: %s (%u)", filterName, static_cast<unsigned int>( m_levelOrder.size() ) ) );
 	}
 }
 
@@ -389,6 +958,37 @@ void Game::UpdateDevCheats()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// Any key or button going up or down, the cursor moving, the wheel turning or the window resizing
+// redraws. The attract planets and the credits' wave text always animate, as does a button's press.
+//
+void Game::UpdateRedrawRequests()
+{
+	bool hadInput = g_theInput->GetMouseWheelDelta() != 0;
+	for ( int keyIndex = 0; keyIndex < MAX_KEYBOARD_KEYS && !hadInput; keyIndex++ )
+	{
+		unsigned char keycode = static_cast<unsigned char>( keyIndex );
+		hadInput = g_theInput->GetKeyDown( keycode ) || g_theInput->GetKeyUp( keycode );
+	}
+
+	Vec2 cursorPosition = g_theInput->GetCursorClientPosition();
+	Vec2 clientDimensions = Vec2( g_theWindow->GetClientDimensions() );
+	if ( hadInput || cursorPosition != m_lastCursorPosition || clientDimensions != m_lastClientDimensions )
+	{
+		m_redrawThrottle.RequestRedraw();
+	}
+	m_lastCursorPosition = cursorPosition;
+	m_lastClientDimensions = clientDimensions;
+
+	bool isMenuAnimating = ( m_currentState == GameState::ATTRACT && m_attractMenu->IsAnimating() )
+		|| ( m_currentState == GameState::LEVEL_SELECT && m_levelSelectMenu->IsAnimating() );
+	if ( m_currentState == GameState::ATTRACT || m_currentState == GameState::CREDITS || isMenuAnimating || g_theDevConsole->IsOpen() )
+	{
+		m_redrawThrottle.RequestAnimationFrame();
+	}
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Game::Update_Attract()
 {
@@ -417,6 +1017,7 @@ void Game::Update_LevelSelect()
 void Game::Update_Gameplay()
 {
 	GetCurrentLevel().Update();
+	GetCurrentLevel().UpdateDebugMessages();
 
 	if ( g_theInput->GetKeyDown( KEYCODE_ESC ) )
 	{
@@ -436,11 +1037,35 @@ void Game::Update_Credits()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+void Game::Update_Calibration()
+{
+	m_calibrator->Update();
+
+	if ( g_theInput->GetKeyDown( KEYCODE_ESC ) )
+	{
+		GoToState( GameState::ATTRACT );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::Update_Editor()
+{
+	m_editor->Update();
+
+	if ( g_theInput->GetKeyDown( KEYCODE_ESC ) )
+	{
+		GoToState( GameState::LEVEL_SELECT );
+	}
+}
+
+
 //--------------------------------------------------------------------------------------------------------------
 void Game::Render_Attract() const
 {	
-	g_theRenderer->ClearScreen( Rgba8::PASTEL_MAGENTA );
-	g_theRenderer->BeginCamera( m_screenCamera );
+	g_theRenderBackend->ClearScreen( Rgba8::PASTEL_MAGENTA );
+	g_theRenderBackend->BeginCamera( m_screenCamera );
 
 	AABB2 const& screenBounds = m_screenCamera.GetBoundingBox();
 	Vec2 screenDimensions = screenBounds.GetDimensions();
@@ -452,41 +1077,43 @@ void Game::Render_Attract() const
 	Vec2 bluePlanetOffset = Vec2::MakeFromPolarDegrees( bluePlanetAngle, planetRotationRadius );
 	Vec2 redPlanetOffset = Vec2::MakeFromPolarDegrees( redPlanetAngle, planetRotationRadius );
 
-	Mesh planetVerts;
+	Mesh& planetVerts = g_theFrameArena->AllocateMesh();
 	AddVertsForDisc2D( planetVerts, planetsCenter + bluePlanetOffset, planetRadius, Rgba8::BLUE, 24 );
 	AddVertsForDisc2D( planetVerts, planetsCenter + redPlanetOffset, planetRadius, Rgba8::RED, 24 );
-	g_theRenderer->BindTexture( nullptr );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawVertexArray( planetVerts );
+	g_theRenderBackend->SetDrawLayer( RenderLayer::ACTORS );
+	g_theRenderBackend->BindTexture( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawVertexArray( planetVerts );
 
 	AABB2 titleBounds = screenBounds;
 	titleBounds.ChopOffBottom( .5f );
 	titleBounds.PadAllSides( -25.f );
 	Vec2 titleDimensions = titleBounds.GetDimensions();
 
-	IndexedMesh titleVerts;
+	IndexedMesh& titleVerts = g_theFrameArena->AllocateIndexedMesh();
 	g_defaultFont->AddVertsForTextInBox2D( titleVerts, "ORBIT", titleBounds, 99999.f, Rgba8::WHITE, .7f );
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->SetBlendMode( BlendMode::OPAQUE );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawIndexedMesh( titleVerts );
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->SetBlendMode( BlendMode::OPAQUE );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawIndexedMesh( titleVerts );
 
-	m_attractMenu->Render( screenBounds );
+	m_attractMenu->Render();
 
-	g_theRenderer->EndCamera( m_screenCamera );
+	g_theRenderBackend->EndCamera( m_screenCamera );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Game::Render_LevelSelect() const
 {
-	g_theRenderer->ClearScreen( Rgba8::PASTEL_BLUE );
-	g_theRenderer->BeginCamera( m_screenCamera );
+	g_theRenderBackend->ClearScreen( Rgba8::PASTEL_BLUE );
+	g_theRenderBackend->BeginCamera( m_screenCamera );
 	AABB2 const& screenBounds = m_screenCamera.GetBoundingBox();
 
 	AABB2 levelInfoBounds = screenBounds;
@@ -494,29 +1121,29 @@ void Game::Render_LevelSelect() const
 	levelInfoBounds.ScaleWidth( .75f );
 	GetCurrentLevel().RenderInfo( levelInfoBounds );
 
-	m_levelSelectMenu->Render( screenBounds );
-	g_theRenderer->EndCamera( m_screenCamera );
+	m_levelSelectMenu->Render();
+	g_theRenderBackend->EndCamera( m_screenCamera );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Game::Render_Gameplay() const
 {
-	g_theRenderer->ClearScreen( Rgba8::DARK_GRAY );
+	g_theRenderBackend->ClearScreen( Rgba8::DARK_GRAY );
 
 	GetCurrentLevel().Render();
 
-	g_theRenderer->BeginCamera( m_screenCamera );
+	g_theRenderBackend->BeginCamera( m_screenCamera );
 	GetCurrentLevel().RenderHUD( m_screenCamera.GetBoundingBox() );
-	g_theRenderer->EndCamera( m_screenCamera );
+	g_theRenderBackend->EndCamera( m_screenCamera );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Game::Render_Credits() const
 {
-	g_theRenderer->ClearScreen( Rgba8( 25, 25, 30, 255 ) );
-	g_theRenderer->BeginCamera( m_screenCamera );
+	g_theRenderBackend->ClearScreen( Rgba8( 25, 25, 30, 255 ) );
+	g_theRenderBackend->BeginCamera( m_screenCamera );
 
 	AABB2 const& screenBounds = m_screenCamera.GetBoundingBox();
 	Vec2 screenDimensions = screenBounds.GetDimensions();
@@ -525,17 +1152,41 @@ void Game::Render_Credits() const
 	AABB2 textBounds = titleBounds.ChopOffBottom( .75f );
 	Vec2 titleDimensions = titleBounds.GetDimensions();
 
-	IndexedMesh textVerts;
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, "Credits", titleBounds, 99999.f, Rgba8::WHITE, .7f );
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, m_credits, textBounds, 99999.f, Rgba8::WHITE, .6f );
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->SetBlendMode( BlendMode::OPAQUE );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawIndexedMesh( textVerts );
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->SetBlendMode( BlendMode::OPAQUE );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
+
+	g_theRenderBackend->EndCamera( m_screenCamera );
+}
 
-	g_theRenderer->EndCamera( m_screenCamera );
+
+//----------------------------------------------------------------------------------------------------------
+void Game::Render_Calibration() const
+{
+	g_theRenderBackend->ClearScreen( Rgba8( 25, 25, 30, 255 ) );
+	g_theRenderBackend->BeginCamera( m_screenCamera );
+	m_calibrator->Render( m_screenCamera.GetBoundingBox() );
+	g_theRenderBackend->EndCamera( m_screenCamera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::Render_Editor() const
+{
+	g_theRenderBackend->ClearScreen( Rgba8::DARK_GRAY );
+
+	m_editor->Render();
+
+	g_theRenderBackend->BeginCamera( m_screenCamera );
+	m_editor->RenderHUD( m_screenCamera.GetBoundingBox() );
+	g_theRenderBackend->EndCamera( m_screenCamera );
 }
 
 
@@ -556,6 +1207,7 @@ void Game::OnExit_LevelSelect()
 void Game::OnExit_Gameplay()
 {
 	GetCurrentLevel().Shutdown();
+	m_fixedDeltaSeconds = 0.0;
 }
 
 
@@ -580,6 +1232,7 @@ void Game::OnEnter_Attract()
 void Game::OnEnter_LevelSelect()
 {
 	InitializeCameras();
+	KeepSelectedLevelVisible();
 }
 
 
@@ -596,3 +1249,42 @@ void Game::OnEnter_Credits()
 {
 
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::OnExit_Calibration()
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::OnEnter_Calibration()
+{
+	InitializeCameras();
+	m_calibrator->Start();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Saved edits go through the same background compile as any other changed chart, so the level picks
+// them up whether or not the file watcher is running
+//
+void Game::OnExit_Editor()
+{
+	if ( m_editor->HasSavedChanges() )
+	{
+		QueueChartReload( m_currentLevelIndex );
+	}
+	m_editor->Close();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Game::OnEnter_Editor()
+{
+	InitializeCameras();
+	if ( !m_editor->Open( GetCurrentLevel().GetFilePath() ) )
+	{
+		GoToState( GameState::LEVEL_SELECT );
+	}
+}
@@ -3,10 +3,13 @@
 #include "Game/TapManager.hpp"
 #include "Game/GameCamera.hpp"
 #include "Game/Level.hpp"
+#include "Game/RedrawThrottle.hpp"
 #include "Engine/Core/Rgba8.hpp"
 #include "Engine/Audio/AudioSystem_Wwise.hpp"
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Core/TaggedString.hpp"
+#include <atomic>
+#include <thread>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -15,6 +18,11 @@ class Path;
 class PlayerPlanets;
 class Conductor;
 class Menu;
+class Replay;
+class LatencyCalibrator;
+class ChartEditor;
+class Button;
+class FileWatcher;
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -24,6 +32,31 @@ enum class GameState
 	LEVEL_SELECT,
 	GAMEPLAY,
 	CREDITS,
+	CALIBRATION,
+	EDITOR,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class LevelSortMode
+{
+	LIBRARY,			// LevelConfig.xml order
+	EASIEST_FIRST,
+	HARDEST_FIRST,
+
+	COUNT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class LevelFilter
+{
+	ALL,
+	EASY,
+	NORMAL,
+	HARD,
+
+	COUNT
 };
 
 
@@ -39,10 +72,24 @@ public:
 
 	void Update();
 	void Render() const;
+	bool ShouldRenderFrame();
 
 	Clock* GetClock();
+	double GetTimeSeconds() const;
 	void GoToState( GameState state );
 
+	bool BeginReplayPlayback( Replay const& replay, double fixedDeltaSeconds );
+	bool IsReplayPlaybackFinished() const;
+
+	unsigned int GetLevelCount() const;
+	std::string const& GetLevelFilePath( unsigned int levelIndex ) const;
+	Level* FindLevel( std::string const& levelName );
+	Level const& GetLevel( unsigned int levelIndex ) const;
+	void AnalyzeCharts();
+
+	bool IsIdleState() const;
+	RedrawThrottle const& GetRedrawThrottle() const;
+
 private:
 	Level& GetCurrentLevel();
 	Level const& GetCurrentLevel() const;
@@ -55,33 +102,59 @@ private:
 
 	void SelectNextLevel();
 	void SelectPrevLevel();
+	void CycleLevelSort();
+	void CycleLevelFilter();
+	void RebuildLevelOrder();
+	void KeepSelectedLevelVisible();
+	bool DoesLevelPassFilter( unsigned int levelIndex, LevelFilter filter ) const;
+	void UpdateLevelSelectLabels();
 
 	void UpdateDevCheats();
+	void UpdateRedrawRequests();
+
+	void StartHotReload();
+	void StopHotReload();
+	void UpdateHotReload();
+	void QueueChartReload( unsigned int levelIndex );
+	void StartChartCompile();
+	void FinishChartCompile();
+	void ApplyPendingCharts();
 
 	void Update_Attract();
 	void Update_LevelSelect();
 	void Update_Gameplay();
 	void Update_Credits();
+	void Update_Calibration();
+	void Update_Editor();
 
 	void Render_Attract() const;
 	void Render_LevelSelect() const;
 	void Render_Gameplay() const;
 	void Render_Credits() const;
+	void Render_Calibration() const;
+	void Render_Editor() const;
 
 	void OnExit_Attract();
 	void OnExit_LevelSelect();
 	void OnExit_Gameplay();
 	void OnExit_Credits();
+	void OnExit_Calibration();
+	void OnExit_Editor();
 
 	void OnEnter_Attract();
 	void OnEnter_LevelSelect();
 	void OnEnter_Gameplay();
 	void OnEnter_Credits();
+	void OnEnter_Calibration();
+	void OnEnter_Editor();
 
 private:
 	Level* m_levels = nullptr;
 	unsigned int m_levelCount;
 	unsigned int m_currentLevelIndex = 0;
+	std::vector<unsigned int> m_levelOrder;		// Level select order: indexes into m_levels, sorted and filtered
+	LevelSortMode m_levelSortMode = LevelSortMode::LIBRARY;
+	LevelFilter m_levelFilter = LevelFilter::ALL;
 
 	TaggedString m_credits;
 	SoundPlaybackID m_music;
@@ -89,9 +162,31 @@ private:
 	Camera m_screenCamera;
 	RandomNumberGenerator* m_rng;
 	Clock* m_gameClock;
+	double m_fixedDeltaSeconds = 0.0;	// Positive while a replay is being stepped at a fixed rate
+	double m_fixedTimeSeconds = 0.0;
 
 	Menu* m_attractMenu;
 	Menu* m_levelSelectMenu;
+	Button* m_levelSortButton = nullptr;
+	Button* m_levelFilterButton = nullptr;
+	LatencyCalibrator* m_calibrator = nullptr;
+	ChartEditor* m_editor = nullptr;
+
+	// Hot reload: the watcher notices edits under Data/, a worker compiles the affected charts, and each
+	// level swaps its new chart in at its next safe point
+	FileWatcher* m_dataWatcher = nullptr;
+	std::vector<unsigned int> m_queuedReloads;			// Level indexes waiting for the worker
+	std::vector<CompiledChart*> m_compilingCharts;		// Owned by the worker until it finishes
+	std::vector<unsigned int> m_compilingLevelIndexes;
+	std::thread m_chartCompileThread;
+	std::atomic<bool> m_isChartCompileFinished = false;
+	bool m_hasPendingCharts = false;
+	bool m_needsLevelOrderRebuild = false;		// A chart changed a rating; waits until gameplay is exited
 
 	bool m_inAttractMode = true;
+
+	// Menus and credits only redraw on input, animation or a refresh timer; see ShouldRenderFrame()
+	RedrawThrottle m_redrawThrottle;
+	Vec2 m_lastCursorPosition;
+	Vec2 m_lastClientDimensions;
 };
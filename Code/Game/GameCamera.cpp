@@ -6,8 +6,16 @@
 //----------------------------------------------------------------------------------------------------------
 void GameCamera::Update()
 {
-	AABB2 bounds = GetBoundingBox();
-	Vec2 displacement = m_targetPosition - Vec2::CopyVec3XY( m_position );
+	Step( static_cast<float>( GetGameClock()->GetDeltaSeconds() ) );
+	PoseAt( m_simulatedPosition );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCamera::Step( float deltaSeconds )
+{
+	m_prevSimulatedPosition = m_simulatedPosition;
+	Vec2 displacement = m_targetPosition - m_simulatedPosition;
 	displacement.y *= m_yBias;
 	float distance = displacement.GetLength();
 	Vec2 directionToTarget = distance > 0.0001f ? displacement / distance : Vec2::ZERO;
@@ -17,9 +25,16 @@ void GameCamera::Update()
 	Vec2 drag = m_dragPerSpeed * m_velocity;
 	Vec2 totalAcceleration = drag + acceleration;
 
-	float deltaTime = static_cast<float>( GetGameClock()->GetDeltaSeconds() );
-	m_velocity += totalAcceleration * deltaTime;
-	m_position += m_velocity * deltaTime;
+	m_velocity += totalAcceleration * deltaSeconds;
+	m_simulatedPosition += m_velocity * deltaSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GameCamera::PoseAt( Vec2 const& position )
+{
+	AABB2 bounds = GetBoundingBox();
+	m_position = Vec3( position, m_position.z );
 	SetOrthoView( bounds, m_orthographicNear, m_orthographicFar );
 }
 
@@ -28,6 +43,27 @@ void GameCamera::Update()
 void GameCamera::Reset()
 {
 	m_velocity = Vec2::ZERO;
+	m_simulatedPosition = m_targetPosition;
+	m_prevSimulatedPosition = m_targetPosition;
 	m_position = Vec3( m_targetPosition, 0.f );
 }
 
+
+//----------------------------------------------------------------------------------------------------------
+// Snapping once a tick keeps the last tick's position, so a camera that follows a track every tick still
+// interpolates smoothly between them
+//
+void GameCamera::SnapTo( Vec2 const& position )
+{
+	m_targetPosition = position;
+	m_velocity = Vec2::ZERO;
+	m_simulatedPosition = position;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Vec2 GameCamera::GetPositionBetweenTicks( float fraction ) const
+{
+	return m_prevSimulatedPosition + ( m_simulatedPosition - m_prevSimulatedPosition ) * fraction;
+}
+
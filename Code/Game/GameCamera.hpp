@@ -6,13 +6,20 @@
 class GameCamera : public Camera
 {
 public:
-	void Update();
+	void Update();								// Steps by the game clock's delta and shows the result
+	void Step( float deltaSeconds );			// One fixed simulation tick
+	void PoseAt( Vec2 const& position );		// What renders; the simulation never touches it
 	void Reset();
+	void SnapTo( Vec2 const& position );
+
+	Vec2 GetPositionBetweenTicks( float fraction ) const;	// A fraction of the way from the last tick to this one
 
 public:
 	Vec2 m_targetPosition = Vec2::ZERO;
 
 private:
+	Vec2 m_simulatedPosition = Vec2::ZERO;
+	Vec2 m_prevSimulatedPosition = Vec2::ZERO;
 	Vec2 m_velocity = Vec2::ZERO;
 	float m_accelerationPerDist = .15f;
 	float m_accelerationPerDistSq = .3f;
@@ -1,11 +1,13 @@
 #include "Game/GameCommon.hpp"
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
+#include "Game/RenderBackend.hpp"
 #include "Engine/Math/Vec2.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "Engine/Core/Rgba8.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include <filesystem>
 
 //--------------------------------------------------------------------------------------------------------------
 void DebugDrawRing( Vec2 const& center, float radius, float thickness, Rgba8 const& color )
@@ -57,8 +59,8 @@ void DebugDrawRing( Vec2 const& center, float radius, float thickness, Rgba8 con
 		m_ringVerts[i].m_color = color;
 
 	// Render
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->DrawVertexArray( NUM_VERTS, m_ringVerts );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->DrawVertexArray( NUM_VERTS, m_ringVerts );
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -93,7 +95,7 @@ void DebugDrawLine( Vec2 const& posA, Vec2 const& posB, float thickness, Rgba8 c
 		m_lineVerts[i].m_color = color;
 
 	// Render
-	g_theRenderer->DrawVertexArray( NUM_VERTS, m_lineVerts );
+	g_theRenderBackend->DrawVertexArray( NUM_VERTS, m_lineVerts );
 }
 
 //--------------------------------------------------------------------------------------------------------------
@@ -116,7 +118,7 @@ void DebugDrawCircle( Vec2 const& center, float radius, Rgba8 const& color )
 		m_circleVerts[3 * triIndex + 2].m_color = color;
 	}
 
-	g_theRenderer->DrawVertexArray( NUM_VERTS, m_circleVerts );
+	g_theRenderBackend->DrawVertexArray( NUM_VERTS, m_circleVerts );
 }
 
 
@@ -154,6 +156,21 @@ float GetAngularDisplacement( float fromDegrees, float toDegrees, bool clockwise
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+unsigned long long HashLevelName( std::string const& levelFilePath )
+{
+	// FNV-1a over the file stem, so the hash survives the data folder being moved
+	std::string levelName = std::filesystem::path( levelFilePath ).stem().string();
+	unsigned long long hash = 14695981039346656037ull;
+	for ( char character : levelName )
+	{
+		hash ^= static_cast<unsigned char>( character );
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 Clock* GetGameClock()
 {
@@ -165,3 +182,16 @@ Clock* GetGameClock()
 
 	return g_theApp->m_theGame->GetClock();
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+double GetGameTimeSeconds()
+{
+	if ( g_theApp == nullptr )
+		return 0.0;
+
+	if ( g_theApp->m_theGame == nullptr )
+		return 0.0;
+
+	return g_theApp->m_theGame->GetTimeSeconds();
+}
@@ -1,13 +1,17 @@
 #pragma once
+#include <string>
 
 class App;
 class RandomNumberGenerator;
 class Renderer;
+class RenderBackend;
 class InputSystem;
 class AudioSystem_Wwise;
 class Window;
 class Clock;
 class BitmapFont;
+class ScoreDatabase;
+class FrameArena;
 
 struct Vec2;
 struct Rgba8;
@@ -17,8 +21,11 @@ extern App* g_theApp;
 extern InputSystem* g_theInput;
 extern Window* g_theWindow;
 extern Renderer* g_theRenderer;
+extern RenderBackend* g_theRenderBackend;
 extern AudioSystem_Wwise* g_theAudio;
 extern BitmapFont* g_defaultFont;
+extern ScoreDatabase* g_theScoreDatabase;
+extern FrameArena* g_theFrameArena;
 
 
 // DEBUG DRAWING FUNCTIONS
@@ -29,4 +36,7 @@ void DebugDrawCircle( Vec2 const& center, float radius, Rgba8 const& color );
 float GetNormalizedAngle( float angle );
 float GetAngularDisplacement( float fromDegrees, float toDegrees, bool clockwise );
 
+unsigned long long HashLevelName( std::string const& levelFilePath );
+
 Clock* GetGameClock();
+double GetGameTimeSeconds();
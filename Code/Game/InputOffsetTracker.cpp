@@ -0,0 +1,129 @@
+#include "Game/InputOffsetTracker.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Scales a median absolute deviation to a standard deviation for normally distributed errors
+constexpr double MAD_TO_STANDARD_DEVIATION = 1.4826;
+
+// The standard error of a median is this much larger than that of a mean of the same samples
+constexpr double MEDIAN_STANDARD_ERROR_FACTOR = 1.2533;
+
+
+//----------------------------------------------------------------------------------------------------------
+void InputOffsetTracker::Reset()
+{
+	m_nextSampleIndex = 0;
+	m_sampleCount = 0;
+	m_biasSeconds = 0.0;
+	m_spreadSeconds = 0.0;
+	m_totalNudgeSeconds = 0.0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Reads the blackboard, which allocates, so it is called once per attempt and never from AddSample().
+// Earlier attempts' nudges are already in inputDelaySeconds, so the total carries on from there.
+//
+void InputOffsetTracker::LoadSettings( double inputDelaySeconds )
+{
+	m_minSamples		= std::clamp( g_gameConfigBlackboard.GetValue( "adaptiveDelayMinSamples", 16 ), 2, INPUT_OFFSET_WINDOW );
+	m_deadbandSeconds	= g_gameConfigBlackboard.GetValue( "adaptiveDelayDeadbandSeconds", 0.008 );
+	m_significance		= g_gameConfigBlackboard.GetValue( "adaptiveDelaySignificance", 3.0 );
+	m_correctionRate	= g_gameConfigBlackboard.GetValue( "adaptiveDelayRate", 0.25 );
+	m_maxStepSeconds	= g_gameConfigBlackboard.GetValue( "adaptiveDelayMaxStepSeconds", 0.004 );
+	m_maxDriftSeconds	= g_gameConfigBlackboard.GetValue( "adaptiveDelayMaxDriftSeconds", 0.05 );
+
+	double calibratedInputDelaySeconds = g_gameConfigBlackboard.GetValue( "calibratedInputDelaySeconds", inputDelaySeconds );
+	m_totalNudgeSeconds = inputDelaySeconds - calibratedInputDelaySeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool InputOffsetTracker::AddSample( double timingErrorSeconds, double& out_nudgeSeconds )
+{
+	m_samples[m_nextSampleIndex] = timingErrorSeconds;
+	m_nextSampleIndex = ( m_nextSampleIndex + 1 ) % INPUT_OFFSET_WINDOW;
+	m_sampleCount = std::min( m_sampleCount + 1, INPUT_OFFSET_WINDOW );
+	UpdateEstimate();
+
+	if ( m_sampleCount < m_minSamples )
+		return false;
+
+	double standardError = MEDIAN_STANDARD_ERROR_FACTOR * m_spreadSeconds / sqrt( static_cast<double>( m_sampleCount ) );
+	double biasMagnitude = fabs( m_biasSeconds );
+	if ( biasMagnitude < m_deadbandSeconds || biasMagnitude < m_significance * standardError )
+		return false;
+
+	double stepSeconds = std::clamp( m_biasSeconds * m_correctionRate, -m_maxStepSeconds, m_maxStepSeconds );
+	double newTotalNudgeSeconds = std::clamp( m_totalNudgeSeconds + stepSeconds, -m_maxDriftSeconds, m_maxDriftSeconds );
+	// A delay already outside the bound is left alone rather than pulled back against the bias
+	double clampedStepSeconds = newTotalNudgeSeconds - m_totalNudgeSeconds;
+	if ( clampedStepSeconds * stepSeconds <= 0.0 )
+		return false;
+
+	stepSeconds = clampedStepSeconds;
+
+	// Taps after the nudge will read this much earlier; shift the history to match
+	for ( int sampleIndex = 0; sampleIndex < m_sampleCount; sampleIndex++ )
+	{
+		m_samples[sampleIndex] -= stepSeconds;
+	}
+	m_biasSeconds -= stepSeconds;
+	m_totalNudgeSeconds = newTotalNudgeSeconds;
+
+	out_nudgeSeconds = stepSeconds;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int InputOffsetTracker::GetSampleCount() const
+{
+	return m_sampleCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double InputOffsetTracker::GetBiasSeconds() const
+{
+	return m_biasSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double InputOffsetTracker::GetSpreadSeconds() const
+{
+	return m_spreadSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double InputOffsetTracker::GetTotalNudgeSeconds() const
+{
+	return m_totalNudgeSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void InputOffsetTracker::UpdateEstimate()
+{
+	double sorted[INPUT_OFFSET_WINDOW];
+	std::copy( m_samples, m_samples + m_sampleCount, sorted );
+
+	// Upper median for even counts; the window is too small for the difference to matter
+	int middle = m_sampleCount / 2;
+	std::nth_element( sorted, sorted + middle, sorted + m_sampleCount );
+	m_biasSeconds = sorted[middle];
+
+	for ( int sampleIndex = 0; sampleIndex < m_sampleCount; sampleIndex++ )
+	{
+		sorted[sampleIndex] = fabs( m_samples[sampleIndex] - m_biasSeconds );
+	}
+	std::nth_element( sorted, sorted + middle, sorted + m_sampleCount );
+	m_spreadSeconds = MAD_TO_STANDARD_DEVIATION * sorted[middle];
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int INPUT_OFFSET_WINDOW = 32;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Watches the signed timing error of accepted taps (positive is late) and keeps a robust estimate of
+// the player's systematic bias: the median of the last INPUT_OFFSET_WINDOW errors, with the scaled
+// median absolute deviation as its spread. When the bias is both larger than a dead band and
+// statistically distinguishable from zero, it proposes a small input delay nudge toward cancelling it.
+// Nudges are rate limited per tap, and bounded in total against the calibrated delay rather than the
+// delay an attempt started with, so the bound holds across levels and sessions. The sample history is
+// re-centred by each nudge so the same bias is never corrected twice. All storage is fixed; adding a sample never allocates.
+//
+class InputOffsetTracker
+{
+public:
+	void Reset();
+	void LoadSettings( double inputDelaySeconds );
+	bool AddSample( double timingErrorSeconds, double& out_nudgeSeconds );
+
+	int GetSampleCount() const;
+	double GetBiasSeconds() const;
+	double GetSpreadSeconds() const;
+	double GetTotalNudgeSeconds() const;
+
+private:
+	void UpdateEstimate();
+
+private:
+	double	m_samples[INPUT_OFFSET_WINDOW] = {};
+	int		m_nextSampleIndex		= 0;
+	int		m_sampleCount			= 0;
+	double	m_biasSeconds			= 0.0;
+	double	m_spreadSeconds			= 0.0;
+	double	m_totalNudgeSeconds		= 0.0;		// From the calibrated delay
+
+	int		m_minSamples			= 16;
+	double	m_deadbandSeconds		= 0.008;
+	double	m_significance			= 3.0;		// Standard errors the bias must clear
+	double	m_correctionRate		= 0.25;		// Fraction of the bias corrected per tap
+	double	m_maxStepSeconds		= 0.004;
+	double	m_maxDriftSeconds		= 0.05;		// Total nudge allowed either way
+};
@@ -0,0 +1,396 @@
+#include "Game/LatencyCalibrator.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/TaggedString.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Input/InputSystem.hpp"
+#include "Engine/Audio/AudioSystem_Wwise.hpp"
+#include "Engine/Math/AABB2.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Renderer/BitmapFont.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+
+//----------------------------------------------------------------------------------------------------------
+TimingOffsetEstimate EstimateTimingOffset( std::vector<double> samples, double trimFraction )
+{
+	TimingOffsetEstimate estimate;
+	estimate.m_sampleCount = static_cast<int>( samples.size() );
+	if ( samples.empty() )
+		return estimate;
+
+	std::sort( samples.begin(), samples.end() );
+
+	size_t middle = samples.size() / 2;
+	estimate.m_medianSeconds = ( samples.size() % 2 == 1 ) ? samples[middle] : 0.5 * ( samples[middle - 1] + samples[middle] );
+
+	// Always keep at least the middle sample, however aggressive the trim
+	size_t trimCount = static_cast<size_t>( static_cast<double>( samples.size() ) * std::clamp( trimFraction, 0.0, 0.5 ) );
+	if ( trimCount * 2 >= samples.size() )
+	{
+		trimCount = ( samples.size() - 1 ) / 2;
+	}
+
+	size_t firstKept = trimCount;
+	size_t endKept = samples.size() - trimCount;
+	estimate.m_keptCount = static_cast<int>( endKept - firstKept );
+
+	double sum = 0.0;
+	for ( size_t sampleIndex = firstKept; sampleIndex < endKept; sampleIndex++ )
+	{
+		sum += samples[sampleIndex];
+	}
+	estimate.m_trimmedMeanSeconds = sum / static_cast<double>( estimate.m_keptCount );
+
+	double sumSquaredError = 0.0;
+	for ( size_t sampleIndex = firstKept; sampleIndex < endKept; sampleIndex++ )
+	{
+		double error = samples[sampleIndex] - estimate.m_trimmedMeanSeconds;
+		sumSquaredError += error * error;
+	}
+
+	if ( estimate.m_keptCount > 1 )
+	{
+		estimate.m_varianceSeconds2 = sumSquaredError / static_cast<double>( estimate.m_keptCount - 1 );
+	}
+	estimate.m_standardDeviationSeconds = sqrt( estimate.m_varianceSeconds2 );
+	return estimate;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool LoadLatencyProfile( std::string const& profileName, LatencyProfile& out_profile )
+{
+	std::string profileFilePath = g_gameConfigBlackboard.GetValue( "latencyProfileFile", "Saved/LatencyProfiles.xml" );
+
+	XmlDocument document;
+	if ( document.LoadFile( profileFilePath.c_str() ) != tinyxml2::XML_SUCCESS )
+		return false;
+
+	XmlElement const* rootElement = document.RootElement();
+	if ( rootElement == nullptr )
+		return false;
+
+	XmlElement const* profileElement = rootElement->FirstChildElement( "Profile" );
+	while ( profileElement != nullptr )
+	{
+		NamedStrings profileArgs;
+		profileArgs.PopulateFromXmlElementAttributes( *profileElement );
+		if ( profileArgs.GetValue( "name", "" ) == profileName )
+		{
+			out_profile.m_name = profileName;
+			out_profile.m_inputDelaySeconds = profileArgs.GetValue( "inputDelaySeconds", 0.0 );
+			out_profile.m_standardDeviationSeconds = profileArgs.GetValue( "standardDeviationSeconds", 0.0 );
+			out_profile.m_sampleCount = profileArgs.GetValue( "samples", 0 );
+			return true;
+		}
+
+		profileElement = profileElement->NextSiblingElement( "Profile" );
+	}
+
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Rewrites only this profile's element; every other profile in the file is left as it was.
+//
+bool SaveLatencyProfile( LatencyProfile const& profile )
+{
+	std::string profileFilePath = g_gameConfigBlackboard.GetValue( "latencyProfileFile", "Saved/LatencyProfiles.xml" );
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( profileFilePath ).parent_path(), error );
+
+	XmlDocument document;
+	XmlElement* rootElement = nullptr;
+	if ( document.LoadFile( profileFilePath.c_str() ) == tinyxml2::XML_SUCCESS )
+	{
+		rootElement = document.RootElement();
+	}
+
+	if ( rootElement == nullptr )
+	{
+		document.Clear();
+		rootElement = document.NewElement( "LatencyProfiles" );
+		document.InsertFirstChild( rootElement );
+	}
+
+	XmlElement* profileElement = rootElement->FirstChildElement( "Profile" );
+	while ( profileElement != nullptr )
+	{
+		char const* name = profileElement->Attribute( "name" );
+		if ( name != nullptr && profile.m_name == name )
+			break;
+
+		profileElement = profileElement->NextSiblingElement( "Profile" );
+	}
+
+	if ( profileElement == nullptr )
+	{
+		profileElement = document.NewElement( "Profile" );
+		rootElement->InsertEndChild( profileElement );
+	}
+
+	profileElement->SetAttribute( "name", profile.m_name.c_str() );
+	profileElement->SetAttribute( "inputDelaySeconds", Stringf( "%.4f", profile.m_inputDelaySeconds ).c_str() );
+	profileElement->SetAttribute( "standardDeviationSeconds", Stringf( "%.4f", profile.m_standardDeviationSeconds ).c_str() );
+	profileElement->SetAttribute( "samples", profile.m_sampleCount );
+
+	return document.SaveFile( profileFilePath.c_str() ) == tinyxml2::XML_SUCCESS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The profile's delay is also the baseline adaptive nudges must stay near; see InputOffsetTracker
+//
+void ApplyLatencyProfile( LatencyProfile const& profile )
+{
+	g_gameConfigBlackboard.SetValue( "inputDelaySeconds", Stringf( "%.4f", profile.m_inputDelaySeconds ) );
+	g_gameConfigBlackboard.SetValue( "calibratedInputDelaySeconds", Stringf( "%.4f", profile.m_inputDelaySeconds ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+LatencyCalibrator::LatencyCalibrator()
+{
+	m_tapInput.SetActive( false );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void LatencyCalibrator::Start()
+{
+	float bpm = g_gameConfigBlackboard.GetValue( "calibrationBpm", 100.f );
+	m_clickIntervalSeconds = 60.0 / static_cast<double>( std::max( bpm, 1.f ) );
+	m_leadInClicks = g_gameConfigBlackboard.GetValue( "calibrationLeadInClicks", 4 );
+	m_targetTaps = std::max( g_gameConfigBlackboard.GetValue( "calibrationTaps", 32 ), 2 );
+	m_trimFraction = g_gameConfigBlackboard.GetValue( "calibrationTrimFraction", 0.2 );
+	m_maxDeviationSeconds = g_gameConfigBlackboard.GetValue( "calibrationMaxDeviationSeconds", 0.035 );
+
+	// A quarter of the clicks can go unanswered before the run is abandoned
+	m_maxClicks = m_leadInClicks + m_targetTaps + m_targetTaps / 4;
+
+	m_phase = CalibrationPhase::LEAD_IN;
+	m_clickTimes.clear();
+	m_isClickAnswered.clear();
+	m_offsetSamples.clear();
+	m_estimate = TimingOffsetEstimate();
+	m_failureReason.clear();
+	m_isResultSaved = false;
+
+	m_tapInput.SetActive( true );
+	m_tapInput.PopAllTaps();
+	m_nextClickTimeSeconds = GetCurrentTimeSeconds() + m_clickIntervalSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void LatencyCalibrator::Update()
+{
+	if ( m_phase == CalibrationPhase::FINISHED || m_phase == CalibrationPhase::FAILED )
+	{
+		if ( g_theInput->GetKeyDown( 'R' ) )
+		{
+			Start();
+			return;
+		}
+
+		if ( m_phase == CalibrationPhase::FINISHED && !m_isResultSaved &&
+			( g_theInput->GetKeyDown( KEYCODE_ENTER ) || g_theInput->GetKeyDown( KEYCODE_SPACE ) ) )
+		{
+			SaveResult();
+		}
+		return;
+	}
+
+	double currentTimeSeconds = GetCurrentTimeSeconds();
+	m_tapInput.PollInput();
+	PlayDueClicks( currentTimeSeconds );
+	MatchTaps();
+
+	if ( m_phase == CalibrationPhase::LEAD_IN && static_cast<int>( m_clickTimes.size() ) > m_leadInClicks )
+	{
+		m_phase = CalibrationPhase::COLLECTING;
+	}
+
+	// Past the last click, wait out the tap window of the final click before giving up on it
+	bool isOutOfClicks = static_cast<int>( m_clickTimes.size() ) >= m_maxClicks &&
+		currentTimeSeconds > m_clickTimes.back() + m_clickIntervalSeconds;
+	if ( static_cast<int>( m_offsetSamples.size() ) >= m_targetTaps || isOutOfClicks )
+	{
+		Finish();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void LatencyCalibrator::Render( AABB2 const& screenBounds ) const
+{
+	std::string statusText;
+	switch ( m_phase )
+	{
+		case CalibrationPhase::LEAD_IN:
+		{
+			statusText = "Listen to the click...";
+			break;
+		}
+		case CalibrationPhase::COLLECTING:
+		{
+			statusText = Stringf( "Tap any key on each click\n%i / %i", static_cast<int>( m_offsetSamples.size() ), m_targetTaps );
+			break;
+		}
+		case CalibrationPhase::FINISHED:
+		{
+			std::string profileName = g_gameConfigBlackboard.GetValue( "latencyProfile", "default" );
+			statusText = Stringf( "Input delay: %.0f ms\nmedian %.0f ms, spread %.0f ms over %i taps\n",
+				m_estimate.m_trimmedMeanSeconds * 1000.0, m_estimate.m_medianSeconds * 1000.0,
+				m_estimate.m_standardDeviationSeconds * 1000.0, m_estimate.m_sampleCount );
+			statusText += m_isResultSaved ? Stringf( "Saved to profile \"%s\"", profileName.c_str() ) : Stringf( "ENTER saves to profile \"%s\", R retries", profileName.c_str() );
+			break;
+		}
+		case CalibrationPhase::FAILED:
+		{
+			statusText = Stringf( "%s\nR to try again", m_failureReason.c_str() );
+			break;
+		}
+	}
+
+	AABB2 textBounds = screenBounds;
+	textBounds.PadAllSides( -50.f );
+	AABB2 statusBounds = textBounds.ChopOffBottom( .66f );
+
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, TaggedString( "<shadow>Calibration<!shadow>" ), textBounds, 150.f, Rgba8::WHITE, .6f );
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, TaggedString( statusText ), statusBounds, 50.f, Rgba8::PASTEL_BLUE, .5f, Vec2( .5f, 1.f ) );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool LatencyCalibrator::SaveResult()
+{
+	if ( m_phase != CalibrationPhase::FINISHED )
+		return false;
+
+	LatencyProfile profile;
+	profile.m_name = g_gameConfigBlackboard.GetValue( "latencyProfile", "default" );
+	profile.m_inputDelaySeconds = std::max( m_estimate.m_trimmedMeanSeconds, 0.0 );
+	profile.m_standardDeviationSeconds = m_estimate.m_standardDeviationSeconds;
+	profile.m_sampleCount = m_estimate.m_sampleCount;
+	ApplyLatencyProfile( profile );
+
+	if ( !SaveLatencyProfile( profile ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save latency profile \"%s\"", profile.m_name.c_str() ) );
+		return false;
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Latency profile \"%s\" set to %1.3f seconds.", profile.m_name.c_str(), profile.m_inputDelaySeconds ) );
+	m_isResultSaved = true;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+CalibrationPhase LatencyCalibrator::GetPhase() const
+{
+	return m_phase;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+TimingOffsetEstimate const& LatencyCalibrator::GetEstimate() const
+{
+	return m_estimate;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Clicks follow a fixed schedule so frame hitches do not accumulate into drift, but each click is
+// timestamped when it is actually triggered, which is what the tap is measured against.
+//
+void LatencyCalibrator::PlayDueClicks( double currentTimeSeconds )
+{
+	if ( static_cast<int>( m_clickTimes.size() ) >= m_maxClicks || currentTimeSeconds < m_nextClickTimeSeconds )
+		return;
+
+	g_theAudio->PlayEvent( AK::EVENTS::PLAY_TESTCLICK );
+	m_clickTimes.push_back( currentTimeSeconds );
+	m_isClickAnswered.push_back( false );
+
+	while ( m_nextClickTimeSeconds <= currentTimeSeconds )
+	{
+		m_nextClickTimeSeconds += m_clickIntervalSeconds;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A tap answers the latest click no more than a quarter interval after it. Latency is almost always
+// positive, so the window leans late: [-0.25, 0.75) of an interval around the click.
+//
+void LatencyCalibrator::MatchTaps()
+{
+	double tapTimeSeconds = 0.0;
+	while ( m_tapInput.PopOldestTap( tapTimeSeconds ) )
+	{
+		int clickIndex = static_cast<int>( m_clickTimes.size() ) - 1;
+		while ( clickIndex >= 0 && m_clickTimes[clickIndex] > tapTimeSeconds + m_clickIntervalSeconds * .25 )
+		{
+			clickIndex--;
+		}
+
+		// Taps during the lead-in, before any click, or doubled up on one click are not samples
+		if ( clickIndex < m_leadInClicks || m_isClickAnswered[clickIndex] )
+			continue;
+
+		double offsetSeconds = tapTimeSeconds - m_clickTimes[clickIndex];
+		if ( offsetSeconds >= m_clickIntervalSeconds * .75 )
+			continue;
+
+		m_isClickAnswered[clickIndex] = true;
+		m_offsetSamples.push_back( offsetSeconds );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void LatencyCalibrator::Finish()
+{
+	m_tapInput.SetActive( false );
+	m_estimate = EstimateTimingOffset( m_offsetSamples, m_trimFraction );
+
+	if ( m_estimate.m_sampleCount < m_targetTaps / 2 )
+	{
+		m_phase = CalibrationPhase::FAILED;
+		m_failureReason = Stringf( "Only %i of the clicks were answered", m_estimate.m_sampleCount );
+		return;
+	}
+
+	if ( m_estimate.m_standardDeviationSeconds > m_maxDeviationSeconds )
+	{
+		m_phase = CalibrationPhase::FAILED;
+		m_failureReason = Stringf( "Taps were too uneven (spread %.0f ms)", m_estimate.m_standardDeviationSeconds * 1000.0 );
+		return;
+	}
+
+	m_phase = CalibrationPhase::FINISHED;
+}
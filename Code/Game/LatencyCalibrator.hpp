@@ -0,0 +1,95 @@
+#pragma once
+#include "Game/TapManager.hpp"
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct AABB2;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct TimingOffsetEstimate
+{
+	int		m_sampleCount				= 0;
+	int		m_keptCount					= 0;	// Samples left after trimming both tails
+	double	m_medianSeconds				= 0.0;
+	double	m_trimmedMeanSeconds		= 0.0;
+	double	m_varianceSeconds2			= 0.0;	// Of the kept samples
+	double	m_standardDeviationSeconds	= 0.0;
+};
+
+TimingOffsetEstimate EstimateTimingOffset( std::vector<double> samples, double trimFraction );
+
+
+//----------------------------------------------------------------------------------------------------------
+// A measured input delay for one output/input setup (speakers, headphones, a wireless pad...), stored by
+// name in the latency profile file so switching setups does not mean recalibrating.
+//
+struct LatencyProfile
+{
+	std::string	m_name;
+	double		m_inputDelaySeconds			= 0.0;
+	double		m_standardDeviationSeconds	= 0.0;
+	int			m_sampleCount				= 0;
+};
+
+bool LoadLatencyProfile( std::string const& profileName, LatencyProfile& out_profile );
+bool SaveLatencyProfile( LatencyProfile const& profile );
+void ApplyLatencyProfile( LatencyProfile const& profile );
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class CalibrationPhase
+{
+	LEAD_IN,
+	COLLECTING,
+	FINISHED,
+	FAILED,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Plays a metronome click on a fixed schedule and pairs each tap with the click it answers. The offset
+// from click to tap is the whole chain the conductor's input delay has to cancel: audio output latency,
+// the player's reaction and input polling. The result is a trimmed mean, so a few early or missed taps
+// do not drag it around.
+//
+class LatencyCalibrator
+{
+public:
+	LatencyCalibrator();
+
+	void Start();
+	void Update();
+	void Render( AABB2 const& screenBounds ) const;
+
+	bool SaveResult();
+
+	CalibrationPhase GetPhase() const;
+	TimingOffsetEstimate const& GetEstimate() const;
+
+private:
+	void PlayDueClicks( double currentTimeSeconds );
+	void MatchTaps();
+	void Finish();
+
+private:
+	TapManager				m_tapInput;
+	CalibrationPhase		m_phase = CalibrationPhase::LEAD_IN;
+
+	std::vector<double>		m_clickTimes;				// When each click was actually triggered
+	std::vector<bool>		m_isClickAnswered;
+	std::vector<double>		m_offsetSamples;
+	TimingOffsetEstimate	m_estimate;
+	std::string				m_failureReason;
+	bool					m_isResultSaved = false;
+
+	double	m_clickIntervalSeconds		= 0.6;
+	double	m_nextClickTimeSeconds		= 0.0;
+	int		m_leadInClicks				= 4;
+	int		m_targetTaps				= 32;
+	int		m_maxClicks					= 0;
+	double	m_trimFraction				= 0.2;
+	double	m_maxDeviationSeconds		= 0.035;
+};
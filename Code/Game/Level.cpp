@@ -1,5 +1,7 @@
 #include "Game/Level.hpp"
+#include "Game/CameraTrack.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
 #include "Game/Conductor.hpp"
@@ -9,18 +11,32 @@
 #include "Game/GameCommon.hpp"
 #include "Game/GameCamera.hpp"
 #include "Game/TapManager.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/ScoreDatabase.hpp"
+#include "Game/ContentHash.hpp"
+#include "Game/SimulationThread.hpp"
+#include "Game/AllocationTracker.hpp"
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Core/FileUtils.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/TaggedString.hpp"
 #include "Engine/Core/Timer.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Audio/AudioSystem_Wwise.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/DebugRender.hpp"
 #include "Engine/Renderer/BitmapFont.hpp"
 #include "Engine/Renderer/Camera.hpp"
+#include "Engine/Renderer/VertexBuffer.hpp"
+#include "Engine/Renderer/IndexBuffer.hpp"
 #include "Engine/Window/Window.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -82,18 +98,32 @@ Level::Level()
 //----------------------------------------------------------------------------------------------------------
 Level::~Level()
 {
+	delete m_simulationThread;
+	m_simulationThread = nullptr;
+
 	delete m_tapInput;
 	m_tapInput = nullptr;
 
 	for ( Prop* prop : m_judgementProps )
 	{
-		if ( prop == nullptr )
+		delete prop;
+	}
+	m_judgementProps.clear();
+
+	for ( int judgementIndex = 0; judgementIndex < (int)TimingJudgement::COUNT; judgementIndex++ )
+	{
+		if ( m_judgementTextVBOs[judgementIndex] == nullptr )
 			continue;
 
-		delete prop;
-		prop = nullptr;
+		g_theRenderBackend->DestroyVertexBuffer( m_judgementTextVBOs[judgementIndex] );
+		g_theRenderBackend->DestroyIndexBuffer( m_judgementTextIBOs[judgementIndex] );
 	}
 
+	delete m_pendingChart;
+	m_pendingChart = nullptr;
+
+	delete m_cameraTrack;
+	m_cameraTrack = nullptr;
 
 	delete m_path;
 	m_path = nullptr;
@@ -103,60 +133,386 @@ Level::~Level()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+CompiledChart::~CompiledChart()
+{
+	delete m_cameraTrack;
+	m_cameraTrack = nullptr;
+
+	delete m_path;
+	m_path = nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void CompiledChart::Reset()
+{
+	delete m_cameraTrack;
+	m_cameraTrack = nullptr;
+
+	delete m_path;
+	m_path = nullptr;
+
+	m_levelFilePath.clear();
+	m_pathFilePath.clear();
+	m_errorMessage.clear();
+	m_warningMessage.clear();
+	m_chartHash = 0;
+	m_info = LevelInfo();
+	m_tempoMap = TempoMap();
+	m_musicPlayEvent.clear();
+	m_musicStopEvent.clear();
+	m_countdownLength = 4;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Read on the main thread, since the blackboard can change under a worker while a level is being played
+//
+ChartCompileSettings ChartCompileSettings::FromGameConfig()
+{
+	ChartCompileSettings settings;
+	settings.m_usePathCache			= g_gameConfigBlackboard.GetValue( "pathCache", true );
+	settings.m_pathCacheFolder		= g_gameConfigBlackboard.GetValue( "pathCacheFolder", "Saved/PathCache" );
+	settings.m_bakeCamera			= g_gameConfigBlackboard.GetValue( "bakedCamera", false );
+	settings.m_cameraLookahead		= g_gameConfigBlackboard.GetValue( "cameraLookahead", 4 );
+	settings.m_cameraSmoothingNodes	= g_gameConfigBlackboard.GetValue( "cameraSmoothingNodes", 2 );
+	return settings;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Level::LoadFromXML( const char* xmlFilePath )
 {
+	CompiledChart chart;
+	if ( !CompileChart( xmlFilePath, ChartCompileSettings::FromGameConfig(), chart ) )
+	{
+		ERROR_AND_DIE( chart.m_errorMessage );
+	}
+
+	AdoptChart( chart );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Does all of the loading that doesn't need the main thread: reading and hashing both files, parsing,
+// compiling the path (or reading it back from the compiled cache) and baking the camera. The compiled
+// cache is named after the chart hash, so an edited chart simply misses and gets compiled again.
+//
+/*static*/ bool Level::CompileChart( std::string const& xmlFilePath, ChartCompileSettings const& settings, CompiledChart& out_chart )
+{
+	out_chart.m_levelFilePath = xmlFilePath;
+
+	// Read once, then both hashed and parsed from memory
+	std::string levelText;
+	if ( FileReadToString( levelText, xmlFilePath ) <= 0 )
+	{
+		out_chart.m_errorMessage = Stringf( "Failed to load \"%s\"", xmlFilePath.c_str() );
+		return false;
+	}
+
 	XmlDocument levelDoc;
-	XmlResult result = levelDoc.LoadFile( xmlFilePath );
+	XmlResult result = levelDoc.Parse( levelText.c_str(), levelText.size() );
 	if ( result != tinyxml2::XML_SUCCESS )
 	{
-		ERROR_AND_DIE( Stringf( "Failed to load \"%s\"", xmlFilePath ) );
+		out_chart.m_errorMessage = Stringf( "Failed to load \"%s\"", xmlFilePath.c_str() );
+		return false;
 	}
 
 	XmlElement* rootElement = levelDoc.RootElement();
 	if ( rootElement == nullptr )
 	{
-		ERROR_AND_DIE( Stringf( "Level file \"%s\" is missing a root element!", xmlFilePath ) );
+		out_chart.m_errorMessage = Stringf( "Level file \"%s\" is missing a root element!", xmlFilePath.c_str() );
+		return false;
 	}
 
 	NamedStrings attributes;
 	attributes.PopulateFromXmlElementAttributes( *rootElement );
 
-	m_countdownLength = attributes.GetValue( "countdownLength", 4 );
+	out_chart.m_countdownLength = attributes.GetValue( "countdownLength", 4 );
+	out_chart.m_musicPlayEvent = attributes.GetValue( "musicPlayEvent", "" );
+	out_chart.m_musicStopEvent = attributes.GetValue( "musicStopEvent", "" );
+	out_chart.m_info.m_name = attributes.GetValue( "name", "" );
+	out_chart.m_info.m_source = attributes.GetValue( "source", "" );
+	out_chart.m_info.m_authoredDifficulty = attributes.GetValue( "difficulty", 0.f ); 
+	out_chart.m_info.m_difficulty = out_chart.m_info.m_authoredDifficulty;
+
 	float bpm = attributes.GetValue( "bpm", 120.f );
-	std::string musicPlay = attributes.GetValue( "musicPlayEvent", "" );
-	std::string musicStop = attributes.GetValue( "musicStopEvent", "" );
-	SoundEventID musicPlayEvent = g_theAudio->GetEventID( musicPlay );
-	SoundEventID musicStopEvent = g_theAudio->GetEventID( musicStop );
-	m_conductor = new Conductor( bpm, musicPlayEvent, musicStopEvent, m_countdownLength );
+	std::string tempoError;
+	if ( !out_chart.m_tempoMap.PopulateFromXmlElement( *rootElement, bpm, tempoError ) )
+	{
+		out_chart.m_errorMessage = Stringf( "Level file \"%s\": %s", xmlFilePath.c_str(), tempoError.c_str() );
+		return false;
+	}
 
-	m_path = new Path( *m_conductor );
 	std::string pathFilePath = attributes.GetValue( "path", "" );
-	bool success = m_path->LoadFromFile( pathFilePath.c_str() );
-	if ( !success )
+	std::string pathText;
+	if ( FileReadToString( pathText, pathFilePath ) <= 0 )
+	{
+		out_chart.m_errorMessage = Stringf( "Failed to load \"%s\"", pathFilePath.c_str() );
+		return false;
+	}
+
+	out_chart.m_pathFilePath = pathFilePath;
+	out_chart.m_chartHash = HashXXH64( pathText, HashXXH64( levelText ) );
+	out_chart.m_path = new Path();
+
+	std::string cacheFilePath = Stringf( "%s/%s.pathc", settings.m_pathCacheFolder.c_str(), GetContentHashString( out_chart.m_chartHash ).c_str() );
+	if ( !settings.m_usePathCache || !out_chart.m_path->LoadCompiled( cacheFilePath, out_chart.m_chartHash ) )
+	{
+		if ( !out_chart.m_path->LoadFromXmlText( pathText, pathFilePath ) )
+		{
+			out_chart.m_errorMessage = Stringf( "Failed to parse \"%s\"", pathFilePath.c_str() );
+			return false;
+		}
+
+		if ( settings.m_usePathCache )
+		{
+			std::error_code error;
+			std::filesystem::create_directories( settings.m_pathCacheFolder, error );
+			if ( !out_chart.m_path->SaveCompiled( cacheFilePath, out_chart.m_chartHash ) )
+			{
+				out_chart.m_warningMessage = Stringf( "Failed to cache compiled path \"%s\"", cacheFilePath.c_str() );
+			}
+		}
+	}
+
+	if ( settings.m_bakeCamera )
+	{
+		out_chart.m_cameraTrack = new CameraTrack();
+		out_chart.m_cameraTrack->Bake( *out_chart.m_path, settings.m_cameraLookahead, settings.m_cameraSmoothingNodes );
+	}
+
+	if ( settings.m_analyzeChart )
+	{
+		out_chart.m_info.m_chart = ::AnalyzeChart( *out_chart.m_path, out_chart.m_tempoMap );
+		out_chart.m_info.m_difficulty = out_chart.m_info.m_chart.m_rating;
+	}
+
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Swaps a compiled chart in for the current one and finishes it on the main thread: a new conductor, and
+// the path's vertex buffers. The player holds on to the old path and conductor, so it goes with them and
+// is rebuilt by the next countdown.
+//
+void Level::AdoptChart( CompiledChart& chart )
+{
+	if ( !chart.m_warningMessage.empty() )
 	{
-		ERROR_AND_DIE( Stringf( "Failed to load \"%s\"", pathFilePath.c_str() ) );
+		g_theDevConsole->AddLine( DevConsole::WARNING, chart.m_warningMessage );
 	}
 
-	m_info.m_name = attributes.GetValue( "name", "" );
-	m_info.m_source = attributes.GetValue( "source", "" );
-	m_info.m_difficulty = attributes.GetValue( "difficulty", 0.f ); 
+	delete m_player;
+	m_player = nullptr;
+
+	delete m_cameraTrack;
+	m_cameraTrack = chart.m_cameraTrack;
+	chart.m_cameraTrack = nullptr;
+
+	bool isSameNodeCount = m_path != nullptr && m_path->GetNodeCount() == chart.m_path->GetNodeCount();
+	delete m_path;
+	m_path = chart.m_path;
+	chart.m_path = nullptr;
+	m_path->UploadVertexBuffers();
+
+	delete m_conductor;
+	SoundEventID musicPlayEvent = g_theAudio->GetEventID( chart.m_musicPlayEvent );
+	SoundEventID musicStopEvent = g_theAudio->GetEventID( chart.m_musicStopEvent );
+	m_conductor = new Conductor( chart.m_tempoMap, musicPlayEvent, musicStopEvent, chart.m_countdownLength );
+
+	m_filePath = chart.m_levelFilePath;
+	m_pathFilePath = chart.m_pathFilePath;
+	m_chartHash = chart.m_chartHash;
+	m_countdownLength = chart.m_countdownLength;
+	m_info = chart.m_info;
+
+	// A checkpoint only means anything on the path it was reached on
+	if ( !isSameNodeCount )
+	{
+		ResetCheckpoints();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SetPendingChart( CompiledChart* chart )
+{
+	delete m_pendingChart;
+	m_pendingChart = chart;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Level::HasPendingChart() const
+{
+	return m_pendingChart != nullptr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Only called where nothing is mid-flight on the old chart: by the game for levels that aren't being
+// played, and by the countdown of the level that is, right before it builds its player.
+//
+void Level::ApplyPendingChart()
+{
+	if ( m_pendingChart == nullptr )
+		return;
+
+	AdoptChart( *m_pendingChart );
+	delete m_pendingChart;
+	m_pendingChart = nullptr;
+	g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Reloaded \"%s\" (chart %s)", m_filePath.c_str(), GetContentHashString( m_chartHash ).c_str() ) );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Level::Startup()
 {
+	m_inputOffsetTracker.Reset();
 	GoToState( LevelState::COUNTDOWN );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
+// While playing live the ticks run on the simulation thread, which also reads the keyboard itself, even
+// while this holds the shared mutex; see PollLiveTaps(). This only picks up its latest snapshot. Otherwise input is polled once a frame, here,
+// and this runs as many whole ticks as the frame covers, the rest carrying over to the next frame, with
+// the last tick due now so it judges this frame's taps.
+//
+// That fallback is not frame-rate independent for live input: every tap in a frame is stamped when the
+// frame polled it, so it is judged up to a frame late. Only replays, whose taps carry their recorded
+// ticks, and live play on the simulation thread judge taps at the time they were made.
+//
 void Level::Update()
 {
-	m_tapInput->PollInput();
-	m_camera->Update();
-	m_conductor->Update();
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::LEVEL );
+
+	// Recording grows here, well ahead of need, so neither this frame's work nor the ticks have to
+	if ( m_state == LevelState::PLAYING && !m_isReplayPlayback )
+	{
+		m_replay.ReserveHeadroom( RECORDING_HEADROOM, RECORDING_HEADROOM );
+		if ( m_runLog.IsRecording() )
+		{
+			m_runLog.ReserveHeadroom( RECORDING_HEADROOM );
+		}
+	}
+
+	ScopedAllocationBan allocationBan( "Level::Update while playing", m_state == LevelState::PLAYING );
+
+	m_runningMainThreadWork.swap( m_mainThreadWork );
+	for ( std::function<void()>& work : m_runningMainThreadWork )
+	{
+		work();
+	}
+	m_runningMainThreadWork.clear();
+
+	for ( PendingJudgementProp const& pendingProp : m_pendingJudgementProps )
+	{
+		SpawnJudgementProp( pendingProp.m_position, pendingProp.m_judgement );
+	}
+	m_pendingJudgementProps.clear();
+
+	if ( m_state == LevelState::INACTIVE )
+		return;
+
+	// Reading the blackboard allocates, so while playing the delay only changes through the level itself.
+	// Replays keep the delay they were recorded with throughout.
+	if ( m_state != LevelState::PLAYING && !m_isReplayPlayback )
+	{
+		m_conductor->RefreshInputDelay();
+	}
+	if ( !m_isReplayPlayback && m_simulationThread == nullptr )
+	{
+		m_tapInput->PollInput();
+	}
+
+	Clock const* gameClock = GetGameClock();
+	m_tickTimeScale = gameClock->IsPaused() ? 0.0 : gameClock->GetTimeScale();
+	if ( m_simulationThread != nullptr )
+	{
+		m_tapInput->RefreshFocus();
+		m_simulationThread->SetTimeScale( m_tickTimeScale );
+		m_renderSnapshot = m_simulationThread->AcquireSnapshot();
+	}
+	else
+	{
+		long long frameMicroseconds = m_replayFrameMicroseconds;
+		if ( !m_isReplayPlayback )
+		{
+			frameMicroseconds = llround( GetGameClock()->GetDeltaSeconds() * 1'000'000.0 );
+		}
+
+		m_unsimulatedMicroseconds += frameMicroseconds;
+		long long tickCount = m_unsimulatedMicroseconds / SIMULATION_TICK_MICROSECONDS;
+		m_unsimulatedMicroseconds -= tickCount * SIMULATION_TICK_MICROSECONDS;
+
+		double frameTimeSeconds = GetCurrentTimeSeconds();
+		for ( long long tickIndex = 0; tickIndex < tickCount; tickIndex++ )
+		{
+			// A tick can finish the level, and an inactive level has no player to simulate. One can also
+			// start playing, which hands the remaining ticks to the simulation thread.
+			if ( m_state == LevelState::INACTIVE || m_simulationThread != nullptr )
+				break;
+
+			long long ticksUntilLast = tickCount - 1 - tickIndex;
+			UpdateTick( frameTimeSeconds - static_cast<double>( ticksUntilLast * SIMULATION_TICK_MICROSECONDS ) / 1'000'000.0 );
+		}
+
+		if ( m_player == nullptr )
+			return;
+
+		if ( m_simulationThread != nullptr )
+		{
+			m_renderSnapshot = m_simulationThread->AcquireSnapshot();
+		}
+		else
+		{
+			WriteSnapshot( m_renderSnapshot, static_cast<float>( m_unsimulatedMicroseconds ) / static_cast<float>( SIMULATION_TICK_MICROSECONDS ) );
+		}
+	}
+
+	m_camera->PoseAt( m_renderSnapshot.m_cameraPosition );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Kept out of Update(), since formatting the messages allocates every frame
+//
+void Level::UpdateDebugMessages()
+{
+	if ( m_state == LevelState::INACTIVE || m_player == nullptr || m_isReplayPlayback )
+		return;
+
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::HUD );
+	if ( m_renderSnapshot.m_beat != m_lastAnnouncedBeat )
+	{
+		m_lastAnnouncedBeat = m_renderSnapshot.m_beat;
+		DebugAddMessage( Stringf( "Beat #%i\n", m_lastAnnouncedBeat + 1 ), 0.8f, Rgba8::DARK_GRAY, Rgba8::CYAN );
+	}
+	DebugAddMessage( Stringf( "Conductor: %f", m_renderSnapshot.m_timeInBeats ), 0.f, Rgba8::PASTEL_RED, Rgba8::PASTEL_RED );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::UpdateTick( double tickTimeSeconds )
+{
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::LEVEL );
+	ScopedAllocationBan allocationBan( "Level::UpdateTick while playing", m_state == LevelState::PLAYING );
+	m_tickTimeSeconds = tickTimeSeconds;
+	if ( m_isReplayPlayback )
+	{
+		ApplyReplayInputDelayChanges();
+	}
+	else if ( m_simulationThread != nullptr )
+	{
+		m_tapInput->TakePolledTaps();
+	}
+
+	m_camera->Step( static_cast<float>( SIMULATION_TICK_MICROSECONDS ) / 1'000'000.f );
+	m_conductor->Update( SIMULATION_TICK_MICROSECONDS );
 	m_player->Update();
 
 	switch ( m_state )
@@ -174,21 +530,25 @@ void Level::Update()
 //----------------------------------------------------------------------------------------------------------
 void Level::Render() const
 {
-	g_theRenderer->BeginCamera( *m_camera );
+	g_theRenderBackend->BeginCamera( *m_camera );
 
+	g_theRenderBackend->SetDrawLayer( RenderLayer::WORLD );
 	m_path->Render();
 	m_path->DebugRender();
-	m_player->Render();
 
+	g_theRenderBackend->SetDrawLayer( RenderLayer::ACTORS );
+	m_player->Render( m_renderSnapshot.m_planets );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::EFFECTS );
 	for ( Prop* prop : m_judgementProps )
 	{
-		if ( prop == nullptr )
+		if ( prop->IsGarbage() )
 			continue;
 
 		prop->Render();
 	}
 
-	g_theRenderer->EndCamera( *m_camera );
+	g_theRenderBackend->EndCamera( *m_camera );
 	DebugRenderWorld( *m_camera );
 }
 
@@ -203,9 +563,30 @@ void Level::Shutdown()
 //----------------------------------------------------------------------------------------------------------
 void Level::GoToState( LevelState newState )
 {
+	// State changes load, save and play audio, so a tick on the simulation thread halts the simulation and
+	// leaves the change to the main thread, unless the main thread has already left playing by then
+	if ( m_simulationThread != nullptr && m_simulationThread->IsCurrentThread() )
+	{
+		m_isSimulationHalted = true;
+		RunOnMainThread( [this, newState]()
+		{
+			if ( m_state == LevelState::PLAYING )
+			{
+				GoToState( newState );
+			}
+		} );
+		return;
+	}
+
 	if ( newState == m_state )
 		return;
 
+	// Leaving play saves, loads and plays audio; only play itself has to stay off the heap
+	if ( m_state == LevelState::PLAYING )
+	{
+		LiftAllocationBan();
+	}
+
 	m_inputLockTimer->Start();
 	switch ( m_state )
 	{
@@ -241,6 +622,8 @@ void Level::ResetCheckpoints()
 //----------------------------------------------------------------------------------------------------------
 void Level::RenderHUD( AABB2 const& screenBounds ) const
 {
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::HUD );
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
 	switch ( m_state )
 	{
 		case LevelState::COUNTDOWN:	RenderHUD_Countdown( screenBounds );	break;
@@ -262,17 +645,41 @@ void Level::RenderInfo( AABB2 const& bounds ) const
 	std::string titleText = m_info.m_name;
 	float textHeight = titleBounds.GetDimensions().x * 0.0625f;
 
-	IndexedMesh textVerts;
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, m_info.m_name, titleBounds, textHeight, 
 		Rgba8::WHITE, .75f, Vec2( .5f, 0.f ) );
 
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetModelConstants();
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawIndexedMesh( textVerts );
+	AABB2 difficultyBounds = bounds;
+	difficultyBounds.ScaleHeight( .5f, 0.f );
+	ChartDifficulty const& chart = m_info.m_chart;
+	std::string difficultyText = Stringf( "Difficulty %.1f\n%.1f notes/s (peak %.1f)  irregularity %.2f  spins %.0f%%  speed changes %.0f%%",
+		m_info.m_difficulty, chart.m_notesPerSecond, chart.m_peakNotesPerSecond, chart.m_irregularity,
+		chart.m_spinsPerNote * 100.f, chart.m_speedChangesPerNote * 100.f );
+
+	if ( g_theScoreDatabase != nullptr )
+	{
+		LevelScoreSummary best = g_theScoreDatabase->GetSummary( m_filePath );
+		if ( best.m_clearCount > 0 )
+		{
+			char const* comboText = best.HasPurePerfect() ? "  Pure Perfect" : ( best.HasFullCombo() ? "  Full Combo" : "" );
+			difficultyText += Stringf( "\nBest %.1f%%%s  (%u of %u attempts cleared)", best.m_bestScore, comboText, best.m_clearCount, best.m_attemptCount );
+		}
+		else if ( best.m_attemptCount > 0 )
+		{
+			difficultyText += Stringf( "\nFurthest %.0f%%  (%u attempts)", best.m_bestPercentClear * 100.f, best.m_attemptCount );
+		}
+	}
+	g_defaultFont->AddVertsForTextInBox2D( textVerts, difficultyText, difficultyBounds, textHeight * .4f,
+		Rgba8::WHITE, .75f, Vec2( .5f, 1.f ) );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
 }
 
 
@@ -290,18 +697,66 @@ void Level::ReportTimingJudgement( Vec2 position, TimingJudgement judgement )
 	m_currentMetrics.m_judgementCounts[(int)judgement]++;
 	m_currentMetrics.m_totalJudgements++;
 
-	// Create timing judgement prop
+	// Props are drawn on the main thread, so a tick on the simulation thread leaves the spawn to it. A full
+	// queue drops the prop rather than grow.
+	if ( m_simulationThread != nullptr && m_simulationThread->IsCurrentThread() )
+	{
+		if ( m_pendingJudgementProps.size() < m_pendingJudgementProps.capacity() )
+		{
+			m_pendingJudgementProps.push_back( PendingJudgementProp{ position, judgement } );
+		}
+		return;
+	}
+
+	SpawnJudgementProp( position, judgement );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every judgement's text is tessellated and uploaded once, and the pooled props share those buffers
+//
+void Level::CreateJudgementProps()
+{
+	if ( !m_judgementProps.empty() )
+		return;
+
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PROP );
+	for ( int judgementIndex = 0; judgementIndex < (int)TimingJudgement::COUNT; judgementIndex++ )
+	{
+		IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
+		const char* judgementText = TimingJudgementToString( static_cast<TimingJudgement>( judgementIndex ) );
+		g_defaultFont->AddVertsForTextInBox2D( textVerts, judgementText, AABB2::ZEROS, .22f, 
+			Rgba8::WHITE, .5f, Vec2( .5f, .5f ), TextBoxMode::OVERRUN );
+		m_judgementTextIndexCounts[judgementIndex] = g_theRenderBackend->CreateNewBuffersFromIndexedMesh( textVerts,
+			&m_judgementTextVBOs[judgementIndex], &m_judgementTextIBOs[judgementIndex] );
+	}
+
+	m_judgementProps.reserve( JUDGEMENT_PROP_POOL_SIZE );
+	for ( int propIndex = 0; propIndex < JUDGEMENT_PROP_POOL_SIZE; propIndex++ )
+	{
+		m_judgementProps.push_back( new Prop() );
+	}
+	m_pendingJudgementProps.reserve( JUDGEMENT_PROP_POOL_SIZE );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SpawnJudgementProp( Vec2 const& position, TimingJudgement judgement )
+{
+	if ( m_judgementProps.empty() )
+		return;
+
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PROP );
 	Rgba8 judgementColor = TimingJudgementToColor( judgement );
 	Rgba8Gradient propGradient = Rgba8Gradient( judgementColor, judgementColor.GetTransparent( 0 ) );
-	Prop* newProp = new Prop( position, propGradient, 2.f );
 
-	IndexedMesh vertData;
-	const char* judgementText = TimingJudgementToString( judgement );
-	g_defaultFont->AddVertsForTextInBox2D( vertData, judgementText, AABB2::ZEROS, .22f, 
-		Rgba8::WHITE, .5f, Vec2( .5f, .5f ), TextBoxMode::OVERRUN );
+	Prop* prop = m_judgementProps[m_nextJudgementPropIndex];
+	m_nextJudgementPropIndex = ( m_nextJudgementPropIndex + 1 ) % JUDGEMENT_PROP_POOL_SIZE;
+	prop->Respawn( position, propGradient, 2.f );
 
-	newProp->SetRenderData( vertData, &g_defaultFont->GetTexture() );
-	AddProp( m_judgementProps, newProp );
+	int judgementIndex = (int)judgement;
+	prop->SetSharedRenderData( m_judgementTextVBOs[judgementIndex], m_judgementTextIBOs[judgementIndex],
+		m_judgementTextIndexCounts[judgementIndex], &g_defaultFont->GetTexture() );
 }
 
 
@@ -313,6 +768,122 @@ void Level::ReportCheckpoint( unsigned int checkpointNodeIndex )
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+void Level::StartReplayPlayback( Replay const& replay, double fixedDeltaSeconds )
+{
+	m_replay = replay;
+	m_replayTapIndex = 0;
+	m_isReplayPlayback = true;
+	m_checkpointNodeIndex = replay.m_checkpointNodeIndex;
+	m_replayFrameMicroseconds = llround( fixedDeltaSeconds * 1'000'000.0 );
+	m_conductor->SetSimulated( true );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every tap lands in the metrics histogram; accepted taps also feed the adaptive input delay. Each nudge
+// goes straight to the conductor and into the replay, so playback judges against the same delay. Nothing
+// here reads the blackboard: whether adaptation is on and the tracker's settings are read in
+// OnEnter_Playing(), and the blackboard is only written when play ends; see PersistInputDelay(). The run
+// log gets the tap's own time, not the later tick that judged it.
+//
+void Level::ReportTimingError( double timingErrorSeconds, TimingJudgement judgement, long long tapTimeInTicks )
+{
+	m_currentMetrics.m_timingErrors.AddSample( timingErrorSeconds );
+	m_runLog.RecordTap( TempoMap::TicksToBeats( tapTimeInTicks ), m_player->GetNodeIndex() + 1, timingErrorSeconds, judgement );
+
+	if ( !IsJudgementAcceptable( judgement ) )
+		return;
+
+	if ( !m_isAdaptiveInputDelay )
+		return;
+
+	double nudgeSeconds = 0.0;
+	if ( !m_inputOffsetTracker.AddSample( timingErrorSeconds, nudgeSeconds ) )
+		return;
+
+	double inputDelaySeconds = m_conductor->GetInputDelaySeconds() + nudgeSeconds;
+	m_conductor->SetInputDelaySeconds( inputDelaySeconds );
+	m_replay.RecordInputDelayChange( m_conductor->GetCurrentTimeInTicks(), inputDelaySeconds );
+	m_hasUnsavedInputDelay = true;
+	m_inputDelayNudgeCount++;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Level::PopReplayTap( long long currentTimeInTicks, long long& out_tapTimeInTicks )
+{
+	if ( !m_isReplayPlayback )
+		return false;
+
+	if ( m_replayTapIndex >= m_replay.m_tapTimesInTicks.size() )
+		return false;
+
+	long long nextTapTime = m_replay.m_tapTimesInTicks[m_replayTapIndex];
+	if ( nextTapTime > currentTimeInTicks )
+		return false;
+
+	out_tapTimeInTicks = nextTapTime;
+	m_replayTapIndex++;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::RecordTap( long long timeInTicks )
+{
+	if ( m_isReplayPlayback )
+		return;
+
+	m_replay.RecordTap( timeInTicks );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::RunOnMainThread( std::function<void()> work )
+{
+	if ( m_simulationThread != nullptr && m_simulationThread->IsCurrentThread() )
+	{
+		m_mainThreadWork.push_back( std::move( work ) );
+		return;
+	}
+
+	work();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::WriteSnapshot( LevelSnapshot& out_snapshot, float fraction ) const
+{
+	out_snapshot.m_cameraPosition = m_camera->GetPositionBetweenTicks( fraction );
+	out_snapshot.m_planets = m_player != nullptr ? m_player->GetPoseBetweenTicks( fraction ) : PlanetsPose();
+	out_snapshot.m_timeInBeats = m_conductor->GetCurrentTimeInBeats();
+	out_snapshot.m_beat = m_conductor->GetCurrentBeat();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::AnalyzeChart()
+{
+	m_info.m_chart = ::AnalyzeChart( *m_path, m_conductor->GetTempoMap() );
+	m_info.m_difficulty = m_info.m_chart.m_rating;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SetDifficultyOverlay( std::vector<NodeDifficulty> const& nodes )
+{
+	m_path->SetDifficultyOverlay( nodes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::ClearDifficultyOverlay()
+{
+	m_path->ClearDifficultyOverlay();
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 TapManager& Level::GetTapManager()
 {
@@ -334,15 +905,90 @@ bool Level::IsPlaying() const
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+bool Level::IsSimulationHalted() const
+{
+	return m_isSimulationHalted;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The simulation thread calls this without the shared mutex, so it must only reach the tap manager's
+// polling side. UpdateTick() takes what it polled.
+//
+void Level::PollLiveTaps( double timeSeconds )
+{
+	m_tapInput->PollKeyboard( timeSeconds );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double Level::GetTickTimeSeconds() const
+{
+	return m_tickTimeSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A tap is taken by the first tick due at or after it, which can be up to a tick later. Stepping back
+// from this tick by the tap's age, in song time, puts it where it actually happened.
+//
+long long Level::GetTapTimeInTicks( double tapTimeSeconds ) const
+{
+	double tapAgeSeconds = std::max( m_tickTimeSeconds - tapTimeSeconds, 0.0 ) * m_tickTimeScale;
+	long long tapTimeInMicroseconds = m_conductor->GetCurrentTimeInMicroseconds() - llround( tapAgeSeconds * 1'000'000.0 );
+	return m_conductor->GetTempoMap().MicrosecondsToTicks( tapTimeInMicroseconds );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+LevelState Level::GetState() const
+{
+	return m_state;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+LevelInfo const& Level::GetInfo() const
+{
+	return m_info;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string const& Level::GetFilePath() const
+{
+	return m_filePath;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string const& Level::GetPathFilePath() const
+{
+	return m_pathFilePath;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned long long Level::GetChartHash() const
+{
+	return m_chartHash;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void Level::OnEnter_Countdown()
 {
+	SaveRunLog( RunOutcome::ABANDONED );
+
 	if ( m_player != nullptr )
 	{
 		delete m_player;
 		m_player = nullptr;
 	}
 
+	ApplyPendingChart();
+
 	PlanetSettings customization;
 	customization.m_planetColors[0] = Rgba8::RED;
 	customization.m_planetColors[1] = Rgba8::BLUE;
@@ -353,6 +999,22 @@ void Level::OnEnter_Countdown()
 	m_startTimeBeats = startingNode ? startingNode->m_timeInBeats : 0.0;
 	m_conductor->Play( m_startTimeBeats );
 
+	if ( m_isReplayPlayback )
+	{
+		m_replayTapIndex = 0;
+		m_replayInputDelayIndex = 0;
+
+		// Straight to the conductor, so the player's own delay on the blackboard outlives the replay
+		m_conductor->SetInputDelaySeconds( m_replay.m_inputDelaySeconds );
+	}
+	else
+	{
+		double inputDelaySeconds = g_gameConfigBlackboard.GetValue( "inputDelaySeconds", 0.0 );
+		m_replay.Reset( m_filePath, m_chartHash, m_checkpointNodeIndex, inputDelaySeconds );
+	}
+
+	CreateJudgementProps();
+
 	m_camera->m_targetPosition = m_player->GetPosition();
 	m_camera->Reset();
 }
@@ -373,6 +1035,46 @@ void Level::OnEnter_Playing()
 
 	m_tapInput->PopAllTaps();
 	m_player->Enable();
+	m_player->LoadPlaySettings();
+
+	// Autoplay and nofail runs would skew scores and per-node death rates, so only real attempts count
+	bool autoplay = g_gameConfigBlackboard.GetValue( "autoplay", false );
+	bool nofail = g_gameConfigBlackboard.GetValue( "nofail", false );
+	m_isRecordedAttempt = !autoplay && !nofail && !m_isReplayPlayback;
+	if ( m_isRecordedAttempt && g_gameConfigBlackboard.GetValue( "runLogs", true ) )
+	{
+		m_runLog.Reset( m_filePath, m_chartHash, m_path->GetNodeCount(), m_checkpointNodeIndex );
+	}
+
+	// Everything play reads from the config is read now, and everything it appends to has room already
+	m_isAdaptiveInputDelay = !m_isReplayPlayback && !autoplay && g_gameConfigBlackboard.GetValue( "adaptiveInputDelay", false );
+	if ( m_isAdaptiveInputDelay )
+	{
+		m_inputOffsetTracker.LoadSettings( m_conductor->GetInputDelaySeconds() );
+	}
+	m_hasUnsavedInputDelay = false;
+	m_inputDelayNudgeCount = 0;
+	m_mainThreadWork.reserve( MAIN_THREAD_WORK_CAPACITY );
+	m_runningMainThreadWork.reserve( MAIN_THREAD_WORK_CAPACITY );
+	if ( !m_isReplayPlayback )
+	{
+		size_t nodeCount = static_cast<size_t>( m_path->GetNodeCount() );
+		m_replay.ReserveHeadroom( 2 * nodeCount + RECORDING_HEADROOM, nodeCount + RECORDING_HEADROOM );
+	}
+
+	// Live play ticks on its own thread, so a slow frame can't hold up judging a tap. Replays stay on the
+	// main thread, since they advance a fixed step per frame rather than with the wall clock.
+	if ( !m_isReplayPlayback && g_gameConfigBlackboard.GetValue( "simulationThread", true ) )
+	{
+		m_isSimulationHalted = false;
+		LevelSnapshot initialSnapshot;
+		WriteSnapshot( initialSnapshot, 1.f );
+
+		double tickSeconds = static_cast<double>( SIMULATION_TICK_MICROSECONDS ) / 1'000'000.0;
+		m_tapInput->BeginKeyboardPolling();
+		m_simulationThread = new SimulationThread( *this );
+		m_simulationThread->Start( initialSnapshot, m_tickTimeSeconds + tickSeconds );
+	}
 }
 
 
@@ -384,6 +1086,9 @@ void Level::OnEnter_Fail()
 	unsigned int totalNodes = m_path->GetNodeCount();
 	unsigned int lastSuccesfulNode = m_player->GetNodeIndex();
 	m_currentMetrics.m_percentClear = static_cast<float>( lastSuccesfulNode ) / ( static_cast<float>( totalNodes ) - 1.f );
+
+	SaveRunLog( RunOutcome::FAILED );
+	SubmitScore( false );
 }
 
 
@@ -392,6 +1097,9 @@ void Level::OnEnter_Win()
 {
 	m_currentMetrics.m_percentClear = 1.f;
 	ResetCheckpoints();
+
+	SaveRunLog( RunOutcome::WON );
+	SubmitScore( true );
 }
 
 
@@ -399,7 +1107,12 @@ void Level::OnEnter_Win()
 void Level::OnEnter_Inactive()
 {	
 	m_conductor->Stop();
+	m_conductor->SetSimulated( false );
+	m_isReplayPlayback = false;
+	m_replayFrameMicroseconds = 0;
+	m_unsimulatedMicroseconds = 0;
 
+	SaveRunLog( RunOutcome::ABANDONED );
 	delete m_player;
 	m_player = nullptr;
 }
@@ -414,8 +1127,28 @@ void Level::OnExit_Countdown()
 //----------------------------------------------------------------------------------------------------------
 void Level::OnExit_Playing()
 {
+	if ( m_simulationThread != nullptr )
+	{
+		delete m_simulationThread;
+		m_simulationThread = nullptr;
+		m_unsimulatedMicroseconds = 0;
+	}
+
 	m_player->Disable();
 	m_tapInput->PopAllTaps();
+	PersistInputDelay();
+
+	bool recordReplays = g_gameConfigBlackboard.GetValue( "recordReplays", true );
+	if ( recordReplays && !m_isReplayPlayback )
+	{
+		SaveReplay();
+	}
+
+	bool exportTimingHistogram = g_gameConfigBlackboard.GetValue( "exportTimingHistogram", true );
+	if ( exportTimingHistogram && !m_isReplayPlayback )
+	{
+		SaveTimingHistogram();
+	}
 }
 
 
@@ -442,7 +1175,15 @@ void Level::OnExit_Inactive()
 //----------------------------------------------------------------------------------------------------------
 void Level::Update_Countdown()
 {
-	m_camera->m_targetPosition = m_player->GetPosition();
+	if ( m_cameraTrack != nullptr )
+	{
+		m_camera->SnapTo( m_cameraTrack->GetPositionAtBeat( m_conductor->GetCurrentTimeInBeats() ) );
+	}
+	else
+	{
+		m_camera->m_targetPosition = m_player->GetPosition();
+	}
+
 	double timeUntilStartBeats = m_startTimeBeats - m_conductor->GetCurrentTimeInBeats();
 	if ( timeUntilStartBeats < 0.25 )
 	{
@@ -454,6 +1195,12 @@ void Level::Update_Countdown()
 //----------------------------------------------------------------------------------------------------------
 void Level::Update_Playing()
 {
+	if ( m_cameraTrack != nullptr )
+	{
+		m_camera->SnapTo( m_cameraTrack->GetPositionAtBeat( m_conductor->GetCurrentTimeInBeats() ) );
+		return;
+	}
+
 	m_camera->m_targetPosition = m_player->GetPositionAhead( 4 );
 }
 
@@ -497,7 +1244,7 @@ void Level::Update_Inactive()
 //----------------------------------------------------------------------------------------------------------
 void Level::RenderHUD_Countdown( AABB2 const& screenBounds ) const
 {
-	double timeUntilStartBeats = m_startTimeBeats - m_conductor->GetCurrentTimeInBeats();
+	double timeUntilStartBeats = m_startTimeBeats - m_renderSnapshot.m_timeInBeats;
 	int beatsUntilStart = CeilToInt( timeUntilStartBeats );
 	int countdownLabel = beatsUntilStart;
 	if ( countdownLabel > 0 && countdownLabel <= m_countdownLength )
@@ -506,17 +1253,17 @@ void Level::RenderHUD_Countdown( AABB2 const& screenBounds ) const
 		TaggedString countdownText = Stringf( "<rainbow;shadow>%i<!>", countdownLabel );
 		AABB2 countdownBounds = screenBounds;
 		countdownBounds.PadAllSides( -50.f );
-		IndexedMesh textVerts;
+		IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 		g_defaultFont->AddVertsForTextInBox2D( textVerts, countdownText, countdownBounds, 250.f, Rgba8::WHITE, .6f );
 
-		g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-		g_theRenderer->BindShader( nullptr );
-		g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-		g_theRenderer->SetDepthMode( DepthMode::DISABLED );
-		g_theRenderer->SetModelConstants();
-		g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-		g_theRenderer->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
-		g_theRenderer->DrawIndexedMesh( textVerts );
+		g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+		g_theRenderBackend->BindShader( nullptr );
+		g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+		g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+		g_theRenderBackend->SetModelConstants();
+		g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+		g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+		g_theRenderBackend->DrawIndexedMesh( textVerts );
 	}
 }
 
@@ -524,7 +1271,7 @@ void Level::RenderHUD_Countdown( AABB2 const& screenBounds ) const
 //----------------------------------------------------------------------------------------------------------
 void Level::RenderHUD_Playing( AABB2 const& screenBounds ) const
 {
-	double timeUntilStartBeats = m_startTimeBeats - m_conductor->GetCurrentTimeInBeats();
+	double timeUntilStartBeats = m_startTimeBeats - m_renderSnapshot.m_timeInBeats;
 	int beatsUntilStart = CeilToInt( timeUntilStartBeats );
 	int countdownLabel = beatsUntilStart;
 	if ( countdownLabel > 0 && countdownLabel <= m_countdownLength )
@@ -533,17 +1280,17 @@ void Level::RenderHUD_Playing( AABB2 const& screenBounds ) const
 		TaggedString countdownText = Stringf( "<rainbow;shadow>%i<!>", countdownLabel );
 		AABB2 countdownBounds = screenBounds;
 		countdownBounds.PadAllSides( -50.f );
-		IndexedMesh textVerts;
+		IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 		g_defaultFont->AddVertsForTextInBox2D( textVerts, countdownText, countdownBounds, 250.f, Rgba8::WHITE, .6f );
 
-		g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-		g_theRenderer->BindShader( nullptr );
-		g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-		g_theRenderer->SetDepthMode( DepthMode::DISABLED );
-		g_theRenderer->SetModelConstants();
-		g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-		g_theRenderer->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
-		g_theRenderer->DrawIndexedMesh( textVerts );
+		g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+		g_theRenderBackend->BindShader( nullptr );
+		g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+		g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+		g_theRenderBackend->SetModelConstants();
+		g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+		g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+		g_theRenderBackend->DrawIndexedMesh( textVerts );
 	}
 }
 
@@ -555,17 +1302,17 @@ void Level::RenderHUD_Fail( AABB2 const& screenBounds ) const
 	TaggedString failText = TaggedString( Stringf( "<shadow>%2.0f%% Complete<!shadow>", percentClear ) );
 	AABB2 countdownBounds = screenBounds;
 	countdownBounds.PadAllSides( -50.f );
-	IndexedMesh textVerts;
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, failText, countdownBounds, 250.f, Rgba8::DARK_RED, .6f );
 
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::DISABLED );
-	g_theRenderer->SetModelConstants();
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
-	g_theRenderer->DrawIndexedMesh( textVerts );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
 }
 
 
@@ -584,6 +1331,7 @@ void Level::RenderHUD_Win( AABB2 const& screenBounds ) const
 
 	TaggedString winMessageText = TaggedString( Stringf( "<shadow>%s<!shadow>", winMessageRaw ) );
 	std::string metricsTextRaw = m_currentMetrics.GetAsRawString();
+	metricsTextRaw += "\n\n" + m_currentMetrics.m_timingErrors.GetAsRawString();
 	TaggedString metricsText = TaggedString( Stringf( "<shadow>%s<!shadow>", metricsTextRaw.c_str() ) );
 	TaggedString scoreText = TaggedString( Stringf( "<shadow>Score: %3.1f%%<!shadow>", m_currentMetrics.GetScore() ) );
 	
@@ -591,20 +1339,82 @@ void Level::RenderHUD_Win( AABB2 const& screenBounds ) const
 	countdownBounds.PadAllSides( -50.f );
 	AABB2 metricsBounds = countdownBounds.ChopOffBottom( .66f );
 	AABB2 scoreBounds = metricsBounds.ChopOffTop( .4f );
+	AABB2 histogramBounds = metricsBounds.ChopOffBottom( .3f );
+	histogramBounds.ScaleWidth( .5f );
+	RenderTimingHistogram( histogramBounds );
 
-	IndexedMesh textVerts;
+	IndexedMesh& textVerts = g_theFrameArena->AllocateIndexedMesh();
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, winMessageText, countdownBounds, 200.f, Rgba8::PASTEL_GREEN, .6f, Vec2( .5f, 0.f ) );
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, scoreText, scoreBounds, 75.f, Rgba8::PASTEL_RED, .5f );
 	g_defaultFont->AddVertsForTextInBox2D( textVerts, metricsText, metricsBounds, 50.f, Rgba8::PASTEL_BLUE, .5f, Vec2( .5f, 1.f ) );
 
-	g_theRenderer->BindTexture( &g_defaultFont->GetTexture() );
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::DISABLED );
-	g_theRenderer->SetModelConstants();
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
-	g_theRenderer->DrawIndexedMesh( textVerts );
+	g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::BILINEAR_WRAP );
+	g_theRenderBackend->DrawIndexedMesh( textVerts );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Bars span the acceptable window in 5 ms steps, coloured by the judgement an error of that size gets.
+//
+void Level::RenderTimingHistogram( AABB2 const& bounds ) const
+{
+	constexpr int BAR_WIDTH_MS = 5;
+
+	TimingErrorHistogram const& histogram = m_currentMetrics.m_timingErrors;
+	if ( histogram.m_sampleCount == 0 )
+		return;
+
+	double acceptedThresholdSeconds = g_gameConfigBlackboard.GetValue( "acceptedThresholdSeconds", 0.13 );
+	int rangeMs = std::clamp( static_cast<int>( acceptedThresholdSeconds * 1000.0 + 0.5 ), BAR_WIDTH_MS, TIMING_HISTOGRAM_RANGE_MS );
+	int barCount = ( 2 * rangeMs ) / BAR_WIDTH_MS + 1;
+	int firstBarMinMs = -( barCount / 2 ) * BAR_WIDTH_MS - BAR_WIDTH_MS / 2;
+
+	unsigned int tallestBarCount = 1;
+	for ( int barIndex = 0; barIndex < barCount; barIndex++ )
+	{
+		int barMinMs = firstBarMinMs + barIndex * BAR_WIDTH_MS;
+		tallestBarCount = std::max( tallestBarCount, histogram.GetCountInRange( barMinMs, barMinMs + BAR_WIDTH_MS - 1 ) );
+	}
+
+	Vec2 dimensions = bounds.GetDimensions();
+	float barWidth = dimensions.x / static_cast<float>( barCount );
+
+	TimingWindows const timingWindows = TimingWindows::FromGameConfig();
+	Mesh& verts = g_theFrameArena->AllocateMesh();
+	for ( int barIndex = 0; barIndex < barCount; barIndex++ )
+	{
+		int barMinMs = firstBarMinMs + barIndex * BAR_WIDTH_MS;
+		unsigned int barCountValue = histogram.GetCountInRange( barMinMs, barMinMs + BAR_WIDTH_MS - 1 );
+		if ( barCountValue == 0 )
+			continue;
+
+		double barCenterSeconds = static_cast<double>( barMinMs + BAR_WIDTH_MS / 2 ) * 0.001;
+		Rgba8 barColor = TimingJudgementToColor( GetTimingJudgment( 0.0, barCenterSeconds, timingWindows ) );
+
+		float barHeight = dimensions.y * static_cast<float>( barCountValue ) / static_cast<float>( tallestBarCount );
+		Vec2 barMins = bounds.m_mins + Vec2( barWidth * static_cast<float>( barIndex ), 0.f );
+		AddVertsForAABB2D( verts, AABB2( barMins, barMins + Vec2( barWidth * .9f, barHeight ) ), barColor );
+	}
+
+	// Zero-error marker
+	float centerX = bounds.m_mins.x + dimensions.x * .5f;
+	AddVertsForAABB2D( verts, AABB2( Vec2( centerX - 1.f, bounds.m_mins.y ), Vec2( centerX + 1.f, bounds.m_maxs.y ) ), Rgba8::WHITE );
+
+	g_theRenderBackend->SetDrawLayer( RenderLayer::UI );
+	g_theRenderBackend->BindTexture( nullptr );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::DISABLED );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawVertexArray( verts );
 }
 
 
@@ -616,33 +1426,111 @@ void Level::RenderHUD_Inactive( AABB2 const& screenBounds ) const
 
 
 //----------------------------------------------------------------------------------------------------------
-void Level::AddProp( std::vector<Prop*>& propList, Prop* newProp )
+void Level::ApplyReplayInputDelayChanges()
 {
-	for ( Prop* prop : propList )
+	std::vector<ReplayInputDelayChange> const& changes = m_replay.m_inputDelayChanges;
+	while ( m_replayInputDelayIndex < changes.size() &&
+		changes[m_replayInputDelayIndex].m_timeInTicks <= m_conductor->GetCurrentTimeInTicks() )
 	{
-		if ( prop != nullptr )
-			continue;
+		double inputDelaySeconds = changes[m_replayInputDelayIndex].m_inputDelaySeconds;
+		m_conductor->SetInputDelaySeconds( inputDelaySeconds );
+		m_replayInputDelayIndex++;
+	}
+}
+
 
-		prop = newProp;
-		break;
+//----------------------------------------------------------------------------------------------------------
+// Nudges while playing only reach the conductor, since the blackboard allocates; this hands the attempt's
+// last delay to the config once play is over. Replays never write back, since their delays belong to the
+// recording and not to the player.
+//
+void Level::PersistInputDelay()
+{
+	if ( !m_hasUnsavedInputDelay || m_isReplayPlayback )
+		return;
+
+	double inputDelaySeconds = m_conductor->GetInputDelaySeconds();
+	g_gameConfigBlackboard.SetValue( "inputDelaySeconds", Stringf( "%.17g", inputDelaySeconds ) );
+	m_hasUnsavedInputDelay = false;
+
+	if ( m_inputDelayNudgeCount > 0 )
+	{
+		g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Input delay nudged %i times to %1.4f seconds (bias %+.1f ms, spread %.1f ms, %+.1f ms from calibration)",
+			m_inputDelayNudgeCount, inputDelaySeconds, m_inputOffsetTracker.GetBiasSeconds() * 1000.0,
+			m_inputOffsetTracker.GetSpreadSeconds() * 1000.0, m_inputOffsetTracker.GetTotalNudgeSeconds() * 1000.0 ) );
 	}
+}
 
-	propList.push_back(	newProp );
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SaveTimingHistogram() const
+{
+	std::string metricsFolder = g_gameConfigBlackboard.GetValue( "metricsFolder", "Saved/Metrics" );
+	std::error_code error;
+	std::filesystem::create_directories( metricsFolder, error );
+
+	std::string levelName = std::filesystem::path( m_filePath ).stem().string();
+	std::string histogramFilePath = Stringf( "%s/%s_timing.csv", metricsFolder.c_str(), levelName.c_str() );
+	if ( !m_currentMetrics.m_timingErrors.SaveToCSV( histogramFilePath ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save timing histogram to \"%s\"", histogramFilePath.c_str() ) );
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void Level::ClearGarbageProps( std::vector<Prop*>& propList )
+// Ends the attempt being logged, if any. Called from every way out of an attempt; after the first call
+// the log is no longer recording, so the later ones do nothing.
+//
+void Level::SaveRunLog( RunOutcome outcome )
 {
-	for ( Prop* prop : propList )
+	if ( !m_runLog.IsRecording() )
+		return;
+
+	unsigned int endNodeIndex = m_path->GetNodeCount() - 1;
+	if ( outcome != RunOutcome::WON && m_player != nullptr )
 	{
-		if ( prop == nullptr )
-			continue;
+		endNodeIndex = m_player->GetNodeIndex() + 1;
+	}
+	m_runLog.Finish( outcome, endNodeIndex );
 
-		if ( !prop->IsGarbage() )
-			continue;
+	std::string runLogFolder = g_gameConfigBlackboard.GetValue( "runLogFolder", "Saved/RunLogs" );
+	std::error_code error;
+	std::filesystem::create_directories( runLogFolder, error );
 
-		delete prop;
-		prop = nullptr;
+	// Millisecond wall clock time keeps every attempt in its own file, even quick restarts
+	long long timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+	std::string levelName = std::filesystem::path( m_filePath ).stem().string();
+	std::string runLogFilePath = Stringf( "%s/%s_%lld.runlog", runLogFolder.c_str(), levelName.c_str(), timestampMs );
+	if ( !m_runLog.SaveToFile( runLogFilePath ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save run log to \"%s\"", runLogFilePath.c_str() ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SubmitScore( bool isCleared )
+{
+	if ( !m_isRecordedAttempt || g_theScoreDatabase == nullptr )
+		return;
+
+	g_theScoreDatabase->SubmitAttempt( m_filePath, m_currentMetrics, isCleared );
+	m_isRecordedAttempt = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Level::SaveReplay() const
+{
+	std::string replayFolder = g_gameConfigBlackboard.GetValue( "replayFolder", "Saved/Replays" );
+	std::error_code error;
+	std::filesystem::create_directories( replayFolder, error );
+
+	std::string levelName = std::filesystem::path( m_filePath ).stem().string();
+	std::string replayFilePath = Stringf( "%s/%s.xml", replayFolder.c_str(), levelName.c_str() );
+	if ( !m_replay.SaveToFile( replayFilePath.c_str() ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to save replay to \"%s\"", replayFilePath.c_str() ) );
 	}
 }
@@ -1,21 +1,47 @@
 #pragma once
 #include "Game/LevelMetrics.hpp"
+#include "Game/Replay.hpp"
+#include "Game/RunLog.hpp"
+#include "Game/ChartAnalyzer.hpp"
+#include "Game/InputOffsetTracker.hpp"
+#include "Game/TempoMap.hpp"
+#include "Game/LevelSnapshot.hpp"
+#include <functional>
 #include <vector>
 
 
 //----------------------------------------------------------------------------------------------------------
+class CameraTrack;
 class Conductor;
 class PlayerPlanets;
 class Path;
 class Prop;
 class GameCamera;
+class SimulationThread;
 class TapManager;
 class Timer;
+class VertexBuffer;
+class IndexBuffer;
 struct PlanetSettings;
 struct AABB2;
 struct Vec2;
 
 
+//----------------------------------------------------------------------------------------------------------
+// Gameplay is simulated in fixed ticks of this many microseconds whatever the frame rate, and rendering
+// interpolates between the last two
+//
+constexpr long long SIMULATION_TICK_MICROSECONDS = 1000;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Judgement props are recycled oldest first, so a spawn while playing never allocates
+//
+constexpr int JUDGEMENT_PROP_POOL_SIZE = 32;
+constexpr size_t RECORDING_HEADROOM = 64;			// Replay and run log entries kept spare while playing
+constexpr size_t MAIN_THREAD_WORK_CAPACITY = 16;
+
+
 //----------------------------------------------------------------------------------------------------------
 enum class LevelState
 {
@@ -32,7 +58,62 @@ struct LevelInfo
 {
 	std::string m_name;
 	std::string m_source;
-	float m_difficulty = 0;
+	float m_difficulty = 0;				// The analyzed rating once AnalyzeChart() has run, else the authored one
+	float m_authoredDifficulty = 0;		// As typed in the level file
+	ChartDifficulty m_chart;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct PendingJudgementProp
+{
+	Vec2			m_position;
+	TimingJudgement	m_judgement = TimingJudgement::PERFECT;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// The config a chart is compiled with, captured up front so CompileChart() never reads the blackboard
+//
+struct ChartCompileSettings
+{
+	bool			m_usePathCache			= true;
+	std::string		m_pathCacheFolder;
+	bool			m_bakeCamera			= false;
+	int				m_cameraLookahead		= 4;
+	int				m_cameraSmoothingNodes	= 2;
+	bool			m_analyzeChart			= false;	// Startup analyzes the whole library at once instead
+
+public:
+	static ChartCompileSettings FromGameConfig();
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Everything a level loads from its two files, built without touching the GPU, the audio system or the
+// config, so hot reload can compile it on a worker thread. Level::AdoptChart() finishes it on the main one.
+//
+struct CompiledChart
+{
+	CompiledChart() = default;
+	CompiledChart( CompiledChart const& ) = delete;				// Owns its path and camera track
+	CompiledChart& operator=( CompiledChart const& ) = delete;
+	~CompiledChart();
+
+	void Reset();		// Back to how it was constructed, deleting what it owns
+
+	std::string			m_levelFilePath;
+	std::string			m_pathFilePath;
+	std::string			m_errorMessage;				// Why CompileChart() failed
+	std::string			m_warningMessage;			// Compiled, but something should still be reported
+	unsigned long long	m_chartHash			= 0;
+	LevelInfo			m_info;
+	TempoMap			m_tempoMap;
+	std::string			m_musicPlayEvent;
+	std::string			m_musicStopEvent;
+	int					m_countdownLength	= 4;
+	Path*				m_path				= nullptr;	// Vertex buffers not created yet
+	CameraTrack*		m_cameraTrack		= nullptr;
 };
 
 
@@ -46,9 +127,16 @@ public:
 	~Level();
 
 	void LoadFromXML( const char* xmlFilePath );
+	static bool CompileChart( std::string const& xmlFilePath, ChartCompileSettings const& settings, CompiledChart& out_chart );
+	void SetPendingChart( CompiledChart* chart );
+	bool HasPendingChart() const;
+	void ApplyPendingChart();
 
 	void Startup();
 	void Update();
+	void UpdateTick( double tickTimeSeconds );		// One simulation tick; see SimulationThread
+	void PollLiveTaps( double timeSeconds );		// Called by the simulation thread without the shared mutex
+	void UpdateDebugMessages();
 	void Render() const;
 	void Shutdown();
 
@@ -61,12 +149,34 @@ public:
 	void SetPlayerSettings( PlanetSettings const& settings );
 	void ReportTimingJudgement( Vec2 position, TimingJudgement judgement );
 	void ReportCheckpoint( unsigned int checkpointNodeIndex );
+	void ReportTimingError( double timingErrorSeconds, TimingJudgement judgement, long long tapTimeInTicks );
+
+	void StartReplayPlayback( Replay const& replay, double fixedDeltaSeconds );
+	bool PopReplayTap( long long currentTimeInTicks, long long& out_tapTimeInTicks );
+	void RecordTap( long long timeInTicks );
+
+	void RunOnMainThread( std::function<void()> work );	// Deferred to the next Update() when called from a tick on the simulation thread
+	void WriteSnapshot( LevelSnapshot& out_snapshot, float fraction ) const;
+
+	void AnalyzeChart();
+	void SetDifficultyOverlay( std::vector<NodeDifficulty> const& nodes );
+	void ClearDifficultyOverlay();
 
 	TapManager& GetTapManager();
 	Path const* GetPath() const;
 	bool IsPlaying() const;
+	bool IsSimulationHalted() const;
+	double GetTickTimeSeconds() const;
+	long long GetTapTimeInTicks( double tapTimeSeconds ) const;
+	LevelState GetState() const;
+	LevelInfo const& GetInfo() const;
+	std::string const& GetFilePath() const;
+	std::string const& GetPathFilePath() const;
+	unsigned long long GetChartHash() const;
 
 private:
+	void AdoptChart( CompiledChart& chart );
+
 	void OnEnter_Countdown();
 	void OnEnter_Playing();
 	void OnEnter_Fail();
@@ -90,27 +200,69 @@ private:
 	void RenderHUD_Fail( AABB2 const& screenBounds ) const;
 	void RenderHUD_Win( AABB2 const& screenBounds ) const;
 	void RenderHUD_Inactive( AABB2 const& screenBounds ) const;
+	void RenderTimingHistogram( AABB2 const& bounds ) const;
+
+	void CreateJudgementProps();
+	void SpawnJudgementProp( Vec2 const& position, TimingJudgement judgement );
+	void PersistInputDelay();
 
-	void AddProp( std::vector<Prop*>& propList, Prop* newProp );
-	void ClearGarbageProps( std::vector<Prop*>& propList );
+	void SaveReplay() const;
+	void SaveTimingHistogram() const;
+	void SaveRunLog( RunOutcome outcome );
+	void SubmitScore( bool isCleared );
+	void ApplyReplayInputDelayChanges();
 
 private:
 	GameCamera*		m_camera			= nullptr;
+	CameraTrack*	m_cameraTrack		= nullptr;	// Only baked when "bakedCamera" is enabled
 	Conductor*		m_conductor			= nullptr;
 	PlayerPlanets*	m_player			= nullptr;
 	Path*			m_path				= nullptr;
 	TapManager*		m_tapInput			= nullptr;
 	Timer*			m_inputLockTimer	= nullptr;
 
-	std::vector<Prop*> m_judgementProps;
+	std::vector<Prop*> m_judgementProps;		// A pool of JUDGEMENT_PROP_POOL_SIZE; see CreateJudgementProps()
+	int				m_nextJudgementPropIndex = 0;
+	VertexBuffer*	m_judgementTextVBOs[(int)TimingJudgement::COUNT] = {};	// Shared by every prop showing that judgement
+	IndexBuffer*	m_judgementTextIBOs[(int)TimingJudgement::COUNT] = {};
+	unsigned int	m_judgementTextIndexCounts[(int)TimingJudgement::COUNT] = {};
 
 	LevelMetrics	m_currentMetrics;
 	LevelMetrics	m_lastCheckpointMetrics;
+	InputOffsetTracker	m_inputOffsetTracker;	// Only fed when "adaptiveInputDelay" is on
+	bool			m_isAdaptiveInputDelay = false;	// Read when play starts; see OnEnter_Playing()
+	bool			m_hasUnsavedInputDelay = false;	// Changed while playing, not yet on the blackboard
+	int				m_inputDelayNudgeCount = 0;
+
+	Replay			m_replay;					// Recorded during normal play, read from during playback
+	unsigned int	m_replayTapIndex = 0;
+	unsigned int	m_replayInputDelayIndex = 0;
+	bool			m_isReplayPlayback = false;
+	long long		m_replayFrameMicroseconds = 0;	// How far each frame of replay playback advances the simulation
+	long long		m_unsimulatedMicroseconds = 0;	// Frame time not yet covered by a whole simulation tick
+
+	SimulationThread*	m_simulationThread = nullptr;	// Only while playing live; see OnEnter_Playing()
+	std::vector<std::function<void()>>	m_mainThreadWork;	// Queued by ticks on the simulation thread
+	std::vector<std::function<void()>>	m_runningMainThreadWork;	// Swapped with the queue, so neither gives up its capacity
+	std::vector<PendingJudgementProp>	m_pendingJudgementProps;	// Never grown past its capacity while playing
+	bool			m_isSimulationHalted = false;	// A tick on the simulation thread is waiting for a state change
+	double			m_tickTimeSeconds = 0.0;		// When the current tick is due, on the same clock taps are stamped with
+	double			m_tickTimeScale = 1.0;			// Song time per wall-clock second, as the game clock runs
+	LevelSnapshot	m_renderSnapshot;				// What Render() draws; written by Update()
+	int				m_lastAnnouncedBeat = 0;
+
+	bool			m_isRecordedAttempt = false;	// Not a replay, autoplay or nofail; see OnEnter_Playing()
+	RunLog			m_runLog;
 
 	LevelInfo		m_info;
+	std::string		m_filePath;
+	std::string		m_pathFilePath;
+	unsigned long long	m_chartHash = 0;		// XXH64 of the path XML seeded with the level XML; see LoadFromXML()
 	LevelState		m_state = LevelState::INACTIVE;
 	int				m_countdownLength = 4;
 	int				m_beatsUntilStart = -1;		// Used for countdown
 	double			m_startTimeBeats  = 0.0;	// Used for countdown
 	unsigned int	m_checkpointNodeIndex = 0;
+
+	CompiledChart*	m_pendingChart = nullptr;	// Hot reloaded, waiting for ApplyPendingChart()
 };
\ No newline at end of file
@@ -3,6 +3,119 @@
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+
+//----------------------------------------------------------------------------------------------------------
+void TimingErrorHistogram::AddSample( double timingErrorSeconds )
+{
+	double errorMs = timingErrorSeconds * 1000.0;
+
+	m_sampleCount++;
+	double deltaFromOldMean = errorMs - m_meanMs;
+	m_meanMs += deltaFromOldMean / static_cast<double>( m_sampleCount );
+	m_sumSquaredDeviationMs2 += deltaFromOldMean * ( errorMs - m_meanMs );
+
+	int bucketMs = static_cast<int>( floor( errorMs + 0.5 ) );
+	if ( bucketMs < -TIMING_HISTOGRAM_RANGE_MS )
+	{
+		m_underflowCount++;
+	}
+	else if ( bucketMs > TIMING_HISTOGRAM_RANGE_MS )
+	{
+		m_overflowCount++;
+	}
+	else
+	{
+		m_bucketCounts[bucketMs + TIMING_HISTOGRAM_RANGE_MS]++;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TimingErrorHistogram::GetStandardDeviationMs() const
+{
+	if ( m_sampleCount < 2 )
+		return 0.0;
+
+	return sqrt( m_sumSquaredDeviationMs2 / static_cast<double>( m_sampleCount - 1 ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Nearest rank, resolved to the 1 ms bucket. Out-of-range samples report as the edge of the range.
+//
+double TimingErrorHistogram::GetPercentileMs( double percentile ) const
+{
+	if ( m_sampleCount == 0 )
+		return 0.0;
+
+	double clampedPercentile = std::clamp( percentile, 0.0, 100.0 );
+	unsigned int rank = static_cast<unsigned int>( ceil( clampedPercentile * 0.01 * static_cast<double>( m_sampleCount ) ) );
+	rank = std::max( rank, 1u );
+
+	unsigned int cumulativeCount = m_underflowCount;
+	if ( cumulativeCount >= rank )
+		return static_cast<double>( -TIMING_HISTOGRAM_RANGE_MS );
+
+	for ( int bucketIndex = 0; bucketIndex < TIMING_HISTOGRAM_BUCKETS; bucketIndex++ )
+	{
+		cumulativeCount += m_bucketCounts[bucketIndex];
+		if ( cumulativeCount >= rank )
+			return static_cast<double>( bucketIndex - TIMING_HISTOGRAM_RANGE_MS );
+	}
+
+	return static_cast<double>( TIMING_HISTOGRAM_RANGE_MS );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int TimingErrorHistogram::GetCountInRange( int minMs, int maxMs ) const
+{
+	int firstBucket = std::max( minMs, -TIMING_HISTOGRAM_RANGE_MS ) + TIMING_HISTOGRAM_RANGE_MS;
+	int lastBucket = std::min( maxMs, TIMING_HISTOGRAM_RANGE_MS ) + TIMING_HISTOGRAM_RANGE_MS;
+
+	unsigned int count = 0;
+	for ( int bucketIndex = firstBucket; bucketIndex <= lastBucket; bucketIndex++ )
+	{
+		count += m_bucketCounts[bucketIndex];
+	}
+	return count;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string TimingErrorHistogram::GetAsRawString() const
+{
+	if ( m_sampleCount == 0 )
+		return "No taps";
+
+	return Stringf( "Mean: %+.1f ms | Std Dev: %.1f ms\nP10: %+.0f | Median: %+.0f | P90: %+.0f ms",
+		m_meanMs, GetStandardDeviationMs(), GetPercentileMs( 10.0 ), GetPercentileMs( 50.0 ), GetPercentileMs( 90.0 ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool TimingErrorHistogram::SaveToCSV( std::string const& filepath ) const
+{
+	std::ofstream file( filepath, std::ios::out | std::ios::trunc );
+	if ( !file.is_open() )
+		return false;
+
+	file << Stringf( "# taps=%u meanMs=%.3f stdDevMs=%.3f p1=%.0f p10=%.0f p50=%.0f p90=%.0f p99=%.0f\n",
+		m_sampleCount, m_meanMs, GetStandardDeviationMs(), GetPercentileMs( 1.0 ), GetPercentileMs( 10.0 ),
+		GetPercentileMs( 50.0 ), GetPercentileMs( 90.0 ), GetPercentileMs( 99.0 ) );
+	file << "errorMs,count\n";
+	file << Stringf( "<%i,%u\n", -TIMING_HISTOGRAM_RANGE_MS, m_underflowCount );
+	for ( int bucketIndex = 0; bucketIndex < TIMING_HISTOGRAM_BUCKETS; bucketIndex++ )
+	{
+		file << Stringf( "%i,%u\n", bucketIndex - TIMING_HISTOGRAM_RANGE_MS, m_bucketCounts[bucketIndex] );
+	}
+	file << Stringf( ">%i,%u\n", TIMING_HISTOGRAM_RANGE_MS, m_overflowCount );
+	return file.good();
+}
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -3,6 +3,35 @@
 #include <string>
 
 
+//----------------------------------------------------------------------------------------------------------
+constexpr int TIMING_HISTOGRAM_RANGE_MS	= 250;
+constexpr int TIMING_HISTOGRAM_BUCKETS	= 2 * TIMING_HISTOGRAM_RANGE_MS + 1;	// One per millisecond, centred on 0
+
+
+//----------------------------------------------------------------------------------------------------------
+// Signed tap error (positive is late) in 1 ms buckets, with the mean and variance kept by Welford's
+// method as samples arrive. Errors past the range land in the under/overflow counts but still count
+// toward the mean and variance. Fixed size, so metrics stay copyable and recording never allocates.
+//
+struct TimingErrorHistogram
+{
+	unsigned int	m_bucketCounts[TIMING_HISTOGRAM_BUCKETS] = {};
+	unsigned int	m_underflowCount	= 0;
+	unsigned int	m_overflowCount		= 0;
+	unsigned int	m_sampleCount		= 0;
+	double			m_meanMs			= 0.0;
+	double			m_sumSquaredDeviationMs2 = 0.0;
+
+public:
+	void			AddSample( double timingErrorSeconds );
+	double			GetStandardDeviationMs() const;
+	double			GetPercentileMs( double percentile ) const;
+	unsigned int	GetCountInRange( int minMs, int maxMs ) const;
+	std::string		GetAsRawString() const;
+	bool			SaveToCSV( std::string const& filepath ) const;
+};
+
+
 //----------------------------------------------------------------------------------------------------------
 struct LevelMetrics
 {
@@ -11,6 +40,7 @@ struct LevelMetrics
 	unsigned int	m_checkpointsUsed = 0;
 	float			m_percentClear = 0.f;
 	float			m_score;
+	TimingErrorHistogram m_timingErrors;
 
 public:
 	float			GetScore() const;
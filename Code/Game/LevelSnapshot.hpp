@@ -0,0 +1,24 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+
+
+#define MAX_PLANETS 2	// In case I want to add three or four planet modes later
+//----------------------------------------------------------------------------------------------------------
+struct PlanetsPose
+{
+	Vec2	m_positions[MAX_PLANETS];
+	bool	m_isVisible = false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Everything drawing a level needs from its simulation, copied out after a tick so the renderer never
+// reads state the simulation may be changing
+//
+struct LevelSnapshot
+{
+	Vec2		m_cameraPosition = Vec2::ZERO;
+	PlanetsPose	m_planets;
+	double		m_timeInBeats	= 0.0;
+	int			m_beat			= 0;
+};
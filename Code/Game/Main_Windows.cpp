@@ -10,14 +10,14 @@
 int WINAPI WinMain( HINSTANCE applicationInstanceHandle, HINSTANCE, LPSTR commandLineString, int )
 {
 	UNUSED( applicationInstanceHandle );
-	UNUSED( commandLineString );
 
 	g_theApp = new App();
-	g_theApp->Startup();
+	g_theApp->Startup( commandLineString );
 	g_theApp->RunMainLoop();
 	g_theApp->Shutdown();
+	int exitCode = g_theApp->GetExitCode();
 	delete g_theApp;
 	g_theApp = nullptr;
 
-	return 0;
+	return exitCode;
 }
@@ -1,8 +1,14 @@
 #include "Game/Menu.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/AllocationTracker.hpp"
+#include "Game/RenderBackend.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/Texture.hpp"
+#include "Engine/Renderer/BitmapFont.hpp"
+#include "Engine/Renderer/VertexBuffer.hpp"
+#include "Engine/Renderer/IndexBuffer.hpp"
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -25,9 +31,17 @@ Menu::Menu( std::string const& name, std::string const& backgroundImageFilepath
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+Menu::~Menu()
+{
+	DestroyBuffers();
+}
+
+
 //----------------------------------------------------------------------------------------------------------	
 void Menu::Update()
 {
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::MENU );
 	if ( m_buttons.size() == 0 )
 		return;
 
@@ -79,26 +93,98 @@ void Menu::Update()
 
 
 //----------------------------------------------------------------------------------------------------------
-void Menu::Render( AABB2 const& screenBounds ) const
+// Nothing is tessellated here: a button changing state only re-copies its cached quad into the batch, and
+// labels are only re-gathered when one of them was retyped
+//
+void Menu::UploadVertexBuffers( AABB2 const& screenBounds )
 {
-	if ( m_backgroundTexture != nullptr )
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::MENU );
+	if ( m_backgroundVBO == nullptr || screenBounds.m_mins != m_uploadedScreenBounds.m_mins || screenBounds.m_maxs != m_uploadedScreenBounds.m_maxs )
 	{
-		AABB2 backgroundBounds = screenBounds;
-		backgroundBounds.GrowToAspect( m_backgroundTexture->GetAspect() );
+		UploadBackground( screenBounds );
+	}
 
-		IndexedMesh backgroundVerts;
-		AddVertsForAABB2D( backgroundVerts, backgroundBounds, Rgba8::WHITE, AABB2::ZERO_TO_ONE, 1.f );
+	bool buttonCountChanged = m_uploadedButtonStates.size() != m_buttons.size();
+	if ( buttonCountChanged )
+	{
+		m_uploadedButtonStates.assign( m_buttons.size(), UploadedButtonState() );
+	}
 
-		g_theRenderer->BindTexture( m_backgroundTexture );
-		g_theRenderer->SetBlendMode( BlendMode::OPAQUE );
-		g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-		g_theRenderer->DrawIndexedMesh( backgroundVerts );
+	bool quadsChanged = buttonCountChanged;
+	bool labelsChanged = buttonCountChanged;
+	for ( size_t buttonIndex = 0; buttonIndex < m_buttons.size(); buttonIndex++ )
+	{
+		Button const& button = m_buttons[buttonIndex];
+		UploadedButtonState& uploadedState = m_uploadedButtonStates[buttonIndex];
+		if ( button.GetVisualState() != uploadedState.m_visualState )
+		{
+			uploadedState.m_visualState = button.GetVisualState();
+			quadsChanged = true;
+		}
+		if ( button.GetLabelRevision() != uploadedState.m_labelRevision )
+		{
+			uploadedState.m_labelRevision = button.GetLabelRevision();
+			labelsChanged = true;
+		}
+	}
+
+	if ( quadsChanged )
+	{
+		UploadQuads();
+	}
+	if ( labelsChanged )
+	{
+		UploadLabels();
 	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Menu::Render() const
+{
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::MENU );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
 
+	if ( m_backgroundVBO != nullptr )
+	{
+		g_theRenderBackend->SetDrawLayer( RenderLayer::BACKGROUND );
+		g_theRenderBackend->BindTexture( m_backgroundTexture );
+		g_theRenderBackend->SetBlendMode( BlendMode::OPAQUE );
+		g_theRenderBackend->DrawIndexedVertexBuffer( m_backgroundVBO, m_backgroundIBO, m_backgroundIndexCount );
+	}
+
+	if ( m_quadVBO != nullptr && !m_quadVerts.empty() )
+	{
+		g_theRenderBackend->SetDrawLayer( RenderLayer::UI );
+		g_theRenderBackend->BindTexture( nullptr );
+		g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+		g_theRenderBackend->DrawVertexBuffer( m_quadVBO, static_cast<int>( m_quadVerts.size() ) );
+	}
+
+	if ( m_labelVBO != nullptr && m_labelIndexCount > 0 )
+	{
+		g_theRenderBackend->SetDrawLayer( RenderLayer::TEXT );
+		g_theRenderBackend->BindTexture( &g_defaultFont->GetTexture() );
+		g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+		g_theRenderBackend->DrawIndexedVertexBuffer( m_labelVBO, m_labelIBO, m_labelIndexCount );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Menu::IsAnimating() const
+{
 	for ( Button const& button : m_buttons )
 	{
-		button.Render();
+		if ( button.IsPressed() )
+			return true;
 	}
+
+	return false;
 }
 
 
@@ -112,3 +198,104 @@ void Menu::Reset()
 
 
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+void Menu::UploadBackground( AABB2 const& screenBounds )
+{
+	m_uploadedScreenBounds = screenBounds;
+	if ( m_backgroundTexture == nullptr )
+		return;
+
+	AABB2 backgroundBounds = screenBounds;
+	backgroundBounds.GrowToAspect( m_backgroundTexture->GetAspect() );
+
+	IndexedMesh& backgroundVerts = g_theFrameArena->AllocateIndexedMesh();
+	AddVertsForAABB2D( backgroundVerts, backgroundBounds, Rgba8::WHITE, AABB2::ZERO_TO_ONE, 1.f );
+
+	if ( m_backgroundVBO != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( m_backgroundVBO );
+		g_theRenderBackend->DestroyIndexBuffer( m_backgroundIBO );
+	}
+	m_backgroundIndexCount = g_theRenderBackend->CreateNewBuffersFromIndexedMesh( backgroundVerts, &m_backgroundVBO, &m_backgroundIBO );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The buffer is reused while the batch still fits and regrown with some slack otherwise, as Path does
+//
+void Menu::UploadQuads()
+{
+	m_quadVerts.clear();
+	for ( Button const& button : m_buttons )
+	{
+		button.AddQuadVerts( m_quadVerts );
+	}
+	if ( m_quadVerts.empty() )
+		return;
+
+	size_t byteSize = m_quadVerts.size() * sizeof( Vertex_PCU );
+	if ( m_quadVBO == nullptr || byteSize > m_quadVBOByteSize )
+	{
+		if ( m_quadVBO != nullptr )
+		{
+			g_theRenderBackend->DestroyVertexBuffer( m_quadVBO );
+		}
+		m_quadVBOByteSize = byteSize + byteSize / 4;
+		m_quadVBO = g_theRenderBackend->CreateVertexBuffer( m_quadVBOByteSize );
+	}
+
+	g_theRenderBackend->CopyCPUToGPU( m_quadVerts.data(), byteSize, m_quadVBO );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Menu::UploadLabels()
+{
+	IndexedMesh& labelVerts = g_theFrameArena->AllocateIndexedMesh();
+	for ( Button const& button : m_buttons )
+	{
+		button.AddLabelVerts( labelVerts );
+	}
+
+	if ( m_labelVBO != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( m_labelVBO );
+		g_theRenderBackend->DestroyIndexBuffer( m_labelIBO );
+		m_labelVBO = nullptr;
+		m_labelIBO = nullptr;
+		m_labelIndexCount = 0;
+	}
+	if ( labelVerts.m_indexes.empty() )
+		return;
+
+	m_labelIndexCount = g_theRenderBackend->CreateNewBuffersFromIndexedMesh( labelVerts, &m_labelVBO, &m_labelIBO );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Menu::DestroyBuffers()
+{
+	if ( m_backgroundVBO != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( m_backgroundVBO );
+		g_theRenderBackend->DestroyIndexBuffer( m_backgroundIBO );
+		m_backgroundVBO = nullptr;
+		m_backgroundIBO = nullptr;
+	}
+
+	if ( m_quadVBO != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( m_quadVBO );
+		m_quadVBO = nullptr;
+	}
+
+	if ( m_labelVBO != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( m_labelVBO );
+		g_theRenderBackend->DestroyIndexBuffer( m_labelIBO );
+		m_labelVBO = nullptr;
+		m_labelIBO = nullptr;
+	}
+}
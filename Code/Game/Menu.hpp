@@ -5,20 +5,42 @@
 
 //----------------------------------------------------------------------------------------------------------
 class Texture;
+class VertexBuffer;
+class IndexBuffer;
 
 
 //----------------------------------------------------------------------------------------------------------
+struct UploadedButtonState
+{
+	ButtonVisualState m_visualState = ButtonVisualState::COUNT;
+	unsigned int m_labelRevision = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Retained: the background, every button quad and every label each live in one GPU buffer, refilled by
+// UploadVertexBuffers() only when the screen, a button's state or a label changed since the last upload
+//
 class Menu
 {
 public:
 	Menu( std::string const& name, Texture* background = nullptr );
 	Menu( std::string const& name, std::string const& backgroundImageFilepath );
+	~Menu();
 
 	void Update();
-	void Render( AABB2 const& screenBounds ) const;
+	void UploadVertexBuffers( AABB2 const& screenBounds );	// Main thread, after Update() and before Render()
+	void Render() const;
+	bool IsAnimating() const;		// A button is showing its press
 
 	void Reset();
 
+private:
+	void UploadBackground( AABB2 const& screenBounds );
+	void UploadQuads();
+	void UploadLabels();
+	void DestroyBuffers();
+
 public:
 	std::vector<Button> m_buttons;
 
@@ -26,4 +48,18 @@ private:
 	Texture* m_backgroundTexture = nullptr;
 	Button* m_selectedButton = nullptr;
 	std::string m_name;
+
+	AABB2 m_uploadedScreenBounds;
+	VertexBuffer* m_backgroundVBO = nullptr;
+	IndexBuffer* m_backgroundIBO = nullptr;
+	unsigned int m_backgroundIndexCount = 0;
+
+	std::vector<UploadedButtonState> m_uploadedButtonStates;
+	Mesh m_quadVerts;
+	VertexBuffer* m_quadVBO = nullptr;
+	size_t m_quadVBOByteSize = 0;
+
+	VertexBuffer* m_labelVBO = nullptr;
+	IndexBuffer* m_labelIBO = nullptr;
+	unsigned int m_labelIndexCount = 0;
 };
\ No newline at end of file
@@ -1,22 +1,212 @@
 #include "Game/Path.hpp"
 #include "Game/GameCommon.hpp"
-#include "Game/Conductor.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/AllocationTracker.hpp"
+#include "Game/RenderBackend.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Renderer/VertexBuffer.hpp"
+#include "Engine/Renderer/IndexBuffer.hpp"
 #include "Engine/Renderer/DebugRender.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/FileUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
 
 //----------------------------------------------------------------------------------------------------------
-void PathNode::InitializeVerts( Vec2 const& inNormal, Vec2 const& outNormal, float width, float borderThickness, 
-	bool spin, int speedChange, Rgba8 const& baseColor, Rgba8 const& borderColor )
+// Small enough that rebuilding one is well under a millisecond, big enough that re-basing every chunk
+// after an edit near the start of a 50k node chart is only a couple hundred transforms
+constexpr int PATH_CHUNK_NODE_COUNT = 256;
+
+// Bump whenever compiling would produce different output for the same XML, or every cached path keeps
+// serving the old result
+constexpr unsigned int COMPILED_PATH_VERSION = 4;
+constexpr unsigned int COMPILED_PATH_MAX_NAME_LENGTH = 256;
+
+// 16-bit indexes; a chunk of nothing but 360 degree nodes is still well under this
+constexpr size_t MAX_PATH_CHUNK_VERTEXES = 65536;
+constexpr unsigned short MAX_QUANTIZED_COORDINATE = 65535;
+
+
+//----------------------------------------------------------------------------------------------------------
+static Rgba8 const PATH_PALETTE[(int)PathColor::COUNT] =
+{
+	Rgba8::BLACK,				// BORDER
+	Rgba8::WHITE,				// BASE
+	Rgba8( 0, 0, 0, 200 ),		// DOT
+	Rgba8( 255, 127, 0 ),		// FAST_DOT: orange
+	Rgba8( 0, 127, 255 ),		// SLOW_DOT: dark cyan
+	Rgba8( 0, 255, 75, 255 ),	// SPIN_DOT
+	Rgba8::PASTEL_CYAN,			// CHECKPOINT_DOT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// One chunk's geometry at full precision while it is built. It is quantized into the chunk once every
+// node is in, since the quantization step depends on the bounds of all of them.
+//
+struct PathMeshBuilder
+{
+	std::vector<Vec2>			m_positions;
+	std::vector<PathColor>		m_colors;
+	std::vector<unsigned short>	m_indexes;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// On-disk layout of a compiled path: this header, the name, then m_nodeCount node defs, m_nodeCount
+// nodes, m_chunkCount chunks, every chunk's vertexes back to back, and finally every chunk's indexes
+//
+struct CompiledPathHeader
+{
+	char				m_magic[4]			= { 'O', 'P', 'T', 'H' };
+	unsigned int		m_version			= COMPILED_PATH_VERSION;
+	unsigned long long	m_chartHash			= 0;	// Level::GetChartHash() of the chart this was compiled from
+	unsigned int		m_nodeCount			= 0;
+	unsigned int		m_chunkCount		= 0;
+	unsigned int		m_vertCount			= 0;
+	unsigned int		m_indexCount		= 0;
+	unsigned int		m_nameLength		= 0;
+	float				m_pathWidth			= 0.f;
+	float				m_scale				= 0.f;
+	unsigned int		m_padding			= 0;
+	long long			m_totalTimeInTicks	= 0;
+};
+static_assert( sizeof( CompiledPathHeader ) == 56, "CompiledPathHeader is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CompiledPathNodeDef
+{
+	float				m_beats				= 0.f;
+	float				m_speed				= 0.f;
+	unsigned char		m_spin				= 0;
+	unsigned char		m_checkpoint		= 0;
+	unsigned char		m_padding[2]		= {};
+};
+static_assert( sizeof( CompiledPathNodeDef ) == 12, "CompiledPathNodeDef is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CompiledPathNode
+{
+	float				m_positionX			= 0.f;
+	float				m_positionY			= 0.f;
+	float				m_localPositionX	= 0.f;
+	float				m_localPositionY	= 0.f;
+	long long			m_timeInTicks		= 0;
+	int					m_durationInTicks	= 0;
+	float				m_speed				= 0.f;
+	float				m_angle				= 0.f;
+	float				m_localAngle		= 0.f;
+	float				m_radius			= 0.f;
+	unsigned int		m_firstIndex		= 0;
+	unsigned int		m_indexCount		= 0;
+	unsigned char		m_clockwise			= 0;
+	unsigned char		m_checkpoint		= 0;
+	unsigned char		m_padding[2]		= {};
+};
+static_assert( sizeof( CompiledPathNode ) == 56, "CompiledPathNode is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+struct CompiledPathChunk
+{
+	unsigned int		m_firstNodeIndex	= 0;
+	unsigned int		m_nodeCount			= 0;
+	unsigned int		m_vertCount			= 0;
+	unsigned int		m_indexCount		= 0;
+	float				m_originX			= 0.f;
+	float				m_originY			= 0.f;
+	float				m_rotationDegrees	= 0.f;
+	float				m_entrySpeed		= 0.f;
+	float				m_quantizedMinX		= 0.f;
+	float				m_quantizedMinY		= 0.f;
+	float				m_quantizedStep		= 0.f;
+	unsigned char		m_entryClockwise	= 0;
+	unsigned char		m_padding[3]		= {};
+};
+static_assert( sizeof( CompiledPathChunk ) == 48, "CompiledPathChunk is part of the file format" );
+static_assert( sizeof( PathVertex ) == 6, "PathVertex is written to compiled paths as-is" );
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned short AddPathVertex( PathMeshBuilder& builder, Vec2 const& position, PathColor color )
+{
+	builder.m_positions.push_back( position );
+	builder.m_colors.push_back( color );
+	return static_cast<unsigned short>( builder.m_positions.size() - 1 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Corners counterclockwise, split along bottomLeft to topRight like AddVertsForQuad2D()
+//
+static void AddPathQuad( PathMeshBuilder& builder, Vec2 const& bottomLeft, Vec2 const& bottomRight, Vec2 const& topRight,
+	Vec2 const& topLeft, PathColor color )
+{
+	unsigned short bottomLeftIndex = AddPathVertex( builder, bottomLeft, color );
+	unsigned short bottomRightIndex = AddPathVertex( builder, bottomRight, color );
+	unsigned short topRightIndex = AddPathVertex( builder, topRight, color );
+	unsigned short topLeftIndex = AddPathVertex( builder, topLeft, color );
+	builder.m_indexes.insert( builder.m_indexes.end(), { bottomLeftIndex, bottomRightIndex, topRightIndex,
+		bottomLeftIndex, topRightIndex, topLeftIndex } );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Two quads sharing the edge from middleLeft to middleRight, as a node's two halves do
+//
+static void AddPathQuadPair( PathMeshBuilder& builder, Vec2 const& inLeft, Vec2 const& inRight, Vec2 const& middleRight,
+	Vec2 const& middleLeft, Vec2 const& outRight, Vec2 const& outLeft, PathColor color )
 {
-	Mesh mesh;
+	unsigned short inLeftIndex = AddPathVertex( builder, inLeft, color );
+	unsigned short inRightIndex = AddPathVertex( builder, inRight, color );
+	unsigned short middleRightIndex = AddPathVertex( builder, middleRight, color );
+	unsigned short middleLeftIndex = AddPathVertex( builder, middleLeft, color );
+	unsigned short outRightIndex = AddPathVertex( builder, outRight, color );
+	unsigned short outLeftIndex = AddPathVertex( builder, outLeft, color );
+	builder.m_indexes.insert( builder.m_indexes.end(), { inLeftIndex, inRightIndex, middleRightIndex,
+		inLeftIndex, middleRightIndex, middleLeftIndex, middleLeftIndex, middleRightIndex, outRightIndex,
+		middleLeftIndex, outRightIndex, outLeftIndex } );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A fan around one shared center vertex, with the same slices as AddVertsForDisc2D()
+//
+static void AddPathDisc( PathMeshBuilder& builder, Vec2 const& center, float radius, PathColor color, int sliceCount = 32 )
+{
+	unsigned short centerIndex = AddPathVertex( builder, center, color );
+	unsigned short firstRimIndex = static_cast<unsigned short>( centerIndex + 1 );
+	float degreesPerSlice = 360.f / static_cast<float>( sliceCount );
+	for ( int sliceIndex = 0; sliceIndex < sliceCount; sliceIndex++ )
+	{
+		AddPathVertex( builder, center + Vec2::MakeFromPolarDegrees( degreesPerSlice * static_cast<float>( sliceIndex ), radius ), color );
+	}
+
+	for ( int sliceIndex = 0; sliceIndex < sliceCount; sliceIndex++ )
+	{
+		unsigned short rimIndex = static_cast<unsigned short>( firstRimIndex + sliceIndex );
+		unsigned short nextRimIndex = static_cast<unsigned short>( firstRimIndex + ( sliceIndex + 1 ) % sliceCount );
+		builder.m_indexes.insert( builder.m_indexes.end(), { centerIndex, rimIndex, nextRimIndex } );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void PathNode::AddVerts( PathMeshBuilder& builder, Vec2 const& inNormal, Vec2 const& outNormal, float width, float borderThickness, 
+	bool spin, int speedChange )
+{
+	m_firstIndex = static_cast<int>( builder.m_indexes.size() );
 	float halfWidth = .5f * width;
 	bool is360 = ( inNormal + outNormal ).GetLengthSquared() < 0.001f;
 
-	Vec2 const& nodeCenter = m_position;
+	Vec2 const& nodeCenter = m_localPosition;
 	Vec2 inTangent = inNormal.GetRotated90Degrees();	// Tangent to the inward edge, orthogonal to inNormal
 	Vec2 outTangent = outNormal.GetRotated90Degrees();	// Tangent to the outward edge, othrogonal to outNormal
 	Vec2 halfTangent = ( inTangent + outTangent ).GetNormalized();
@@ -57,65 +247,48 @@ void PathNode::InitializeVerts( Vec2 const& inNormal, Vec2 const& outNormal, flo
 
 	if ( is360 )
 	{
-		Vec2 centerLeft = m_position + ( halfWidth * inTangent );
-		Vec2 centerRight = m_position - ( halfWidth * inTangent );
+		Vec2 centerLeft = m_localPosition + ( halfWidth * inTangent );
+		Vec2 centerRight = m_localPosition - ( halfWidth * inTangent );
 		Vec2 innerCenterLeft = centerLeft - ( borderThickness * inTangent );
 		Vec2 innerCenterRight = centerRight + ( borderThickness * inTangent );
 
-		AddVertsForDisc2D( mesh, m_position, halfWidth, borderColor );
-		AddVertsForQuad2D( mesh, inLeft, inRight, centerRight, centerLeft, borderColor );
-		AddVertsForDisc2D( mesh, m_position, halfWidth - borderThickness, baseColor );
-		AddVertsForQuad2D( mesh, innerInLeft, innerInRight, innerCenterRight, innerCenterLeft, baseColor );
+		AddPathDisc( builder, m_localPosition, halfWidth, PathColor::BORDER );
+		AddPathQuad( builder, inLeft, inRight, centerRight, centerLeft, PathColor::BORDER );
+		AddPathDisc( builder, m_localPosition, halfWidth - borderThickness, PathColor::BASE );
+		AddPathQuad( builder, innerInLeft, innerInRight, innerCenterRight, innerCenterLeft, PathColor::BASE );
 	}
 	else
 	{
-		AddVertsForQuad2D( mesh, inLeft, inRight, cornerRight, cornerLeft, borderColor );
-		AddVertsForQuad2D( mesh, cornerLeft, cornerRight, outRight, outLeft, borderColor );
-		AddVertsForQuad2D( mesh, innerInLeft, innerInRight, innerCornerRight, innerCornerLeft, baseColor );
-		AddVertsForQuad2D( mesh, innerCornerLeft, innerCornerRight, innerOutRight, innerOutLeft, baseColor );
+		AddPathQuadPair( builder, inLeft, inRight, cornerRight, cornerLeft, outRight, outLeft, PathColor::BORDER );
+		AddPathQuadPair( builder, innerInLeft, innerInRight, innerCornerRight, innerCornerLeft, innerOutRight, innerOutLeft, PathColor::BASE );
 	}
 
-	// DEBUG RENDER STUFF:
-// 	AddVertsForLineSegment2D( mesh, inLeft, inRight, .125f * width, Rgba8( 0, 255, 0, 127 ) );
-// 	AddVertsForLineSegment2D( mesh, outLeft, outRight, .125f * width, Rgba8( 255, 0, 0, 127 ) );
-	Rgba8 dotColor	= Rgba8( 0, 0, 0, 200 );
-	float dotRadius	= .1f * width;
+	PathColor dotColor	= PathColor::DOT;
+	float dotRadius		= .1f * width;
 	if ( speedChange > 0 )		// Fast
 	{
-		dotColor = Rgba8( 255, 127, 0 );	// Orange
+		dotColor = PathColor::FAST_DOT;
 		dotRadius = .25f * width;
 	}
 	else if ( speedChange < 0 )	// Slow
 	{
-		dotColor = Rgba8( 0, 127, 255 );	// Dark cyan
+		dotColor = PathColor::SLOW_DOT;
 		dotRadius = .25f * width;
 	}
 	else if ( spin )
 	{
-		dotColor = Rgba8( 0, 255, 75, 255 );
+		dotColor = PathColor::SPIN_DOT;
 		dotRadius = .25f * width;
 	}
 	else if ( m_checkpoint )
 	{
-		dotColor = Rgba8::PASTEL_CYAN;
+		dotColor = PathColor::CHECKPOINT_DOT;
 		dotRadius = .3f * width;
 	}
 
- 	AddVertsForDisc2D( mesh, m_position, dotRadius, dotColor, 16 );
+ 	AddPathDisc( builder, m_localPosition, dotRadius, dotColor, 16 );
 
-	m_vertCount = static_cast<int>( mesh.size() );
-	m_vbo = g_theRenderer->CreateVertexBuffer( m_vertCount * sizeof( Vertex_PCU ) );
-	g_theRenderer->CopyCPUToGPU( mesh.data(), m_vertCount * sizeof( Vertex_PCU ), m_vbo );
-}
-
-
-//----------------------------------------------------------------------------------------------------------
-void PathNode::Render() const
-{
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->BindTexture( nullptr );
-	g_theRenderer->DrawVertexBuffer( m_vbo, m_vertCount );
+	m_indexCount = static_cast<int>( builder.m_indexes.size() ) - m_firstIndex;
 }
 
 
@@ -132,26 +305,28 @@ void PathNode::DebugRender() const
 
 
 //----------------------------------------------------------------------------------------------------------
-Vec2 const& PathNode::GetPosition() const
+void PathNode::SetTiming( long long timeInTicks, int durationInTicks )
 {
-	return m_position;
+	m_timeInTicks = timeInTicks;
+	m_durationInTicks = durationInTicks;
+	m_timeInBeats = TempoMap::TicksToBeats( timeInTicks );
+	m_durationInBeats = static_cast<float>( TempoMap::TicksToBeats( durationInTicks ) );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-Path::Path( Conductor const& conductor )
-	: m_conductor( conductor )
+Vec2 const& PathNode::GetPosition() const
 {
+	return m_position;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 Path::~Path()
 {
-	for ( PathNode& node : m_nodes )
+	for ( PathChunk& chunk : m_chunks )
 	{
-		delete node.m_vbo;
-		node.m_vbo = nullptr;
+		DestroyChunkBuffers( chunk );
 	}
 }
 
@@ -159,9 +334,19 @@ Path::~Path()
 //----------------------------------------------------------------------------------------------------------
 bool Path::LoadFromFile( const char* filepath )
 {
-	// Load File
+	std::string xmlText;
+	if ( FileReadToString( xmlText, filepath ) <= 0 )
+		return false;
+
+	return LoadFromXmlText( xmlText, filepath );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Path::LoadFromXmlText( std::string const& xmlText, std::string const& filepath )
+{
 	XmlDocument document;
-	XmlResult result = document.LoadFile( filepath );
+	XmlResult result = document.Parse( xmlText.c_str(), xmlText.size() );
 	if ( result != tinyxml2::XML_SUCCESS )
 		return false;
 
@@ -178,6 +363,7 @@ bool Path::LoadFromFile( const char* filepath )
 	m_scale		= pathArgs.GetValue( "scale", 1.f );
 
 	int nodeCount = rootElement->ChildElementCount( "Node" );
+	m_nodeDefs.reserve( nodeCount );
 	m_nodes.reserve( nodeCount );
 	XmlElement const* nodeElement = rootElement->FirstChildElement( "Node" );
 	while ( nodeElement != nullptr )
@@ -188,95 +374,515 @@ bool Path::LoadFromFile( const char* filepath )
 		nodeElement = nodeElement->NextSiblingElement( "Node" );
 	}
 
+	Recompile( 0 );
 	return true;
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void Path::Render() const
+// Reads back exactly what SaveCompiled() wrote for this chart hash: no XML parsing, no vertex math. Any
+// mismatch (another hash, another compiler version, a short file) reports failure and leaves the path
+// empty, so the caller can compile from XML instead.
+//
+bool Path::LoadCompiled( std::string const& filepath, unsigned long long chartHash )
 {
-	int nodeCount = static_cast<int>( m_nodes.size() );
-	for ( int nodeIndex = nodeCount - 1; nodeIndex >= 0; nodeIndex-- )
+	std::ifstream file( filepath, std::ios::in | std::ios::binary );
+	if ( !file.is_open() )
+		return false;
+
+	CompiledPathHeader header;
+	if ( !file.read( reinterpret_cast<char*>( &header ), sizeof( CompiledPathHeader ) ) )
+		return false;
+
+	CompiledPathHeader const expectedHeader;
+	if ( memcmp( header.m_magic, expectedHeader.m_magic, sizeof( header.m_magic ) ) != 0 || header.m_version != COMPILED_PATH_VERSION )
+		return false;
+
+	if ( header.m_chartHash != chartHash || header.m_nameLength > COMPILED_PATH_MAX_NAME_LENGTH )
+		return false;
+
+	std::string name( header.m_nameLength, '\0' );
+	std::vector<CompiledPathNodeDef> compiledDefs( header.m_nodeCount );
+	std::vector<CompiledPathNode> compiledNodes( header.m_nodeCount );
+	std::vector<CompiledPathChunk> compiledChunks( header.m_chunkCount );
+	std::vector<PathVertex> vertexes( header.m_vertCount );
+	std::vector<unsigned short> indexes( header.m_indexCount );
+	file.read( name.data(), header.m_nameLength );
+	file.read( reinterpret_cast<char*>( compiledDefs.data() ), compiledDefs.size() * sizeof( CompiledPathNodeDef ) );
+	file.read( reinterpret_cast<char*>( compiledNodes.data() ), compiledNodes.size() * sizeof( CompiledPathNode ) );
+	file.read( reinterpret_cast<char*>( compiledChunks.data() ), compiledChunks.size() * sizeof( CompiledPathChunk ) );
+	file.read( reinterpret_cast<char*>( vertexes.data() ), vertexes.size() * sizeof( PathVertex ) );
+	file.read( reinterpret_cast<char*>( indexes.data() ), indexes.size() * sizeof( unsigned short ) );
+	if ( !file || file.peek() != std::ifstream::traits_type::eof() )
+		return false;
+
+	// Chunks have to tile the nodes exactly, their vertexes and indexes have to add up, and every index has
+	// to land inside its chunk, or the file is lying
+	std::vector<PathChunk> chunks( header.m_chunkCount );
+	unsigned int expectedFirstNodeIndex = 0;
+	unsigned long long vertCursor = 0;
+	unsigned long long indexCursor = 0;
+	for ( unsigned int chunkIndex = 0; chunkIndex < header.m_chunkCount; chunkIndex++ )
+	{
+		CompiledPathChunk const& compiledChunk = compiledChunks[chunkIndex];
+		if ( compiledChunk.m_firstNodeIndex != expectedFirstNodeIndex || compiledChunk.m_nodeCount == 0 )
+			return false;
+		if ( vertCursor + compiledChunk.m_vertCount > header.m_vertCount || compiledChunk.m_vertCount > MAX_PATH_CHUNK_VERTEXES )
+			return false;
+		if ( indexCursor + compiledChunk.m_indexCount > header.m_indexCount )
+			return false;
+
+		auto firstIndex = indexes.begin() + indexCursor;
+		auto endIndex = firstIndex + compiledChunk.m_indexCount;
+		if ( std::any_of( firstIndex, endIndex, [&compiledChunk]( unsigned short index ) { return index >= compiledChunk.m_vertCount; } ) )
+			return false;
+
+		PathChunk& chunk = chunks[chunkIndex];
+		chunk.m_firstNodeIndex	= static_cast<int>( compiledChunk.m_firstNodeIndex );
+		chunk.m_nodeCount		= static_cast<int>( compiledChunk.m_nodeCount );
+		chunk.m_origin			= Vec2( compiledChunk.m_originX, compiledChunk.m_originY );
+		chunk.m_rotationDegrees	= compiledChunk.m_rotationDegrees;
+		chunk.m_entryClockwise	= compiledChunk.m_entryClockwise != 0;
+		chunk.m_entrySpeed		= compiledChunk.m_entrySpeed;
+		chunk.m_quantizedMins	= Vec2( compiledChunk.m_quantizedMinX, compiledChunk.m_quantizedMinY );
+		chunk.m_quantizedStep	= compiledChunk.m_quantizedStep;
+		chunk.m_needsBuild		= false;
+		chunk.m_vertexes.assign( vertexes.begin() + vertCursor, vertexes.begin() + vertCursor + compiledChunk.m_vertCount );
+		chunk.m_indexes.assign( firstIndex, endIndex );
+		expectedFirstNodeIndex += compiledChunk.m_nodeCount;
+		vertCursor += compiledChunk.m_vertCount;
+		indexCursor += compiledChunk.m_indexCount;
+	}
+	if ( expectedFirstNodeIndex != header.m_nodeCount || vertCursor != header.m_vertCount || indexCursor != header.m_indexCount )
+		return false;
+
+	std::vector<PathNodeDef> defs( header.m_nodeCount );
+	std::vector<PathNode> nodes( header.m_nodeCount );
+	for ( unsigned int nodeIndex = 0; nodeIndex < header.m_nodeCount; nodeIndex++ )
 	{
+		CompiledPathNodeDef const& compiledDef = compiledDefs[nodeIndex];
+		PathNodeDef& def = defs[nodeIndex];
+		def.m_beats			= compiledDef.m_beats;
+		def.m_speed			= compiledDef.m_speed;
+		def.m_spin			= compiledDef.m_spin != 0;
+		def.m_checkpoint	= compiledDef.m_checkpoint != 0;
+
+		CompiledPathNode const& compiledNode = compiledNodes[nodeIndex];
+		PathNode& node = nodes[nodeIndex];
+		node.m_position			= Vec2( compiledNode.m_positionX, compiledNode.m_positionY );
+		node.m_localPosition	= Vec2( compiledNode.m_localPositionX, compiledNode.m_localPositionY );
+		node.m_localAngle		= compiledNode.m_localAngle;
+		node.m_firstIndex		= static_cast<int>( compiledNode.m_firstIndex );
+		node.m_indexCount		= static_cast<int>( compiledNode.m_indexCount );
+		node.SetTiming( compiledNode.m_timeInTicks, compiledNode.m_durationInTicks );
+		node.m_speed			= compiledNode.m_speed;
+		node.m_angle			= compiledNode.m_angle;
+		node.m_radius			= compiledNode.m_radius;
+		node.m_clockwise		= compiledNode.m_clockwise != 0;
+		node.m_checkpoint		= compiledNode.m_checkpoint != 0;
+	}
+
+	m_name = name;
+	m_pathWidth = header.m_pathWidth;
+	m_scale = header.m_scale;
+	m_totalTimeInTicks = header.m_totalTimeInTicks;
+	m_nodeDefs.swap( defs );
+	m_nodes.swap( nodes );
+	m_chunks.swap( chunks );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Path::SaveCompiled( std::string const& filepath, unsigned long long chartHash ) const
+{
+	CompiledPathHeader header;
+	header.m_chartHash = chartHash;
+	header.m_nodeCount = GetNodeCount();
+	header.m_chunkCount = static_cast<unsigned int>( m_chunks.size() );
+	header.m_nameLength = static_cast<unsigned int>( std::min( m_name.size(), static_cast<size_t>( COMPILED_PATH_MAX_NAME_LENGTH ) ) );
+	header.m_pathWidth = m_pathWidth;
+	header.m_scale = m_scale;
+	header.m_totalTimeInTicks = m_totalTimeInTicks;
+
+	std::vector<CompiledPathNodeDef> compiledDefs( m_nodeDefs.size() );
+	std::vector<CompiledPathNode> compiledNodes( m_nodes.size() );
+	for ( size_t nodeIndex = 0; nodeIndex < m_nodes.size(); nodeIndex++ )
+	{
+		PathNodeDef const& def = m_nodeDefs[nodeIndex];
+		CompiledPathNodeDef& compiledDef = compiledDefs[nodeIndex];
+		compiledDef.m_beats				= def.m_beats;
+		compiledDef.m_speed				= def.m_speed;
+		compiledDef.m_spin				= def.m_spin ? 1 : 0;
+		compiledDef.m_checkpoint		= def.m_checkpoint ? 1 : 0;
+
 		PathNode const& node = m_nodes[nodeIndex];
-		node.Render();
+		CompiledPathNode& compiledNode = compiledNodes[nodeIndex];
+		compiledNode.m_positionX		= node.m_position.x;
+		compiledNode.m_positionY		= node.m_position.y;
+		compiledNode.m_localPositionX	= node.m_localPosition.x;
+		compiledNode.m_localPositionY	= node.m_localPosition.y;
+		compiledNode.m_localAngle		= node.m_localAngle;
+		compiledNode.m_timeInTicks		= node.m_timeInTicks;
+		compiledNode.m_durationInTicks	= node.m_durationInTicks;
+		compiledNode.m_speed			= node.m_speed;
+		compiledNode.m_angle			= node.m_angle;
+		compiledNode.m_radius			= node.m_radius;
+		compiledNode.m_firstIndex		= static_cast<unsigned int>( node.m_firstIndex );
+		compiledNode.m_indexCount		= static_cast<unsigned int>( node.m_indexCount );
+		compiledNode.m_clockwise		= node.m_clockwise ? 1 : 0;
+		compiledNode.m_checkpoint		= node.m_checkpoint ? 1 : 0;
+	}
+
+	std::vector<CompiledPathChunk> compiledChunks( m_chunks.size() );
+	for ( size_t chunkIndex = 0; chunkIndex < m_chunks.size(); chunkIndex++ )
+	{
+		PathChunk const& chunk = m_chunks[chunkIndex];
+		CompiledPathChunk& compiledChunk = compiledChunks[chunkIndex];
+		compiledChunk.m_firstNodeIndex	= static_cast<unsigned int>( chunk.m_firstNodeIndex );
+		compiledChunk.m_nodeCount		= static_cast<unsigned int>( chunk.m_nodeCount );
+		compiledChunk.m_vertCount		= static_cast<unsigned int>( chunk.m_vertexes.size() );
+		compiledChunk.m_indexCount		= static_cast<unsigned int>( chunk.m_indexes.size() );
+		compiledChunk.m_originX			= chunk.m_origin.x;
+		compiledChunk.m_originY			= chunk.m_origin.y;
+		compiledChunk.m_rotationDegrees	= chunk.m_rotationDegrees;
+		compiledChunk.m_entrySpeed		= chunk.m_entrySpeed;
+		compiledChunk.m_quantizedMinX	= chunk.m_quantizedMins.x;
+		compiledChunk.m_quantizedMinY	= chunk.m_quantizedMins.y;
+		compiledChunk.m_quantizedStep	= chunk.m_quantizedStep;
+		compiledChunk.m_entryClockwise	= chunk.m_entryClockwise ? 1 : 0;
+		header.m_vertCount += compiledChunk.m_vertCount;
+		header.m_indexCount += compiledChunk.m_indexCount;
+	}
+
+	// Written under a temporary name and renamed into place, so a half-written cache is never picked up
+	std::string tempFilePath = filepath + ".tmp";
+	{
+		std::ofstream file( tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( !file.is_open() )
+			return false;
+
+		file.write( reinterpret_cast<char const*>( &header ), sizeof( CompiledPathHeader ) );
+		file.write( m_name.data(), header.m_nameLength );
+		file.write( reinterpret_cast<char const*>( compiledDefs.data() ), compiledDefs.size() * sizeof( CompiledPathNodeDef ) );
+		file.write( reinterpret_cast<char const*>( compiledNodes.data() ), compiledNodes.size() * sizeof( CompiledPathNode ) );
+		file.write( reinterpret_cast<char const*>( compiledChunks.data() ), compiledChunks.size() * sizeof( CompiledPathChunk ) );
+		for ( PathChunk const& chunk : m_chunks )
+		{
+			file.write( reinterpret_cast<char const*>( chunk.m_vertexes.data() ), chunk.m_vertexes.size() * sizeof( PathVertex ) );
+		}
+		for ( PathChunk const& chunk : m_chunks )
+		{
+			file.write( reinterpret_cast<char const*>( chunk.m_indexes.data() ), chunk.m_indexes.size() * sizeof( unsigned short ) );
+		}
+		if ( !file.good() )
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename( tempFilePath, filepath, error );
+	return !error;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Writes the authored defs back out as <Node> elements. If the file already exists its root element and
+// anything that isn't a node (comments, extra attributes) are kept, so only the chart itself changes.
+//
+bool Path::SaveToXmlFile( std::string const& filepath ) const
+{
+	XmlDocument document;
+	XmlElement* rootElement = nullptr;
+	if ( document.LoadFile( filepath.c_str() ) == tinyxml2::XML_SUCCESS )
+	{
+		rootElement = document.RootElement();
 	}
+
+	if ( rootElement == nullptr )
+	{
+		document.Clear();
+		rootElement = document.NewElement( "Path" );
+		rootElement->SetAttribute( "name", m_name.c_str() );
+		rootElement->SetAttribute( "scale", Stringf( "%g", m_scale ).c_str() );
+		rootElement->SetAttribute( "width", Stringf( "%g", m_pathWidth ).c_str() );
+		document.InsertFirstChild( rootElement );
+	}
+
+	XmlElement* nodeElement = rootElement->FirstChildElement( "Node" );
+	while ( nodeElement != nullptr )
+	{
+		XmlElement* nextNodeElement = nodeElement->NextSiblingElement( "Node" );
+		rootElement->DeleteChild( nodeElement );
+		nodeElement = nextNodeElement;
+	}
+
+	for ( PathNodeDef const& def : m_nodeDefs )
+	{
+		nodeElement = document.NewElement( "Node" );
+		nodeElement->SetAttribute( "beat", Stringf( "%g", def.m_beats ).c_str() );
+		if ( def.m_speed > 0.f )
+		{
+			nodeElement->SetAttribute( "speed", Stringf( "%g", def.m_speed ).c_str() );
+		}
+		if ( def.m_spin )
+		{
+			nodeElement->SetAttribute( "spin", "true" );
+		}
+		if ( def.m_checkpoint )
+		{
+			nodeElement->SetAttribute( "checkpoint", "true" );
+		}
+		rootElement->InsertEndChild( nodeElement );
+	}
+
+	return document.SaveFile( filepath.c_str() ) == tinyxml2::XML_SUCCESS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Only chunks that were rebuilt since their last upload are sent. The renderer only takes Vertex_PCU, so
+// each chunk is expanded from its compact vertexes here; it stays indexed, so shared corners and disc
+// centers are still sent once.
+//
+void Path::UploadVertexBuffers()
+{
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PATH );
+
+	// The renderer only takes Vertex_PCU and 32-bit indexes, so each chunk is expanded into this one mesh
+	// just long enough to upload it. Buffers are reused while the new data fits, so an editor re-upload
+	// only reallocates a chunk that grew.
+	IndexedMesh expandedMesh;
+	for ( PathChunk& chunk : m_chunks )
+	{
+		if ( !chunk.m_needsUpload )
+			continue;
+
+		chunk.m_needsUpload = false;
+		if ( chunk.m_indexes.empty() )
+		{
+			DestroyChunkBuffers( chunk );
+			continue;
+		}
+
+		expandedMesh.m_vertexes.resize( chunk.m_vertexes.size() );
+		for ( size_t vertexIndex = 0; vertexIndex < chunk.m_vertexes.size(); vertexIndex++ )
+		{
+			PathVertex const& vertex = chunk.m_vertexes[vertexIndex];
+			Vec2 position = chunk.m_quantizedMins + chunk.m_quantizedStep * Vec2( static_cast<float>( vertex.m_x ), static_cast<float>( vertex.m_y ) );
+			expandedMesh.m_vertexes[vertexIndex] = Vertex_PCU( Vec3( position.x, position.y, 0.f ), PATH_PALETTE[(int)vertex.m_color], Vec2::ZERO );
+		}
+		expandedMesh.m_indexes.assign( chunk.m_indexes.begin(), chunk.m_indexes.end() );
+
+		size_t vertexByteSize = expandedMesh.m_vertexes.size() * sizeof( Vertex_PCU );
+		if ( chunk.m_vbo == nullptr || vertexByteSize > chunk.m_vboByteSize )
+		{
+			if ( chunk.m_vbo != nullptr )
+			{
+				g_theRenderBackend->DestroyVertexBuffer( chunk.m_vbo );
+			}
+			chunk.m_vboByteSize = vertexByteSize + vertexByteSize / 4;
+			chunk.m_vbo = g_theRenderBackend->CreateVertexBuffer( chunk.m_vboByteSize );
+		}
+		g_theRenderBackend->CopyCPUToGPU( expandedMesh.m_vertexes.data(), vertexByteSize, chunk.m_vbo );
+
+		size_t indexByteSize = expandedMesh.m_indexes.size() * sizeof( unsigned int );
+		if ( chunk.m_ibo == nullptr || indexByteSize > chunk.m_iboByteSize )
+		{
+			if ( chunk.m_ibo != nullptr )
+			{
+				g_theRenderBackend->DestroyIndexBuffer( chunk.m_ibo );
+			}
+			chunk.m_iboByteSize = indexByteSize + indexByteSize / 4;
+			chunk.m_ibo = g_theRenderBackend->CreateIndexBuffer( chunk.m_iboByteSize );
+		}
+		g_theRenderBackend->CopyCPUToGPU( expandedMesh.m_indexes.data(), indexByteSize, chunk.m_ibo );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Path::Render() const
+{
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PATH );
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->BindTexture( nullptr );
+
+	// Last chunk first, matching the last-node-first order inside each chunk
+	for ( int chunkIndex = static_cast<int>( m_chunks.size() ) - 1; chunkIndex >= 0; chunkIndex-- )
+	{
+		PathChunk const& chunk = m_chunks[chunkIndex];
+		if ( chunk.m_vbo == nullptr || chunk.m_ibo == nullptr )
+			continue;
+
+		Mat44 chunkToWorld = Mat44::MakeTranslation2D( chunk.m_origin );
+		chunkToWorld.AppendZRotation( chunk.m_rotationDegrees );
+		g_theRenderBackend->SetModelConstants( chunkToWorld );
+		g_theRenderBackend->DrawIndexedVertexBuffer( chunk.m_vbo, chunk.m_ibo, static_cast<unsigned int>( chunk.m_indexes.size() ) );
+	}
+	g_theRenderBackend->SetModelConstants();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Path::DebugRender() const
 {
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PATH );
 	int nodeCount = static_cast<int>( m_nodes.size() );
 	for ( int nodeIndex = nodeCount - 1; nodeIndex >= 0; nodeIndex-- )
 	{
 		PathNode const& node = m_nodes[nodeIndex];
 		node.DebugRender();
 	}
+
+	if ( m_difficultyOverlay.empty() )
+		return;
+
+	// Heatmap of how often each node kills or trips up players; green is fair, red is where runs end
+	unsigned int minReachCount = g_gameConfigBlackboard.GetValue( "runStatsMinReach", 10 );
+	Mesh& overlayVerts = g_theFrameArena->AllocateMesh();
+	overlayVerts.reserve( nodeCount * 3 * 16 );
+	for ( int nodeIndex = 1; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		PathNode const& node = m_nodes[nodeIndex];
+		NodeDifficulty const& difficulty = m_difficultyOverlay[nodeIndex];
+		if ( difficulty.m_reachCount < minReachCount )
+		{
+			AddVertsForDisc2D( overlayVerts, node.m_position, .35f * m_pathWidth, Rgba8( 128, 128, 128, 96 ), 16 );
+			continue;
+		}
+
+		float trouble = 1.f - ( 1.f - difficulty.m_missRate ) * ( 1.f - difficulty.m_deathRate );
+		trouble = std::clamp( trouble * 2.f, 0.f, 1.f );
+		unsigned char red = static_cast<unsigned char>( 255.f * std::min( 2.f * trouble, 1.f ) );
+		unsigned char green = static_cast<unsigned char>( 255.f * std::min( 2.f - 2.f * trouble, 1.f ) );
+		AddVertsForDisc2D( overlayVerts, node.m_position, .35f * m_pathWidth, Rgba8( red, green, 0, 160 ), 16 );
+
+		std::string info = Stringf( "%.0f%% miss %.0f%% die %+.0fms", difficulty.m_missRate * 100.f, difficulty.m_deathRate * 100.f, difficulty.m_meanErrorMs );
+		Mat44 transform = Mat44::MakeTranslation3D( Vec3( node.m_position - Vec2::UP * node.m_radius, 1 ) );
+		transform.AppendZRotation( -90 );
+		transform.AppendYRotation( -90 );
+		DebugAddWorldText( info, transform, node.m_radius * .2f, Vec2( 0.5, 0.5 ), 0.f, Rgba8( red, green, 0 ), Rgba8( red, green, 0 ) );
+	}
+
+	g_theRenderBackend->BindTexture( nullptr );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetModelConstants();
+	g_theRenderBackend->DrawVertexArray( overlayVerts );
 }
 
 
+
 //----------------------------------------------------------------------------------------------------------
-void Path::AddNode( NamedStrings& arguments )
+void Path::SetNodeDef( int index, PathNodeDef const& def )
+{
+	if ( index < 0 || index >= static_cast<int>( m_nodeDefs.size() ) )
+		return;
+
+	m_nodeDefs[index] = def;
+	Recompile( FindChunkIndex( index ) );
+	UploadVertexBuffers();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Only the chunk the node lands in grows; every later chunk just starts one node further on. A chunk
+// that has grown to twice the usual size is split so rebuilds stay cheap.
+//
+void Path::InsertNode( int index, PathNodeDef const& def )
 {
-	float timeInBeats = arguments.GetValue( "beat", 1.f );
-	float deltaAngle = RangeMap( timeInBeats, 2.f, 0.f, -180.f, 180.f );
+	int nodeCount = static_cast<int>( m_nodes.size() );
+	index = std::clamp( index, 0, nodeCount );
+	m_nodeDefs.insert( m_nodeDefs.begin() + index, def );
+	m_nodes.insert( m_nodes.begin() + index, PathNode() );
 
-	if ( m_nodes.size() == 0 )
+	if ( m_chunks.empty() )
+	{
+		m_chunks.emplace_back();
+	}
+	int chunkIndex = index == nodeCount ? static_cast<int>( m_chunks.size() ) - 1 : FindChunkIndex( index );
+	m_chunks[chunkIndex].m_nodeCount++;
+	for ( size_t laterIndex = chunkIndex + 1; laterIndex < m_chunks.size(); laterIndex++ )
 	{
-		m_nodes.emplace_back();
-		PathNode& newNode = m_nodes.back();
-		newNode.m_durationInBeats = timeInBeats;
-		newNode.m_angle = 0.f;
-		newNode.m_speed = 1.f;
-		newNode.m_radius = .5f * m_scale;
-		Vec2 outNormal = Vec2::MakeFromPolarDegrees( deltaAngle );
-		newNode.InitializeVerts( Vec2::RIGHT, outNormal, m_pathWidth, 0.125f * m_pathWidth );
+		m_chunks[laterIndex].m_firstNodeIndex++;
+	}
 
-		m_totalTimeInBeats += timeInBeats;
-		return;
+	if ( m_chunks[chunkIndex].m_nodeCount >= 2 * PATH_CHUNK_NODE_COUNT )
+	{
+		PathChunk secondHalf;
+		secondHalf.m_nodeCount = m_chunks[chunkIndex].m_nodeCount / 2;
+		secondHalf.m_firstNodeIndex = m_chunks[chunkIndex].m_firstNodeIndex + m_chunks[chunkIndex].m_nodeCount - secondHalf.m_nodeCount;
+		m_chunks[chunkIndex].m_nodeCount -= secondHalf.m_nodeCount;
+		m_chunks.insert( m_chunks.begin() + chunkIndex + 1, std::move( secondHalf ) );
 	}
 
-	PathNode& prevNode = m_nodes.back();
-	bool spin = arguments.GetValue( "spin", false );
-	float speed = arguments.GetValue( "speed", prevNode.m_speed );
-	timeInBeats /= speed;
+	m_chunks[chunkIndex].m_needsBuild = true;
+	Recompile( chunkIndex );
+	UploadVertexBuffers();
+}
 
-#if defined( _DEBUG )
-	if ( deltaAngle > 360.f )
+
+//----------------------------------------------------------------------------------------------------------
+void Path::RemoveNode( int index )
+{
+	if ( index < 0 || index >= static_cast<int>( m_nodes.size() ) )
+		return;
+
+	m_nodeDefs.erase( m_nodeDefs.begin() + index );
+	m_nodes.erase( m_nodes.begin() + index );
+
+	int chunkIndex = FindChunkIndex( index );
+	m_chunks[chunkIndex].m_nodeCount--;
+	for ( size_t laterIndex = chunkIndex + 1; laterIndex < m_chunks.size(); laterIndex++ )
 	{
-		ERROR_RECOVERABLE( "Tried to add a path node with a change in angle over 360 degrees! This may lead to desync!" );
+		m_chunks[laterIndex].m_firstNodeIndex--;
 	}
-#endif
 
-	bool isClockwise = spin ? !prevNode.m_clockwise : prevNode.m_clockwise;
-	float turnDirection = isClockwise ? 1.f : -1.f;
-	float prevAngle = prevNode.m_angle;
-	float angle = prevAngle + ( turnDirection * deltaAngle );
-	angle = GetNormalizedAngle( angle );
+	if ( m_chunks[chunkIndex].m_nodeCount == 0 )
+	{
+		DestroyChunkBuffers( m_chunks[chunkIndex] );
+		m_chunks.erase( m_chunks.begin() + chunkIndex );
+		if ( m_chunks.empty() )
+		{
+			m_totalTimeInTicks = 0;
+			return;
+		}
+	}
 
-	Vec2 prevPosition = prevNode.m_position;
-	Vec2 inDirection = Vec2::MakeFromPolarDegrees( prevAngle );
-	Vec2 position = prevPosition + ( inDirection * m_scale );
+	// The node after the removed one now starts where it was, so that is the first one to rebuild
+	chunkIndex = std::min( chunkIndex, static_cast<int>( m_chunks.size() ) - 1 );
+	m_chunks[chunkIndex].m_needsBuild = true;
+	Recompile( chunkIndex );
+	UploadVertexBuffers();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+PathNodeDef const& Path::GetNodeDef( int index ) const
+{
+	return m_nodeDefs[index];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Path::SetDifficultyOverlay( std::vector<NodeDifficulty> const& nodes )
+{
+	if ( nodes.size() != m_nodes.size() )
+	{
+		ERROR_RECOVERABLE( Stringf( "Difficulty overlay has %u nodes but path \"%s\" has %u", static_cast<unsigned int>( nodes.size() ), m_name.c_str(), GetNodeCount() ) );
+		return;
+	}
+
+	m_difficultyOverlay = nodes;
+}
 
-	m_nodes.emplace_back();
-	PathNode& newNode = m_nodes.back();
-	newNode.m_position = position;
-	newNode.m_durationInBeats = timeInBeats;
-	newNode.m_timeInBeats = m_totalTimeInBeats;
-	newNode.m_angle = angle;
-	newNode.m_radius = .5f * m_scale;
-	newNode.m_clockwise = isClockwise;
-	newNode.m_speed = speed;
-	newNode.m_checkpoint = arguments.GetValue( "checkpoint", false );
 
-	Vec2 outDirection = Vec2::MakeFromPolarDegrees( angle );
-	int speedChange = 0;
-	if ( speed > prevNode.m_speed )			speedChange = 1;
-	else if ( speed < prevNode.m_speed )	speedChange = -1;
-	newNode.InitializeVerts( inDirection, outDirection, m_pathWidth, 0.125f * m_pathWidth, spin, speedChange );
 
-	m_totalTimeInBeats += timeInBeats;
+//----------------------------------------------------------------------------------------------------------
+void Path::ClearDifficultyOverlay()
+{
+	m_difficultyOverlay.clear();
 }
 
 
@@ -301,6 +907,18 @@ PathNode const* Path::GetLastNode() const
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// The node the planets are pivoting on at this time: the last one whose time has come. Times only ever
+// increase along the path, so this is a binary search.
+//
+int Path::GetNodeIndexAtTime( double timeInBeats ) const
+{
+	auto nodeIter = std::upper_bound( m_nodes.begin(), m_nodes.end(), timeInBeats,
+		[]( double time, PathNode const& node ) { return time < node.m_timeInBeats; } );
+	return std::max( static_cast<int>( nodeIter - m_nodes.begin() ) - 1, 0 );
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 unsigned int Path::GetNodeCount() const
 {
@@ -308,8 +926,287 @@ unsigned int Path::GetNodeCount() const
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+double Path::GetTotalTimeInBeats() const
+{
+	return TempoMap::TicksToBeats( m_totalTimeInTicks );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+long long Path::GetTotalTimeInTicks() const
+{
+	return m_totalTimeInTicks;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 float Path::GetWidth() const
 {
 	return m_pathWidth;
 }
+
+
+//----------------------------------------------------------------------------------------------------------
+PathMeshStats Path::GetMeshStats() const
+{
+	PathMeshStats stats;
+	stats.m_nodeCount = GetNodeCount();
+	for ( PathChunk const& chunk : m_chunks )
+	{
+		stats.m_vertexCount += chunk.m_vertexes.size();
+		stats.m_indexCount += chunk.m_indexes.size();
+
+		// Coordinates round to the nearest step, so none is off by more than half of one
+		stats.m_maxQuantizationError = std::max( stats.m_maxQuantizationError, 0.5f * chunk.m_quantizedStep );
+	}
+
+	stats.m_compactByteSize = stats.m_vertexCount * sizeof( PathVertex ) + stats.m_indexCount * sizeof( unsigned short );
+	stats.m_gpuByteSize = stats.m_vertexCount * sizeof( Vertex_PCU ) + stats.m_indexCount * sizeof( unsigned int );
+	stats.m_unindexedByteSize = stats.m_indexCount * sizeof( Vertex_PCU );
+	return stats;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Appends one node as parsed from XML. Loading appends every node first and compiles them all in one
+// go afterward.
+//
+void Path::AddNode( NamedStrings& arguments )
+{
+	PathNodeDef& def = m_nodeDefs.emplace_back();
+	def.m_beats			= arguments.GetValue( "beat", 1.f );
+	def.m_speed			= arguments.GetValue( "speed", 0.f );
+	def.m_spin			= arguments.GetValue( "spin", false );
+	def.m_checkpoint	= arguments.GetValue( "checkpoint", false );
+	m_nodes.emplace_back();
+
+	if ( m_chunks.empty() || m_chunks.back().m_nodeCount >= PATH_CHUNK_NODE_COUNT )
+	{
+		PathChunk& chunk = m_chunks.emplace_back();
+		chunk.m_firstNodeIndex = static_cast<int>( m_nodes.size() ) - 1;
+	}
+	m_chunks.back().m_nodeCount++;
+	m_chunks.back().m_needsBuild = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int Path::FindChunkIndex( int nodeIndex ) const
+{
+	auto chunkIter = std::upper_bound( m_chunks.begin(), m_chunks.end(), nodeIndex,
+		[]( int index, PathChunk const& chunk ) { return index < chunk.m_firstNodeIndex; } );
+	return std::max( static_cast<int>( chunkIter - m_chunks.begin() ) - 1, 0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Walks the chunks from the edited one to the end. A chunk is rebuilt when it was edited or when the
+// turn direction or speed it inherits changed; otherwise it only moves to where its predecessor now ends.
+//
+void Path::Recompile( int editedChunkIndex )
+{
+	int chunkCount = static_cast<int>( m_chunks.size() );
+	if ( editedChunkIndex < 0 || editedChunkIndex >= chunkCount )
+		return;
+
+	m_chunks[editedChunkIndex].m_needsBuild = true;
+	for ( int chunkIndex = editedChunkIndex; chunkIndex < chunkCount; chunkIndex++ )
+	{
+		PathChunk& chunk = m_chunks[chunkIndex];
+		bool entryClockwise = true;
+		float entrySpeed = 1.f;
+		Vec2 entryPosition = Vec2::ZERO;
+		float entryAngle = 0.f;
+		if ( chunk.m_firstNodeIndex > 0 )
+		{
+			PathNode const& prevNode = m_nodes[chunk.m_firstNodeIndex - 1];
+			entryClockwise = prevNode.m_clockwise;
+			entrySpeed = prevNode.m_speed;
+			entryPosition = prevNode.m_position;
+			entryAngle = prevNode.m_angle;
+		}
+
+		if ( chunk.m_needsBuild || chunk.m_entryClockwise != entryClockwise || chunk.m_entrySpeed != entrySpeed )
+		{
+			BuildChunk( chunk, entryClockwise, entrySpeed );
+		}
+
+		chunk.m_origin = entryPosition;
+		chunk.m_rotationDegrees = entryAngle;
+		RebaseChunk( chunk );
+	}
+
+	UpdateTimes( m_chunks[editedChunkIndex].m_firstNodeIndex );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Lays the chunk's nodes out in its own frame, exactly as AddNode() used to lay out the whole path from
+// the origin: the node before the chunk is at ( 0, 0 ) facing 0 degrees.
+//
+void Path::BuildChunk( PathChunk& chunk, bool entryClockwise, float entrySpeed )
+{
+	chunk.m_entryClockwise = entryClockwise;
+	chunk.m_entrySpeed = entrySpeed;
+	chunk.m_needsBuild = false;
+	chunk.m_needsUpload = true;
+
+	int endNodeIndex = chunk.m_firstNodeIndex + chunk.m_nodeCount;
+	Vec2 prevPosition = Vec2::ZERO;
+	float prevAngle = 0.f;
+	bool prevClockwise = entryClockwise;
+	float prevSpeed = entrySpeed;
+	for ( int nodeIndex = chunk.m_firstNodeIndex; nodeIndex < endNodeIndex; nodeIndex++ )
+	{
+		PathNodeDef const& def = m_nodeDefs[nodeIndex];
+		PathNode& node = m_nodes[nodeIndex];
+		float deltaAngle = RangeMap( def.m_beats, 2.f, 0.f, -180.f, 180.f );
+		node.m_radius = .5f * m_scale;
+		node.m_checkpoint = def.m_checkpoint;
+
+		if ( nodeIndex == 0 )
+		{
+			node.m_durationInTicks = static_cast<int>( TempoMap::BeatsToTicks( def.m_beats ) );
+			node.m_localAngle = 0.f;
+			node.m_localPosition = Vec2::ZERO;
+			node.m_speed = 1.f;
+			node.m_clockwise = true;
+			node.m_checkpoint = false;
+		}
+		else
+		{
+#if defined( _DEBUG )
+			if ( deltaAngle > 360.f )
+			{
+				ERROR_RECOVERABLE( "Tried to add a path node with a change in angle over 360 degrees! This may lead to desync!" );
+			}
+#endif
+			float speed = def.m_speed > 0.f ? def.m_speed : prevSpeed;
+			bool isClockwise = def.m_spin ? !prevClockwise : prevClockwise;
+			float turnDirection = isClockwise ? 1.f : -1.f;
+
+			node.m_durationInTicks = static_cast<int>( TempoMap::BeatsToTicks( static_cast<double>( def.m_beats ) / static_cast<double>( speed ) ) );
+			node.m_localAngle = GetNormalizedAngle( prevAngle + ( turnDirection * deltaAngle ) );
+			node.m_localPosition = prevPosition + ( Vec2::MakeFromPolarDegrees( prevAngle ) * m_scale );
+			node.m_speed = speed;
+			node.m_clockwise = isClockwise;
+		}
+
+		prevPosition = node.m_localPosition;
+		prevAngle = node.m_localAngle;
+		prevClockwise = node.m_clockwise;
+		prevSpeed = node.m_speed;
+	}
+
+	// Verts last node first, so that within the chunk earlier nodes draw over later ones like they always have
+	PathMeshBuilder builder;
+	for ( int nodeIndex = endNodeIndex - 1; nodeIndex >= chunk.m_firstNodeIndex; nodeIndex-- )
+	{
+		PathNodeDef const& def = m_nodeDefs[nodeIndex];
+		PathNode& node = m_nodes[nodeIndex];
+		if ( nodeIndex == 0 )
+		{
+			Vec2 outNormal = Vec2::MakeFromPolarDegrees( RangeMap( def.m_beats, 2.f, 0.f, -180.f, 180.f ) );
+			node.AddVerts( builder, Vec2::RIGHT, outNormal, m_pathWidth, 0.125f * m_pathWidth );
+			continue;
+		}
+
+		bool isFirstInChunk = nodeIndex == chunk.m_firstNodeIndex;
+		float inAngle = isFirstInChunk ? 0.f : m_nodes[nodeIndex - 1].m_localAngle;
+		float inSpeed = isFirstInChunk ? entrySpeed : m_nodes[nodeIndex - 1].m_speed;
+		int speedChange = 0;
+		if ( node.m_speed > inSpeed )		speedChange = 1;
+		else if ( node.m_speed < inSpeed )	speedChange = -1;
+
+		Vec2 inDirection = Vec2::MakeFromPolarDegrees( inAngle );
+		Vec2 outDirection = Vec2::MakeFromPolarDegrees( node.m_localAngle );
+		node.AddVerts( builder, inDirection, outDirection, m_pathWidth, 0.125f * m_pathWidth, def.m_spin, speedChange );
+	}
+
+	if ( builder.m_positions.size() > MAX_PATH_CHUNK_VERTEXES )
+	{
+		ERROR_AND_DIE( Stringf( "Path chunk at node %i has %u vertexes, more than 16-bit indexes can reach", chunk.m_firstNodeIndex,
+			static_cast<unsigned int>( builder.m_positions.size() ) ) );
+	}
+
+	// Quantized over the chunk's own bounds, so precision depends on how far the chunk wanders rather than
+	// on how long the whole path is
+	Vec2 mins = builder.m_positions.empty() ? Vec2::ZERO : builder.m_positions[0];
+	Vec2 maxs = mins;
+	for ( Vec2 const& position : builder.m_positions )
+	{
+		mins = Vec2( std::min( mins.x, position.x ), std::min( mins.y, position.y ) );
+		maxs = Vec2( std::max( maxs.x, position.x ), std::max( maxs.y, position.y ) );
+	}
+	float extent = std::max( maxs.x - mins.x, maxs.y - mins.y );
+	chunk.m_quantizedMins = mins;
+	chunk.m_quantizedStep = extent > 0.f ? extent / static_cast<float>( MAX_QUANTIZED_COORDINATE ) : 1.f;
+
+	chunk.m_vertexes.resize( builder.m_positions.size() );
+	for ( size_t vertexIndex = 0; vertexIndex < builder.m_positions.size(); vertexIndex++ )
+	{
+		Vec2 quantized = ( builder.m_positions[vertexIndex] - mins ) / chunk.m_quantizedStep;
+		PathVertex& vertex = chunk.m_vertexes[vertexIndex];
+		vertex.m_x = static_cast<unsigned short>( std::clamp( std::lround( quantized.x ), 0L, static_cast<long>( MAX_QUANTIZED_COORDINATE ) ) );
+		vertex.m_y = static_cast<unsigned short>( std::clamp( std::lround( quantized.y ), 0L, static_cast<long>( MAX_QUANTIZED_COORDINATE ) ) );
+		vertex.m_color = builder.m_colors[vertexIndex];
+	}
+	chunk.m_indexes.swap( builder.m_indexes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Path::DestroyChunkBuffers( PathChunk& chunk )
+{
+	if ( chunk.m_vbo != nullptr )
+	{
+		g_theRenderBackend->DestroyVertexBuffer( chunk.m_vbo );
+		chunk.m_vbo = nullptr;
+		chunk.m_vboByteSize = 0;
+	}
+
+	if ( chunk.m_ibo != nullptr )
+	{
+		g_theRenderBackend->DestroyIndexBuffer( chunk.m_ibo );
+		chunk.m_ibo = nullptr;
+		chunk.m_iboByteSize = 0;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Path::RebaseChunk( PathChunk const& chunk )
+{
+	int endNodeIndex = chunk.m_firstNodeIndex + chunk.m_nodeCount;
+	for ( int nodeIndex = chunk.m_firstNodeIndex; nodeIndex < endNodeIndex; nodeIndex++ )
+	{
+		PathNode& node = m_nodes[nodeIndex];
+		node.m_position = chunk.m_origin + node.m_localPosition.GetRotatedDegrees( chunk.m_rotationDegrees );
+		node.m_angle = GetNormalizedAngle( node.m_localAngle + chunk.m_rotationDegrees );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Times are summed in whole ticks, so an edited chart times out exactly like the same chart loaded fresh
+// whatever order its chunks were rebuilt in, and its replays still line up.
+//
+void Path::UpdateTimes( int firstNodeIndex )
+{
+	int nodeCount = static_cast<int>( m_nodes.size() );
+	long long totalTimeInTicks = 0;
+	if ( firstNodeIndex > 0 )
+	{
+		PathNode const& prevNode = m_nodes[firstNodeIndex - 1];
+		totalTimeInTicks = prevNode.m_timeInTicks + prevNode.m_durationInTicks;
+	}
+
+	for ( int nodeIndex = firstNodeIndex; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		PathNode& node = m_nodes[nodeIndex];
+		node.SetTiming( nodeIndex == 0 ? 0 : totalTimeInTicks, node.m_durationInTicks );
+		totalTimeInTicks += node.m_durationInTicks;
+	}
+	m_totalTimeInTicks = totalTimeInTicks;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "Game/RunLog.hpp"
+#include "Game/TempoMap.hpp"
 #include "Engine/Math/Vec2.hpp"
 #include "Engine/Core/XmlUtils.hpp"
 #include "Engine/Renderer/Renderer.hpp"
@@ -7,7 +9,66 @@
 
 
 //----------------------------------------------------------------------------------------------------------
-class Conductor;
+// A node as the chart author wrote it. Everything else about a node (where it is, which way it turns, when
+// it is hit) follows from these and from the nodes before it.
+//
+struct PathNodeDef
+{
+	float	m_beats			= 1.f;		// "beat": how long the node lasts at speed 1, which also sets its turn angle
+	float	m_speed			= 0.f;		// "speed"; 0 or less keeps the previous node's speed
+	bool	m_spin			= false;	// "spin": reverses the turn direction from this node on
+	bool	m_checkpoint	= false;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every color the track is drawn in. Path verts store an index into PATH_PALETTE rather than a color.
+//
+enum class PathColor : unsigned char
+{
+	BORDER,
+	BASE,
+	DOT,
+	FAST_DOT,
+	SLOW_DOT,
+	SPIN_DOT,
+	CHECKPOINT_DOT,
+
+	COUNT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// The track is flat, untextured and drawn in a handful of colors, so a vertex only needs its position in
+// its chunk's frame, quantized to 16 bits per axis over the chunk's bounds, and a palette index. Chunks
+// index these with 16-bit indexes; see PathChunk.
+//
+struct PathVertex
+{
+	unsigned short	m_x				= 0;
+	unsigned short	m_y				= 0;
+	PathColor		m_color			= PathColor::BORDER;
+	unsigned char	m_padding		= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// What a path's geometry costs as stored, as uploaded, and as it would as unindexed Vertex_PCU triangles
+//
+struct PathMeshStats
+{
+	unsigned int		m_nodeCount				= 0;
+	unsigned long long	m_vertexCount			= 0;
+	unsigned long long	m_indexCount			= 0;
+	unsigned long long	m_compactByteSize		= 0;
+	unsigned long long	m_gpuByteSize			= 0;
+	unsigned long long	m_unindexedByteSize		= 0;
+	float				m_maxQuantizationError	= 0.f;	// World units, per axis, over every chunk
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct PathMeshBuilder;
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -19,22 +80,26 @@ public:
 	PathNode() = default;
 
 private:
-	void InitializeVerts( Vec2 const& inNormal, Vec2 const& outNormal, float width, float borderThickness, 
-		bool spin = false, int speedChange = 0, Rgba8 const& baseColor = Rgba8::WHITE, Rgba8 const& borderColor = Rgba8::BLACK );
+	void AddVerts( PathMeshBuilder& builder, Vec2 const& inNormal, Vec2 const& outNormal, float width, float borderThickness,
+		bool spin = false, int speedChange = 0 );
 
-	void Render() const;
 	void DebugRender() const;
+	void SetTiming( long long timeInTicks, int durationInTicks );
 
 public:
 	Vec2 const& GetPosition() const;
 
 private:
-	VertexBuffer* m_vbo = nullptr;
 	Vec2 m_position = Vec2::ZERO;
-	int m_vertCount = 0;
+	Vec2 m_localPosition = Vec2::ZERO;	// In its chunk's frame, which is what its verts are built in
+	float m_localAngle = 0.f;
+	int m_firstIndex = 0;				// Into its chunk's indexes
+	int m_indexCount = 0;
 
 public:
-	float m_durationInBeats = 1.f;
+	long long m_timeInTicks = 0;				// Judged against: exact, and the same on every build
+	int m_durationInTicks = TICKS_PER_BEAT;
+	float m_durationInBeats = 1.f;			// Both in beats are derived from the ticks, for drawing only
 	double m_timeInBeats = 0.f;
 	float m_speed = 1.0;
 	float m_angle = 180.f;
@@ -44,31 +109,91 @@ public:
 };
 
 
+//----------------------------------------------------------------------------------------------------------
+// A run of consecutive nodes built in a frame of their own: the node before the chunk sits at the local
+// origin, facing along +x. Because a node only depends on the nodes before it through where that node
+// is, which way it faces, its turn direction and its speed, an edit upstream of a chunk that leaves the
+// last two alone moves the whole chunk rigidly. Only its origin and rotation change; its verts don't.
+//
+struct PathChunk
+{
+	int				m_firstNodeIndex	= 0;
+	int				m_nodeCount			= 0;
+	Vec2			m_origin			= Vec2::ZERO;	// World position of the node before the chunk
+	float			m_rotationDegrees	= 0.f;			// World angle of the node before the chunk
+	bool			m_entryClockwise	= true;			// What the verts were built for
+	float			m_entrySpeed		= 1.f;
+	bool			m_needsBuild		= true;
+	bool			m_needsUpload		= true;
+	Vec2			m_quantizedMins		= Vec2::ZERO;	// A vertex is at m_quantizedMins + m_quantizedStep * ( m_x, m_y )
+	float			m_quantizedStep		= 0.f;
+
+	std::vector<PathVertex>		m_vertexes;
+	std::vector<unsigned short>	m_indexes;				// Last node first, so earlier nodes draw on top
+	VertexBuffer*	m_vbo				= nullptr;
+	IndexBuffer*	m_ibo				= nullptr;
+	size_t			m_vboByteSize		= 0;
+	size_t			m_iboByteSize		= 0;
+};
+
+
 //----------------------------------------------------------------------------------------------------------
 class Path
 {
 public:
-	Path( Conductor const& conductor );
+	Path() = default;
 	~Path();
 
+	// Loading only builds nodes and verts on the CPU, so it is safe off the main thread. The path can't
+	// render until UploadVertexBuffers() has been called on the main thread.
 	bool LoadFromFile( const char* filepath );
+	bool LoadFromXmlText( std::string const& xmlText, std::string const& filepath );
+	bool LoadCompiled( std::string const& filepath, unsigned long long chartHash );
+	bool SaveCompiled( std::string const& filepath, unsigned long long chartHash ) const;
+	bool SaveToXmlFile( std::string const& filepath ) const;
+	void UploadVertexBuffers();
 
 	void Render() const;
 	void DebugRender() const;
 
-	void AddNode( NamedStrings& arguments );
+	// Editing recompiles incrementally: the edited node's chunk is rebuilt, later chunks are re-based or,
+	// if the edit changed what they were built for, rebuilt, and only rebuilt chunks are re-uploaded.
+	// Main thread only, since it uploads.
+	void SetNodeDef( int index, PathNodeDef const& def );
+	void InsertNode( int index, PathNodeDef const& def );
+	void RemoveNode( int index );
+	PathNodeDef const& GetNodeDef( int index ) const;
+
+	void SetDifficultyOverlay( std::vector<NodeDifficulty> const& nodes );
+	void ClearDifficultyOverlay();
 
 	PathNode const* GetNode( int index ) const;
 	PathNode const* GetLastNode() const;
+	int GetNodeIndexAtTime( double timeInBeats ) const;
 	unsigned int GetNodeCount() const;
+	double GetTotalTimeInBeats() const;
+	long long GetTotalTimeInTicks() const;
 	float GetWidth() const;
+	PathMeshStats GetMeshStats() const;
+
+private:
+	void AddNode( NamedStrings& arguments );
+	int FindChunkIndex( int nodeIndex ) const;
+	void Recompile( int editedChunkIndex );
+	void BuildChunk( PathChunk& chunk, bool entryClockwise, float entrySpeed );
+	void RebaseChunk( PathChunk const& chunk );
+	void DestroyChunkBuffers( PathChunk& chunk );
+	void UpdateTimes( int firstNodeIndex );
 
 private:
-	Conductor const& m_conductor;
+	std::vector<PathNodeDef> m_nodeDefs;
 	std::vector<PathNode> m_nodes;
+	std::vector<PathChunk> m_chunks;
 	std::string m_name;
 	float m_scale = 1.f;
 	float m_pathWidth = .8f;
 
-	double m_totalTimeInBeats = 0.0;
-};
\ No newline at end of file
+	long long m_totalTimeInTicks = 0;
+
+	std::vector<NodeDifficulty> m_difficultyOverlay;	// Aggregated from run logs; empty when not shown
+};
@@ -1,8 +1,11 @@
 #include "Game/PlayerPlanets.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/FrameArena.hpp"
 #include "Game/Conductor.hpp"
 #include "Game/TapManager.hpp"
 #include "Game/Path.hpp"
+#include "Game/AllocationTracker.hpp"
+#include "Game/RenderBackend.hpp"
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/Clock.hpp"
 #include "Engine/Math/FloatRange.hpp"
@@ -20,6 +23,11 @@ PlayerPlanets::PlayerPlanets( Level& level, Conductor const& conductor, PlanetSe
 	, m_currentNodeIndex( startingIndex - 1 )
 {
 	GoToNextNode();
+	UpdatePlanetPositions();
+	for ( int planetIndex = 0; planetIndex < MAX_PLANETS; planetIndex++ )
+	{
+		m_prevPlanetPositions[planetIndex] = m_planetPositions[planetIndex];
+	}
 }
 
 
@@ -32,6 +40,32 @@ PlayerPlanets::~PlayerPlanets()
 
 //----------------------------------------------------------------------------------------------------------
 void PlayerPlanets::Update()
+{
+	ScopedAllocationBan allocationBan( "PlayerPlanets::Update while playing", m_level.IsPlaying() );
+	for ( int planetIndex = 0; planetIndex < MAX_PLANETS; planetIndex++ )
+	{
+		m_prevPlanetPositions[planetIndex] = m_planetPositions[planetIndex];
+	}
+
+	UpdateOrbit();
+	UpdatePlanetPositions();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void PlayerPlanets::LoadPlaySettings()
+{
+	m_timingWindows = TimingWindows::FromGameConfig();
+	m_overloadThreshold = g_gameConfigBlackboard.GetValue( "overloadThreshold", 5 );
+	m_isAutoplay = g_gameConfigBlackboard.GetValue( "autoplay", false );
+	m_isNofail = g_gameConfigBlackboard.GetValue( "nofail", false );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// The orbit angle follows the conductor's time this tick, then any tap due by now is judged
+//
+void PlayerPlanets::UpdateOrbit()
 {
 	if ( m_isDead )
 		return;
@@ -63,34 +97,55 @@ void PlayerPlanets::Update()
 	if ( !m_level.IsPlaying() )
 		return;
 
-	bool autoplay = g_gameConfigBlackboard.GetValue( "autoplay", false );
-	if ( autoplay && m_active )
+	long long currentTime = m_conductor.GetCurrentTimeInTicks();
+	if ( m_isAutoplay && m_active && nextNode != nullptr && nextNode->m_timeInTicks < currentTime )
 	{
-		double targetTime = nextNode->m_timeInBeats;
-		double deltaTimeToTarget = targetTime - timeInBeats;
-		if ( deltaTimeToTarget < 0.0 )
-		{
-			m_level.GetTapManager().PushTap();
-		}
+		m_level.GetTapManager().PushTap( m_level.GetTickTimeSeconds() );
 	}
 
 	if ( nextNode == nullptr )
 		return;
 
-	double targetTime = nextNode->m_timeInBeats;
-	double currentTime = m_conductor.GetCurrentTimeInBeats();
-	currentTime = m_conductor.GetCurrentTimeInBeats();
+	// Node and tap times are whole ticks, and each converts to seconds through the tempo map's integer
+	// microseconds, so the same tap stream judges bit for bit the same on every build. Judged in song
+	// seconds, so timing windows are the same width whatever the tempo at the node.
+	TempoMap const& tempoMap = m_conductor.GetTempoMap();
+	double targetTimeSeconds = tempoMap.TicksToSeconds( nextNode->m_timeInTicks );
+	double currentTimeSeconds = tempoMap.TicksToSeconds( currentTime );
+
+	// Replayed taps are judged at the exact tick they were recorded at, not at this frame's time
+	long long replayTapTime = 0;
+	while ( m_level.PopReplayTap( currentTime, replayTapTime ) )
+	{
+		double replayTapTimeSeconds = tempoMap.TicksToSeconds( replayTapTime );
+		HandleTap( GetTimingJudgment( targetTimeSeconds, replayTapTimeSeconds, m_timingWindows ), replayTapTimeSeconds - targetTimeSeconds, replayTapTime );
+
+		nextNode = GetNextNode();
+		if ( m_isDead || nextNode == nullptr )
+			return;
+
+		targetTimeSeconds = tempoMap.TicksToSeconds( nextNode->m_timeInTicks );
+	}
 
-	float beatDurationSeconds = m_conductor.GetBeatDuration();
-	double targetTimeSeconds = targetTime * beatDurationSeconds;
-	double currentTimeSeconds = currentTime * beatDurationSeconds;
+	// Live taps are judged the same way, at the tick they were made rather than the tick that took them,
+	// and recorded at that tick so playback judges them identically
+	double tapTimeSeconds = 0.0;
+	while ( m_level.GetTapManager().PopTapBy( m_level.GetTickTimeSeconds(), tapTimeSeconds ) )
+	{
+		long long tapTime = m_level.GetTapTimeInTicks( tapTimeSeconds );
+		m_level.RecordTap( tapTime );
+		double tapSongSeconds = tempoMap.TicksToSeconds( tapTime );
+		HandleTap( GetTimingJudgment( targetTimeSeconds, tapSongSeconds, m_timingWindows ), tapSongSeconds - targetTimeSeconds, tapTime );
 
-	if ( beatDurationSeconds < 0.f )
- 		return;
+		nextNode = GetNextNode();
+		if ( m_isDead || nextNode == nullptr )
+			return;
 
-	TimingJudgement judgement = GetTimingJudgment( targetTimeSeconds, currentTimeSeconds );
-	bool nofail = g_gameConfigBlackboard.GetValue( "nofail", false );
-	if ( nofail && ( judgement == TimingJudgement::DEATH || judgement == TimingJudgement::TOO_LATE ) )
+		targetTimeSeconds = tempoMap.TicksToSeconds( nextNode->m_timeInTicks );
+	}
+
+	TimingJudgement judgement = GetTimingJudgment( targetTimeSeconds, currentTimeSeconds, m_timingWindows );
+	if ( m_isNofail && ( judgement == TimingJudgement::DEATH || judgement == TimingJudgement::TOO_LATE ) )
 	{
 		m_level.ReportTimingJudgement( GetOrbitingPlanetPosition(), judgement );
 		GoToNextNode();
@@ -100,57 +155,61 @@ void PlayerPlanets::Update()
 	if ( judgement == TimingJudgement::DEATH )
 	{
 		Die();
-		return;
-	}
-
-	while ( m_level.GetTapManager().PopIfTap() )
-	{
-		HandleTap( judgement );
-
-		nextNode = GetNextNode();
-		if ( nextNode == nullptr )
-			break;
-
-		targetTime = nextNode->m_timeInBeats;
-		targetTimeSeconds = targetTime * beatDurationSeconds;
-		judgement = GetTimingJudgment( targetTimeSeconds, currentTimeSeconds );
 	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
-void PlayerPlanets::Render() const
+void PlayerPlanets::Render( PlanetsPose const& pose ) const
 {
-	if ( m_isDead )
+	if ( !pose.m_isVisible )
 		return;
 
-	Vec2 planetPositions[MAX_PLANETS];
-	planetPositions[m_currentPlanet] = m_position;
-
-	int nextPlanet = ( m_currentPlanet + 1 ) % m_planetCount;
-	float travelRadius = GetCurrentNode()->m_radius * 2;
-	Vec2 toOtherPlanet = Vec2::MakeFromPolarDegrees( m_angle, travelRadius );
-	planetPositions[nextPlanet] = m_position + toOtherPlanet;
-
-	Mesh verts;
+	Mesh& verts = g_theFrameArena->AllocateMesh();
 	for ( int planetIndex = 0; planetIndex < m_planetCount; planetIndex++ )
 	{
 		AddVertsForDisc2D( 
 			verts, 
-			planetPositions[planetIndex], 
+			pose.m_positions[planetIndex], 
 			m_settings.m_planetRadius, 
 			m_settings.m_planetColors[planetIndex],
 			32
 		);
 	}
 
-	g_theRenderer->BindTexture( nullptr );
-	g_theRenderer->BindShader( nullptr );
-	g_theRenderer->SetBlendMode( BlendMode::ALPHA );
-	g_theRenderer->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
-	g_theRenderer->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
-	g_theRenderer->SetSamplerMode( SamplerMode::POINT_CLAMP );
-	g_theRenderer->DrawVertexArray( verts );
+	g_theRenderBackend->BindTexture( nullptr );
+	g_theRenderBackend->BindShader( nullptr );
+	g_theRenderBackend->SetBlendMode( BlendMode::ALPHA );
+	g_theRenderBackend->SetDepthMode( DepthMode::READ_WRITE_LESS_EQUAL );
+	g_theRenderBackend->SetRasterizerMode( RasterizerMode::SOLID_CULL_BACK );
+	g_theRenderBackend->SetSamplerMode( SamplerMode::POINT_CLAMP );
+	g_theRenderBackend->DrawVertexArray( verts );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void PlayerPlanets::UpdatePlanetPositions()
+{
+	m_planetPositions[m_currentPlanet] = m_position;
+
+	int nextPlanet = ( m_currentPlanet + 1 ) % m_planetCount;
+	float travelRadius = GetCurrentNode()->m_radius * 2;
+	Vec2 toOtherPlanet = Vec2::MakeFromPolarDegrees( m_angle, travelRadius );
+	m_planetPositions[nextPlanet] = m_position + toOtherPlanet;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+PlanetsPose PlayerPlanets::GetPoseBetweenTicks( float fraction ) const
+{
+	PlanetsPose pose;
+	pose.m_isVisible = !m_isDead;
+	for ( int planetIndex = 0; planetIndex < MAX_PLANETS; planetIndex++ )
+	{
+		Vec2 const& prevPosition = m_prevPlanetPositions[planetIndex];
+		pose.m_positions[planetIndex] = prevPosition + ( m_planetPositions[planetIndex] - prevPosition ) * fraction;
+	}
+	return pose;
 }
 
 
@@ -169,8 +228,9 @@ void PlayerPlanets::Disable()
 
 
 //----------------------------------------------------------------------------------------------------------
-void PlayerPlanets::HandleTap( TimingJudgement judgement )
+void PlayerPlanets::HandleTap( TimingJudgement judgement, double timingErrorSeconds, long long tapTimeInTicks )
 {
+	m_level.ReportTimingError( timingErrorSeconds, judgement, tapTimeInTicks );
 	if ( IsJudgementAcceptable( judgement ) )
 	{
 		GoToNextNode();
@@ -185,8 +245,7 @@ void PlayerPlanets::HandleTap( TimingJudgement judgement )
 	else
 	{
 		m_overloadCount++;
-		int overloadThreshold = g_gameConfigBlackboard.GetValue( "overloadThreshold", 5 );
-		if ( m_overloadCount >= overloadThreshold )
+		if ( m_overloadCount >= m_overloadThreshold )
 		{
 			Overload();
 		}
@@ -269,18 +328,20 @@ Vec2 PlayerPlanets::GetOrbitingPlanetPosition() const
 
 
 //----------------------------------------------------------------------------------------------------------
+// Dying first, so the message is shown once the level has left play and may allocate again
+//
 void PlayerPlanets::Overload()
 {
-	DebugAddMessage( "OVERLOAD!!!", 1.f, Rgba8::DARK_RED, Rgba8::CYAN );
 	Die();
+	m_level.RunOnMainThread( []() { DebugAddMessage( "OVERLOAD!!!", 1.f, Rgba8::DARK_RED, Rgba8::CYAN ); } );
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void PlayerPlanets::Die()
 {
-	g_theAudio->PlayEvent( AK::EVENTS::PLAY_PLAYERDEATH );
 	m_level.GoToState( LevelState::FAIL );
+	m_level.RunOnMainThread( []() { g_theAudio->PlayEvent( AK::EVENTS::PLAY_PLAYERDEATH ); } );
 	m_isDead = true;
 	m_active = false;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Game/Level.hpp"
+#include "Game/LevelSnapshot.hpp"
 #include "Game/TimingJudgement.hpp"
 #include "Engine/Core/Rgba8.hpp"
 #include "Engine/Math/Vec2.hpp"
@@ -11,7 +12,6 @@ class Conductor;
 class PathNode;
 
 
-#define MAX_PLANETS 2	// In case I want to add three or four planet modes later
 //----------------------------------------------------------------------------------------------------------
 struct PlanetSettings
 {
@@ -29,21 +29,25 @@ public:
 	PlayerPlanets( Level& level, Conductor const& conductor, PlanetSettings const& settings, int startingIndex = 0 );
 	~PlayerPlanets();
 
-	void Update();
-	void Render() const;
+	void Update();								// One simulation tick
+	void LoadPlaySettings();					// When play starts, so judging a tap never reads the config
+	void Render( PlanetsPose const& pose ) const;
 
 	void Enable();
 	void Disable();
 
-	void HandleTap( TimingJudgement judgement );
+	void HandleTap( TimingJudgement judgement, double timingErrorSeconds, long long tapTimeInTicks );
 	void GoToNextNode();
 
 	unsigned int GetNodeIndex() const;
 	Vec2 const& GetPosition() const;
 	Vec2 const& GetPositionAhead( int nodeLookahead = 1 ) const;
 	Vec2 GetOrbitingPlanetPosition() const;
+	PlanetsPose GetPoseBetweenTicks( float fraction ) const;	// A fraction of the way from the last tick to this one
 
 private:
+	void UpdateOrbit();
+	void UpdatePlanetPositions();
 	void Overload();
 	void Die();
 
@@ -65,6 +69,14 @@ private:
 	int m_overloadCount = 0;
 	int m_judgementCounts[(int)TimingJudgement::COUNT];
 
+	TimingWindows m_timingWindows;
+	int m_overloadThreshold = 5;
+	bool m_isAutoplay = false;
+	bool m_isNofail = false;
+
+	Vec2 m_planetPositions[MAX_PLANETS];		// As of the last tick; each planet moves continuously, even when they swap
+	Vec2 m_prevPlanetPositions[MAX_PLANETS];
+
 	float m_angle = 0;	// The angle from the stationary planet to the next orbiting planet against Vec2::RIGHT
 	bool m_clockwise = true;
 	bool m_active = true;
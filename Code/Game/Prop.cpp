@@ -1,5 +1,7 @@
 #include "Game/Prop.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/AllocationTracker.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/VertexBuffer.hpp"
 #include "Engine/Renderer/IndexBuffer.hpp"
@@ -18,7 +20,7 @@ Prop::Prop( Vec2 const& position /*= Vec2::ZERO */ )
 		ERROR_AND_DIE( "ERROR: Trying to create a prop without having made the game clock first!" );
 	}
 
-	m_startTimeSeconds = clock->GetTotalSeconds();
+	m_startTimeSeconds = GetGameTimeSeconds();
 }
 
 
@@ -34,7 +36,7 @@ Prop::Prop( Vec2 const& position, Rgba8Gradient const& colorGradient, float life
 		ERROR_AND_DIE( "ERROR: Trying to create a prop without having made the game clock first!" );
 	}
 
-	m_startTimeSeconds = clock->GetTotalSeconds();
+	m_startTimeSeconds = GetGameTimeSeconds();
 }
 
 
@@ -49,14 +51,40 @@ Prop::~Prop()
 void Prop::SetRenderData( IndexedMesh const& meshToCopy, Texture* texture )
 {
 	ResetBuffers();
-	m_vertCount = g_theRenderer->CreateNewBuffersFromIndexedMesh( meshToCopy, &m_vbo, &m_ibo );
+	m_vertCount = g_theRenderBackend->CreateNewBuffersFromIndexedMesh( meshToCopy, &m_vbo, &m_ibo );
 	m_texture = texture;
+	m_ownsBuffers = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Prop::SetSharedRenderData( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int vertCount, Texture* texture )
+{
+	ResetBuffers();
+	m_vbo = vbo;
+	m_ibo = ibo;
+	m_vertCount = vertCount;
+	m_texture = texture;
+	m_ownsBuffers = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Starts the prop's lifetime over, so pooled props can be reused instead of reallocated
+//
+void Prop::Respawn( Vec2 const& position, Rgba8Gradient const& colorGradient, float lifetime )
+{
+	m_position = position;
+	m_colorGradient = colorGradient;
+	m_lifetimeSeconds = lifetime;
+	m_startTimeSeconds = GetGameTimeSeconds();
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void Prop::Render() const
 {
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::PROP );
 	if ( m_vbo == nullptr || m_ibo == nullptr )
 		return;
 
@@ -64,15 +92,15 @@ void Prop::Render() const
 	if ( clock == nullptr )
 		return;
 
-	double currentTime = clock->GetTotalSeconds();
+	double currentTime = GetGameTimeSeconds();
 	float timeSinceStart = static_cast<float>( currentTime - m_startTimeSeconds );
 	float lifetimeFraction = timeSinceStart / m_lifetimeSeconds;
 	Rgba8 color = m_colorGradient.GetColor( lifetimeFraction );
 
 	Mat44 transform = Mat44::MakeTranslation2D( m_position );
-	g_theRenderer->BindTexture( m_texture );
-	g_theRenderer->SetModelConstants( transform, color );
-	g_theRenderer->DrawIndexedVertexBuffer( m_vbo, m_ibo, m_vertCount );
+	g_theRenderBackend->BindTexture( m_texture );
+	g_theRenderBackend->SetModelConstants( transform, color );
+	g_theRenderBackend->DrawIndexedVertexBuffer( m_vbo, m_ibo, m_vertCount );
 }
 
 
@@ -89,7 +117,7 @@ bool Prop::IsGarbage() const
 	if ( clock == nullptr )
 		return true;				// If the game clock doesn't exist, we can't meaningfully track lifetimes. Default to garbage.
 
-	double currentTime = clock->GetTotalSeconds();
+	double currentTime = GetGameTimeSeconds();
 	float timeSinceStart = static_cast<float>( currentTime - m_startTimeSeconds );
 	if ( timeSinceStart > m_lifetimeSeconds )
 		return true;				// Props that have lived longer than their lifetime are garbage
@@ -101,15 +129,22 @@ bool Prop::IsGarbage() const
 //----------------------------------------------------------------------------------------------------------
 void Prop::ResetBuffers()
 {
+	if ( !m_ownsBuffers )
+	{
+		m_vbo = nullptr;
+		m_ibo = nullptr;
+		return;
+	}
+
 	if ( m_vbo != nullptr )
 	{
-		delete m_vbo;
+		g_theRenderBackend->DestroyVertexBuffer( m_vbo );
 		m_vbo = nullptr;
 	}
 
 	if ( m_ibo != nullptr )
 	{
-		delete m_ibo;
+		g_theRenderBackend->DestroyIndexBuffer( m_ibo );
 		m_ibo = nullptr;
 	}
 }
@@ -19,6 +19,8 @@ public:
 	~Prop();
 
 	void SetRenderData( IndexedMesh const& meshToCopy, Texture* texture = nullptr );
+	void SetSharedRenderData( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int vertCount, Texture* texture = nullptr );	// Buffers stay the caller's
+	void Respawn( Vec2 const& position, Rgba8Gradient const& colorGradient, float lifetime );
 	void Render() const;
 	bool IsGarbage() const;
 
@@ -33,6 +35,7 @@ private:
 	float			m_lifetimeSeconds = -1.0;	// Negative means never destroy
 	double			m_startTimeSeconds;
 	bool			m_repeatLifetime = false;
+	bool			m_ownsBuffers = true;
 
 	Vec2 m_position;
 	Rgba8Gradient m_colorGradient = Rgba8Gradient( Rgba8::WHITE, Rgba8::TRANSPARENT_WHITE );
@@ -0,0 +1,498 @@
+#include "Game/RecordingRenderBackend.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Renderer/Camera.hpp"
+#include "Engine/Renderer/Texture.hpp"
+#include <fstream>
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderFrameStats::Accumulate( RenderFrameStats const& frameStats )
+{
+	m_drawCalls				+= frameStats.m_drawCalls;
+	m_vertexesSubmitted		+= frameStats.m_vertexesSubmitted;
+	m_stateChanges			+= frameStats.m_stateChanges;
+	m_redundantStateChanges	+= frameStats.m_redundantStateChanges;
+	m_constantUpdates		+= frameStats.m_constantUpdates;
+	m_bufferCreations		+= frameStats.m_bufferCreations;
+	m_bufferUploads			+= frameStats.m_bufferUploads;
+	m_cameraPasses			+= frameStats.m_cameraPasses;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string RenderFrameStats::GetAsString() const
+{
+	return Stringf( "draws=%i verts=%i states=%i redundant=%i constants=%i buffersCreated=%i uploads=%i cameras=%i",
+		m_drawCalls, m_vertexesSubmitted, m_stateChanges, m_redundantStateChanges, m_constantUpdates, m_bufferCreations, m_bufferUploads, m_cameraPasses );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RecordingRenderBackend::RecordingRenderBackend( RenderBackend* wrappedBackend )
+	: m_wrappedBackend( wrappedBackend )
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::BeginFrame()
+{
+	m_wrappedBackend->BeginFrame();
+
+	// Traces start on a frame boundary, with names assigned fresh so two traces of the same frames match
+	if ( m_traceFramesRequested > 0 )
+	{
+		m_traceFramesLeft = m_traceFramesRequested;
+		m_traceFramesRequested = 0;
+		m_traceLines.clear();
+		m_objectNames.clear();
+		m_nextObjectID = 0;
+	}
+
+	m_frameStats = RenderFrameStats();
+	InvalidateBoundState();
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "frame %i", m_recordedFrameCount ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::EndFrame()
+{
+	m_wrappedBackend->EndFrame();
+
+	m_lastFrameStats = m_frameStats;
+	m_totalStats.Accumulate( m_frameStats );
+	m_recordedFrameCount++;
+
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  stats %s", m_frameStats.GetAsString().c_str() ) );
+		m_traceFramesLeft--;
+		if ( m_traceFramesLeft == 0 )
+		{
+			WriteTrace();
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::ClearScreen( Rgba8 const& clearColor )
+{
+	m_wrappedBackend->ClearScreen( clearColor );
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  ClearScreen %i,%i,%i,%i", clearColor.r, clearColor.g, clearColor.b, clearColor.a ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::BeginCamera( Camera const& camera )
+{
+	m_wrappedBackend->BeginCamera( camera );
+
+	// Make no assumptions about what the renderer resets per camera; the next bind of anything counts
+	InvalidateBoundState();
+	m_frameStats.m_cameraPasses++;
+
+	if ( IsRecordingTrace() )
+	{
+		AABB2 bounds = camera.GetBoundingBox();
+		AddTraceLine( Stringf( "  BeginCamera (%.2f,%.2f)-(%.2f,%.2f)", bounds.m_mins.x, bounds.m_mins.y, bounds.m_maxs.x, bounds.m_maxs.y ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::EndCamera( Camera const& camera )
+{
+	m_wrappedBackend->EndCamera( camera );
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( "  EndCamera" );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetDrawLayer( RenderLayer layer )
+{
+	m_wrappedBackend->SetDrawLayer( layer );
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  SetDrawLayer %i", static_cast<int>( layer ) ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::BindTexture( Texture const* texture )
+{
+	m_wrappedBackend->BindTexture( texture );
+	bool isRedundant = RecordStateChange( STATE_TEXTURE, reinterpret_cast<uintptr_t>( texture ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_TEXTURE, texture ? texture->GetImageFilePath().c_str() : "none", isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::BindShader( Shader* shader )
+{
+	m_wrappedBackend->BindShader( shader );
+	bool isRedundant = RecordStateChange( STATE_SHADER, reinterpret_cast<uintptr_t>( shader ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_SHADER, shader ? GetObjectName( shader, "shader" ).c_str() : "default", isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetBlendMode( BlendMode blendMode )
+{
+	m_wrappedBackend->SetBlendMode( blendMode );
+	bool isRedundant = RecordStateChange( STATE_BLEND, static_cast<uintptr_t>( blendMode ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_BLEND, Stringf( "%i", static_cast<int>( blendMode ) ).c_str(), isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetDepthMode( DepthMode depthMode )
+{
+	m_wrappedBackend->SetDepthMode( depthMode );
+	bool isRedundant = RecordStateChange( STATE_DEPTH, static_cast<uintptr_t>( depthMode ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_DEPTH, Stringf( "%i", static_cast<int>( depthMode ) ).c_str(), isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetRasterizerMode( RasterizerMode rasterizerMode )
+{
+	m_wrappedBackend->SetRasterizerMode( rasterizerMode );
+	bool isRedundant = RecordStateChange( STATE_RASTERIZER, static_cast<uintptr_t>( rasterizerMode ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_RASTERIZER, Stringf( "%i", static_cast<int>( rasterizerMode ) ).c_str(), isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetSamplerMode( SamplerMode samplerMode )
+{
+	m_wrappedBackend->SetSamplerMode( samplerMode );
+	bool isRedundant = RecordStateChange( STATE_SAMPLER, static_cast<uintptr_t>( samplerMode ) );
+	if ( IsRecordingTrace() )
+	{
+		TraceStateChange( STATE_SAMPLER, Stringf( "%i", static_cast<int>( samplerMode ) ).c_str(), isRedundant );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::SetModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor )
+{
+	m_wrappedBackend->SetModelConstants( modelToWorldTransform, modelColor );
+	m_frameStats.m_constantUpdates++;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  SetModelConstants color=%i,%i,%i,%i", modelColor.r, modelColor.g, modelColor.b, modelColor.a ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+VertexBuffer* RecordingRenderBackend::CreateVertexBuffer( size_t byteSize )
+{
+	VertexBuffer* vbo = m_wrappedBackend->CreateVertexBuffer( byteSize );
+	m_frameStats.m_bufferCreations++;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  CreateVertexBuffer %s bytes=%i", GetObjectName( vbo, "vbo" ).c_str(), static_cast<int>( byteSize ) ) );
+	}
+	return vbo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo )
+{
+	m_wrappedBackend->CopyCPUToGPU( data, byteSize, vbo );
+	m_frameStats.m_bufferUploads++;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  CopyCPUToGPU %s bytes=%i", GetObjectName( vbo, "vbo" ).c_str(), static_cast<int>( byteSize ) ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IndexBuffer* RecordingRenderBackend::CreateIndexBuffer( size_t byteSize )
+{
+	IndexBuffer* ibo = m_wrappedBackend->CreateIndexBuffer( byteSize );
+	m_frameStats.m_bufferCreations++;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  CreateIndexBuffer %s bytes=%i", GetObjectName( ibo, "ibo" ).c_str(), static_cast<int>( byteSize ) ) );
+	}
+	return ibo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo )
+{
+	m_wrappedBackend->CopyCPUToGPU( data, byteSize, ibo );
+	m_frameStats.m_bufferUploads++;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  CopyCPUToGPU %s bytes=%i", GetObjectName( ibo, "ibo" ).c_str(), static_cast<int>( byteSize ) ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int RecordingRenderBackend::CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo )
+{
+	unsigned int indexCount = m_wrappedBackend->CreateNewBuffersFromIndexedMesh( mesh, out_vbo, out_ibo );
+	m_frameStats.m_bufferCreations += 2;
+	m_frameStats.m_bufferUploads += 2;
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  CreateNewBuffersFromIndexedMesh %s %s indexes=%u", GetObjectName( *out_vbo, "vbo" ).c_str(), GetObjectName( *out_ibo, "ibo" ).c_str(), indexCount ) );
+	}
+	return indexCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DestroyVertexBuffer( VertexBuffer* vbo )
+{
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  DestroyVertexBuffer %s", GetObjectName( vbo, "vbo" ).c_str() ) );
+	}
+	m_objectNames.erase( vbo );
+	m_wrappedBackend->DestroyVertexBuffer( vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DestroyIndexBuffer( IndexBuffer* ibo )
+{
+	if ( IsRecordingTrace() )
+	{
+		AddTraceLine( Stringf( "  DestroyIndexBuffer %s", GetObjectName( ibo, "ibo" ).c_str() ) );
+	}
+	m_objectNames.erase( ibo );
+	m_wrappedBackend->DestroyIndexBuffer( ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes )
+{
+	m_wrappedBackend->DrawVertexArray( numVertexes, vertexes );
+	RecordDraw( "DrawVertexArray", numVertexes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DrawVertexArray( Mesh const& mesh )
+{
+	m_wrappedBackend->DrawVertexArray( mesh );
+	RecordDraw( "DrawVertexArray", static_cast<int>( mesh.size() ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DrawIndexedMesh( IndexedMesh const& mesh )
+{
+	m_wrappedBackend->DrawIndexedMesh( mesh );
+	RecordDraw( "DrawIndexedMesh", static_cast<int>( mesh.m_indexes.size() ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DrawVertexBuffer( VertexBuffer* vbo, int vertexCount )
+{
+	m_wrappedBackend->DrawVertexBuffer( vbo, vertexCount );
+	RecordDraw( "DrawVertexBuffer", vertexCount, vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount )
+{
+	m_wrappedBackend->DrawIndexedVertexBuffer( vbo, ibo, indexCount );
+	RecordDraw( "DrawIndexedVertexBuffer", static_cast<int>( indexCount ), vbo, ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::StartTrace( int frameCount, std::string const& traceFilePath )
+{
+	m_traceFilePath = traceFilePath;
+	m_traceFramesRequested = frameCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RecordingRenderBackend::IsTracing() const
+{
+	return m_traceFramesRequested > 0 || m_traceFramesLeft > 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderBackend* RecordingRenderBackend::GetWrappedBackend() const
+{
+	return m_wrappedBackend;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderFrameStats const& RecordingRenderBackend::GetLastFrameStats() const
+{
+	return m_lastFrameStats;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderFrameStats const& RecordingRenderBackend::GetTotalStats() const
+{
+	return m_totalStats;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int RecordingRenderBackend::GetRecordedFrameCount() const
+{
+	return m_recordedFrameCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RecordingRenderBackend::RecordStateChange( StateSlot slot, uintptr_t value )
+{
+	bool isRedundant = m_isStateKnown[slot] && m_boundState[slot] == value;
+	m_boundState[slot] = value;
+	m_isStateKnown[slot] = true;
+
+	m_frameStats.m_stateChanges++;
+	if ( isRedundant )
+	{
+		m_frameStats.m_redundantStateChanges++;
+	}
+
+	return isRedundant;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::TraceStateChange( StateSlot slot, char const* valueName, bool isRedundant )
+{
+	static char const* const s_stateCallNames[STATE_COUNT] =
+	{
+		"SetBlendMode", "SetDepthMode", "SetRasterizerMode", "SetSamplerMode", "BindShader", "BindTexture"
+	};
+
+	AddTraceLine( Stringf( "  %s %s%s", s_stateCallNames[slot], valueName, isRedundant ? " (redundant)" : "" ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::RecordDraw( char const* callName, int vertexCount, VertexBuffer* vbo, IndexBuffer* ibo )
+{
+	m_frameStats.m_drawCalls++;
+	m_frameStats.m_vertexesSubmitted += vertexCount;
+	if ( !IsRecordingTrace() )
+		return;
+
+	if ( ibo )
+	{
+		AddTraceLine( Stringf( "  %s %s %s count=%i", callName, GetObjectName( vbo, "vbo" ).c_str(), GetObjectName( ibo, "ibo" ).c_str(), vertexCount ) );
+	}
+	else if ( vbo )
+	{
+		AddTraceLine( Stringf( "  %s %s count=%i", callName, GetObjectName( vbo, "vbo" ).c_str(), vertexCount ) );
+	}
+	else
+	{
+		AddTraceLine( Stringf( "  %s count=%i", callName, vertexCount ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RecordingRenderBackend::IsRecordingTrace() const
+{
+	return m_traceFramesLeft > 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::AddTraceLine( std::string const& line )
+{
+	m_traceLines.push_back( line );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::InvalidateBoundState()
+{
+	for ( int slotIndex = 0; slotIndex < STATE_COUNT; slotIndex++ )
+	{
+		m_isStateKnown[slotIndex] = false;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RecordingRenderBackend::WriteTrace()
+{
+	std::ofstream file( m_traceFilePath );
+	if ( !file )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to write render trace \"%s\"", m_traceFilePath.c_str() ) );
+		return;
+	}
+
+	for ( std::string const& line : m_traceLines )
+	{
+		file << line << '\n';
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Wrote render trace \"%s\" (%i lines)", m_traceFilePath.c_str(), static_cast<int>( m_traceLines.size() ) ) );
+	m_traceLines.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+std::string const& RecordingRenderBackend::GetObjectName( void const* object, char const* prefix )
+{
+	// Named in order of first appearance, so the same frame traced twice gives the same names
+	auto found = m_objectNames.find( object );
+	if ( found != m_objectNames.end() )
+		return found->second;
+
+	std::string& name = m_objectNames[object];
+	name = Stringf( "%s%i", prefix, m_nextObjectID++ );
+	return name;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "Game/RenderBackend.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct RenderFrameStats
+{
+	void Accumulate( RenderFrameStats const& frameStats );
+	std::string GetAsString() const;
+
+	int m_drawCalls				= 0;
+	int m_vertexesSubmitted		= 0;	// Index count for indexed draws
+	int m_stateChanges			= 0;	// Blend, depth, rasterizer, sampler, shader and texture binds
+	int m_redundantStateChanges	= 0;	// State changes that set what was already bound
+	int m_constantUpdates		= 0;
+	int m_bufferCreations		= 0;
+	int m_bufferUploads			= 0;
+	int m_cameraPasses			= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Wraps another backend, forwarding every call unchanged while counting draws, state changes and
+// buffer traffic per frame. Optionally records a text trace of every call; pointers are replaced by
+// names that are stable between runs, so traces from two builds can be diffed directly.
+//
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	explicit RecordingRenderBackend( RenderBackend* wrappedBackend );
+
+	void BeginFrame() override;
+	void EndFrame() override;
+
+	void ClearScreen( Rgba8 const& clearColor ) override;
+	void BeginCamera( Camera const& camera ) override;
+	void EndCamera( Camera const& camera ) override;
+	void SetDrawLayer( RenderLayer layer ) override;
+
+	void BindTexture( Texture const* texture ) override;
+	void BindShader( Shader* shader ) override;
+	void SetBlendMode( BlendMode blendMode ) override;
+	void SetDepthMode( DepthMode depthMode ) override;
+	void SetRasterizerMode( RasterizerMode rasterizerMode ) override;
+	void SetSamplerMode( SamplerMode samplerMode ) override;
+	void SetModelConstants( Mat44 const& modelToWorldTransform = Mat44(), Rgba8 const& modelColor = Rgba8::WHITE ) override;
+
+	VertexBuffer* CreateVertexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo ) override;
+	IndexBuffer* CreateIndexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo ) override;
+	unsigned int CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo ) override;
+	void DestroyVertexBuffer( VertexBuffer* vbo ) override;
+	void DestroyIndexBuffer( IndexBuffer* ibo ) override;
+
+	void DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes ) override;
+	void DrawVertexArray( Mesh const& mesh ) override;
+	void DrawIndexedMesh( IndexedMesh const& mesh ) override;
+	void DrawVertexBuffer( VertexBuffer* vbo, int vertexCount ) override;
+	void DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount ) override;
+
+	void StartTrace( int frameCount, std::string const& traceFilePath );
+	bool IsTracing() const;
+
+	RenderBackend* GetWrappedBackend() const;
+	RenderFrameStats const& GetLastFrameStats() const;
+	RenderFrameStats const& GetTotalStats() const;
+	int GetRecordedFrameCount() const;
+
+private:
+	enum StateSlot
+	{
+		STATE_BLEND,
+		STATE_DEPTH,
+		STATE_RASTERIZER,
+		STATE_SAMPLER,
+		STATE_SHADER,
+		STATE_TEXTURE,
+		STATE_COUNT
+	};
+
+	// Stats are counted on every call; trace text and object names are only built while a trace is recording
+	bool RecordStateChange( StateSlot slot, uintptr_t value );
+	void TraceStateChange( StateSlot slot, char const* valueName, bool isRedundant );
+	void RecordDraw( char const* callName, int vertexCount, VertexBuffer* vbo = nullptr, IndexBuffer* ibo = nullptr );
+	bool IsRecordingTrace() const;
+	void AddTraceLine( std::string const& line );
+	void InvalidateBoundState();
+	void WriteTrace();
+	std::string const& GetObjectName( void const* object, char const* prefix );
+
+private:
+	RenderBackend*		m_wrappedBackend = nullptr;
+	RenderFrameStats	m_frameStats;
+	RenderFrameStats	m_lastFrameStats;
+	RenderFrameStats	m_totalStats;
+	int					m_recordedFrameCount = 0;
+
+	uintptr_t	m_boundState[STATE_COUNT]	= {};
+	bool		m_isStateKnown[STATE_COUNT]	= {};
+
+	std::unordered_map<void const*, std::string> m_objectNames;
+	int m_nextObjectID = 0;
+
+	std::vector<std::string>	m_traceLines;
+	std::string					m_traceFilePath;
+	int							m_traceFramesRequested = 0;
+	int							m_traceFramesLeft = 0;
+};
@@ -0,0 +1,65 @@
+#include "Game/RedrawThrottle.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+void RedrawThrottle::Configure( double maxRedrawHz, double refreshIntervalSeconds )
+{
+	m_minRedrawIntervalSeconds = maxRedrawHz > 0.0 ? 1.0 / maxRedrawHz : 0.0;
+	m_refreshIntervalSeconds = refreshIntervalSeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RedrawThrottle::RequestRedraw()
+{
+	m_isRedrawRequested = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RedrawThrottle::RequestAnimationFrame()
+{
+	m_isAnimating = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RedrawThrottle::ShouldDrawFrame( double currentTimeSeconds )
+{
+	m_frameCount++;
+	double secondsSinceDraw = currentTimeSeconds - m_lastDrawTimeSeconds;
+	bool isDrawWanted = m_isRedrawRequested || m_isAnimating || secondsSinceDraw >= m_refreshIntervalSeconds;
+	m_isAnimating = false;
+
+	if ( !isDrawWanted || secondsSinceDraw < m_minRedrawIntervalSeconds )
+	{
+		m_skippedFrameCount++;
+		return false;
+	}
+
+	m_isRedrawRequested = false;
+	m_lastDrawTimeSeconds = currentTimeSeconds;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RedrawThrottle::ResetFrameCounts()
+{
+	m_frameCount = 0;
+	m_skippedFrameCount = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int RedrawThrottle::GetFrameCount() const
+{
+	return m_frameCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int RedrawThrottle::GetSkippedFrameCount() const
+{
+	return m_skippedFrameCount;
+}
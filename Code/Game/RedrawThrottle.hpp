@@ -0,0 +1,31 @@
+#pragma once
+
+
+//----------------------------------------------------------------------------------------------------------
+// Decides which frames of a mostly static screen are worth drawing. Input or a change draws a frame, and
+// so does anything animating, but never more often than the cap. Otherwise one frame is drawn every
+// refresh interval, so nothing can stay stale for long.
+//
+class RedrawThrottle
+{
+public:
+	void Configure( double maxRedrawHz, double refreshIntervalSeconds );
+
+	void RequestRedraw();				// Kept until a frame is drawn
+	void RequestAnimationFrame();		// Only for this frame
+
+	bool ShouldDrawFrame( double currentTimeSeconds );		// Once a frame
+	void ResetFrameCounts();
+
+	unsigned int GetFrameCount() const;
+	unsigned int GetSkippedFrameCount() const;
+
+private:
+	double			m_minRedrawIntervalSeconds	= 1.0 / 30.0;
+	double			m_refreshIntervalSeconds	= 1.0;
+	double			m_lastDrawTimeSeconds		= -1.0e9;
+	bool			m_isRedrawRequested			= true;
+	bool			m_isAnimating				= false;
+	unsigned int	m_frameCount				= 0;
+	unsigned int	m_skippedFrameCount			= 0;
+};
@@ -0,0 +1,159 @@
+#include "Game/RenderBackend.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Renderer/Renderer.hpp"
+#include "Engine/Renderer/VertexBuffer.hpp"
+#include "Engine/Renderer/IndexBuffer.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::ClearScreen( Rgba8 const& clearColor )
+{
+	g_theRenderer->ClearScreen( clearColor );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::BeginCamera( Camera const& camera )
+{
+	g_theRenderer->BeginCamera( camera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::EndCamera( Camera const& camera )
+{
+	g_theRenderer->EndCamera( camera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::BindTexture( Texture const* texture )
+{
+	g_theRenderer->BindTexture( texture );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::BindShader( Shader* shader )
+{
+	g_theRenderer->BindShader( shader );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::SetBlendMode( BlendMode blendMode )
+{
+	g_theRenderer->SetBlendMode( blendMode );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::SetDepthMode( DepthMode depthMode )
+{
+	g_theRenderer->SetDepthMode( depthMode );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::SetRasterizerMode( RasterizerMode rasterizerMode )
+{
+	g_theRenderer->SetRasterizerMode( rasterizerMode );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::SetSamplerMode( SamplerMode samplerMode )
+{
+	g_theRenderer->SetSamplerMode( samplerMode );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::SetModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor )
+{
+	g_theRenderer->SetModelConstants( modelToWorldTransform, modelColor );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+VertexBuffer* GpuRenderBackend::CreateVertexBuffer( size_t byteSize )
+{
+	return g_theRenderer->CreateVertexBuffer( byteSize );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo )
+{
+	g_theRenderer->CopyCPUToGPU( data, byteSize, vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IndexBuffer* GpuRenderBackend::CreateIndexBuffer( size_t byteSize )
+{
+	return g_theRenderer->CreateIndexBuffer( byteSize );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo )
+{
+	g_theRenderer->CopyCPUToGPU( data, byteSize, ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int GpuRenderBackend::CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo )
+{
+	return g_theRenderer->CreateNewBuffersFromIndexedMesh( mesh, out_vbo, out_ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DestroyVertexBuffer( VertexBuffer* vbo )
+{
+	delete vbo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DestroyIndexBuffer( IndexBuffer* ibo )
+{
+	delete ibo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes )
+{
+	g_theRenderer->DrawVertexArray( numVertexes, vertexes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DrawVertexArray( Mesh const& mesh )
+{
+	g_theRenderer->DrawVertexArray( mesh );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DrawIndexedMesh( IndexedMesh const& mesh )
+{
+	g_theRenderer->DrawIndexedMesh( mesh );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DrawVertexBuffer( VertexBuffer* vbo, int vertexCount )
+{
+	g_theRenderer->DrawVertexBuffer( vbo, vertexCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void GpuRenderBackend::DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount )
+{
+	g_theRenderer->DrawIndexedVertexBuffer( vbo, ibo, indexCount );
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Engine/Renderer/Renderer.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+
+
+//----------------------------------------------------------------------------------------------------------
+class Camera;
+class Texture;
+class Shader;
+class VertexBuffer;
+class IndexBuffer;
+struct IndexedMesh;
+struct Vertex_PCU;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Painter's order between groups of draws within one camera pass. Backends that batch or reorder
+// draws only do so within a layer; layers always render in this order.
+enum class RenderLayer
+{
+	BACKGROUND,
+	WORLD,
+	ACTORS,
+	EFFECTS,
+	UI,
+	TEXT,
+	COUNT
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// The subset of Renderer calls the game layer draws through. Gameplay and UI code talks to
+// g_theRenderBackend rather than g_theRenderer so that draws can be redirected to a CPU rasterizer
+// (replay export, render tests) without touching the calling code.
+//
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void BeginFrame() {}
+	virtual void EndFrame() {}
+
+	virtual void ClearScreen( Rgba8 const& clearColor ) = 0;
+	virtual void BeginCamera( Camera const& camera ) = 0;
+	virtual void EndCamera( Camera const& camera ) = 0;
+	virtual void SetDrawLayer( RenderLayer layer ) { UNUSED( layer ); }
+
+	virtual void BindTexture( Texture const* texture ) = 0;
+	virtual void BindShader( Shader* shader ) = 0;
+	virtual void SetBlendMode( BlendMode blendMode ) = 0;
+	virtual void SetDepthMode( DepthMode depthMode ) = 0;
+	virtual void SetRasterizerMode( RasterizerMode rasterizerMode ) = 0;
+	virtual void SetSamplerMode( SamplerMode samplerMode ) = 0;
+	virtual void SetModelConstants( Mat44 const& modelToWorldTransform = Mat44(), Rgba8 const& modelColor = Rgba8::WHITE ) = 0;
+
+	virtual VertexBuffer* CreateVertexBuffer( size_t byteSize ) = 0;
+	virtual void CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo ) = 0;
+	virtual IndexBuffer* CreateIndexBuffer( size_t byteSize ) = 0;
+	virtual void CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo ) = 0;	// 32-bit indexes
+	virtual unsigned int CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo ) = 0;
+	virtual void DestroyVertexBuffer( VertexBuffer* vbo ) = 0;
+	virtual void DestroyIndexBuffer( IndexBuffer* ibo ) = 0;
+
+	virtual void DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes ) = 0;
+	virtual void DrawVertexArray( Mesh const& mesh ) = 0;
+	virtual void DrawIndexedMesh( IndexedMesh const& mesh ) = 0;
+	virtual void DrawVertexBuffer( VertexBuffer* vbo, int vertexCount ) = 0;
+	virtual void DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount ) = 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Forwards everything straight to g_theRenderer. This is the backend used during normal play.
+//
+class GpuRenderBackend : public RenderBackend
+{
+public:
+	void ClearScreen( Rgba8 const& clearColor ) override;
+	void BeginCamera( Camera const& camera ) override;
+	void EndCamera( Camera const& camera ) override;
+
+	void BindTexture( Texture const* texture ) override;
+	void BindShader( Shader* shader ) override;
+	void SetBlendMode( BlendMode blendMode ) override;
+	void SetDepthMode( DepthMode depthMode ) override;
+	void SetRasterizerMode( RasterizerMode rasterizerMode ) override;
+	void SetSamplerMode( SamplerMode samplerMode ) override;
+	void SetModelConstants( Mat44 const& modelToWorldTransform = Mat44(), Rgba8 const& modelColor = Rgba8::WHITE ) override;
+
+	VertexBuffer* CreateVertexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo ) override;
+	IndexBuffer* CreateIndexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo ) override;
+	unsigned int CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo ) override;
+	void DestroyVertexBuffer( VertexBuffer* vbo ) override;
+	void DestroyIndexBuffer( IndexBuffer* ibo ) override;
+
+	void DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes ) override;
+	void DrawVertexArray( Mesh const& mesh ) override;
+	void DrawIndexedMesh( IndexedMesh const& mesh ) override;
+	void DrawVertexBuffer( VertexBuffer* vbo, int vertexCount ) override;
+	void DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount ) override;
+};
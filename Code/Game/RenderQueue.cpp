@@ -0,0 +1,486 @@
+#include "Game/RenderQueue.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Sort key layout, most significant first. The segment keeps blended draws in submission order: it
+// advances around every alpha-blended draw, so only runs of unblended draws between them are grouped.
+// Shader and texture rebinds are the expensive ones, so they group ahead of the fixed-function modes.
+//   layer:4 | segment:12 | shader:12 | texture:16 | blend:4 | depth:4 | rasterizer:4 | sampler:4 | unused:4
+//
+constexpr int	SORT_SHIFT_LAYER		= 60;
+constexpr int	SORT_SHIFT_SEGMENT		= 48;
+constexpr int	SORT_SHIFT_SHADER		= 36;
+constexpr int	SORT_SHIFT_TEXTURE		= 20;
+constexpr int	SORT_SHIFT_BLEND		= 16;
+constexpr int	SORT_SHIFT_DEPTH		= 12;
+constexpr int	SORT_SHIFT_RASTERIZER	= 8;
+constexpr int	SORT_SHIFT_SAMPLER		= 4;
+constexpr uint16_t MAX_SEGMENT			= 0x0FFF;
+constexpr uint16_t MAX_SHADER_ID		= 0x0FFF;
+constexpr uint16_t MAX_TEXTURE_ID		= 0xFFFF;
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RenderQueue::RenderState::operator==( RenderState const& other ) const
+{
+	return m_blendMode == other.m_blendMode
+		&& m_depthMode == other.m_depthMode
+		&& m_rasterizerMode == other.m_rasterizerMode
+		&& m_samplerMode == other.m_samplerMode
+		&& m_shader == other.m_shader
+		&& m_texture == other.m_texture;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderQueue::RenderQueue( RenderBackend* wrappedBackend )
+	: m_wrappedBackend( wrappedBackend )
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::BeginFrame()
+{
+	m_wrappedBackend->BeginFrame();
+
+	m_shaderIDs.clear();
+	m_textureIDs.clear();
+	InvalidateEmittedState();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::EndFrame()
+{
+	// Anything drawn outside a camera pass still has to land before the frame is presented
+	Flush();
+	m_wrappedBackend->EndFrame();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::ClearScreen( Rgba8 const& clearColor )
+{
+	Flush();
+	m_wrappedBackend->ClearScreen( clearColor );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::BeginCamera( Camera const& camera )
+{
+	Flush();
+	m_wrappedBackend->BeginCamera( camera );
+
+	// Match what the backends reset per camera, so a pass never inherits the last pass's draw settings
+	m_pendingLayer = RenderLayer::BACKGROUND;
+	m_pendingState = RenderState();
+	m_pendingModelToWorldTransform = Mat44();
+	m_pendingModelColor = Rgba8::WHITE;
+	InvalidateEmittedState();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::EndCamera( Camera const& camera )
+{
+	Flush();
+	m_wrappedBackend->EndCamera( camera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetDrawLayer( RenderLayer layer )
+{
+	m_pendingLayer = layer;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::BindTexture( Texture const* texture )
+{
+	m_pendingState.m_texture = texture;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::BindShader( Shader* shader )
+{
+	m_pendingState.m_shader = shader;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetBlendMode( BlendMode blendMode )
+{
+	m_pendingState.m_blendMode = blendMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetDepthMode( DepthMode depthMode )
+{
+	m_pendingState.m_depthMode = depthMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetRasterizerMode( RasterizerMode rasterizerMode )
+{
+	m_pendingState.m_rasterizerMode = rasterizerMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetSamplerMode( SamplerMode samplerMode )
+{
+	m_pendingState.m_samplerMode = samplerMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor )
+{
+	m_pendingModelToWorldTransform = modelToWorldTransform;
+	m_pendingModelColor = modelColor;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+VertexBuffer* RenderQueue::CreateVertexBuffer( size_t byteSize )
+{
+	return m_wrappedBackend->CreateVertexBuffer( byteSize );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo )
+{
+	// Queued draws reading this buffer must see its old contents
+	Flush();
+	m_wrappedBackend->CopyCPUToGPU( data, byteSize, vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IndexBuffer* RenderQueue::CreateIndexBuffer( size_t byteSize )
+{
+	return m_wrappedBackend->CreateIndexBuffer( byteSize );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo )
+{
+	Flush();
+	m_wrappedBackend->CopyCPUToGPU( data, byteSize, ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int RenderQueue::CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo )
+{
+	return m_wrappedBackend->CreateNewBuffersFromIndexedMesh( mesh, out_vbo, out_ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DestroyVertexBuffer( VertexBuffer* vbo )
+{
+	Flush();
+	m_wrappedBackend->DestroyVertexBuffer( vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DestroyIndexBuffer( IndexBuffer* ibo )
+{
+	Flush();
+	m_wrappedBackend->DestroyIndexBuffer( ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes )
+{
+	if ( numVertexes <= 0 )
+	{
+		return;
+	}
+
+	// Callers build these meshes on the stack, so the vertexes are copied rather than referenced
+	QueuedDraw& draw = AddQueuedDraw( DrawType::VERTEX_ARRAY );
+	draw.m_firstVertex = static_cast<int>( m_vertexStorage.size() );
+	draw.m_count = numVertexes;
+	m_vertexStorage.insert( m_vertexStorage.end(), vertexes, vertexes + numVertexes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DrawVertexArray( Mesh const& mesh )
+{
+	DrawVertexArray( static_cast<int>( mesh.size() ), mesh.data() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DrawIndexedMesh( IndexedMesh const& mesh )
+{
+	if ( mesh.m_indexes.empty() )
+	{
+		return;
+	}
+
+	QueuedDraw& draw = AddQueuedDraw( DrawType::INDEXED_MESH );
+	draw.m_firstVertex = static_cast<int>( m_vertexStorage.size() );
+	draw.m_vertexCount = static_cast<int>( mesh.m_vertexes.size() );
+	draw.m_firstIndex = static_cast<int>( m_indexStorage.size() );
+	draw.m_count = static_cast<int>( mesh.m_indexes.size() );
+	m_vertexStorage.insert( m_vertexStorage.end(), mesh.m_vertexes.begin(), mesh.m_vertexes.end() );
+	m_indexStorage.insert( m_indexStorage.end(), mesh.m_indexes.begin(), mesh.m_indexes.end() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DrawVertexBuffer( VertexBuffer* vbo, int vertexCount )
+{
+	QueuedDraw& draw = AddQueuedDraw( DrawType::VERTEX_BUFFER );
+	draw.m_vbo = vbo;
+	draw.m_count = vertexCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount )
+{
+	QueuedDraw& draw = AddQueuedDraw( DrawType::INDEXED_VERTEX_BUFFER );
+	draw.m_vbo = vbo;
+	draw.m_ibo = ibo;
+	draw.m_count = static_cast<int>( indexCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::Flush()
+{
+	if ( m_queuedDraws.empty() )
+	{
+		return;
+	}
+
+	// Sequence breaks ties, which makes this a stable sort without std::stable_sort's extra buffer
+	std::sort( m_queuedDraws.begin(), m_queuedDraws.end(), []( QueuedDraw const& a, QueuedDraw const& b )
+	{
+		if ( a.m_sortKey != b.m_sortKey )
+		{
+			return a.m_sortKey < b.m_sortKey;
+		}
+		return a.m_sequence < b.m_sequence;
+	} );
+
+	RenderLayer currentLayer = RenderLayer::COUNT;
+	for ( QueuedDraw const& draw : m_queuedDraws )
+	{
+		if ( draw.m_layer != currentLayer )
+		{
+			currentLayer = draw.m_layer;
+			m_wrappedBackend->SetDrawLayer( currentLayer );
+		}
+		EmitState( draw.m_state );
+		EmitModelConstants( draw.m_modelToWorldTransform, draw.m_modelColor );
+		SubmitDraw( draw );
+	}
+
+	m_queuedDraws.clear();
+	m_vertexStorage.clear();
+	m_indexStorage.clear();
+	m_nextSequence = 0;
+	m_nextSegment = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderBackend* RenderQueue::GetWrappedBackend() const
+{
+	return m_wrappedBackend;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SetWrappedBackend( RenderBackend* wrappedBackend )
+{
+	Flush();
+	m_wrappedBackend = wrappedBackend;
+	InvalidateEmittedState();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+RenderQueue::QueuedDraw& RenderQueue::AddQueuedDraw( DrawType type )
+{
+	// A blended draw takes a segment of its own, fencing it off from the draws on either side. Running
+	// out of segments just submits what is queued so far, which keeps the order correct.
+	bool isBlended = m_pendingState.m_blendMode == BlendMode::ALPHA;
+	if ( isBlended && m_nextSegment + 2 > MAX_SEGMENT )
+	{
+		Flush();
+	}
+
+	uint16_t segment = m_nextSegment;
+	if ( isBlended )
+	{
+		segment = ++m_nextSegment;
+		m_nextSegment++;
+	}
+
+	m_queuedDraws.emplace_back();
+	QueuedDraw& draw = m_queuedDraws.back();
+	draw.m_type = type;
+	draw.m_sequence = m_nextSequence++;
+	draw.m_layer = m_pendingLayer;
+	draw.m_state = m_pendingState;
+	draw.m_modelToWorldTransform = m_pendingModelToWorldTransform;
+	draw.m_modelColor = m_pendingModelColor;
+	draw.m_sortKey = GetSortKey( m_pendingLayer, segment, m_pendingState );
+	return draw;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+uint64_t RenderQueue::GetSortKey( RenderLayer layer, uint16_t segment, RenderState const& state )
+{
+	uint64_t shaderID = std::min( GetFrameLocalID( state.m_shader, m_shaderIDs ), MAX_SHADER_ID );
+	uint64_t textureID = std::min( GetFrameLocalID( state.m_texture, m_textureIDs ), MAX_TEXTURE_ID );
+
+	uint64_t key = 0;
+	key |= static_cast<uint64_t>( layer ) << SORT_SHIFT_LAYER;
+	key |= static_cast<uint64_t>( segment ) << SORT_SHIFT_SEGMENT;
+	key |= shaderID << SORT_SHIFT_SHADER;
+	key |= textureID << SORT_SHIFT_TEXTURE;
+	key |= ( static_cast<uint64_t>( state.m_blendMode ) & 0xF ) << SORT_SHIFT_BLEND;
+	key |= ( static_cast<uint64_t>( state.m_depthMode ) & 0xF ) << SORT_SHIFT_DEPTH;
+	key |= ( static_cast<uint64_t>( state.m_rasterizerMode ) & 0xF ) << SORT_SHIFT_RASTERIZER;
+	key |= ( static_cast<uint64_t>( state.m_samplerMode ) & 0xF ) << SORT_SHIFT_SAMPLER;
+	return key;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Null (default shader, untextured) is always 0. IDs past the key field width share its last value,
+// which costs only sorting quality, never correctness.
+//
+uint16_t RenderQueue::GetFrameLocalID( void const* object, std::unordered_map<void const*, uint16_t>& ids )
+{
+	if ( object == nullptr )
+	{
+		return 0;
+	}
+
+	auto found = ids.find( object );
+	if ( found != ids.end() )
+	{
+		return found->second;
+	}
+
+	uint16_t newID = static_cast<uint16_t>( std::min( ids.size() + 1, static_cast<size_t>( MAX_TEXTURE_ID ) ) );
+	ids[object] = newID;
+	return newID;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::EmitState( RenderState const& state )
+{
+	bool isKnown = m_isEmittedStateKnown;
+	if ( !isKnown || state.m_blendMode != m_emittedState.m_blendMode )
+	{
+		m_wrappedBackend->SetBlendMode( state.m_blendMode );
+	}
+	if ( !isKnown || state.m_depthMode != m_emittedState.m_depthMode )
+	{
+		m_wrappedBackend->SetDepthMode( state.m_depthMode );
+	}
+	if ( !isKnown || state.m_rasterizerMode != m_emittedState.m_rasterizerMode )
+	{
+		m_wrappedBackend->SetRasterizerMode( state.m_rasterizerMode );
+	}
+	if ( !isKnown || state.m_samplerMode != m_emittedState.m_samplerMode )
+	{
+		m_wrappedBackend->SetSamplerMode( state.m_samplerMode );
+	}
+	if ( !isKnown || state.m_shader != m_emittedState.m_shader )
+	{
+		m_wrappedBackend->BindShader( state.m_shader );
+	}
+	if ( !isKnown || state.m_texture != m_emittedState.m_texture )
+	{
+		m_wrappedBackend->BindTexture( state.m_texture );
+	}
+
+	m_emittedState = state;
+	m_isEmittedStateKnown = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::EmitModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor )
+{
+	if ( m_areEmittedConstantsKnown
+		&& std::memcmp( &modelToWorldTransform, &m_emittedModelToWorldTransform, sizeof( Mat44 ) ) == 0
+		&& modelColor == m_emittedModelColor )
+	{
+		return;
+	}
+
+	m_wrappedBackend->SetModelConstants( modelToWorldTransform, modelColor );
+	m_emittedModelToWorldTransform = modelToWorldTransform;
+	m_emittedModelColor = modelColor;
+	m_areEmittedConstantsKnown = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::SubmitDraw( QueuedDraw const& draw )
+{
+	switch ( draw.m_type )
+	{
+		case DrawType::VERTEX_ARRAY:
+		{
+			m_wrappedBackend->DrawVertexArray( draw.m_count, m_vertexStorage.data() + draw.m_firstVertex );
+			break;
+		}
+		case DrawType::INDEXED_MESH:
+		{
+			Vertex_PCU const* firstVertex = m_vertexStorage.data() + draw.m_firstVertex;
+			unsigned int const* firstIndex = m_indexStorage.data() + draw.m_firstIndex;
+			m_scratchMesh.m_vertexes.assign( firstVertex, firstVertex + draw.m_vertexCount );
+			m_scratchMesh.m_indexes.assign( firstIndex, firstIndex + draw.m_count );
+			m_wrappedBackend->DrawIndexedMesh( m_scratchMesh );
+			break;
+		}
+		case DrawType::VERTEX_BUFFER:
+		{
+			m_wrappedBackend->DrawVertexBuffer( draw.m_vbo, draw.m_count );
+			break;
+		}
+		case DrawType::INDEXED_VERTEX_BUFFER:
+		{
+			m_wrappedBackend->DrawIndexedVertexBuffer( draw.m_vbo, draw.m_ibo, static_cast<unsigned int>( draw.m_count ) );
+			break;
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RenderQueue::InvalidateEmittedState()
+{
+	m_isEmittedStateKnown = false;
+	m_areEmittedConstantsKnown = false;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "Game/RenderBackend.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/Mat44.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Sits in front of another backend and defers every draw until the end of its camera pass. Draws are
+// then sorted by layer and render state and submitted with only the state binds that actually differ
+// from what is already bound. Sorting never crosses a layer boundary, and an alpha-blended draw is
+// never moved past any other draw, so blended content composites exactly as it was submitted.
+//
+class RenderQueue : public RenderBackend
+{
+public:
+	explicit RenderQueue( RenderBackend* wrappedBackend );
+
+	void BeginFrame() override;
+	void EndFrame() override;
+
+	void ClearScreen( Rgba8 const& clearColor ) override;
+	void BeginCamera( Camera const& camera ) override;
+	void EndCamera( Camera const& camera ) override;
+	void SetDrawLayer( RenderLayer layer ) override;
+
+	void BindTexture( Texture const* texture ) override;
+	void BindShader( Shader* shader ) override;
+	void SetBlendMode( BlendMode blendMode ) override;
+	void SetDepthMode( DepthMode depthMode ) override;
+	void SetRasterizerMode( RasterizerMode rasterizerMode ) override;
+	void SetSamplerMode( SamplerMode samplerMode ) override;
+	void SetModelConstants( Mat44 const& modelToWorldTransform = Mat44(), Rgba8 const& modelColor = Rgba8::WHITE ) override;
+
+	VertexBuffer* CreateVertexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo ) override;
+	IndexBuffer* CreateIndexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo ) override;
+	unsigned int CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo ) override;
+	void DestroyVertexBuffer( VertexBuffer* vbo ) override;
+	void DestroyIndexBuffer( IndexBuffer* ibo ) override;
+
+	void DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes ) override;
+	void DrawVertexArray( Mesh const& mesh ) override;
+	void DrawIndexedMesh( IndexedMesh const& mesh ) override;
+	void DrawVertexBuffer( VertexBuffer* vbo, int vertexCount ) override;
+	void DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount ) override;
+
+	void Flush();
+
+	RenderBackend* GetWrappedBackend() const;
+	void SetWrappedBackend( RenderBackend* wrappedBackend );
+
+private:
+	struct RenderState
+	{
+		bool operator==( RenderState const& other ) const;
+
+		BlendMode		m_blendMode			= BlendMode::ALPHA;
+		DepthMode		m_depthMode			= DepthMode::DISABLED;
+		RasterizerMode	m_rasterizerMode	= RasterizerMode::SOLID_CULL_BACK;
+		SamplerMode		m_samplerMode		= SamplerMode::POINT_CLAMP;
+		Shader*			m_shader			= nullptr;
+		Texture const*	m_texture			= nullptr;
+	};
+
+	enum class DrawType
+	{
+		VERTEX_ARRAY,
+		INDEXED_MESH,
+		VERTEX_BUFFER,
+		INDEXED_VERTEX_BUFFER
+	};
+
+	struct QueuedDraw
+	{
+		uint64_t		m_sortKey			= 0;
+		int				m_sequence			= 0;
+		RenderLayer		m_layer				= RenderLayer::BACKGROUND;
+		RenderState		m_state;
+		Mat44			m_modelToWorldTransform;
+		Rgba8			m_modelColor		= Rgba8::WHITE;
+		DrawType		m_type				= DrawType::VERTEX_ARRAY;
+		int				m_firstVertex		= 0;	// Into m_vertexStorage for CPU-side draws
+		int				m_firstIndex		= 0;	// Into m_indexStorage for indexed meshes
+		int				m_count				= 0;	// Vertexes, or indexes for indexed draws
+		int				m_vertexCount		= 0;	// Vertexes copied for an indexed mesh
+		VertexBuffer*	m_vbo				= nullptr;
+		IndexBuffer*	m_ibo				= nullptr;
+	};
+
+	QueuedDraw& AddQueuedDraw( DrawType type );
+	uint64_t GetSortKey( RenderLayer layer, uint16_t segment, RenderState const& state );
+	uint16_t GetFrameLocalID( void const* object, std::unordered_map<void const*, uint16_t>& ids );
+	void EmitState( RenderState const& state );
+	void EmitModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor );
+	void SubmitDraw( QueuedDraw const& draw );
+	void InvalidateEmittedState();
+
+private:
+	RenderBackend*	m_wrappedBackend = nullptr;
+
+	// What the game has asked for; captured into each draw as it is queued
+	RenderLayer		m_pendingLayer = RenderLayer::BACKGROUND;
+	RenderState		m_pendingState;
+	Mat44			m_pendingModelToWorldTransform;
+	Rgba8			m_pendingModelColor = Rgba8::WHITE;
+
+	// What has actually been sent to the wrapped backend in this camera pass
+	RenderState		m_emittedState;
+	bool			m_isEmittedStateKnown = false;
+	Mat44			m_emittedModelToWorldTransform;
+	Rgba8			m_emittedModelColor = Rgba8::WHITE;
+	bool			m_areEmittedConstantsKnown = false;
+
+	std::vector<QueuedDraw>		m_queuedDraws;
+	std::vector<Vertex_PCU>		m_vertexStorage;
+	std::vector<unsigned int>	m_indexStorage;
+	IndexedMesh					m_scratchMesh;
+	int							m_nextSequence = 0;
+	uint16_t					m_nextSegment = 0;
+
+	// Numbered in order of first use each frame so the sort order does not depend on heap addresses
+	std::unordered_map<void const*, uint16_t>	m_shaderIDs;
+	std::unordered_map<void const*, uint16_t>	m_textureIDs;
+};
@@ -0,0 +1,254 @@
+#include "Game/RenderTest.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/App.hpp"
+#include "Game/Game.hpp"
+#include "Game/Button.hpp"
+#include "Game/Replay.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/SoftwareRenderBackend.hpp"
+#include "Game/FrameArena.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <cfloat>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr double RENDER_TEST_FIXED_DELTA_SECONDS = 1.0 / 60.0;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct RenderTestScene
+{
+	std::string		m_name;
+	GameState		m_state				= GameState::ATTRACT;
+	unsigned int	m_levelIndex		= 0;
+	int				m_framesToSimulate	= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Swaps in the software backend and a freshly loaded Game for as long as it lives
+class SoftwareGameScope
+{
+public:
+	explicit SoftwareGameScope( IntVec2 const& dimensions )
+	{
+		m_backend = new SoftwareRenderBackend( dimensions );
+		m_previousBackend = g_theRenderBackend;
+		g_theRenderBackend = m_backend;
+
+		// The temporary game subscribes and later unsubscribes the shared button handler
+		UnsubscribeEventCallbackFunction( BUTTON_PRESS_EVENT_NAME, Game::RecieveButtonPressEvent );
+		m_previousGame = g_theApp->m_theGame;
+		g_theApp->m_theGame = new Game();
+	}
+
+	~SoftwareGameScope()
+	{
+		delete g_theApp->m_theGame;
+		g_theApp->m_theGame = m_previousGame;
+		SubscribeEventCallbackFunction( BUTTON_PRESS_EVENT_NAME, Game::RecieveButtonPressEvent );
+
+		g_theRenderBackend = m_previousBackend;
+		delete m_backend;
+	}
+
+	Game& GetGame() const { return *g_theApp->m_theGame; }
+	SoftwareRenderBackend& GetBackend() const { return *m_backend; }
+
+private:
+	SoftwareRenderBackend*	m_backend			= nullptr;
+	RenderBackend*			m_previousBackend	= nullptr;
+	Game*					m_previousGame		= nullptr;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+static std::vector<RenderTestScene> GetRenderTestScenes( Game const& game )
+{
+	std::vector<RenderTestScene> scenes;
+	scenes.push_back( { "attract", GameState::ATTRACT, 0, 0 } );
+	scenes.push_back( { "level_select", GameState::LEVEL_SELECT, 0, 0 } );
+
+	for ( unsigned int levelIndex = 0; levelIndex < game.GetLevelCount(); levelIndex++ )
+	{
+		std::string levelName = std::filesystem::path( game.GetLevelFilePath( levelIndex ) ).stem().string();
+		scenes.push_back( { Stringf( "%s_countdown", levelName.c_str() ), GameState::GAMEPLAY, levelIndex, 0 } );
+		scenes.push_back( { Stringf( "%s_2s", levelName.c_str() ), GameState::GAMEPLAY, levelIndex, 120 } );
+	}
+
+	return scenes;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void PrepareScene( Game& game, RenderTestScene const& scene )
+{
+	if ( scene.m_state != GameState::GAMEPLAY )
+	{
+		game.GoToState( scene.m_state );
+		return;
+	}
+
+	// An empty replay gives a deterministic, input-free run on the fixed timestep
+	Replay replay;
+	replay.Reset( game.GetLevelFilePath( scene.m_levelIndex ), game.GetLevel( scene.m_levelIndex ).GetChartHash(), 0, 0.0 );
+	game.BeginReplayPlayback( replay, RENDER_TEST_FIXED_DELTA_SECONDS );
+	for ( int frameIndex = 0; frameIndex < scene.m_framesToSimulate; frameIndex++ )
+	{
+		game.Update();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static bool LoadGoldenTGA( std::string const& filepath, IntVec2 const& expectedDimensions, std::vector<Rgba8>& out_pixels )
+{
+	std::ifstream file( filepath, std::ios::binary );
+	if ( !file )
+		return false;
+
+	// Only the format SoftwareRenderBackend::WriteFrameToTGA produces: uncompressed, 32bpp, top-left origin
+	unsigned char header[18] = {};
+	file.read( reinterpret_cast<char*>( header ), sizeof( header ) );
+	int width = header[12] | ( header[13] << 8 );
+	int height = header[14] | ( header[15] << 8 );
+	if ( !file || header[2] != 2 || header[16] != 32 || width != expectedDimensions.x || height != expectedDimensions.y )
+		return false;
+
+	file.seekg( header[0], std::ios::cur );
+	out_pixels.resize( static_cast<size_t>( width ) * height );
+	for ( Rgba8& pixel : out_pixels )
+	{
+		unsigned char bgra[4];
+		file.read( reinterpret_cast<char*>( bgra ), sizeof( bgra ) );
+		pixel = Rgba8( bgra[2], bgra[1], bgra[0], bgra[3] );
+	}
+
+	return static_cast<bool>( file );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static int CountBadPixels( Rgba8 const* actual, std::vector<Rgba8> const& expected, int channelTolerance )
+{
+	int badPixelCount = 0;
+	for ( size_t pixelIndex = 0; pixelIndex < expected.size(); pixelIndex++ )
+	{
+		Rgba8 const& a = actual[pixelIndex];
+		Rgba8 const& e = expected[pixelIndex];
+		if ( abs( a.r - e.r ) > channelTolerance || abs( a.g - e.g ) > channelTolerance ||
+			 abs( a.b - e.b ) > channelTolerance || abs( a.a - e.a ) > channelTolerance )
+		{
+			badPixelCount++;
+		}
+	}
+
+	return badPixelCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int RunRenderGoldenTests( RenderTestSettings const& settings )
+{
+	std::error_code error;
+	std::filesystem::create_directories( settings.m_updateGoldens ? settings.m_goldenFolder : settings.m_outputFolder, error );
+
+	SoftwareGameScope scope( settings.m_dimensions );
+	Game& game = scope.GetGame();
+	SoftwareRenderBackend& backend = scope.GetBackend();
+
+	int failureCount = 0;
+	std::vector<RenderTestScene> scenes = GetRenderTestScenes( game );
+	for ( RenderTestScene const& scene : scenes )
+	{
+		PrepareScene( game, scene );
+		g_theFrameArena->BeginFrame();
+		game.Render();
+
+		std::string goldenFilePath = Stringf( "%s/%s.tga", settings.m_goldenFolder.c_str(), scene.m_name.c_str() );
+		if ( settings.m_updateGoldens )
+		{
+			backend.WriteFrameToTGA( goldenFilePath.c_str() );
+			g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "Updated golden \"%s\"", goldenFilePath.c_str() ) );
+			continue;
+		}
+
+		// A missing golden fails like a wrong one; only update=true records new goldens
+		bool hasGolden = std::filesystem::exists( goldenFilePath );
+		std::vector<Rgba8> goldenPixels;
+		int badPixelCount = -1;
+		if ( hasGolden && LoadGoldenTGA( goldenFilePath, settings.m_dimensions, goldenPixels ) )
+		{
+			badPixelCount = CountBadPixels( backend.GetColorBuffer(), goldenPixels, settings.m_channelTolerance );
+		}
+
+		if ( badPixelCount >= 0 && badPixelCount <= settings.m_maxBadPixels )
+		{
+			g_theDevConsole->AddLine( DevConsole::INFO_MINOR, Stringf( "PASS %s", scene.m_name.c_str() ) );
+			continue;
+		}
+
+		failureCount++;
+		std::string actualFilePath = Stringf( "%s/%s_actual.tga", settings.m_outputFolder.c_str(), scene.m_name.c_str() );
+		backend.WriteFrameToTGA( actualFilePath.c_str() );
+		if ( !hasGolden )
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "FAIL %s: no golden \"%s\", wrote \"%s\"", scene.m_name.c_str(), goldenFilePath.c_str(), actualFilePath.c_str() ) );
+		}
+		else if ( badPixelCount < 0 )
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "FAIL %s: unreadable or mismatched golden \"%s\"", scene.m_name.c_str(), goldenFilePath.c_str() ) );
+		}
+		else
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "FAIL %s: %i pixels differ, wrote \"%s\"", scene.m_name.c_str(), badPixelCount, actualFilePath.c_str() ) );
+		}
+	}
+
+	game.GoToState( GameState::ATTRACT );
+	g_theDevConsole->AddLine( failureCount == 0 ? DevConsole::INFO_MAJOR : DevConsole::WARNING,
+		Stringf( "Render tests: %i of %i scenes passed (tolerance %i, max bad pixels %i)", static_cast<int>( scenes.size() ) - failureCount,
+		static_cast<int>( scenes.size() ), settings.m_channelTolerance, settings.m_maxBadPixels ) );
+	return failureCount;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RunRenderBenchmark( IntVec2 const& dimensions, int frameCount )
+{
+	SoftwareGameScope scope( dimensions );
+	Game& game = scope.GetGame();
+	if ( game.GetLevelCount() == 0 || frameCount <= 0 )
+		return;
+
+	// Mid-level gameplay is the heaviest scene: path, planets, props and HUD text all on screen
+	RenderTestScene benchmarkScene = { "benchmark", GameState::GAMEPLAY, 0, 240 };
+	PrepareScene( game, benchmarkScene );
+
+	double totalSeconds = 0.0;
+	double fastestSeconds = DBL_MAX;
+	double slowestSeconds = 0.0;
+	for ( int frameIndex = 0; frameIndex < frameCount; frameIndex++ )
+	{
+		double startTime = GetCurrentTimeSeconds();
+		g_theFrameArena->BeginFrame();
+		game.Render();
+		double frameSeconds = GetCurrentTimeSeconds() - startTime;
+
+		totalSeconds += frameSeconds;
+		fastestSeconds = frameSeconds < fastestSeconds ? frameSeconds : fastestSeconds;
+		slowestSeconds = frameSeconds > slowestSeconds ? frameSeconds : slowestSeconds;
+	}
+
+	game.GoToState( GameState::ATTRACT );
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Software render %ix%i over %i frames: avg %.3fms, min %.3fms, max %.3fms",
+		dimensions.x, dimensions.y, frameCount, 1000.0 * totalSeconds / frameCount, 1000.0 * fastestSeconds, 1000.0 * slowestSeconds ) );
+}
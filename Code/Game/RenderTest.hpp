@@ -0,0 +1,26 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <string>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct RenderTestSettings
+{
+	std::string	m_goldenFolder		= "Data/RenderTests";
+	std::string	m_outputFolder		= "Saved/RenderTests";
+	IntVec2		m_dimensions		= IntVec2( 1600, 800 );
+	int			m_channelTolerance	= 2;		// Per-channel difference still treated as a match
+	int			m_maxBadPixels		= 0;
+	bool		m_updateGoldens		= false;	// Overwrite the goldens with this run instead of comparing
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Golden-image tests and benchmarks for the software backend, so the game's render paths can be checked
+// without depending on any GPU's output. They still need the app's window, D3D renderer and audio, since
+// textures, fonts and sounds load through them; the software backend re-reads textures from their files.
+// Scenes render through a temporary Game built while the software backend is installed, which
+// guarantees every vertex buffer has a CPU-side copy to draw from.
+//
+int RunRenderGoldenTests( RenderTestSettings const& settings );	// Returns the number of failing scenes
+void RunRenderBenchmark( IntVec2 const& dimensions, int frameCount );
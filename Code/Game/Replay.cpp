@@ -0,0 +1,140 @@
+#include "Game/Replay.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/ContentHash.hpp"
+#include "Game/TempoMap.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+
+//----------------------------------------------------------------------------------------------------------
+void Replay::Reset( std::string const& levelFilePath, unsigned long long chartHash, unsigned int checkpointNodeIndex, double inputDelaySeconds )
+{
+	m_levelFilePath = levelFilePath;
+	m_chartHash = chartHash;
+	m_checkpointNodeIndex = checkpointNodeIndex;
+	m_inputDelaySeconds = inputDelaySeconds;
+	m_tapTimesInTicks.clear();
+	m_inputDelayChanges.clear();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Doubles rather than growing by exactly the headroom, so a long attempt regrows only a handful of times
+//
+void Replay::ReserveHeadroom( size_t tapCount, size_t inputDelayChangeCount )
+{
+	if ( m_tapTimesInTicks.capacity() - m_tapTimesInTicks.size() < tapCount )
+	{
+		m_tapTimesInTicks.reserve( std::max( m_tapTimesInTicks.capacity() * 2, m_tapTimesInTicks.size() + tapCount ) );
+	}
+
+	if ( m_inputDelayChanges.capacity() - m_inputDelayChanges.size() < inputDelayChangeCount )
+	{
+		m_inputDelayChanges.reserve( std::max( m_inputDelayChanges.capacity() * 2, m_inputDelayChanges.size() + inputDelayChangeCount ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Replay::RecordTap( long long timeInTicks )
+{
+	m_tapTimesInTicks.push_back( timeInTicks );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void Replay::RecordInputDelayChange( long long timeInTicks, double inputDelaySeconds )
+{
+	ReplayInputDelayChange& change = m_inputDelayChanges.emplace_back();
+	change.m_timeInTicks = timeInTicks;
+	change.m_inputDelaySeconds = inputDelaySeconds;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Replay::SaveToFile( char const* filepath ) const
+{
+	XmlDocument document;
+	XmlElement* rootElement = document.NewElement( "Replay" );
+	rootElement->SetAttribute( "level", m_levelFilePath.c_str() );
+	rootElement->SetAttribute( "chart", GetContentHashString( m_chartHash ).c_str() );
+	rootElement->SetAttribute( "checkpoint", m_checkpointNodeIndex );
+	rootElement->SetAttribute( "inputDelaySeconds", Stringf( "%.17g", m_inputDelaySeconds ).c_str() );
+	document.InsertFirstChild( rootElement );
+
+	for ( long long tapTime : m_tapTimesInTicks )
+	{
+		XmlElement* tapElement = document.NewElement( "Tap" );
+		tapElement->SetAttribute( "tick", tapTime );
+		rootElement->InsertEndChild( tapElement );
+	}
+
+	for ( ReplayInputDelayChange const& change : m_inputDelayChanges )
+	{
+		XmlElement* changeElement = document.NewElement( "InputDelay" );
+		changeElement->SetAttribute( "tick", change.m_timeInTicks );
+		changeElement->SetAttribute( "seconds", Stringf( "%.17g", change.m_inputDelaySeconds ).c_str() );
+		rootElement->InsertEndChild( changeElement );
+	}
+
+	return document.SaveFile( filepath ) == tinyxml2::XML_SUCCESS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool Replay::LoadFromFile( char const* filepath )
+{
+	XmlDocument document;
+	if ( document.LoadFile( filepath ) != tinyxml2::XML_SUCCESS )
+		return false;
+
+	XmlElement const* rootElement = document.RootElement();
+	if ( rootElement == nullptr )
+		return false;
+
+	NamedStrings replayArgs;
+	replayArgs.PopulateFromXmlElementAttributes( *rootElement );
+	unsigned long long chartHash = std::strtoull( replayArgs.GetValue( "chart", "0" ).c_str(), nullptr, 16 );
+	Reset( replayArgs.GetValue( "level", "" ), chartHash, replayArgs.GetValue( "checkpoint", 0 ), replayArgs.GetValue( "inputDelaySeconds", 0.0 ) );
+
+	m_tapTimesInTicks.reserve( rootElement->ChildElementCount( "Tap" ) );
+	XmlElement const* tapElement = rootElement->FirstChildElement( "Tap" );
+	while ( tapElement != nullptr )
+	{
+		m_tapTimesInTicks.push_back( ParseTimeInTicks( *tapElement ) );
+		tapElement = tapElement->NextSiblingElement( "Tap" );
+	}
+
+	XmlElement const* changeElement = rootElement->FirstChildElement( "InputDelay" );
+	while ( changeElement != nullptr )
+	{
+		RecordInputDelayChange( ParseTimeInTicks( *changeElement ), changeElement->DoubleAttribute( "seconds", 0.0 ) );
+		changeElement = changeElement->NextSiblingElement( "InputDelay" );
+	}
+
+	return !m_levelFilePath.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+long long Replay::GetEndTimeInTicks() const
+{
+	if ( m_tapTimesInTicks.empty() )
+		return 0;
+
+	return m_tapTimesInTicks.back();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+/*static*/long long Replay::ParseTimeInTicks( XmlElement const& element )
+{
+	if ( element.Attribute( "tick" ) != nullptr )
+		return element.Int64Attribute( "tick", 0 );
+
+	return TempoMap::BeatsToTicks( element.DoubleAttribute( "beat", 0.0 ) );
+}
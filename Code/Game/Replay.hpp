@@ -0,0 +1,43 @@
+#pragma once
+#include "Engine/Core/XmlUtils.hpp"
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct ReplayInputDelayChange
+{
+	long long m_timeInTicks			= 0;
+	double m_inputDelaySeconds		= 0.0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every tap the player made during one attempt, stored as the conductor tick the tap was judged at.
+// Playing these back against the same level reproduces the attempt's judgements exactly. Replays from
+// before ticks stored beats, which load rounded to the nearest tick.
+//
+class Replay
+{
+public:
+	void Reset( std::string const& levelFilePath, unsigned long long chartHash, unsigned int checkpointNodeIndex, double inputDelaySeconds );
+	void RecordTap( long long timeInTicks );
+	void RecordInputDelayChange( long long timeInTicks, double inputDelaySeconds );
+	void ReserveHeadroom( size_t tapCount, size_t inputDelayChangeCount );	// So recording while playing never has to grow
+
+	bool SaveToFile( char const* filepath ) const;
+	bool LoadFromFile( char const* filepath );
+
+	long long GetEndTimeInTicks() const;
+
+private:
+	static long long ParseTimeInTicks( XmlElement const& element );
+
+public:
+	std::string			m_levelFilePath;
+	unsigned long long	m_chartHash				= 0;	// Level::GetChartHash() when recorded; 0 in replays older than the hash
+	unsigned int		m_checkpointNodeIndex	= 0;
+	double				m_inputDelaySeconds		= 0.0;
+	std::vector<long long>	m_tapTimesInTicks;
+	std::vector<ReplayInputDelayChange>	m_inputDelayChanges;	// Adaptive nudges made during the attempt
+};
@@ -0,0 +1,252 @@
+#define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
+#include <windows.h>			// Only needed here for spawning worker processes
+
+#include "Game/ReplayExporter.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/App.hpp"
+#include "Game/Game.hpp"
+#include "Game/RenderBackend.hpp"
+#include "Game/SoftwareRenderBackend.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <filesystem>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int MAX_EXPORT_FRAMES = 60 * 60 * 240;	// An hour at 240fps; guards against a replay that never ends
+
+
+//----------------------------------------------------------------------------------------------------------
+ReplayExporter::ReplayExporter( ReplayExportConfig const& config )
+	: m_config( config )
+{
+	// Installed before the game loads any levels so every path buffer gets a CPU copy
+	m_softwareBackend = new SoftwareRenderBackend( m_config.m_dimensions );
+	m_previousBackend = g_theRenderBackend;
+	g_theRenderBackend = m_softwareBackend;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ReplayExporter::~ReplayExporter()
+{
+	Shutdown();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ReplayExporter::Startup()
+{
+	if ( !m_replay.LoadFromFile( m_config.m_replayFilePath.c_str() ) )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to load replay \"%s\"", m_config.m_replayFilePath.c_str() ) );
+		m_isFinished = true;
+		return;
+	}
+
+	// Reproduce the timing conditions the replay was recorded under; the level applies the replay's own
+	// input delay to its conductor
+	g_gameConfigBlackboard.SetValue( "autoplay", "false" );
+
+	std::error_code error;
+	std::filesystem::create_directories( m_config.m_outputFolder, error );
+
+	if ( m_config.m_workerCount > 1 )
+	{
+		SpawnWorkers( CountFrames() );
+		return;
+	}
+
+	double fixedDeltaSeconds = 1.0 / m_config.m_framesPerSecond;
+	if ( !g_theApp->m_theGame->BeginReplayPlayback( m_replay, fixedDeltaSeconds ) )
+	{
+		m_isFinished = true;
+		return;
+	}
+
+	m_frameIndex = 0;
+	m_tailFramesLeft = RoundDownToInt( static_cast<float>( m_config.m_tailSeconds * m_config.m_framesPerSecond ) );
+
+	if ( m_config.m_format == "raw" )
+	{
+		std::string rawFilePath = Stringf( "%s/frames_%06i.rgba", m_config.m_outputFolder.c_str(), m_config.m_firstFrame );
+		m_rawFile.open( rawFilePath, std::ios::binary );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ReplayExporter::RunFrame()
+{
+	if ( m_isFinished )
+		return;
+
+	if ( !m_workerProcesses.empty() )
+	{
+		m_isFinished = PollWorkers();
+		return;
+	}
+
+	Game* game = g_theApp->m_theGame;
+	game->Update();
+
+	// Frames before this worker's range are simulated but never rasterized
+	if ( m_frameIndex >= m_config.m_firstFrame )
+	{
+		game->Render();
+		WriteFrame( m_frameIndex );
+	}
+
+	m_frameIndex++;
+
+	if ( m_config.m_endFrame >= 0 && m_frameIndex >= m_config.m_endFrame )
+	{
+		m_isFinished = true;
+	}
+	else if ( game->IsReplayPlaybackFinished() )
+	{
+		m_isFinished = ( m_tailFramesLeft <= 0 );
+		m_tailFramesLeft--;
+	}
+	else if ( m_frameIndex >= MAX_EXPORT_FRAMES )
+	{
+		m_isFinished = true;
+	}
+
+	if ( m_isFinished )
+	{
+		g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Exported frames %i to %i", m_config.m_firstFrame, m_frameIndex ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ReplayExporter::Shutdown()
+{
+	for ( void* workerProcess : m_workerProcesses )
+	{
+		CloseHandle( static_cast<HANDLE>( workerProcess ) );
+	}
+	m_workerProcesses.clear();
+
+	if ( m_rawFile.is_open() )
+	{
+		m_rawFile.close();
+	}
+
+	if ( m_softwareBackend != nullptr )
+	{
+		g_theRenderBackend = m_previousBackend;
+		delete m_softwareBackend;
+		m_softwareBackend = nullptr;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool ReplayExporter::IsFinished() const
+{
+	return m_isFinished;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int ReplayExporter::CountFrames()
+{
+	// Simulation alone is cheap, so the coordinator plays the whole replay once to find its length
+	Game* game = g_theApp->m_theGame;
+	double fixedDeltaSeconds = 1.0 / m_config.m_framesPerSecond;
+	if ( !game->BeginReplayPlayback( m_replay, fixedDeltaSeconds ) )
+		return 0;
+
+	int frameCount = 0;
+	while ( !game->IsReplayPlaybackFinished() && frameCount < MAX_EXPORT_FRAMES )
+	{
+		game->Update();
+		frameCount++;
+	}
+
+	game->GoToState( GameState::LEVEL_SELECT );
+	return frameCount + RoundDownToInt( static_cast<float>( m_config.m_tailSeconds * m_config.m_framesPerSecond ) ) + 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ReplayExporter::SpawnWorkers( int totalFrameCount )
+{
+	char executablePath[MAX_PATH];
+	GetModuleFileNameA( nullptr, executablePath, MAX_PATH );
+
+	int workerCount = m_config.m_workerCount;
+	int framesPerWorker = ( totalFrameCount + workerCount - 1 ) / workerCount;
+	for ( int workerIndex = 0; workerIndex < workerCount; workerIndex++ )
+	{
+		int firstFrame = workerIndex * framesPerWorker;
+		int endFrame = firstFrame + framesPerWorker;
+		if ( endFrame > totalFrameCount )
+		{
+			endFrame = totalFrameCount;
+		}
+
+		if ( firstFrame >= endFrame )
+			break;
+
+		std::string commandLine = Stringf( "\"%s\" export=\"%s\" exportOut=\"%s\" exportFormat=%s exportWidth=%i exportHeight=%i exportFps=%f exportTail=%f exportStart=%i exportEnd=%i exportWorkers=1",
+			executablePath, m_config.m_replayFilePath.c_str(), m_config.m_outputFolder.c_str(), m_config.m_format.c_str(),
+			m_config.m_dimensions.x, m_config.m_dimensions.y, m_config.m_framesPerSecond, m_config.m_tailSeconds, firstFrame, endFrame );
+
+		STARTUPINFOA startupInfo = {};
+		startupInfo.cb = sizeof( startupInfo );
+		PROCESS_INFORMATION processInfo = {};
+		BOOL success = CreateProcessA( nullptr, &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo );
+		if ( !success )
+		{
+			g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Failed to start export worker for frames %i to %i", firstFrame, endFrame ) );
+			continue;
+		}
+
+		CloseHandle( processInfo.hThread );
+		m_workerProcesses.push_back( processInfo.hProcess );
+	}
+
+	g_theDevConsole->AddLine( DevConsole::INFO_MAJOR, Stringf( "Exporting %i frames across %i workers", totalFrameCount, static_cast<int>( m_workerProcesses.size() ) ) );
+	if ( m_workerProcesses.empty() )
+	{
+		m_isFinished = true;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool ReplayExporter::PollWorkers()
+{
+	for ( int workerIndex = static_cast<int>( m_workerProcesses.size() ) - 1; workerIndex >= 0; workerIndex-- )
+	{
+		HANDLE workerProcess = static_cast<HANDLE>( m_workerProcesses[workerIndex] );
+		if ( WaitForSingleObject( workerProcess, 0 ) != WAIT_OBJECT_0 )
+			continue;
+
+		CloseHandle( workerProcess );
+		m_workerProcesses.erase( m_workerProcesses.begin() + workerIndex );
+	}
+
+	return m_workerProcesses.empty();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ReplayExporter::WriteFrame( int frameIndex )
+{
+	if ( m_config.m_format == "raw" )
+	{
+		IntVec2 const& dimensions = m_softwareBackend->GetDimensions();
+		size_t frameBytes = static_cast<size_t>( dimensions.x ) * dimensions.y * sizeof( Rgba8 );
+		m_rawFile.write( reinterpret_cast<char const*>( m_softwareBackend->GetColorBuffer() ), frameBytes );
+		return;
+	}
+
+	std::string frameFilePath = Stringf( "%s/frame_%06i.tga", m_config.m_outputFolder.c_str(), frameIndex );
+	m_softwareBackend->WriteFrameToTGA( frameFilePath.c_str() );
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Game/Replay.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+class SoftwareRenderBackend;
+class RenderBackend;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct ReplayExportConfig
+{
+	std::string	m_replayFilePath;
+	std::string	m_outputFolder		= "Saved/Export";
+	std::string	m_format			= "tga";	// "tga" writes an image sequence, "raw" a single RGBA8 stream
+	IntVec2		m_dimensions		= IntVec2( 1600, 800 );
+	double		m_framesPerSecond	= 60.0;
+	double		m_tailSeconds		= 2.0;		// Keeps rendering this long after the level is won or failed
+	int			m_firstFrame		= 0;
+	int			m_endFrame			= -1;		// Exclusive; negative renders until the replay is over
+	int			m_workerCount		= 1;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Plays a recorded Replay back at a fixed timestep and renders every frame through the software
+// backend to disk. With more than one worker, the timeline is split into contiguous frame ranges
+// and each range is exported by a child process running this same executable.
+//
+class ReplayExporter
+{
+public:
+	explicit ReplayExporter( ReplayExportConfig const& config );
+	~ReplayExporter();
+
+	void Startup();
+	void RunFrame();
+	void Shutdown();
+
+	bool IsFinished() const;
+
+private:
+	int CountFrames();
+	void SpawnWorkers( int totalFrameCount );
+	bool PollWorkers();
+	void WriteFrame( int frameIndex );
+
+private:
+	ReplayExportConfig		m_config;
+	Replay					m_replay;
+	SoftwareRenderBackend*	m_softwareBackend	= nullptr;
+	RenderBackend*			m_previousBackend	= nullptr;
+	std::ofstream			m_rawFile;
+	std::vector<void*>		m_workerProcesses;
+	int						m_frameIndex		= 0;
+	int						m_tailFramesLeft	= 0;
+	bool					m_isFinished		= false;
+};
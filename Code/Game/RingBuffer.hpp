@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Queues values from one writer thread to one reader thread without either side ever waiting. Each side
+// only advances its own index, and only after its slot is written or read, so the other side never sees a
+// half-written value. A full buffer refuses the push rather than overwrite what the reader hasn't taken.
+//
+template<typename T, int CAPACITY>
+class RingBuffer
+{
+public:
+	void Reset();						// Only while neither thread is using it
+
+	bool Push( T const& value );		// Writer only
+	bool Pop( T& out_value );			// Reader only
+
+private:
+	static_assert( ( CAPACITY & ( CAPACITY - 1 ) ) == 0, "RingBuffer capacity must be a power of two" );
+	static constexpr unsigned int INDEX_MASK = CAPACITY - 1;
+
+	T							m_slots[CAPACITY] = {};
+	std::atomic<unsigned int>	m_writeCount	= 0;	// Only the writer advances this
+	std::atomic<unsigned int>	m_readCount		= 0;	// Only the reader advances this
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T, int CAPACITY>
+void RingBuffer<T, CAPACITY>::Reset()
+{
+	m_writeCount.store( 0 );
+	m_readCount.store( 0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T, int CAPACITY>
+bool RingBuffer<T, CAPACITY>::Push( T const& value )
+{
+	unsigned int writeCount = m_writeCount.load( std::memory_order_relaxed );
+	if ( writeCount - m_readCount.load( std::memory_order_acquire ) >= static_cast<unsigned int>( CAPACITY ) )
+		return false;
+
+	m_slots[writeCount & INDEX_MASK] = value;
+	m_writeCount.store( writeCount + 1, std::memory_order_release );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T, int CAPACITY>
+bool RingBuffer<T, CAPACITY>::Pop( T& out_value )
+{
+	unsigned int readCount = m_readCount.load( std::memory_order_relaxed );
+	if ( readCount == m_writeCount.load( std::memory_order_acquire ) )
+		return false;
+
+	out_value = m_slots[readCount & INDEX_MASK];
+	m_readCount.store( readCount + 1, std::memory_order_release );
+	return true;
+}
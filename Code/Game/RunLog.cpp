@@ -0,0 +1,320 @@
+#include "Game/RunLog.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int RUN_LOG_READ_CHUNK_ENTRIES = 512;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct NodeRunCounters
+{
+	unsigned int	m_reachCount		= 0;
+	unsigned int	m_deathCount		= 0;
+	unsigned int	m_tapCount			= 0;
+	unsigned int	m_missCount			= 0;
+	double			m_hitErrorSumMs		= 0.0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Everything one aggregation thread accumulates; merged into the result once every thread has joined
+//
+struct RunLogWorkerResult
+{
+	std::vector<NodeRunCounters>	m_counters;
+	unsigned int		m_runCount			= 0;
+	unsigned int		m_skippedFileCount	= 0;
+	unsigned long long	m_tapCount			= 0;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+void RunLog::Reset( std::string const& levelFilePath, unsigned long long chartHash, unsigned int nodeCount, unsigned int startNodeIndex )
+{
+	m_header = RunLogHeader();
+	m_header.m_levelHash = HashLevelName( levelFilePath );
+	m_header.m_chartHash = chartHash;
+	m_header.m_nodeCount = nodeCount;
+	m_header.m_startNodeIndex = startNodeIndex;
+	m_header.m_endNodeIndex = startNodeIndex;
+
+	m_entries.clear();
+	m_entries.reserve( 2 * static_cast<size_t>( nodeCount ) + 16 );		// A tap per node, plus misses
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RunLog::ReserveHeadroom( size_t entryCount )
+{
+	if ( m_entries.capacity() - m_entries.size() < entryCount )
+	{
+		m_entries.reserve( std::max( m_entries.capacity() * 2, m_entries.size() + entryCount ) );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RunLog::RecordTap( double timeInBeats, unsigned int nodeIndex, double timingErrorSeconds, TimingJudgement judgement )
+{
+	if ( !IsRecording() || nodeIndex >= m_header.m_nodeCount )
+		return;
+
+	double errorTenthsMs = std::clamp( round( timingErrorSeconds * 10000.0 ), -32767.0, 32767.0 );
+
+	RunLogEntry& entry = m_entries.emplace_back();
+	entry.m_timeInBeats = static_cast<float>( timeInBeats );
+	entry.m_nodeIndex = nodeIndex;
+	entry.m_errorTenthsMs = static_cast<short>( errorTenthsMs );
+	entry.m_judgement = static_cast<unsigned char>( judgement );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void RunLog::Finish( RunOutcome outcome, unsigned int endNodeIndex )
+{
+	if ( !IsRecording() )
+		return;
+
+	m_header.m_outcome = outcome;
+	m_header.m_endNodeIndex = std::min( endNodeIndex, m_header.m_nodeCount - 1 );
+	m_header.m_entryCount = static_cast<unsigned int>( m_entries.size() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RunLog::IsRecording() const
+{
+	return m_header.m_nodeCount > 0 && m_header.m_outcome == RunOutcome::IN_PROGRESS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool RunLog::SaveToFile( std::string const& filepath ) const
+{
+	std::ofstream file( filepath, std::ios::out | std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+		return false;
+
+	file.write( reinterpret_cast<char const*>( &m_header ), sizeof( RunLogHeader ) );
+	file.write( reinterpret_cast<char const*>( m_entries.data() ), m_entries.size() * sizeof( RunLogEntry ) );
+	return file.good();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Streams one log into the counters a chunk at a time. The size is checked against the header before
+// anything is counted, so a truncated log is skipped whole instead of half-counted.
+//
+static bool AccumulateRunLog( std::filesystem::path const& filepath, unsigned long long levelHash, unsigned long long chartHash, unsigned int nodeCount,
+	RunLogEntry* entryBuffer, RunLogWorkerResult& result )
+{
+	std::ifstream file( filepath, std::ios::in | std::ios::binary );
+	if ( !file.is_open() )
+		return false;
+
+	RunLogHeader header;
+	if ( !file.read( reinterpret_cast<char*>( &header ), sizeof( RunLogHeader ) ) )
+		return false;
+
+	RunLogHeader const expectedHeader;
+	if ( memcmp( header.m_magic, expectedHeader.m_magic, sizeof( header.m_magic ) ) != 0 || header.m_version != RUN_LOG_VERSION )
+		return false;
+
+	if ( header.m_levelHash != levelHash || header.m_chartHash != chartHash || header.m_nodeCount != nodeCount || header.m_endNodeIndex >= nodeCount )
+		return false;
+
+	if ( header.m_outcome == RunOutcome::IN_PROGRESS )
+		return false;
+
+	std::error_code error;
+	unsigned long long expectedSize = sizeof( RunLogHeader ) + static_cast<unsigned long long>( header.m_entryCount ) * sizeof( RunLogEntry );
+	if ( std::filesystem::file_size( filepath, error ) != expectedSize || error )
+		return false;
+
+	std::vector<NodeRunCounters>& counters = result.m_counters;
+	for ( unsigned int nodeIndex = header.m_startNodeIndex + 1; nodeIndex <= header.m_endNodeIndex; nodeIndex++ )
+	{
+		counters[nodeIndex].m_reachCount++;
+	}
+
+	if ( header.m_outcome == RunOutcome::FAILED )
+	{
+		counters[header.m_endNodeIndex].m_deathCount++;
+	}
+
+	unsigned int entriesLeft = header.m_entryCount;
+	while ( entriesLeft > 0 )
+	{
+		unsigned int chunkEntries = std::min( entriesLeft, static_cast<unsigned int>( RUN_LOG_READ_CHUNK_ENTRIES ) );
+		if ( !file.read( reinterpret_cast<char*>( entryBuffer ), chunkEntries * sizeof( RunLogEntry ) ) )
+			break;
+
+		for ( unsigned int entryIndex = 0; entryIndex < chunkEntries; entryIndex++ )
+		{
+			RunLogEntry const& entry = entryBuffer[entryIndex];
+			if ( entry.m_nodeIndex >= nodeCount )
+				continue;
+
+			NodeRunCounters& node = counters[entry.m_nodeIndex];
+			node.m_tapCount++;
+			if ( IsJudgementAcceptable( static_cast<TimingJudgement>( entry.m_judgement ) ) )
+			{
+				node.m_hitErrorSumMs += entry.m_errorTenthsMs * 0.1;
+			}
+			else
+			{
+				node.m_missCount++;
+			}
+		}
+		entriesLeft -= chunkEntries;
+		result.m_tapCount += chunkEntries;
+	}
+
+	result.m_runCount++;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Files are handed out one at a time through an atomic cursor, so a few long logs never leave a thread
+// idle, and each thread counts into its own per-node arrays with no locking until the final merge.
+//
+bool AggregateRunLogs( std::string const& folder, std::string const& levelFilePath, unsigned long long chartHash, unsigned int nodeCount, RunLogAggregate& out_aggregate )
+{
+	double startTimeSeconds = GetCurrentTimeSeconds();
+	out_aggregate = RunLogAggregate();
+	out_aggregate.m_nodes.resize( nodeCount );
+
+	std::error_code error;
+	std::filesystem::directory_iterator folderIterator( folder, error );
+	if ( error )
+		return false;
+
+	// Logs are named "<level>_<time>.runlog"; the prefix saves opening other levels' logs at all
+	std::string filePrefix = std::filesystem::path( levelFilePath ).stem().string() + "_";
+	std::vector<std::filesystem::path> filepaths;
+	for ( std::filesystem::directory_entry const& entry : folderIterator )
+	{
+		std::filesystem::path const& filepath = entry.path();
+		if ( filepath.extension() != ".runlog" )
+			continue;
+
+		if ( filepath.filename().string().compare( 0, filePrefix.size(), filePrefix ) != 0 )
+			continue;
+
+		filepaths.push_back( filepath );
+	}
+
+	int threadCount = g_gameConfigBlackboard.GetValue( "runStatsThreads", 0 );
+	if ( threadCount <= 0 )
+	{
+		threadCount = static_cast<int>( std::thread::hardware_concurrency() );
+	}
+	threadCount = std::clamp( threadCount, 1, std::max( static_cast<int>( filepaths.size() ), 1 ) );
+	out_aggregate.m_threadCount = threadCount;
+
+	unsigned long long levelHash = HashLevelName( levelFilePath );
+	std::atomic<size_t> nextFileIndex = 0;
+	std::vector<RunLogWorkerResult> results( threadCount );
+	auto aggregateWork = [&]( RunLogWorkerResult& result )
+	{
+		result.m_counters.resize( nodeCount );
+		RunLogEntry entryBuffer[RUN_LOG_READ_CHUNK_ENTRIES];
+		for ( ;; )
+		{
+			size_t fileIndex = nextFileIndex.fetch_add( 1, std::memory_order_relaxed );
+			if ( fileIndex >= filepaths.size() )
+				break;
+
+			if ( !AccumulateRunLog( filepaths[fileIndex], levelHash, chartHash, nodeCount, entryBuffer, result ) )
+			{
+				result.m_skippedFileCount++;
+			}
+		}
+	};
+
+	// The calling thread takes the first share instead of waiting idle
+	std::vector<std::thread> threads;
+	threads.reserve( threadCount - 1 );
+	for ( int threadIndex = 1; threadIndex < threadCount; threadIndex++ )
+	{
+		threads.emplace_back( aggregateWork, std::ref( results[threadIndex] ) );
+	}
+	aggregateWork( results[0] );
+	for ( std::thread& thread : threads )
+	{
+		thread.join();
+	}
+
+	std::vector<NodeRunCounters> totals( nodeCount );
+	for ( RunLogWorkerResult const& result : results )
+	{
+		out_aggregate.m_runCount += result.m_runCount;
+		out_aggregate.m_skippedFileCount += result.m_skippedFileCount;
+		out_aggregate.m_tapCount += result.m_tapCount;
+		for ( unsigned int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+		{
+			NodeRunCounters const& counters = result.m_counters[nodeIndex];
+			totals[nodeIndex].m_reachCount		+= counters.m_reachCount;
+			totals[nodeIndex].m_deathCount		+= counters.m_deathCount;
+			totals[nodeIndex].m_tapCount		+= counters.m_tapCount;
+			totals[nodeIndex].m_missCount		+= counters.m_missCount;
+			totals[nodeIndex].m_hitErrorSumMs	+= counters.m_hitErrorSumMs;
+		}
+	}
+
+	for ( unsigned int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++ )
+	{
+		NodeRunCounters const& counters = totals[nodeIndex];
+		NodeDifficulty& node = out_aggregate.m_nodes[nodeIndex];
+		node.m_reachCount = counters.m_reachCount;
+		node.m_tapCount = counters.m_tapCount;
+
+		unsigned int hitCount = counters.m_tapCount - counters.m_missCount;
+		if ( counters.m_tapCount > 0 )
+		{
+			node.m_missRate = static_cast<float>( counters.m_missCount ) / static_cast<float>( counters.m_tapCount );
+		}
+		if ( hitCount > 0 )
+		{
+			node.m_meanErrorMs = static_cast<float>( counters.m_hitErrorSumMs / static_cast<double>( hitCount ) );
+		}
+		if ( counters.m_reachCount > 0 )
+		{
+			node.m_deathRate = static_cast<float>( counters.m_deathCount ) / static_cast<float>( counters.m_reachCount );
+		}
+	}
+
+	out_aggregate.m_elapsedSeconds = GetCurrentTimeSeconds() - startTimeSeconds;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool SaveNodeDifficultyToCSV( std::vector<NodeDifficulty> const& nodes, std::string const& filepath )
+{
+	std::ofstream file( filepath, std::ios::out | std::ios::trunc );
+	if ( !file.is_open() )
+		return false;
+
+	file << "node,reached,taps,missRate,meanErrorMs,deathRate\n";
+	for ( size_t nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++ )
+	{
+		NodeDifficulty const& node = nodes[nodeIndex];
+		file << Stringf( "%u,%u,%u,%.4f,%.2f,%.4f\n", static_cast<unsigned int>( nodeIndex ), node.m_reachCount, node.m_tapCount,
+			node.m_missRate, node.m_meanErrorMs, node.m_deathRate );
+	}
+	return file.good();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "Game/TimingJudgement.hpp"
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr unsigned int RUN_LOG_VERSION = 3;
+
+
+//----------------------------------------------------------------------------------------------------------
+enum class RunOutcome : unsigned char
+{
+	IN_PROGRESS,
+	FAILED,
+	WON,
+	ABANDONED,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// On-disk layout of a run log: one header followed by m_entryCount fixed size entries, both written
+// exactly as laid out here. Logs are only read back by the same build family, so no byte swapping.
+//
+struct RunLogHeader
+{
+	char				m_magic[4]				= { 'O', 'R', 'U', 'N' };
+	unsigned int		m_version				= RUN_LOG_VERSION;
+	unsigned long long	m_levelHash				= 0;	// HashLevelName() of the level file
+	unsigned long long	m_chartHash				= 0;	// Level::GetChartHash(); logs from another revision of the chart are skipped
+	unsigned int		m_nodeCount				= 0;
+	unsigned int		m_startNodeIndex		= 0;	// Checkpoint the attempt started from
+	unsigned int		m_endNodeIndex			= 0;	// Node the player was heading for when the attempt ended
+	unsigned int		m_entryCount			= 0;
+	RunOutcome			m_outcome				= RunOutcome::IN_PROGRESS;
+	unsigned char		m_padding[7]			= {};
+};
+static_assert( sizeof( RunLogHeader ) == 48, "RunLogHeader is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+struct RunLogEntry
+{
+	float				m_timeInBeats			= 0.f;	// Song time of the tap
+	unsigned int		m_nodeIndex				= 0;	// Node the tap was judged against
+	short				m_errorTenthsMs			= 0;	// Signed, positive is late; saturates at +-3.2 seconds
+	unsigned char		m_judgement				= 0;	// TimingJudgement
+	unsigned char		m_padding				= 0;
+};
+static_assert( sizeof( RunLogEntry ) == 12, "RunLogEntry is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+// Every judged tap of one level attempt plus how the attempt ended. A few hundred bytes per run, so one
+// gets written for every attempt and charters can aggregate thousands of them with AggregateRunLogs().
+//
+class RunLog
+{
+public:
+	void Reset( std::string const& levelFilePath, unsigned long long chartHash, unsigned int nodeCount, unsigned int startNodeIndex );
+	void RecordTap( double timeInBeats, unsigned int nodeIndex, double timingErrorSeconds, TimingJudgement judgement );
+	void Finish( RunOutcome outcome, unsigned int endNodeIndex );
+	void ReserveHeadroom( size_t entryCount );		// So recording while playing never has to grow
+
+	bool IsRecording() const;
+	bool SaveToFile( std::string const& filepath ) const;
+
+private:
+	RunLogHeader				m_header;
+	std::vector<RunLogEntry>	m_entries;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct NodeDifficulty
+{
+	unsigned int	m_reachCount		= 0;	// Runs that had to hit this node
+	unsigned int	m_tapCount			= 0;
+	float			m_missRate			= 0.f;	// Unacceptable taps over all taps judged against the node
+	float			m_meanErrorMs		= 0.f;	// Of the acceptable taps
+	float			m_deathRate			= 0.f;	// Failed runs ending here over runs reaching here
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct RunLogAggregate
+{
+	std::vector<NodeDifficulty>	m_nodes;
+	unsigned int		m_runCount				= 0;
+	unsigned int		m_skippedFileCount		= 0;	// Unreadable, another level, or another chart revision
+	unsigned long long	m_tapCount				= 0;
+	int					m_threadCount			= 0;
+	double				m_elapsedSeconds		= 0.0;
+};
+
+bool AggregateRunLogs( std::string const& folder, std::string const& levelFilePath, unsigned long long chartHash, unsigned int nodeCount, RunLogAggregate& out_aggregate );
+bool SaveNodeDifficultyToCSV( std::vector<NodeDifficulty> const& nodes, std::string const& filepath );
@@ -0,0 +1,411 @@
+#define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
+#include <windows.h>			// Only needed here for mapping the score files and flushing them to disk
+
+#include "Game/ScoreDatabase.hpp"
+#include "Game/GameCommon.hpp"
+#include "Game/LevelMetrics.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr unsigned int SCORE_RECORD_MAGIC = 0x4345524F;		// "OREC" when read as bytes
+
+
+//----------------------------------------------------------------------------------------------------------
+struct ScoreIndexHeader
+{
+	char				m_magic[4]			= { 'O', 'S', 'I', 'X' };
+	unsigned int		m_version			= SCORE_DATABASE_VERSION;
+	unsigned int		m_summaryCount		= 0;
+	unsigned int		m_checksum			= 0;	// Of the summaries that follow
+	unsigned long long	m_coveredLogBytes	= 0;	// Log records past this point are not in the summaries yet
+};
+static_assert( sizeof( ScoreIndexHeader ) == 24, "ScoreIndexHeader is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+// A read-only view of a whole file. A missing or empty file opens as an empty view.
+//
+struct MappedFileView
+{
+	HANDLE					m_file		= INVALID_HANDLE_VALUE;
+	HANDLE					m_mapping	= nullptr;
+	unsigned char const*	m_data		= nullptr;
+	unsigned long long		m_size		= 0;
+
+public:
+	~MappedFileView() { Close(); }
+
+	bool Open( std::string const& filepath )
+	{
+		m_file = CreateFileA( filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if ( m_file == INVALID_HANDLE_VALUE )
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if ( !GetFileSizeEx( m_file, &fileSize ) )
+			return false;
+
+		m_size = static_cast<unsigned long long>( fileSize.QuadPart );
+		if ( m_size == 0 )
+			return true;
+
+		m_mapping = CreateFileMappingA( m_file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( m_mapping == nullptr )
+			return false;
+
+		m_data = static_cast<unsigned char const*>( MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 ) );
+		return m_data != nullptr;
+	}
+
+	void Close()
+	{
+		if ( m_data != nullptr )					UnmapViewOfFile( m_data );
+		if ( m_mapping != nullptr )					CloseHandle( m_mapping );
+		if ( m_file != INVALID_HANDLE_VALUE )		CloseHandle( m_file );
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+		m_size = 0;
+	}
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned int HashScoreBytes( void const* data, size_t byteCount )
+{
+	// FNV-1a
+	unsigned char const* bytes = static_cast<unsigned char const*>( data );
+	unsigned int hash = 2166136261u;
+	for ( size_t byteIndex = 0; byteIndex < byteCount; byteIndex++ )
+	{
+		hash ^= bytes[byteIndex];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static unsigned int GetRecordChecksum( ScoreRecord const& record )
+{
+	size_t checkedOffset = offsetof( ScoreRecord, m_levelHash );
+	return HashScoreBytes( reinterpret_cast<unsigned char const*>( &record ) + checkedOffset, sizeof( ScoreRecord ) - checkedOffset );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static void ApplyRecord( LevelScoreSummaryMap& summaries, ScoreRecord const& record )
+{
+	LevelScoreSummary& summary = summaries[record.m_levelHash];
+	summary.m_levelHash = record.m_levelHash;
+	summary.m_attemptCount++;
+	summary.m_flags |= record.m_flags;
+	summary.m_bestPercentClear = std::max( summary.m_bestPercentClear, record.m_percentClear );
+	if ( ( record.m_flags & SCORE_FLAG_CLEARED ) != 0 )
+	{
+		summary.m_clearCount++;
+		summary.m_bestScore = std::max( summary.m_bestScore, record.m_score );
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+ScoreDatabase::~ScoreDatabase()
+{
+	Shutdown();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ScoreDatabase::Startup()
+{
+	std::string scoreFolder = g_gameConfigBlackboard.GetValue( "scoreFolder", "Saved/Scores" );
+	std::error_code error;
+	std::filesystem::create_directories( scoreFolder, error );
+	m_logFilePath = scoreFolder + "/Scores.log";
+	m_indexFilePath = scoreFolder + "/Scores.idx";
+	m_batchSeconds = g_gameConfigBlackboard.GetValue( "scoreFlushBatchSeconds", 0.5 );
+
+	unsigned long long coveredLogBytes = 0;
+	if ( !LoadIndex( coveredLogBytes ) )
+	{
+		m_summaries.clear();
+		coveredLogBytes = 0;
+	}
+
+	unsigned long long validLogBytes = ReplayLog( coveredLogBytes );
+	if ( validLogBytes < coveredLogBytes )
+	{
+		// The log lost records the index counted; only a full rescan gives consistent summaries
+		g_theDevConsole->AddLine( DevConsole::WARNING, "Score index is ahead of the score log; rebuilding it from the log" );
+		m_summaries.clear();
+		coveredLogBytes = 0;
+		validLogBytes = ReplayLog( 0 );
+	}
+
+	m_logFile = CreateFileA( m_logFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( m_logFile == INVALID_HANDLE_VALUE )
+	{
+		ERROR_RECOVERABLE( Stringf( "Failed to open the score log \"%s\"; scores will not be saved", m_logFilePath.c_str() ) );
+		m_logFile = nullptr;
+		return;
+	}
+
+	// Anything past the last whole record is a write a crash interrupted
+	LARGE_INTEGER validEnd;
+	validEnd.QuadPart = static_cast<long long>( validLogBytes );
+	SetFilePointerEx( m_logFile, validEnd, nullptr, FILE_BEGIN );
+	SetEndOfFile( m_logFile );
+
+	m_logBytes = validLogBytes;
+	m_writtenSummaries = m_summaries;
+	if ( validLogBytes != coveredLogBytes )
+	{
+		WriteIndex( m_writtenSummaries, m_logBytes );
+	}
+
+	m_isStopping = false;
+	m_writerThread = std::thread( &ScoreDatabase::WriterThreadMain, this );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ScoreDatabase::Shutdown()
+{
+	if ( m_writerThread.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_queueMutex );
+			m_isStopping = true;
+		}
+		m_queueCondition.notify_one();
+		m_writerThread.join();
+	}
+
+	if ( m_logFile != nullptr )
+	{
+		CloseHandle( m_logFile );
+		m_logFile = nullptr;
+	}
+
+	if ( m_hasWriteFailed )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Some scores could not be written to \"%s\"", m_logFilePath.c_str() ) );
+		m_hasWriteFailed = false;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ScoreDatabase::SubmitAttempt( std::string const& levelFilePath, LevelMetrics const& metrics, bool isCleared )
+{
+	ScoreRecord record;
+	record.m_magic = SCORE_RECORD_MAGIC;
+	record.m_levelHash = HashLevelName( levelFilePath );
+	record.m_timestamp = static_cast<long long>( std::time( nullptr ) );
+	record.m_score = metrics.m_totalJudgements > 0 ? metrics.GetScore() : 0.f;
+	record.m_percentClear = metrics.m_percentClear;
+	record.m_totalJudgements = metrics.m_totalJudgements;
+	record.m_checkpointsUsed = metrics.m_checkpointsUsed;
+	if ( isCleared )
+	{
+		record.m_flags |= SCORE_FLAG_CLEARED;
+		if ( metrics.IsFullCombo() )	record.m_flags |= SCORE_FLAG_FULL_COMBO;
+		if ( metrics.IsPurePerfect() )	record.m_flags |= SCORE_FLAG_PURE_PERFECT;
+	}
+	record.m_checksum = GetRecordChecksum( record );
+
+	ApplyRecord( m_summaries, record );
+
+	if ( !m_writerThread.joinable() )
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock( m_queueMutex );
+		m_pendingRecords.push_back( record );
+	}
+	m_queueCondition.notify_one();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+LevelScoreSummary ScoreDatabase::GetSummary( std::string const& levelFilePath ) const
+{
+	auto summaryIter = m_summaries.find( HashLevelName( levelFilePath ) );
+	if ( summaryIter == m_summaries.end() )
+		return LevelScoreSummary();
+
+	return summaryIter->second;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool ScoreDatabase::LoadIndex( unsigned long long& out_coveredLogBytes )
+{
+	MappedFileView indexView;
+	if ( !indexView.Open( m_indexFilePath ) || indexView.m_size < sizeof( ScoreIndexHeader ) )
+		return false;
+
+	ScoreIndexHeader header;
+	memcpy( &header, indexView.m_data, sizeof( ScoreIndexHeader ) );
+
+	ScoreIndexHeader const expectedHeader;
+	if ( memcmp( header.m_magic, expectedHeader.m_magic, sizeof( header.m_magic ) ) != 0 || header.m_version != SCORE_DATABASE_VERSION )
+		return false;
+
+	unsigned long long summaryBytes = static_cast<unsigned long long>( header.m_summaryCount ) * sizeof( LevelScoreSummary );
+	if ( indexView.m_size != sizeof( ScoreIndexHeader ) + summaryBytes )
+		return false;
+
+	unsigned char const* summaryData = indexView.m_data + sizeof( ScoreIndexHeader );
+	if ( HashScoreBytes( summaryData, summaryBytes ) != header.m_checksum )
+		return false;
+
+	m_summaries.clear();
+	m_summaries.reserve( header.m_summaryCount );
+	for ( unsigned int summaryIndex = 0; summaryIndex < header.m_summaryCount; summaryIndex++ )
+	{
+		LevelScoreSummary summary;
+		memcpy( &summary, summaryData + summaryIndex * sizeof( LevelScoreSummary ), sizeof( LevelScoreSummary ) );
+		m_summaries[summary.m_levelHash] = summary;
+	}
+
+	out_coveredLogBytes = header.m_coveredLogBytes;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Folds every whole, intact record from fromByte onward into the summaries and returns where the valid
+// part of the log ends. Returns fromByte unchanged when the log is shorter than that.
+//
+unsigned long long ScoreDatabase::ReplayLog( unsigned long long fromByte )
+{
+	MappedFileView logView;
+	if ( !logView.Open( m_logFilePath ) || logView.m_size < fromByte )
+		return std::min( fromByte, logView.m_size );
+
+	unsigned long long byteOffset = fromByte;
+	while ( byteOffset + sizeof( ScoreRecord ) <= logView.m_size )
+	{
+		ScoreRecord record;
+		memcpy( &record, logView.m_data + byteOffset, sizeof( ScoreRecord ) );
+		if ( record.m_magic != SCORE_RECORD_MAGIC || record.m_checksum != GetRecordChecksum( record ) )
+			break;
+
+		ApplyRecord( m_summaries, record );
+		byteOffset += sizeof( ScoreRecord );
+	}
+
+	if ( byteOffset != logView.m_size )
+	{
+		g_theDevConsole->AddLine( DevConsole::WARNING, Stringf( "Discarding %llu bytes of incomplete score records from \"%s\"",
+			logView.m_size - byteOffset, m_logFilePath.c_str() ) );
+	}
+	return byteOffset;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Written beside the real index, flushed, then moved over it, so a crash leaves either the old index or
+// the new one and never half of each
+//
+bool ScoreDatabase::WriteIndex( LevelScoreSummaryMap const& summaries, unsigned long long coveredLogBytes ) const
+{
+	std::vector<LevelScoreSummary> summaryArray;
+	summaryArray.reserve( summaries.size() );
+	for ( auto const& summaryPair : summaries )
+	{
+		summaryArray.push_back( summaryPair.second );
+	}
+
+	ScoreIndexHeader header;
+	header.m_summaryCount = static_cast<unsigned int>( summaryArray.size() );
+	header.m_checksum = HashScoreBytes( summaryArray.data(), summaryArray.size() * sizeof( LevelScoreSummary ) );
+	header.m_coveredLogBytes = coveredLogBytes;
+
+	std::string tempFilePath = m_indexFilePath + ".tmp";
+	HANDLE indexFile = CreateFileA( tempFilePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( indexFile == INVALID_HANDLE_VALUE )
+		return false;
+
+	DWORD summaryBytes = static_cast<DWORD>( summaryArray.size() * sizeof( LevelScoreSummary ) );
+	DWORD bytesWritten = 0;
+	bool success = WriteFile( indexFile, &header, sizeof( ScoreIndexHeader ), &bytesWritten, nullptr ) && bytesWritten == sizeof( ScoreIndexHeader );
+	success = success && WriteFile( indexFile, summaryArray.data(), summaryBytes, &bytesWritten, nullptr ) && bytesWritten == summaryBytes;
+	success = success && FlushFileBuffers( indexFile );
+	CloseHandle( indexFile );
+	if ( !success )
+		return false;
+
+	return MoveFileExA( tempFilePath.c_str(), m_indexFilePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != FALSE;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Waits for a record, then lingers for the batch window so a burst of attempts (quick restarts) shares
+// one flush. Shutdown skips the wait and drains whatever is queued.
+//
+void ScoreDatabase::WriterThreadMain()
+{
+	std::chrono::duration<double> batchDuration( m_batchSeconds );
+	std::unique_lock<std::mutex> lock( m_queueMutex );
+	for ( ;; )
+	{
+		m_queueCondition.wait( lock, [this]() { return m_isStopping || !m_pendingRecords.empty(); } );
+		if ( !m_isStopping )
+		{
+			m_queueCondition.wait_for( lock, batchDuration, [this]() { return m_isStopping; } );
+		}
+
+		std::vector<ScoreRecord> batch;
+		batch.swap( m_pendingRecords );
+		bool isStopping = m_isStopping;
+		lock.unlock();
+
+		if ( !batch.empty() )
+		{
+			WriteBatch( batch );
+		}
+
+		lock.lock();
+		if ( isStopping && m_pendingRecords.empty() )
+			break;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void ScoreDatabase::WriteBatch( std::vector<ScoreRecord> const& records )
+{
+	DWORD batchBytes = static_cast<DWORD>( records.size() * sizeof( ScoreRecord ) );
+	DWORD bytesWritten = 0;
+	if ( !WriteFile( m_logFile, records.data(), batchBytes, &bytesWritten, nullptr ) || bytesWritten != batchBytes || !FlushFileBuffers( m_logFile ) )
+	{
+		// Cut back to the last whole batch so later appends stay aligned to record boundaries
+		LARGE_INTEGER validEnd;
+		validEnd.QuadPart = static_cast<long long>( m_logBytes );
+		SetFilePointerEx( m_logFile, validEnd, nullptr, FILE_BEGIN );
+		SetEndOfFile( m_logFile );
+		m_hasWriteFailed = true;
+		return;
+	}
+
+	m_logBytes += batchBytes;
+	for ( ScoreRecord const& record : records )
+	{
+		ApplyRecord( m_writtenSummaries, record );
+	}
+
+	// A stale index is only slower to load, never wrong, so a failure here is not worth reporting
+	WriteIndex( m_writtenSummaries, m_logBytes );
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct LevelMetrics;
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr unsigned int SCORE_DATABASE_VERSION = 1;
+
+enum ScoreFlags : unsigned char
+{
+	SCORE_FLAG_CLEARED		= 1 << 0,
+	SCORE_FLAG_FULL_COMBO	= 1 << 1,
+	SCORE_FLAG_PURE_PERFECT	= 1 << 2,
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// One attempt as appended to the score log. The checksum covers every byte after it, so a record torn by
+// a crash mid-write is recognized on the next startup and cut off instead of being read as garbage.
+//
+struct ScoreRecord
+{
+	unsigned int		m_magic				= 0;
+	unsigned int		m_checksum			= 0;
+	unsigned long long	m_levelHash			= 0;	// HashLevelName()
+	long long			m_timestamp			= 0;	// Seconds since the Unix epoch
+	float				m_score				= 0.f;
+	float				m_percentClear		= 0.f;
+	unsigned int		m_totalJudgements	= 0;
+	unsigned int		m_checkpointsUsed	= 0;
+	unsigned char		m_flags				= 0;	// ScoreFlags
+	unsigned char		m_padding[7]		= {};
+};
+static_assert( sizeof( ScoreRecord ) == 48, "ScoreRecord is part of the file format" );
+
+
+//----------------------------------------------------------------------------------------------------------
+// Everything the game shows about a level's history, folded from every record of that level. The index
+// file is a flat array of these, which is what makes startup O(levels) instead of O(attempts).
+//
+struct LevelScoreSummary
+{
+	unsigned long long	m_levelHash			= 0;
+	float				m_bestScore			= 0.f;	// Of cleared attempts only
+	float				m_bestPercentClear	= 0.f;
+	unsigned int		m_attemptCount		= 0;
+	unsigned int		m_clearCount		= 0;
+	unsigned char		m_flags				= 0;	// Every ScoreFlags bit any attempt has earned
+	unsigned char		m_padding[7]		= {};
+
+public:
+	bool HasFullCombo() const	{ return ( m_flags & SCORE_FLAG_FULL_COMBO ) != 0; }
+	bool HasPurePerfect() const	{ return ( m_flags & SCORE_FLAG_PURE_PERFECT ) != 0; }
+};
+static_assert( sizeof( LevelScoreSummary ) == 32, "LevelScoreSummary is part of the file format" );
+
+typedef std::unordered_map<unsigned long long, LevelScoreSummary> LevelScoreSummaryMap;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Persistent per-level scores: an append-only log of every attempt plus an index of per-level summaries
+// that records how many log bytes it covers. Startup maps the index, then maps the log and replays only
+// the records past that point (normally none). Submitting an attempt updates the in-memory summary at
+// once and queues the record; a writer thread appends queued records in batches, flushes the log to disk
+// once per batch, then atomically replaces the index. The frame never waits on the disk.
+//
+class ScoreDatabase
+{
+public:
+	ScoreDatabase() = default;
+	~ScoreDatabase();
+
+	void Startup();
+	void Shutdown();
+
+	void SubmitAttempt( std::string const& levelFilePath, LevelMetrics const& metrics, bool isCleared );
+	LevelScoreSummary GetSummary( std::string const& levelFilePath ) const;
+
+private:
+	bool LoadIndex( unsigned long long& out_coveredLogBytes );
+	unsigned long long ReplayLog( unsigned long long fromByte );
+	bool WriteIndex( LevelScoreSummaryMap const& summaries, unsigned long long coveredLogBytes ) const;
+
+	void WriterThreadMain();
+	void WriteBatch( std::vector<ScoreRecord> const& records );
+
+private:
+	std::string					m_logFilePath;
+	std::string					m_indexFilePath;
+	LevelScoreSummaryMap		m_summaries;			// Main thread only; includes attempts not yet on disk
+	double						m_batchSeconds = 0.5;
+
+	// Owned by the writer thread once it is running
+	void*						m_logFile = nullptr;	// HANDLE
+	unsigned long long			m_logBytes = 0;
+	LevelScoreSummaryMap		m_writtenSummaries;		// Exactly what the flushed log holds
+	bool						m_hasWriteFailed = false;
+
+	std::mutex					m_queueMutex;
+	std::condition_variable		m_queueCondition;
+	std::vector<ScoreRecord>	m_pendingRecords;
+	bool						m_isStopping = false;
+	std::thread					m_writerThread;
+};
@@ -0,0 +1,129 @@
+#include "Game/SimulationThread.hpp"
+#include "Game/Level.hpp"
+#include "Engine/Core/Time.hpp"
+#include <chrono>
+
+
+//----------------------------------------------------------------------------------------------------------
+SimulationThread::SimulationThread( Level& level )
+	: m_level( level )
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+SimulationThread::~SimulationThread()
+{
+	Stop();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SimulationThread::Start( LevelSnapshot const& initialSnapshot, double firstTickTimeSeconds )
+{
+	Stop();
+	m_snapshots.Reset( initialSnapshot );
+	m_nextTickTimeSeconds = firstTickTimeSeconds;
+	m_isStopping = false;
+	m_thread = std::thread( &SimulationThread::ThreadMain, this );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Safe to call while holding the shared mutex, since the thread never blocks on it
+//
+void SimulationThread::Stop()
+{
+	if ( !m_thread.joinable() )
+		return;
+
+	m_isStopping = true;
+	m_thread.join();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SimulationThread::SetTimeScale( double timeScale )
+{
+	m_timeScale = timeScale;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool SimulationThread::IsCurrentThread() const
+{
+	return std::this_thread::get_id() == m_thread.get_id();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+LevelSnapshot const& SimulationThread::AcquireSnapshot()
+{
+	return m_snapshots.Acquire();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+/*static*/ std::mutex& SimulationThread::GetSharedStateMutex()
+{
+	static std::mutex s_sharedStateMutex;
+	return s_sharedStateMutex;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Sleeps overshoot, by up to a whole scheduler quantum on Windows, so each wake runs every tick that came
+// due since the last one, each at the time it was due. The keyboard is read on every wake before trying
+// the lock, and again about every LOCK_RETRY_MICROSECONDS while the main thread holds it, so a tap is
+// stamped within about a tick of when it happened even through a long BeginFrame() or Update(). The
+// first tick due after it then judges it at that stamp. Taps still can't be stamped more precisely than
+// the operating system wakes this thread, which on Windows depends on the timer resolution.
+//
+void SimulationThread::ThreadMain()
+{
+	double const tickSeconds = static_cast<double>( SIMULATION_TICK_MICROSECONDS ) / 1'000'000.0;
+	while ( !m_isStopping )
+	{
+		double timeScale = m_timeScale;
+		double currentTimeSeconds = GetCurrentTimeSeconds();
+		if ( timeScale <= 0.0 )
+		{
+			m_nextTickTimeSeconds = currentTimeSeconds + tickSeconds;
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			continue;
+		}
+
+		if ( currentTimeSeconds < m_nextTickTimeSeconds )
+		{
+			std::this_thread::sleep_for( std::chrono::duration<double>( m_nextTickTimeSeconds - currentTimeSeconds ) );
+			continue;
+		}
+
+		m_level.PollLiveTaps( currentTimeSeconds );
+
+		// Never blocks, so Stop() can join while the main thread holds the lock
+		std::unique_lock<std::mutex> lock( GetSharedStateMutex(), std::try_to_lock );
+		if ( !lock.owns_lock() )
+		{
+			std::this_thread::sleep_for( std::chrono::microseconds( LOCK_RETRY_MICROSECONDS ) );
+			continue;
+		}
+
+		double tickIntervalSeconds = tickSeconds / timeScale;
+		currentTimeSeconds = GetCurrentTimeSeconds();
+		while ( m_nextTickTimeSeconds <= currentTimeSeconds && !m_level.IsSimulationHalted() )
+		{
+			m_level.UpdateTick( m_nextTickTimeSeconds );
+			m_nextTickTimeSeconds += tickIntervalSeconds;
+		}
+
+		// A halted level waits on the main thread to change state, which stops this thread
+		if ( m_level.IsSimulationHalted() )
+		{
+			m_nextTickTimeSeconds = currentTimeSeconds + tickIntervalSeconds;
+		}
+
+		m_level.WriteSnapshot( m_snapshots.GetWriteBuffer(), 1.f );
+		m_snapshots.Publish();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Game/LevelSnapshot.hpp"
+#include "Game/TripleBuffer.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+
+//----------------------------------------------------------------------------------------------------------
+class Level;
+
+
+//----------------------------------------------------------------------------------------------------------
+// Runs a level's simulation ticks on schedule on their own thread, whatever the main thread is drawing,
+// and publishes a snapshot after each batch of ticks for the main thread to draw from.
+//
+// The main thread holds GetSharedStateMutex() through BeginFrame() and Update(), which is where console
+// commands run and the blackboard is written. Ticks only run while this thread holds it. Taps are read by
+// this thread before it takes the lock, and reach the ticks through the tap manager's ring buffer.
+// Render() and EndFrame() run unlocked and only read the snapshot, so a slow draw never delays a tick. A
+// slow Update() does, though each delayed tick still runs at the time it was due.
+//
+class SimulationThread
+{
+public:
+	explicit SimulationThread( Level& level );
+	~SimulationThread();
+
+	void Start( LevelSnapshot const& initialSnapshot, double firstTickTimeSeconds );
+	void Stop();
+	void SetTimeScale( double timeScale );		// 0 holds the simulation, as a paused game clock does
+
+	bool IsCurrentThread() const;
+	LevelSnapshot const& AcquireSnapshot();
+
+	static std::mutex& GetSharedStateMutex();
+
+private:
+	static constexpr long long LOCK_RETRY_MICROSECONDS = 250;
+
+	void ThreadMain();
+
+private:
+	Level&						m_level;
+	std::thread					m_thread;
+	std::atomic<bool>			m_isStopping			= false;
+	std::atomic<double>			m_timeScale				= 1.0;
+	double						m_nextTickTimeSeconds	= 0.0;	// Owned by the thread once it is running
+	TripleBuffer<LevelSnapshot>	m_snapshots;
+};
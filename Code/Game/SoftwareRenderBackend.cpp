@@ -0,0 +1,599 @@
+#include "Game/SoftwareRenderBackend.hpp"
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/Image.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Renderer/Camera.hpp"
+#include "Engine/Renderer/Texture.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <emmintrin.h>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int SIMD_WIDTH = 4;	// SSE2 is baseline on every x64 target, so no scalar fallback is kept
+
+
+//----------------------------------------------------------------------------------------------------------
+// Edge (start -> end) owns the pixels that lie exactly on it only if it is a top or left edge,
+// so triangles sharing an edge never blend the same pixel twice.
+static bool IsTopLeftEdge( Vec2 const& start, Vec2 const& end )
+{
+	Vec2 edge = end - start;
+	return ( edge.y < 0.f ) || ( edge.y == 0.f && edge.x > 0.f );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static float GetEdgeWeight( Vec2 const& start, Vec2 const& end, Vec2 const& point )
+{
+	return ( end.x - start.x ) * ( point.y - start.y ) - ( end.y - start.y ) * ( point.x - start.x );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static __m128 GetEdgeWeights4( Vec2 const& start, Vec2 const& end, __m128 pointX, __m128 pointY )
+{
+	__m128 edgeX = _mm_set1_ps( end.x - start.x );
+	__m128 edgeY = _mm_set1_ps( end.y - start.y );
+	__m128 offsetX = _mm_sub_ps( pointX, _mm_set1_ps( start.x ) );
+	__m128 offsetY = _mm_sub_ps( pointY, _mm_set1_ps( start.y ) );
+	return _mm_sub_ps( _mm_mul_ps( edgeX, offsetY ), _mm_mul_ps( edgeY, offsetX ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static __m128 GetEdgeCoverage4( __m128 edgeWeights, bool isTopLeftEdge )
+{
+	__m128 zero = _mm_setzero_ps();
+	return isTopLeftEdge ? _mm_cmpge_ps( edgeWeights, zero ) : _mm_cmpgt_ps( edgeWeights, zero );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// A vertex attribute as a linear function of pixel position across one triangle, measured from vertex A.
+// A block of pixels then costs one multiply-add per attribute instead of a full barycentric blend.
+struct AttributePlane
+{
+	float m_valueAtA = 0.f;
+	float m_stepX = 0.f;
+	float m_stepY = 0.f;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+static AttributePlane MakeAttributePlane( Vec2 const& posA, Vec2 const& posB, Vec2 const& posC, float valueA, float valueB, float valueC, float inverseArea )
+{
+	AttributePlane plane;
+	plane.m_valueAtA = valueA;
+	plane.m_stepX = -inverseArea * ( ( posC.y - posB.y ) * valueA + ( posA.y - posC.y ) * valueB + ( posB.y - posA.y ) * valueC );
+	plane.m_stepY = inverseArea * ( ( posC.x - posB.x ) * valueA + ( posA.x - posC.x ) * valueB + ( posB.x - posA.x ) * valueC );
+	return plane;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+SoftwareRenderBackend::SoftwareRenderBackend( IntVec2 const& dimensions )
+	: m_dimensions( dimensions )
+{
+	size_t pixelCount = static_cast<size_t>( dimensions.x ) * static_cast<size_t>( dimensions.y );
+	m_colorBuffer.resize( pixelCount + SIMD_WIDTH, Rgba8::BLACK );
+	m_depthBuffer.resize( pixelCount + SIMD_WIDTH, FLT_MAX );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+SoftwareRenderBackend::~SoftwareRenderBackend()
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::ClearScreen( Rgba8 const& clearColor )
+{
+	std::fill( m_colorBuffer.begin(), m_colorBuffer.end(), clearColor );
+	std::fill( m_depthBuffer.begin(), m_depthBuffer.end(), FLT_MAX );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::BeginCamera( Camera const& camera )
+{
+	AABB2 const& viewBounds = camera.GetBoundingBox();
+	Vec2 viewDimensions = viewBounds.GetDimensions();
+
+	m_cameraMins = viewBounds.m_mins + Vec2::CopyVec3XY( camera.m_position );
+	m_worldToPixels.x = static_cast<float>( m_dimensions.x ) / viewDimensions.x;
+	m_worldToPixels.y = static_cast<float>( m_dimensions.y ) / viewDimensions.y;
+
+	m_modelToWorld = Mat44();
+	m_modelColor = Rgba8::WHITE;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::EndCamera( Camera const& camera )
+{
+	UNUSED( camera );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::BindTexture( Texture const* texture )
+{
+	m_boundTexture = GetOrLoadTexture( texture );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::BindShader( Shader* shader )
+{
+	// Only the default shader is supported; everything is drawn as vertex color * texture * model color
+	UNUSED( shader );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::SetBlendMode( BlendMode blendMode )
+{
+	m_blendMode = blendMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::SetDepthMode( DepthMode depthMode )
+{
+	m_depthMode = depthMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::SetRasterizerMode( RasterizerMode rasterizerMode )
+{
+	m_rasterizerMode = rasterizerMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::SetSamplerMode( SamplerMode samplerMode )
+{
+	m_samplerMode = samplerMode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::SetModelConstants( Mat44 const& modelToWorldTransform, Rgba8 const& modelColor )
+{
+	m_modelToWorld = modelToWorldTransform;
+	m_modelColor = modelColor;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+VertexBuffer* SoftwareRenderBackend::CreateVertexBuffer( size_t byteSize )
+{
+	UNUSED( byteSize );
+	VertexBuffer* vbo = reinterpret_cast<VertexBuffer*>( m_nextBufferHandle++ );
+	m_vertexBuffers[vbo].clear();
+	return vbo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo )
+{
+	auto found = m_vertexBuffers.find( vbo );
+	if ( found == m_vertexBuffers.end() )
+		return;
+
+	Vertex_PCU const* vertexes = static_cast<Vertex_PCU const*>( data );
+	size_t vertexCount = byteSize / sizeof( Vertex_PCU );
+	found->second.assign( vertexes, vertexes + vertexCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IndexBuffer* SoftwareRenderBackend::CreateIndexBuffer( size_t byteSize )
+{
+	UNUSED( byteSize );
+	IndexBuffer* ibo = reinterpret_cast<IndexBuffer*>( m_nextBufferHandle++ );
+	m_indexBuffers[ibo].clear();
+	return ibo;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo )
+{
+	auto found = m_indexBuffers.find( ibo );
+	if ( found == m_indexBuffers.end() )
+		return;
+
+	unsigned int const* indexes = static_cast<unsigned int const*>( data );
+	size_t indexCount = byteSize / sizeof( unsigned int );
+	found->second.assign( indexes, indexes + indexCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+unsigned int SoftwareRenderBackend::CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo )
+{
+	*out_vbo = reinterpret_cast<VertexBuffer*>( m_nextBufferHandle++ );
+	*out_ibo = reinterpret_cast<IndexBuffer*>( m_nextBufferHandle++ );
+	m_vertexBuffers[*out_vbo] = mesh.m_vertexes;
+	m_indexBuffers[*out_ibo] = mesh.m_indexes;
+	return static_cast<unsigned int>( mesh.m_indexes.size() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DestroyVertexBuffer( VertexBuffer* vbo )
+{
+	m_vertexBuffers.erase( vbo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DestroyIndexBuffer( IndexBuffer* ibo )
+{
+	m_indexBuffers.erase( ibo );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes )
+{
+	DrawTriangles( vertexes, nullptr, numVertexes );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawVertexArray( Mesh const& mesh )
+{
+	DrawTriangles( mesh.data(), nullptr, static_cast<int>( mesh.size() ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawIndexedMesh( IndexedMesh const& mesh )
+{
+	DrawTriangles( mesh.m_vertexes.data(), mesh.m_indexes.data(), static_cast<int>( mesh.m_indexes.size() ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawVertexBuffer( VertexBuffer* vbo, int vertexCount )
+{
+	auto found = m_vertexBuffers.find( vbo );
+	if ( found == m_vertexBuffers.end() )
+		return;
+
+	std::vector<Vertex_PCU> const& vertexes = found->second;
+	int drawCount = vertexCount < static_cast<int>( vertexes.size() ) ? vertexCount : static_cast<int>( vertexes.size() );
+	DrawTriangles( vertexes.data(), nullptr, drawCount );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount )
+{
+	auto foundVerts = m_vertexBuffers.find( vbo );
+	auto foundIndexes = m_indexBuffers.find( ibo );
+	if ( foundVerts == m_vertexBuffers.end() || foundIndexes == m_indexBuffers.end() )
+		return;
+
+	std::vector<unsigned int> const& indexes = foundIndexes->second;
+	unsigned int drawCount = indexCount < indexes.size() ? indexCount : static_cast<unsigned int>( indexes.size() );
+	DrawTriangles( foundVerts->second.data(), indexes.data(), static_cast<int>( drawCount ) );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+IntVec2 const& SoftwareRenderBackend::GetDimensions() const
+{
+	return m_dimensions;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Rgba8 const* SoftwareRenderBackend::GetColorBuffer() const
+{
+	return m_colorBuffer.data();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool SoftwareRenderBackend::WriteFrameToTGA( char const* filepath ) const
+{
+	std::ofstream file( filepath, std::ios::binary );
+	if ( !file )
+		return false;
+
+	// Uncompressed true-color TGA, 32 bits per pixel, top-left origin
+	unsigned char header[18] = {};
+	header[2]  = 2;
+	header[12] = static_cast<unsigned char>( m_dimensions.x & 0xFF );
+	header[13] = static_cast<unsigned char>( ( m_dimensions.x >> 8 ) & 0xFF );
+	header[14] = static_cast<unsigned char>( m_dimensions.y & 0xFF );
+	header[15] = static_cast<unsigned char>( ( m_dimensions.y >> 8 ) & 0xFF );
+	header[16] = 32;
+	header[17] = 0x28;
+	file.write( reinterpret_cast<char const*>( header ), sizeof( header ) );
+
+	std::vector<unsigned char> row( static_cast<size_t>( m_dimensions.x ) * 4 );
+	for ( int y = 0; y < m_dimensions.y; y++ )
+	{
+		Rgba8 const* pixels = &m_colorBuffer[static_cast<size_t>( y ) * m_dimensions.x];
+		for ( int x = 0; x < m_dimensions.x; x++ )
+		{
+			row[x * 4 + 0] = pixels[x].b;
+			row[x * 4 + 1] = pixels[x].g;
+			row[x * 4 + 2] = pixels[x].r;
+			row[x * 4 + 3] = pixels[x].a;
+		}
+
+		file.write( reinterpret_cast<char const*>( row.data() ), row.size() );
+	}
+
+	return file.good();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::DrawTriangles( Vertex_PCU const* vertexes, unsigned int const* indexes, int vertexCount )
+{
+	for ( int triStart = 0; triStart + 2 < vertexCount; triStart += 3 )
+	{
+		if ( indexes != nullptr )
+		{
+			RasterizeTriangle( vertexes[indexes[triStart]], vertexes[indexes[triStart + 1]], vertexes[indexes[triStart + 2]] );
+		}
+		else
+		{
+			RasterizeTriangle( vertexes[triStart], vertexes[triStart + 1], vertexes[triStart + 2] );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void SoftwareRenderBackend::RasterizeTriangle( Vertex_PCU const& vertA, Vertex_PCU const& vertB, Vertex_PCU const& vertC )
+{
+	// World -> pixel space (pixel y grows downward)
+	Vertex_PCU const* verts[3] = { &vertA, &vertB, &vertC };
+	Vec2 pixelPos[3];
+	float depth[3];
+	for ( int i = 0; i < 3; i++ )
+	{
+		Vec3 worldPos = m_modelToWorld.TransformPosition3D( verts[i]->m_position );
+		pixelPos[i].x = ( worldPos.x - m_cameraMins.x ) * m_worldToPixels.x;
+		pixelPos[i].y = static_cast<float>( m_dimensions.y ) - ( worldPos.y - m_cameraMins.y ) * m_worldToPixels.y;
+		depth[i] = worldPos.z;
+	}
+
+	// Counter-clockwise in world space is clockwise once y is flipped, which gives a negative area here
+	float area = GetEdgeWeight( pixelPos[0], pixelPos[1], pixelPos[2] );
+	if ( area == 0.f )
+		return;
+
+	if ( area > 0.f && m_rasterizerMode == RasterizerMode::SOLID_CULL_BACK )
+		return;
+
+	int indexB = 1;
+	int indexC = 2;
+	if ( area < 0.f )
+	{
+		indexB = 2;
+		indexC = 1;
+		area = -area;
+	}
+
+	Vec2 const& posA = pixelPos[0];
+	Vec2 const& posB = pixelPos[indexB];
+	Vec2 const& posC = pixelPos[indexC];
+	Vertex_PCU const& colorA = *verts[0];
+	Vertex_PCU const& colorB = *verts[indexB];
+	Vertex_PCU const& colorC = *verts[indexC];
+
+	int minX = static_cast<int>( floorf( std::min( { posA.x, posB.x, posC.x } ) ) );
+	int minY = static_cast<int>( floorf( std::min( { posA.y, posB.y, posC.y } ) ) );
+	int maxX = static_cast<int>( ceilf( std::max( { posA.x, posB.x, posC.x } ) ) );
+	int maxY = static_cast<int>( ceilf( std::max( { posA.y, posB.y, posC.y } ) ) );
+	minX = std::max( minX, 0 );
+	minY = std::max( minY, 0 );
+	maxX = std::min( maxX, m_dimensions.x - 1 );
+	maxY = std::min( maxY, m_dimensions.y - 1 );
+	if ( minX > maxX || minY > maxY )
+		return;
+
+	bool topLeftBC = IsTopLeftEdge( posB, posC );
+	bool topLeftCA = IsTopLeftEdge( posC, posA );
+	bool topLeftAB = IsTopLeftEdge( posA, posB );
+
+	float inverseArea = 1.f / area;
+	float modelR = NormalizeByte( m_modelColor.r );
+	float modelG = NormalizeByte( m_modelColor.g );
+	float modelB = NormalizeByte( m_modelColor.b );
+	float modelA = NormalizeByte( m_modelColor.a );
+	bool isTextured = ( m_boundTexture != nullptr );
+	bool depthEnabled = ( m_depthMode != DepthMode::DISABLED );
+	bool alphaBlend = ( m_blendMode == BlendMode::ALPHA );
+
+	enum { DEPTH, RED, GREEN, BLUE, ALPHA, TEXTURE_U, TEXTURE_V, ATTRIBUTE_COUNT };
+	AttributePlane planes[ATTRIBUTE_COUNT];
+	planes[DEPTH]		= MakeAttributePlane( posA, posB, posC, depth[0], depth[indexB], depth[indexC], inverseArea );
+	planes[RED]			= MakeAttributePlane( posA, posB, posC, colorA.m_color.r * modelR, colorB.m_color.r * modelR, colorC.m_color.r * modelR, inverseArea );
+	planes[GREEN]		= MakeAttributePlane( posA, posB, posC, colorA.m_color.g * modelG, colorB.m_color.g * modelG, colorC.m_color.g * modelG, inverseArea );
+	planes[BLUE]		= MakeAttributePlane( posA, posB, posC, colorA.m_color.b * modelB, colorB.m_color.b * modelB, colorC.m_color.b * modelB, inverseArea );
+	planes[ALPHA]		= MakeAttributePlane( posA, posB, posC, colorA.m_color.a * modelA, colorB.m_color.a * modelA, colorC.m_color.a * modelA, inverseArea );
+	planes[TEXTURE_U]	= MakeAttributePlane( posA, posB, posC, colorA.m_uvTexCoords.x, colorB.m_uvTexCoords.x, colorC.m_uvTexCoords.x, inverseArea );
+	planes[TEXTURE_V]	= MakeAttributePlane( posA, posB, posC, colorA.m_uvTexCoords.y, colorB.m_uvTexCoords.y, colorC.m_uvTexCoords.y, inverseArea );
+
+	__m128 attributeStepsX[ATTRIBUTE_COUNT];
+	__m128 attributeRows[ATTRIBUTE_COUNT];
+	for ( int attributeIndex = 0; attributeIndex < ATTRIBUTE_COUNT; attributeIndex++ )
+	{
+		attributeStepsX[attributeIndex] = _mm_set1_ps( planes[attributeIndex].m_stepX );
+	}
+
+	__m128 const pixelCenterOffsets = _mm_setr_ps( .5f, 1.5f, 2.5f, 3.5f );
+	__m128 const lastPixelCenterX = _mm_set1_ps( static_cast<float>( maxX ) + .5f );
+	__m128 const posAX = _mm_set1_ps( posA.x );
+	__m128 const zero4 = _mm_setzero_ps();
+	__m128 const byteMax4 = _mm_set1_ps( 255.f );
+	__m128 const inverseByteMax4 = _mm_set1_ps( 1.f / 255.f );
+	__m128 const one4 = _mm_set1_ps( 1.f );
+	__m128i const byteMask4 = _mm_set1_epi32( 0xFF );
+
+	// Four horizontally adjacent pixels per step; lanes past the right edge are masked off, and the
+	// buffers carry SIMD_WIDTH pixels of padding so the last row never reads out of bounds
+	for ( int y = minY; y <= maxY; y++ )
+	{
+		float pixelCenterY = static_cast<float>( y ) + .5f;
+		__m128 pixelCenterY4 = _mm_set1_ps( pixelCenterY );
+		for ( int attributeIndex = 0; attributeIndex < ATTRIBUTE_COUNT; attributeIndex++ )
+		{
+			AttributePlane const& plane = planes[attributeIndex];
+			attributeRows[attributeIndex] = _mm_set1_ps( plane.m_valueAtA + plane.m_stepY * ( pixelCenterY - posA.y ) );
+		}
+
+		for ( int x = minX; x <= maxX; x += SIMD_WIDTH )
+		{
+			__m128 pixelCenterX = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), pixelCenterOffsets );
+			__m128 coverage = _mm_cmple_ps( pixelCenterX, lastPixelCenterX );
+			coverage = _mm_and_ps( coverage, GetEdgeCoverage4( GetEdgeWeights4( posB, posC, pixelCenterX, pixelCenterY4 ), topLeftBC ) );
+			coverage = _mm_and_ps( coverage, GetEdgeCoverage4( GetEdgeWeights4( posC, posA, pixelCenterX, pixelCenterY4 ), topLeftCA ) );
+			coverage = _mm_and_ps( coverage, GetEdgeCoverage4( GetEdgeWeights4( posA, posB, pixelCenterX, pixelCenterY4 ), topLeftAB ) );
+			if ( _mm_movemask_ps( coverage ) == 0 )
+				continue;
+
+			__m128 offsetX = _mm_sub_ps( pixelCenterX, posAX );
+			size_t pixelIndex = static_cast<size_t>( y ) * m_dimensions.x + x;
+			__m128 z = _mm_add_ps( attributeRows[DEPTH], _mm_mul_ps( attributeStepsX[DEPTH], offsetX ) );
+			__m128 destinationDepth = zero4;
+			if ( depthEnabled )
+			{
+				destinationDepth = _mm_loadu_ps( &m_depthBuffer[pixelIndex] );
+				coverage = _mm_and_ps( coverage, _mm_cmple_ps( z, destinationDepth ) );
+				if ( _mm_movemask_ps( coverage ) == 0 )
+					continue;
+			}
+
+			__m128 r = _mm_add_ps( attributeRows[RED], _mm_mul_ps( attributeStepsX[RED], offsetX ) );
+			__m128 g = _mm_add_ps( attributeRows[GREEN], _mm_mul_ps( attributeStepsX[GREEN], offsetX ) );
+			__m128 b = _mm_add_ps( attributeRows[BLUE], _mm_mul_ps( attributeStepsX[BLUE], offsetX ) );
+			__m128 a = _mm_add_ps( attributeRows[ALPHA], _mm_mul_ps( attributeStepsX[ALPHA], offsetX ) );
+
+			if ( isTextured )
+			{
+				// Texel fetches are scattered, so sampling stays per-lane
+				alignas( 16 ) float u[SIMD_WIDTH];
+				alignas( 16 ) float v[SIMD_WIDTH];
+				alignas( 16 ) float texelChannels[4][SIMD_WIDTH];
+				_mm_store_ps( u, _mm_add_ps( attributeRows[TEXTURE_U], _mm_mul_ps( attributeStepsX[TEXTURE_U], offsetX ) ) );
+				_mm_store_ps( v, _mm_add_ps( attributeRows[TEXTURE_V], _mm_mul_ps( attributeStepsX[TEXTURE_V], offsetX ) ) );
+
+				int coverageBits = _mm_movemask_ps( coverage );
+				for ( int lane = 0; lane < SIMD_WIDTH; lane++ )
+				{
+					Rgba8 texel = ( coverageBits & ( 1 << lane ) ) ? SampleTexture( *m_boundTexture, u[lane], v[lane] ) : Rgba8::WHITE;
+					texelChannels[0][lane] = NormalizeByte( texel.r );
+					texelChannels[1][lane] = NormalizeByte( texel.g );
+					texelChannels[2][lane] = NormalizeByte( texel.b );
+					texelChannels[3][lane] = NormalizeByte( texel.a );
+				}
+
+				r = _mm_mul_ps( r, _mm_load_ps( texelChannels[0] ) );
+				g = _mm_mul_ps( g, _mm_load_ps( texelChannels[1] ) );
+				b = _mm_mul_ps( b, _mm_load_ps( texelChannels[2] ) );
+				a = _mm_mul_ps( a, _mm_load_ps( texelChannels[3] ) );
+			}
+
+			__m128i* destinationPixels = reinterpret_cast<__m128i*>( &m_colorBuffer[pixelIndex] );
+			__m128i destination = _mm_loadu_si128( destinationPixels );
+			if ( alphaBlend )
+			{
+				coverage = _mm_and_ps( coverage, _mm_cmpgt_ps( a, zero4 ) );
+				if ( _mm_movemask_ps( coverage ) == 0 )
+					continue;
+
+				__m128 sourceWeight = _mm_mul_ps( a, inverseByteMax4 );
+				__m128 destinationWeight = _mm_sub_ps( one4, sourceWeight );
+				__m128 destinationR = _mm_cvtepi32_ps( _mm_and_si128( destination, byteMask4 ) );
+				__m128 destinationG = _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( destination, 8 ), byteMask4 ) );
+				__m128 destinationB = _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( destination, 16 ), byteMask4 ) );
+				__m128 destinationA = _mm_cvtepi32_ps( _mm_srli_epi32( destination, 24 ) );
+				r = _mm_add_ps( _mm_mul_ps( r, sourceWeight ), _mm_mul_ps( destinationR, destinationWeight ) );
+				g = _mm_add_ps( _mm_mul_ps( g, sourceWeight ), _mm_mul_ps( destinationG, destinationWeight ) );
+				b = _mm_add_ps( _mm_mul_ps( b, sourceWeight ), _mm_mul_ps( destinationB, destinationWeight ) );
+				a = _mm_add_ps( a, _mm_mul_ps( destinationA, destinationWeight ) );
+			}
+
+			// Rgba8 is r,g,b,a in memory, which is r in the low byte of each little-endian lane
+			__m128i packed = _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( r, zero4 ), byteMax4 ) );
+			packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( g, zero4 ), byteMax4 ) ), 8 ) );
+			packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( b, zero4 ), byteMax4 ) ), 16 ) );
+			packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( a, zero4 ), byteMax4 ) ), 24 ) );
+
+			__m128i coverageBits = _mm_castps_si128( coverage );
+			_mm_storeu_si128( destinationPixels, _mm_or_si128( _mm_and_si128( coverageBits, packed ), _mm_andnot_si128( coverageBits, destination ) ) );
+
+			if ( depthEnabled )
+			{
+				_mm_storeu_ps( &m_depthBuffer[pixelIndex], _mm_or_ps( _mm_and_ps( coverage, z ), _mm_andnot_ps( coverage, destinationDepth ) ) );
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+SoftwareTexture const* SoftwareRenderBackend::GetOrLoadTexture( Texture const* texture )
+{
+	if ( texture == nullptr )
+		return nullptr;
+
+	auto found = m_textures.find( texture );
+	if ( found != m_textures.end() )
+		return &found->second;
+
+	// Re-read the source image; the GPU copy isn't readable from here
+	Image image( texture->GetImageFilePath().c_str() );
+	SoftwareTexture& softwareTexture = m_textures[texture];
+	softwareTexture.m_dimensions = image.GetDimensions();
+
+	Rgba8 const* texels = static_cast<Rgba8 const*>( image.GetRawData() );
+	size_t texelCount = static_cast<size_t>( softwareTexture.m_dimensions.x ) * softwareTexture.m_dimensions.y;
+	softwareTexture.m_texels.assign( texels, texels + texelCount );
+	return &softwareTexture;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+Rgba8 SoftwareRenderBackend::SampleTexture( SoftwareTexture const& texture, float u, float v ) const
+{
+	int width = texture.m_dimensions.x;
+	int height = texture.m_dimensions.y;
+	if ( width <= 0 || height <= 0 )
+		return Rgba8::WHITE;
+
+	bool clamp = ( m_samplerMode == SamplerMode::POINT_CLAMP );
+	if ( clamp )
+	{
+		u = GetClampedZeroToOne( u );
+		v = GetClampedZeroToOne( v );
+	}
+	else
+	{
+		u -= floorf( u );
+		v -= floorf( v );
+	}
+
+	int texelX = static_cast<int>( u * width );
+	int texelY = static_cast<int>( v * height );
+	texelX = texelX < width ? texelX : width - 1;
+	texelY = texelY < height ? texelY : height - 1;
+	return texture.m_texels[static_cast<size_t>( texelY ) * width + texelX];
+}
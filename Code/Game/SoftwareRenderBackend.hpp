@@ -0,0 +1,89 @@
+#pragma once
+#include "Game/RenderBackend.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Mat44.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+struct SoftwareTexture
+{
+	IntVec2 m_dimensions;
+	std::vector<Rgba8> m_texels;	// Row 0 is the bottom of the image, matching UV space
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// CPU rasterizer for the calls in RenderBackend. Renders Vertex_PCU triangles into an in-memory color
+// buffer with the same blend, depth, cull and sampler behavior the game relies on from the GPU renderer.
+// Triangles are rasterized four pixels at a time with SSE2.
+// Buffers live only in CPU memory, so nothing drawn here touches the GPU. The handles this backend gives out are opaque
+// keys into its own buffer maps, never engine objects: they must only ever be passed back to the
+// backend that created them.
+//
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+	explicit SoftwareRenderBackend( IntVec2 const& dimensions );
+	~SoftwareRenderBackend();
+
+	void ClearScreen( Rgba8 const& clearColor ) override;
+	void BeginCamera( Camera const& camera ) override;
+	void EndCamera( Camera const& camera ) override;
+
+	void BindTexture( Texture const* texture ) override;
+	void BindShader( Shader* shader ) override;
+	void SetBlendMode( BlendMode blendMode ) override;
+	void SetDepthMode( DepthMode depthMode ) override;
+	void SetRasterizerMode( RasterizerMode rasterizerMode ) override;
+	void SetSamplerMode( SamplerMode samplerMode ) override;
+	void SetModelConstants( Mat44 const& modelToWorldTransform = Mat44(), Rgba8 const& modelColor = Rgba8::WHITE ) override;
+
+	VertexBuffer* CreateVertexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, VertexBuffer* vbo ) override;
+	IndexBuffer* CreateIndexBuffer( size_t byteSize ) override;
+	void CopyCPUToGPU( void const* data, size_t byteSize, IndexBuffer* ibo ) override;
+	unsigned int CreateNewBuffersFromIndexedMesh( IndexedMesh const& mesh, VertexBuffer** out_vbo, IndexBuffer** out_ibo ) override;
+	void DestroyVertexBuffer( VertexBuffer* vbo ) override;
+	void DestroyIndexBuffer( IndexBuffer* ibo ) override;
+
+	void DrawVertexArray( int numVertexes, Vertex_PCU const* vertexes ) override;
+	void DrawVertexArray( Mesh const& mesh ) override;
+	void DrawIndexedMesh( IndexedMesh const& mesh ) override;
+	void DrawVertexBuffer( VertexBuffer* vbo, int vertexCount ) override;
+	void DrawIndexedVertexBuffer( VertexBuffer* vbo, IndexBuffer* ibo, unsigned int indexCount ) override;
+
+	IntVec2 const& GetDimensions() const;
+	Rgba8 const* GetColorBuffer() const;
+	bool WriteFrameToTGA( char const* filepath ) const;
+
+private:
+	void DrawTriangles( Vertex_PCU const* vertexes, unsigned int const* indexes, int vertexCount );
+	void RasterizeTriangle( Vertex_PCU const& vertA, Vertex_PCU const& vertB, Vertex_PCU const& vertC );
+	SoftwareTexture const* GetOrLoadTexture( Texture const* texture );
+	Rgba8 SampleTexture( SoftwareTexture const& texture, float u, float v ) const;
+
+private:
+	IntVec2 m_dimensions;
+	std::vector<Rgba8> m_colorBuffer;	// Row 0 is the top of the frame
+	std::vector<float> m_depthBuffer;
+
+	SoftwareTexture const* m_boundTexture = nullptr;
+	BlendMode		m_blendMode			= BlendMode::ALPHA;
+	DepthMode		m_depthMode			= DepthMode::DISABLED;
+	RasterizerMode	m_rasterizerMode	= RasterizerMode::SOLID_CULL_BACK;
+	SamplerMode		m_samplerMode		= SamplerMode::POINT_CLAMP;
+	Mat44			m_modelToWorld;
+	Rgba8			m_modelColor		= Rgba8::WHITE;
+
+	Vec2 m_cameraMins = Vec2::ZERO;		// World-space corner that maps to the bottom-left pixel
+	Vec2 m_worldToPixels = Vec2::ZERO;	// Pixels per world unit on each axis
+
+	std::unordered_map<Texture const*, SoftwareTexture> m_textures;
+	std::unordered_map<VertexBuffer const*, std::vector<Vertex_PCU>> m_vertexBuffers;
+	std::unordered_map<IndexBuffer const*, std::vector<unsigned int>> m_indexBuffers;
+	uintptr_t m_nextBufferHandle = 1;
+};
@@ -1,12 +1,38 @@
+#define WIN32_LEAN_AND_MEAN		// Always #define this before #including <windows.h>
+#include <windows.h>			// Only needed here for reading the keyboard off the main thread
 #include "Game/TapManager.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/AllocationTracker.hpp"
 #include "Engine/Input/InputSystem.hpp"
 #include "Engine/Core/Time.hpp"
 
 
+//----------------------------------------------------------------------------------------------------------
+// The virtual keys a player can actually press on a keyboard or mouse: mouse buttons, editing keys,
+// the generic shift, control and alt, space, navigation, digits, letters, the numpad and punctuation.
+// Everything else, including the left and right variants of the modifiers, which the generic codes
+// already report, is never read.
+//
+static bool IsTapCapableKey( int keyIndex )
+{
+	return keyIndex == VK_LBUTTON || keyIndex == VK_RBUTTON || keyIndex == VK_MBUTTON
+		|| keyIndex == VK_BACK || keyIndex == VK_TAB || keyIndex == VK_RETURN
+		|| ( keyIndex >= VK_SHIFT && keyIndex <= VK_MENU )
+		|| ( keyIndex >= VK_SPACE && keyIndex <= VK_DOWN )
+		|| keyIndex == VK_INSERT || keyIndex == VK_DELETE
+		|| ( keyIndex >= '0' && keyIndex <= '9' )
+		|| ( keyIndex >= 'A' && keyIndex <= 'Z' )
+		|| ( keyIndex >= VK_NUMPAD0 && keyIndex <= VK_DIVIDE )
+		|| ( keyIndex >= VK_OEM_1 && keyIndex <= VK_OEM_3 )
+		|| ( keyIndex >= VK_OEM_4 && keyIndex <= VK_OEM_7 );
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 TapManager::TapManager()
 {
+	m_taps.reserve( MAX_KEYBOARD_KEYS );		// Every key down in one poll, so pushing a tap never grows
+
 	IgnoreKey( KEYCODE_ESC );
 	IgnoreKey( KEYCODE_TILDE );
 	IgnoreKey( KEYCODE_F1 );
@@ -37,6 +63,7 @@ void TapManager::IgnoreKey( unsigned char keycode )
 //----------------------------------------------------------------------------------------------------------
 void TapManager::PollInput()
 {
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::TAP_MANAGER );
 	if ( !m_active )
 		return;
 
@@ -55,19 +82,112 @@ void TapManager::PollInput()
 
 
 //----------------------------------------------------------------------------------------------------------
+// The engine's key states only change when the main thread pumps messages, once a frame, so a tap read
+// through them is stamped late by however long the frame took. PollKeyboard() reads the keyboard
+// directly and can run on the simulation thread every tick, so it reads as few keys as it can. This picks
+// them, once, and takes their current state, so a key that is already held when polling starts is not
+// counted as a new press.
+//
+void TapManager::BeginKeyboardPolling()
+{
+	m_polledTaps.Reset();
+	m_polledKeyCount = 0;
+	for ( int keyIndex = 0; keyIndex < MAX_KEYBOARD_KEYS; keyIndex++ )
+	{
+		if ( m_ignoreKey[keyIndex] || !IsTapCapableKey( keyIndex ) )
+			continue;
+
+		m_polledKeys[m_polledKeyCount++] = static_cast<unsigned char>( keyIndex );
+		m_wasKeyboardKeyDown[keyIndex] = ( GetAsyncKeyState( keyIndex ) & 0x8000 ) != 0;
+	}
+	RefreshFocus();
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Checking focus takes a few calls into the window manager, too many to make every tick, so the main
+// thread checks once a frame and PollKeyboard() uses the answer. A tap right after switching away can
+// still count, for up to a frame.
+//
+void TapManager::RefreshFocus()
+{
+	DWORD foregroundProcessID = 0;
+	GetWindowThreadProcessId( GetForegroundWindow(), &foregroundProcessID );
+	m_isFocused.store( foregroundProcessID == GetCurrentProcessId(), std::memory_order_relaxed );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Engine keycodes are Windows virtual-key codes, so they index GetAsyncKeyState() directly. Keys pressed
+// while another application has focus are not taps.
+//
+// This only hands taps to TakePolledTaps() through the ring buffer, so the simulation thread can poll
+// without the shared mutex while the main thread holds it. Only TakePolledTaps() touches m_taps.
+//
+void TapManager::PollKeyboard( double timeSeconds )
+{
+	bool isFocused = m_isFocused.load( std::memory_order_relaxed );
+	for ( int polledKeyIndex = 0; polledKeyIndex < m_polledKeyCount; polledKeyIndex++ )
+	{
+		unsigned char keycode = m_polledKeys[polledKeyIndex];
+		bool isDown = ( GetAsyncKeyState( keycode ) & 0x8000 ) != 0;
+		bool isNewPress = isDown && !m_wasKeyboardKeyDown[keycode];
+		m_wasKeyboardKeyDown[keycode] = isDown;
+
+		if ( isNewPress && isFocused )
+		{
+			m_polledTaps.Push( timeSeconds );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Runs on the thread that judges taps, with the shared mutex held. Taps that don't fit in m_taps' reserve
+// wait in the ring for the next call rather than grow it.
+//
+void TapManager::TakePolledTaps()
+{
+	double tapTimeSeconds = 0.0;
+	while ( m_taps.size() < m_taps.capacity() && m_polledTaps.Pop( tapTimeSeconds ) )
+	{
+		if ( m_active )
+		{
+			m_taps.push_back( tapTimeSeconds );
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Empties the ring from the reading side rather than resetting it, so it never races PollKeyboard()
+//
 void TapManager::PopAllTaps()
 {
 	m_taps.clear();
+
+	double tapTimeSeconds = 0.0;
+	while ( m_polledTaps.Pop( tapTimeSeconds ) )
+	{
+	}
 }
 
 
 //----------------------------------------------------------------------------------------------------------
 void TapManager::PushTap()
 {
+	PushTap( GetCurrentTimeSeconds() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+void TapManager::PushTap( double timeSeconds )
+{
+	ScopedAllocationSubsystem allocationSubsystem( AllocationSubsystem::TAP_MANAGER );
 	if ( !m_active )
 		return;
 
-	m_taps.push_back( GetCurrentTimeSeconds() );
+	m_taps.push_back( timeSeconds );
 }
 
 
@@ -82,6 +202,32 @@ bool TapManager::PopIfTap()
 }
 
 
+//----------------------------------------------------------------------------------------------------------
+// Taps can be polled ahead of the tick that judges them, so a tick only takes the taps that came before it
+//
+bool TapManager::PopTapBy( double timeSeconds, double& out_tapTimeSeconds )
+{
+	if ( m_taps.empty() || m_taps.front() > timeSeconds )
+		return false;
+
+	out_tapTimeSeconds = m_taps.front();
+	m_taps.erase( m_taps.begin() );
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool TapManager::PopOldestTap( double& out_tapTimeSeconds )
+{
+	if ( m_taps.empty() )
+		return false;
+
+	out_tapTimeSeconds = m_taps.front();
+	m_taps.erase( m_taps.begin() );
+	return true;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 void TapManager::ToggleActive()
 {
@@ -1,5 +1,7 @@
 #pragma once
+#include "Game/RingBuffer.hpp"
 #include "Engine/Input/InputSystem.hpp"
+#include <atomic>
 
 
 //----------------------------------------------------------------------------------------------------------
@@ -11,16 +13,28 @@ public:
 	void IgnoreKey( unsigned char keycode );
 
 	void PollInput();
+	void BeginKeyboardPolling();
+	void RefreshFocus();						// Main thread only; PollKeyboard() reads what this found
+	void PollKeyboard( double timeSeconds );	// Safe off the main thread; see the definition
+	void TakePolledTaps();
 	void PopAllTaps();
 
 	void PushTap();
+	void PushTap( double timeSeconds );
 	bool PopIfTap();
+	bool PopTapBy( double timeSeconds, double& out_tapTimeSeconds );		// Only a tap stamped no later than timeSeconds
+	bool PopOldestTap( double& out_tapTimeSeconds );
 
 	void ToggleActive();
 	void SetActive( bool active );
 
 private:
 	std::vector<double> m_taps;
-	bool m_ignoreKey[MAX_KEYBOARD_KEYS];
+	bool m_ignoreKey[MAX_KEYBOARD_KEYS] = {};
+	bool m_wasKeyboardKeyDown[MAX_KEYBOARD_KEYS] = {};	// As of the last PollKeyboard()
+	unsigned char m_polledKeys[MAX_KEYBOARD_KEYS] = {};	// The only keys PollKeyboard() reads; see BeginKeyboardPolling()
+	int m_polledKeyCount = 0;
+	std::atomic<bool> m_isFocused = false;
+	RingBuffer<double, MAX_KEYBOARD_KEYS> m_polledTaps;	// From PollKeyboard() to TakePolledTaps()
 	bool m_active = true;
 };
\ No newline at end of file
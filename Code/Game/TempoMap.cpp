@@ -0,0 +1,263 @@
+#include "Game/TempoMap.hpp"
+#include "Engine/Core/NamedStrings.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Microseconds in a minute, times the thousandths tempos are held in
+//
+constexpr long long MICROSECONDS_PER_MINUTE_THOUSANDTHS = 60'000'000'000LL;
+
+
+//----------------------------------------------------------------------------------------------------------
+static long long FloorDivide( long long numerator, long long denominator )
+{
+	long long quotient = numerator / denominator;
+	return ( numerator % denominator != 0 && ( numerator < 0 ) != ( denominator < 0 ) ) ? quotient - 1 : quotient;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static long long CeilDivide( long long numerator, long long denominator )
+{
+	return -FloorDivide( -numerator, denominator );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+static long long BpmToThousandths( double bpm )
+{
+	return llround( bpm * 1000.0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TimeSignature::GetMeasureLengthInBeats() const
+{
+	return static_cast<double>( m_beatsPerMeasure ) * 4.0 / static_cast<double>( m_beatUnit );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+TempoMap::TempoMap( float bpm )
+{
+	m_segments[0].m_bpmThousandths = BpmToThousandths( bpm );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool TempoMap::PopulateFromXmlElement( XmlElement const& levelElement, float initialBpm, std::string& out_errorMessage )
+{
+	if ( initialBpm <= 0.f )
+	{
+		out_errorMessage = Stringf( "Level bpm must be positive, not %g", initialBpm );
+		return false;
+	}
+
+	m_segments.assign( 1, TempoSegment() );
+	m_segments[0].m_bpmThousandths = BpmToThousandths( initialBpm );
+	m_timeSignatures.assign( 1, TimeSignature() );
+
+	XmlElement const* tempoElement = levelElement.FirstChildElement( "Tempo" );
+	while ( tempoElement != nullptr )
+	{
+		NamedStrings tempoArgs;
+		tempoArgs.PopulateFromXmlElementAttributes( *tempoElement );
+		double startBeat = tempoArgs.GetValue( "beat", 0.0 );
+		float bpm = tempoArgs.GetValue( "bpm", 0.f );
+		if ( bpm <= 0.f || startBeat < 0.0 )
+		{
+			out_errorMessage = Stringf( "Tempo change at beat %g to %g bpm is invalid", startBeat, bpm );
+			return false;
+		}
+
+		TempoSegment& segment = m_segments.emplace_back();
+		segment.m_startTick = BeatsToTicks( startBeat );
+		segment.m_bpmThousandths = BpmToThousandths( bpm );
+		tempoElement = tempoElement->NextSiblingElement( "Tempo" );
+	}
+
+	XmlElement const* signatureElement = levelElement.FirstChildElement( "TimeSignature" );
+	while ( signatureElement != nullptr )
+	{
+		NamedStrings signatureArgs;
+		signatureArgs.PopulateFromXmlElementAttributes( *signatureElement );
+		TimeSignature signature;
+		signature.m_startBeat = signatureArgs.GetValue( "beat", 0.0 );
+		signature.m_beatsPerMeasure = signatureArgs.GetValue( "beats", 4 );
+		signature.m_beatUnit = signatureArgs.GetValue( "unit", 4 );
+		if ( signature.m_beatsPerMeasure <= 0 || signature.m_beatUnit <= 0 || signature.m_startBeat < 0.0 )
+		{
+			out_errorMessage = Stringf( "Time signature %i/%i at beat %g is invalid", signature.m_beatsPerMeasure, signature.m_beatUnit, signature.m_startBeat );
+			return false;
+		}
+
+		// One at beat 0 replaces the default 4/4 rather than following it
+		if ( signature.m_startBeat == 0.0 )
+		{
+			m_timeSignatures[0] = signature;
+		}
+		else
+		{
+			m_timeSignatures.push_back( signature );
+		}
+		signatureElement = signatureElement->NextSiblingElement( "TimeSignature" );
+	}
+
+	Finalize();
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+long long TempoMap::TicksToMicroseconds( long long timeInTicks ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByTick( timeInTicks )];
+	return segment.m_startMicroseconds + CeilDivide( ( timeInTicks - segment.m_startTick ) * MICROSECONDS_PER_MINUTE_THOUSANDTHS,
+		segment.m_bpmThousandths * TICKS_PER_BEAT );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+long long TempoMap::MicrosecondsToTicks( long long timeInMicroseconds ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByMicroseconds( timeInMicroseconds )];
+	return segment.m_startTick + FloorDivide( ( timeInMicroseconds - segment.m_startMicroseconds ) * segment.m_bpmThousandths * TICKS_PER_BEAT,
+		MICROSECONDS_PER_MINUTE_THOUSANDTHS );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TempoMap::TicksToSeconds( long long timeInTicks ) const
+{
+	return static_cast<double>( TicksToMicroseconds( timeInTicks ) ) / 1'000'000.0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TempoMap::BeatsToSeconds( double timeInBeats ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByTick( static_cast<long long>( floor( timeInBeats * TICKS_PER_BEAT ) ) )];
+	return static_cast<double>( segment.m_startMicroseconds ) / 1'000'000.0
+		+ ( timeInBeats - TicksToBeats( segment.m_startTick ) ) * GetSecondsPerBeat( timeInBeats );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TempoMap::SecondsToBeats( double timeInSeconds ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByMicroseconds( static_cast<long long>( floor( timeInSeconds * 1'000'000.0 ) ) )];
+	return TicksToBeats( segment.m_startTick )
+		+ ( timeInSeconds - static_cast<double>( segment.m_startMicroseconds ) / 1'000'000.0 ) * static_cast<double>( segment.m_bpmThousandths ) / 60'000.0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TempoMap::GetSecondsPerBeat( double timeInBeats ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByTick( static_cast<long long>( floor( timeInBeats * TICKS_PER_BEAT ) ) )];
+	return 60'000.0 / static_cast<double>( segment.m_bpmThousandths );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+float TempoMap::GetBpm( double timeInBeats ) const
+{
+	TempoSegment const& segment = m_segments[FindSegmentIndexByTick( static_cast<long long>( floor( timeInBeats * TICKS_PER_BEAT ) ) )];
+	return static_cast<float>( static_cast<double>( segment.m_bpmThousandths ) / 1000.0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Measures count from 0 at beat 0, so the count-in is in negative measures
+//
+void TempoMap::GetMeasureAndBeat( double timeInBeats, int& out_measure, double& out_beatInMeasure ) const
+{
+	auto signatureIter = std::upper_bound( m_timeSignatures.begin(), m_timeSignatures.end(), timeInBeats,
+		[]( double time, TimeSignature const& signature ) { return time < signature.m_startBeat; } );
+	TimeSignature const& signature = signatureIter == m_timeSignatures.begin() ? m_timeSignatures.front() : *( signatureIter - 1 );
+
+	double measureLength = signature.GetMeasureLengthInBeats();
+	double measuresIn = floor( ( timeInBeats - signature.m_startBeat ) / measureLength );
+	out_measure = signature.m_startMeasure + static_cast<int>( measuresIn );
+	out_beatInMeasure = timeInBeats - signature.m_startBeat - measuresIn * measureLength;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+bool TempoMap::HasTempoChanges() const
+{
+	return m_segments.size() > 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+long long TempoMap::BeatsToTicks( double timeInBeats )
+{
+	return llround( timeInBeats * TICKS_PER_BEAT );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+double TempoMap::TicksToBeats( long long timeInTicks )
+{
+	return static_cast<double>( timeInTicks ) / static_cast<double>( TICKS_PER_BEAT );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int TempoMap::FindSegmentIndexByTick( long long timeInTicks ) const
+{
+	auto segmentIter = std::upper_bound( m_segments.begin(), m_segments.end(), timeInTicks,
+		[]( long long time, TempoSegment const& segment ) { return time < segment.m_startTick; } );
+	return std::max( static_cast<int>( segmentIter - m_segments.begin() ) - 1, 0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+int TempoMap::FindSegmentIndexByMicroseconds( long long timeInMicroseconds ) const
+{
+	auto segmentIter = std::upper_bound( m_segments.begin(), m_segments.end(), timeInMicroseconds,
+		[]( long long time, TempoSegment const& segment ) { return time < segment.m_startMicroseconds; } );
+	return std::max( static_cast<int>( segmentIter - m_segments.begin() ) - 1, 0 );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+// Sorts both lists and sums their prefixes. Of several tempo changes on one tick the last one written
+// wins. Each segment starts on the microsecond its previous segment rounds its start tick up to, so the
+// conversions are continuous across changes. A time signature change that lands mid-measure starts a
+// new measure there.
+//
+void TempoMap::Finalize()
+{
+	std::stable_sort( m_segments.begin(), m_segments.end(),
+		[]( TempoSegment const& a, TempoSegment const& b ) { return a.m_startTick < b.m_startTick; } );
+	for ( size_t segmentIndex = m_segments.size() - 1; segmentIndex > 0; segmentIndex-- )
+	{
+		if ( m_segments[segmentIndex].m_startTick == m_segments[segmentIndex - 1].m_startTick )
+		{
+			m_segments.erase( m_segments.begin() + segmentIndex - 1 );
+		}
+	}
+
+	for ( size_t segmentIndex = 1; segmentIndex < m_segments.size(); segmentIndex++ )
+	{
+		TempoSegment const& prevSegment = m_segments[segmentIndex - 1];
+		TempoSegment& segment = m_segments[segmentIndex];
+		segment.m_startMicroseconds = prevSegment.m_startMicroseconds + CeilDivide( ( segment.m_startTick - prevSegment.m_startTick ) * MICROSECONDS_PER_MINUTE_THOUSANDTHS,
+			prevSegment.m_bpmThousandths * TICKS_PER_BEAT );
+	}
+
+	std::stable_sort( m_timeSignatures.begin(), m_timeSignatures.end(),
+		[]( TimeSignature const& a, TimeSignature const& b ) { return a.m_startBeat < b.m_startBeat; } );
+	for ( size_t signatureIndex = 1; signatureIndex < m_timeSignatures.size(); signatureIndex++ )
+	{
+		TimeSignature const& prevSignature = m_timeSignatures[signatureIndex - 1];
+		TimeSignature& signature = m_timeSignatures[signatureIndex];
+		double measuresIn = ( signature.m_startBeat - prevSignature.m_startBeat ) / prevSignature.GetMeasureLengthInBeats();
+		signature.m_startMeasure = prevSignature.m_startMeasure + static_cast<int>( ceil( measuresIn ) );
+	}
+}
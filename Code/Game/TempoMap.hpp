@@ -0,0 +1,75 @@
+#pragma once
+#include "Engine/Core/XmlUtils.hpp"
+#include <string>
+#include <vector>
+
+
+//----------------------------------------------------------------------------------------------------------
+constexpr int TICKS_PER_BEAT = 960;
+
+
+//----------------------------------------------------------------------------------------------------------
+struct TempoSegment
+{
+	long long	m_startTick				= 0;
+	long long	m_startMicroseconds		= 0;		// Prefix sum of every earlier segment's length
+	long long	m_bpmThousandths		= 120000;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+struct TimeSignature
+{
+	double	m_startBeat			= 0.0;
+	int		m_startMeasure		= 0;		// Prefix count of every earlier signature's measures
+	int		m_beatsPerMeasure	= 4;
+	int		m_beatUnit			= 4;		// 4 is a quarter note, which is one chart beat
+
+public:
+	double GetMeasureLengthInBeats() const;
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+// Where every chart beat falls in the song. Ticks (TICKS_PER_BEAT to a beat) are the chart's time axis and
+// integer microseconds are the song's; both are exact, so the same chart and tap stream judge bit for bit
+// the same on every build. The map is a list of constant-tempo segments whose start times are summed once
+// when it is built, so converting either way is a binary search plus one integer multiply and divide.
+// Ticks round up to microseconds and microseconds round down to ticks, which makes the round trip exact.
+// Beats before zero (the count-in) use the first segment's tempo, and the last segment runs forever.
+// The double beat and second conversions are for the edges only: rendering, the HUD and the analyzer.
+//
+class TempoMap
+{
+public:
+	TempoMap() = default;
+	explicit TempoMap( float bpm );
+
+	// Reads <Tempo beat="" bpm=""/> and <TimeSignature beat="" beats="" unit=""/> children of a level
+	// element; the level's own bpm is the tempo from beat 0 until the first change
+	bool PopulateFromXmlElement( XmlElement const& levelElement, float initialBpm, std::string& out_errorMessage );
+
+	long long TicksToMicroseconds( long long timeInTicks ) const;
+	long long MicrosecondsToTicks( long long timeInMicroseconds ) const;
+	double TicksToSeconds( long long timeInTicks ) const;
+
+	double BeatsToSeconds( double timeInBeats ) const;
+	double SecondsToBeats( double timeInSeconds ) const;
+	double GetSecondsPerBeat( double timeInBeats ) const;
+	float GetBpm( double timeInBeats ) const;
+	void GetMeasureAndBeat( double timeInBeats, int& out_measure, double& out_beatInMeasure ) const;
+
+	bool HasTempoChanges() const;
+
+	static long long BeatsToTicks( double timeInBeats );		// Rounds to the nearest tick
+	static double TicksToBeats( long long timeInTicks );
+
+private:
+	int FindSegmentIndexByTick( long long timeInTicks ) const;
+	int FindSegmentIndexByMicroseconds( long long timeInMicroseconds ) const;
+	void Finalize();
+
+private:
+	std::vector<TempoSegment>	m_segments		= { TempoSegment() };
+	std::vector<TimeSignature>	m_timeSignatures = { TimeSignature() };
+};
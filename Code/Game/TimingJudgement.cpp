@@ -5,13 +5,32 @@
 #include "Engine/Core/Rgba8.hpp"
 
 
+//----------------------------------------------------------------------------------------------------------
+TimingWindows TimingWindows::FromGameConfig()
+{
+	TimingWindows windows;
+	windows.m_perfectSeconds		= g_gameConfigBlackboard.GetValue( "perfectThresholdSeconds", windows.m_perfectSeconds );
+	windows.m_nearPerfectSeconds	= g_gameConfigBlackboard.GetValue( "nearPerfectThresholdSeconds", windows.m_nearPerfectSeconds );
+	windows.m_acceptableSeconds		= g_gameConfigBlackboard.GetValue( "acceptedThresholdSeconds", windows.m_acceptableSeconds );
+	windows.m_deathSeconds			= g_gameConfigBlackboard.GetValue( "deathThresholdSeconds", windows.m_deathSeconds );
+	return windows;
+}
+
+
 //----------------------------------------------------------------------------------------------------------
 TimingJudgement GetTimingJudgment( double targetSeconds, double actualSeconds )
 {
-	const float perfectThreshold = g_gameConfigBlackboard.GetValue( "perfectThresholdSeconds", 0.05f );
-	const float nearPerfectThreshold = g_gameConfigBlackboard.GetValue( "nearPerfectThresholdSeconds", 0.25f );
-	const float acceptableThreshold = g_gameConfigBlackboard.GetValue( "acceptedThresholdSeconds", 0.40f );
-	const float deathThreshold = g_gameConfigBlackboard.GetValue( "deathThresholdSeconds", 0.40f );
+	return GetTimingJudgment( targetSeconds, actualSeconds, TimingWindows::FromGameConfig() );
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+TimingJudgement GetTimingJudgment( double targetSeconds, double actualSeconds, TimingWindows const& windows )
+{
+	const float perfectThreshold = windows.m_perfectSeconds;
+	const float nearPerfectThreshold = windows.m_nearPerfectSeconds;
+	const float acceptableThreshold = windows.m_acceptableSeconds;
+	const float deathThreshold = windows.m_deathSeconds;
 
 	const float timeSinceTarget = static_cast<float>( actualSeconds - targetSeconds );
 	const float timeOffset = fabsf( timeSinceTarget );
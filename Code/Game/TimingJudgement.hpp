@@ -20,8 +20,24 @@ enum class TimingJudgement
 };
 
 
+//----------------------------------------------------------------------------------------------------------
+// How far off a tap can be for each judgement, read from the config once rather than for every tap
+//
+struct TimingWindows
+{
+	float m_perfectSeconds		= 0.05f;
+	float m_nearPerfectSeconds	= 0.25f;
+	float m_acceptableSeconds	= 0.40f;
+	float m_deathSeconds		= 0.40f;
+
+public:
+	static TimingWindows FromGameConfig();
+};
+
+
 //----------------------------------------------------------------------------------------------------------
 TimingJudgement GetTimingJudgment( double target, double actual );
+TimingJudgement GetTimingJudgment( double target, double actual, TimingWindows const& windows );
 bool IsJudgementAcceptable( TimingJudgement judgement );
 const char* TimingJudgementToString( TimingJudgement judgement );
 Rgba8 TimingJudgementToColor( TimingJudgement judgement );
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+
+
+//----------------------------------------------------------------------------------------------------------
+// Hands the newest of a stream of values from one writer thread to one reader thread without either side
+// ever waiting. The writer fills its own slot and publishes it by swapping it with the shared middle slot;
+// the reader swaps its own slot for the middle one whenever something new was published. Neither side
+// touches the other's slot, so the reader always sees a complete value, and only ever the latest one.
+//
+template<typename T>
+class TripleBuffer
+{
+public:
+	void Reset( T const& value );		// Only while neither thread is using it
+
+	T& GetWriteBuffer();
+	void Publish();
+
+	T const& Acquire();
+
+private:
+	static constexpr int FRESH_BIT = 4;
+	static constexpr int INDEX_MASK = 3;
+
+	T					m_slots[3];
+	int					m_writeIndex	= 0;	// Only the writer touches this
+	std::atomic<int>	m_middleIndex	= 1;	// Ors in FRESH_BIT when the writer published since the reader last took it
+	int					m_readIndex		= 2;	// Only the reader touches this
+};
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T>
+void TripleBuffer<T>::Reset( T const& value )
+{
+	for ( T& slot : m_slots )
+	{
+		slot = value;
+	}
+	m_writeIndex = 0;
+	m_middleIndex.store( 1 );
+	m_readIndex = 2;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T>
+T& TripleBuffer<T>::GetWriteBuffer()
+{
+	return m_slots[m_writeIndex];
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T>
+void TripleBuffer<T>::Publish()
+{
+	int prevMiddleIndex = m_middleIndex.exchange( m_writeIndex | FRESH_BIT, std::memory_order_acq_rel );
+	m_writeIndex = prevMiddleIndex & INDEX_MASK;
+}
+
+
+//----------------------------------------------------------------------------------------------------------
+template<typename T>
+T const& TripleBuffer<T>::Acquire()
+{
+	if ( ( m_middleIndex.load( std::memory_order_acquire ) & FRESH_BIT ) != 0 )
+	{
+		int prevMiddleIndex = m_middleIndex.exchange( m_readIndex, std::memory_order_acq_rel );
+		m_readIndex = prevMiddleIndex & INDEX_MASK;
+	}
+	return m_slots[m_readIndex];
+}